@@ -16,10 +16,10 @@ extern Blit3D* blit3D;
 * @param AudioEngine& reference to the main game audio engine object.
 * @return An instance of the asteroid class.
 */
-Asteroid::Asteroid(AsteroidType newType, std::vector<std::vector<Sprite*>>& newSpriteList, glm::vec2 newPosition, float rotationSpeed, AudioEngine*& newAudioEngine) : audioEngine(newAudioEngine)
+Asteroid::Asteroid(AsteroidType newType, const std::vector<std::vector<Sprite*>>& newSpriteList, glm::vec2 newPosition, float rotationSpeed, AudioEngine*& newAudioEngine) : audioEngine(newAudioEngine)
 {
 	this->type = newType;
-	this->spriteList = newSpriteList;
+	this->spriteList = &newSpriteList;
 	this->position = newPosition;
 	this->state = 0;
 	switch (this->type)
@@ -28,19 +28,19 @@ Asteroid::Asteroid(AsteroidType newType, std::vector<std::vector<Sprite*>>& newS
 		this->radius = 80.0f;
 		this->radiusOrtho = this->radius / 280.0f / sqrt(2);
 		this->mass = 3.0f;
-		this->soundEvent = "BigAsteroid";
+		this->soundEvent = AudioIDs::EVENTS::BIGASTEROID;
 		break;
 	case MEDIUM_ASTEROID:
 		this->radius = 60.0f;
 		this->radiusOrtho = this->radius / 150.0f / sqrt(2);
 		this->mass = 1.0f;
-		this->soundEvent = "MediumAsteroid";
+		this->soundEvent = AudioIDs::EVENTS::MEDIUMASTEROID;
 		break;
 	case SMALL_ASTEROID:
 		this->radius = 25.0f;
 		this->radiusOrtho = this->radius / 50.0f / sqrt(2);
 		this->mass = 0.7f;
-		this->soundEvent = "SmallAsteroid";
+		this->soundEvent = AudioIDs::EVENTS::SMALLASTEROID;
 		break;
 	default:
 		break;
@@ -87,6 +87,14 @@ int Asteroid::GetScore()
 	return 0;
 }
 /**
+* This method returns the asteroid's type
+* @return AsteroidType the asteroid's type
+*/
+AsteroidType Asteroid::GetType()
+{
+	return this->type;
+}
+/**
 * Updates the asteroid's values after certain time period.
 * @param float The time period that has occurred since last uptade.
 */
@@ -125,7 +133,7 @@ bool Asteroid::Update(float deltaTime)
 			this->rotationSpeed -= 360;
 		}
 		// Update the sprite angle
-		this->spriteList[this->type][this->state]->angle += this->rotationSpeed * deltaTime;
+		(*this->spriteList)[this->type][this->state]->angle += this->rotationSpeed * deltaTime;
 
 		if (this->destroyed) {
 			return false;
@@ -142,49 +150,20 @@ bool Asteroid::Update(float deltaTime)
 void Asteroid::Draw()
 {
 	//left
-	if (this->position.x < this->radius) this->spriteList[this->type][this->state]->Blit(this->position.x + backgroundWidth, this->position.y, this->radiusOrtho, this->radiusOrtho);
+	if (this->position.x < this->radius) (*this->spriteList)[this->type][this->state]->Blit(this->position.x + backgroundWidth, this->position.y, this->radiusOrtho, this->radiusOrtho);
 	//right
-	if (this->position.x > backgroundWidth - this->radius) this->spriteList[this->type][this->state]->Blit(this->position.x - backgroundWidth, this->position.y, this->radiusOrtho, this->radiusOrtho);
+	if (this->position.x > backgroundWidth - this->radius) (*this->spriteList)[this->type][this->state]->Blit(this->position.x - backgroundWidth, this->position.y, this->radiusOrtho, this->radiusOrtho);
 	//down
-	if (this->position.y < this->radius) this->spriteList[this->type][this->state]->Blit(this->position.x, this->position.y + backgroundHeight, this->radiusOrtho, this->radiusOrtho);
+	if (this->position.y < this->radius) (*this->spriteList)[this->type][this->state]->Blit(this->position.x, this->position.y + backgroundHeight, this->radiusOrtho, this->radiusOrtho);
 	//up
-	if (this->position.y > backgroundHeight - this->radius) this->spriteList[this->type][this->state]->Blit(this->position.x, this->position.y - backgroundHeight, this->radiusOrtho, this->radiusOrtho);
+	if (this->position.y > backgroundHeight - this->radius) (*this->spriteList)[this->type][this->state]->Blit(this->position.x, this->position.y - backgroundHeight, this->radiusOrtho, this->radiusOrtho);
 
 	//copies for 4 diagonal corners
-	this->spriteList[this->type][this->state]->Blit(this->position.x + backgroundWidth, this->position.y + backgroundHeight, this->radiusOrtho, this->radiusOrtho);
-	this->spriteList[this->type][this->state]->Blit(this->position.x - backgroundWidth, this->position.y - backgroundHeight, this->radiusOrtho, this->radiusOrtho);
-	this->spriteList[this->type][this->state]->Blit(this->position.x - backgroundWidth, this->position.y + backgroundHeight, this->radiusOrtho, this->radiusOrtho);
-	this->spriteList[this->type][this->state]->Blit(this->position.x + backgroundWidth, this->position.y - backgroundHeight, this->radiusOrtho, this->radiusOrtho);
-	this->spriteList[this->type][this->state]->Blit(position.x, position.y, this->radiusOrtho, this->radiusOrtho);
-}
-/**
-* Calculates collisions with other asteroids.
-* @param std::vector<glm::vec2> The list of asteroid to check collision with.
-*/
-bool Asteroid::CollideWithAsteroids(std::vector<Asteroid*> asteroids)
-{
-	if (asteroids.size() == 0)
-	{
-		return false;
-	}
-	bool collided = false;
-	// For each asteroid check the collission with each asteroid
-	for (int i = 0; i < asteroids.size() - 1; i++)
-	{
-		for (int j = i + 1; j < asteroids.size(); j++)
-		{
-			if (asteroids[i] != asteroids[j]) {
-				if (asteroids[i]->CollideAsteroid(asteroids[j]))
-				{
-					// Collide the asteroid with the other asteroid
-					asteroids[i]->Collide(asteroids[j]);
-					collided = true;
-					asteroids[i]->playCollisionSound();
-				}
-			}
-		}
-	}
-	return collided;
+	(*this->spriteList)[this->type][this->state]->Blit(this->position.x + backgroundWidth, this->position.y + backgroundHeight, this->radiusOrtho, this->radiusOrtho);
+	(*this->spriteList)[this->type][this->state]->Blit(this->position.x - backgroundWidth, this->position.y - backgroundHeight, this->radiusOrtho, this->radiusOrtho);
+	(*this->spriteList)[this->type][this->state]->Blit(this->position.x - backgroundWidth, this->position.y + backgroundHeight, this->radiusOrtho, this->radiusOrtho);
+	(*this->spriteList)[this->type][this->state]->Blit(this->position.x + backgroundWidth, this->position.y - backgroundHeight, this->radiusOrtho, this->radiusOrtho);
+	(*this->spriteList)[this->type][this->state]->Blit(position.x, position.y, this->radiusOrtho, this->radiusOrtho);
 }
 /**
 * Calculates distance from the center of this asteroid to a point.
@@ -245,10 +224,10 @@ bool Asteroid::CollideAsteroid(Asteroid* asteroid) {
 }
 /**
 * This method handles when the asteroid gets hit.
-* @param Asteroid* The asteroid list to add new Asteroids.
+* @param SlotMap<Asteroid>& The asteroids to spawn the pieces into, they appear on its next Flush().
 * @return the value of hitting the asteroid
 */
-int Asteroid::GotHitByBullet(std::vector<Asteroid*>& asteroids)
+int Asteroid::GotHitByBullet(SlotMap<Asteroid>& asteroids)
 {
 	if (!this->destroyed)
 	{
@@ -258,10 +237,10 @@ int Asteroid::GotHitByBullet(std::vector<Asteroid*>& asteroids)
 			for (int i = 0; i < 2; i++)
 			{
 				// Create two medium asteroids
-				Asteroid* asteroid = new Asteroid(MEDIUM_ASTEROID, this->spriteList, { this->position.x, this->position.y }, (-1 ^ i) * 2 * this->rotationSpeed, this->audioEngine);
+				Asteroid asteroid(MEDIUM_ASTEROID, *this->spriteList, { this->position.x, this->position.y }, (-1 ^ i) * 2 * this->rotationSpeed, this->audioEngine);
 				glm::vec2 normalVector = glm::normalize(this->velocity);
-				asteroid->SetVelocity({ (-2 ^ i) * normalVector.x, (-2 ^ i) * normalVector.y });
-				asteroids.push_back(asteroid);
+				asteroid.SetVelocity({ (-2 ^ i) * normalVector.x, (-2 ^ i) * normalVector.y });
+				asteroids.Spawn(std::move(asteroid));
 				this->destroyed = true;
 				this->state++;
 			}
@@ -271,9 +250,9 @@ int Asteroid::GotHitByBullet(std::vector<Asteroid*>& asteroids)
 			for (int i = 0; i < 2; i++)
 			{
 				// Create two small asteroids
-				Asteroid* asteroid = new Asteroid(SMALL_ASTEROID, this->spriteList, { this->position.x, this->position.y }, (-1 ^ i) * 2 * this->rotationSpeed, this->audioEngine);
-				asteroid->SetVelocity(this->GetSmallAsteroidDirection(i));
-				asteroids.push_back(asteroid);
+				Asteroid asteroid(SMALL_ASTEROID, *this->spriteList, { this->position.x, this->position.y }, (-1 ^ i) * 2 * this->rotationSpeed, this->audioEngine);
+				asteroid.SetVelocity(this->GetSmallAsteroidDirection(i));
+				asteroids.Spawn(std::move(asteroid));
 				this->destroyed = true;
 				this->state++;
 			}
@@ -290,6 +269,7 @@ int Asteroid::GotHitByBullet(std::vector<Asteroid*>& asteroids)
 			break;
 		}
 	}
+	return 0;
 }
 /**
 	* This method gets the direction of the small asteroid given the iteration of the ateroid.
@@ -362,8 +342,8 @@ float Asteroid::GetRadius()
 */
 void Asteroid::playExplosionSound()
 {
-	AKRESULT panningX = AK::SoundEngine::SetRTPCValue(L"PanningX", (AkRtpcValue)(this->position.x), this->soundId);
-	this->explosionSound = this->audioEngine->PlayEvent(this->soundEvent, this->soundId);
+	// Heavier asteroids win when too many explode at once, the panning is set by the audio engine
+	this->explosionSound = this->audioEngine->PlayEvent(this->soundEvent, this->soundId, this->mass, this->position.x, this->position.y);
 }
 /**
 * This method plays the proper asteroid collission sound
@@ -372,8 +352,7 @@ void Asteroid::playCollisionSound()
 {
 	if (this->collisionSoundTimer > 1.0f)
 	{
-		AKRESULT panningX = AK::SoundEngine::SetRTPCValue(L"PanningX", (AkRtpcValue)(this->position.x), this->soundId);
-		this->collisionSound = this->audioEngine->PlayEvent("Collision", this->soundId);
+		this->collisionSound = this->audioEngine->PlayEvent(AudioIDs::EVENTS::COLLISION, this->soundId, this->mass, this->position.x, this->position.y);
 		this->collisionSoundTimer = 0;
 	}
 	
@@ -2,6 +2,8 @@
 
 #include "Blit3D.h"
 #include "AudioEngine.h"
+#include "AudioIDs.h"
+#include "SlotMap.h"
 #include <string>
 #include <random>
 #include <vector>
@@ -30,9 +32,9 @@ private:
 	*/
 	AsteroidType type;
 	/**
-	* The sprites that represents the asteroids graphucally.
+	* The sprites that represents the asteroids graphucally, shared by all the asteroids.
 	*/
-	std::vector<std::vector<Sprite*>> spriteList;
+	const std::vector<std::vector<Sprite*>>* spriteList;
 	/**
 	* The 2D vector that represents the asteroid's direction and speed.
 	*/
@@ -70,13 +72,13 @@ private:
 	*/
 	AkGameObjectID soundId = 4;
 	/**
-	* The ships audio Game object ID
+	* The explosion sound event for this asteroid's size
 	*/
-	std::string soundEvent;
+	AkUniqueID soundEvent;
 	/**
 	* The Game Object sound elements
 	*/
-	AkPlayingID collisionSound, explosionSound;
+	AudioHandle collisionSound, explosionSound;
 	/**
 	* The collission timer
 	*/
@@ -93,7 +95,7 @@ public:
 	* @param AudioEngine& reference to the main game audio engine object.
 	* @return An instance of the asteroid class.
 	*/
-	Asteroid(AsteroidType, std::vector<std::vector<Sprite*>>&, glm::vec2, float, AudioEngine*&);
+	Asteroid(AsteroidType, const std::vector<std::vector<Sprite*>>&, glm::vec2, float, AudioEngine*&);
 	/**
 	* Sets the asteroid's velocity to a given 2D vector.
 	* @param glm::vec2 The asteroid's new velocity.
@@ -125,6 +127,11 @@ public:
 	*/
 	int GetScore();
 	/**
+	* This method returns the asteroid's type
+	* @return AsteroidType the asteroid's type
+	*/
+	AsteroidType GetType();
+	/**
 	* Updates the asteroid's values after certain time period.
 	* @param float The time period that has occurred since last uptade.
 	*/
@@ -134,11 +141,6 @@ public:
 	*/
 	void Draw();
 	/**
-	* Calculates collisions with other asteroids.
-	* @param std::vector<glm::vec2> The list of asteroid to check collision with.
-	*/
-	static bool CollideWithAsteroids(std::vector<Asteroid*>);
-	/**
 	* Calculates distance from the center of this asteroid to a point.
 	* @param glm::vec2 The point to calculate the distance with this asteroid.
 	*/
@@ -156,9 +158,9 @@ public:
 	bool CollideAsteroid(Asteroid*);
 	/**
 	* This method handles when the asteroid gets hit.
-	* @param Asteroid* The asteroid list to add new Asteroids.
+	* @param SlotMap<Asteroid>& The asteroids to spawn the pieces into, they appear on its next Flush().
 	*/
-	int GotHitByBullet(std::vector<Asteroid*>&);
+	int GotHitByBullet(SlotMap<Asteroid>&);
 	/**
 	* This method gets the direction of the small asteroid given the iteration of the ateroid.
 	* For the first one, is the velocity
@@ -185,4 +187,6 @@ public:
 	* This method cleand the object before deletion
 	*/
 	void playCollisionSound();
-};
\ No newline at end of file
+};
+
+typedef SlotHandle<Asteroid> AsteroidHandle;
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+	Interface between AudioEngine and whatever actually makes the noise.
+
+	AudioEngine calls Init(), Term(), SetBasePath(), SetArchive(), LoadBank() and LoadBankAsync() from
+	the game thread and everything else from its audio thread, so a backend only needs to
+	be safe for those two callers, never for calls coming from the rest of the game.
+
+	The callback given to LoadBankAsync() may be called from any thread, the sound
+	engine's bank thread for Wwise, or from inside LoadBankAsync() itself.
+*/
+
+#include <string>
+#include "AudioTypes.h"
+
+class AssetArchive;
+
+// Called once when an asynchronous bank load is over, loaded is false if it failed.
+typedef void (*AudioBankCallback)(bool loaded, void *cookie);
+
+class AudioBackend
+{
+public:
+	virtual ~AudioBackend() { }
+
+	virtual bool Init() = 0;
+	virtual void Term() = 0;
+	virtual void RenderAudio() = 0;
+	virtual void SetBasePath(const std::string &path) = 0;
+	// Banks found in the archive (at base path + bank name) are loaded straight from its
+	// mapping, which must stay open until Term(). Backends that load nothing can ignore it.
+	virtual void SetArchive(const AssetArchive * /*archive*/) { }
+	virtual bool LoadBank(const std::string &bank) = 0;
+	// Queues the bank and returns straight away. Returns false, without calling
+	// the callback, if the load could not even be queued.
+	virtual bool LoadBankAsync(const std::string &bank, AudioBankCallback callback, void *cookie) = 0;
+
+	virtual AkPlayingID PostEvent(AkUniqueID eventID, AkGameObjectID gameObjectID) = 0;
+	// action is one of AudioCommandType::STOP, PAUSE or RESUME
+	virtual void ExecuteActionOnEvent(AudioCommandType action, AkUniqueID eventID, AkGameObjectID gameObjectID,
+		AkTimeMs transitionDuration, AkPlayingID playingID) = 0;
+	virtual void SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID) = 0;
+	// 2D position of a game object, the game plays in the XY plane
+	virtual void SetPosition(AkGameObjectID gameObjectID, float x, float y) = 0;
+	virtual void RegisterGameObject(AkGameObjectID gameObjectID) = 0;
+};
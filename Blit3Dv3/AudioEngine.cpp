@@ -1,299 +1,666 @@
 #include "AudioEngine.h"
+#include "WwiseAudioBackend.h"
+#include "NullAudioBackend.h"
+#include "Logger.h"
+#include "AllocationTracker.h"
 #include <stdlib.h>
-
-//below needed for VirtualAlloc etc
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 
-//add the following libraries to the build
-#pragma comment(lib, "AkSoundEngine.lib") //sound engine core
-#pragma comment(lib, "AkMemoryMgr.lib") //memory manager
-#pragma comment(lib, "AkStreamMgr.lib") //io manager
-#pragma comment(lib, "AkMusicEngine.lib") //interactive dynamic music
-#ifndef AK_OPTIMIZED
-#pragma comment(lib, "CommunicationCentral.lib") //debug comms
-#endif
+//use the main Blit3D logger
+extern logger oLog;
 
-//source plugin libs
-#pragma comment(lib, "AkAudioInputSource.lib")
-#pragma comment(lib, "AkSilenceSource.lib")
-#pragma comment(lib, "AkSineSource.lib")
-#pragma comment(lib, "AkSynthOneSource.lib")
-#pragma comment(lib, "AkToneSource.lib")
-
-//effect plugins
-#pragma comment(lib, "AkCompressorFX.lib")
-#pragma comment(lib, "AkDelayFX.lib")
-#pragma comment(lib, "AkExpanderFX.lib")
-#pragma comment(lib, "AkFlangerFX.lib")
-#pragma comment(lib, "AkGainFX.lib")
-#pragma comment(lib, "AkGuitarDistortionFX.lib")
-#pragma comment(lib, "AkHarmonizerFX.lib")
-#pragma comment(lib, "AkMatrixReverbFX.lib")
-#pragma comment(lib, "AkMeterFX.lib")
-#pragma comment(lib, "AkParametricEQFX.lib")
-#pragma comment(lib, "AkPeakLimiterFX.lib")
-#pragma comment(lib, "AkPitchShifterFX.lib")
-#pragma comment(lib, "AkRoomVerbFX.lib")
-#pragma comment(lib, "AkStereoDelayFX.lib")
-#pragma comment(lib, "AkTimeStretchFX.lib")
-#pragma comment(lib, "AkTremoloFX.lib")
-
-//codec plugins
-#pragma comment(lib, "AkVorbisDecoder.lib")
-
-//motion plugins
-#pragma comment(lib, "AkMotionGeneratorSource.lib")
-//#pragma comment(lib, "AkRumble.lib")
-
-//platform-specific (windows)
-#pragma comment(lib, "dinput8.lib")
-#pragma comment(lib, "dsound.lib")
-#pragma comment(lib, "xinput.lib")
-#pragma comment(lib, "dxguid.lib")
-#ifndef AK_OPTIMIZED
-#pragma comment(lib, "Ws2_32.lib")
-#endif
+static const char *AudioCommandNames[] = { "Play", "Stop", "Pause", "Resume", "SetRTPCValue", "SetPosition",
+	"RegisterGameObject" };
 
-// Custom alloc/free functions. These are declared as "extern" in AkMemoryMgr.h
-// and MUST be defined by the game developer.
-namespace AK
+AudioEngine::AudioEngine() : backend(NULL), droppedCommands(0), nextHandle(1), audioThreadRunning(false),
+	renderInterval(10000), termed(false), rtpcThreshold(0), positionThreshold(0),
+	requestedUpdates(0), coalescedUpdates(0), listenerX(0), listenerY(0), proximityWeight(0.001f),
+	governedEvents(0), mergedEvents(0)
 {
-#ifdef WIN32
-	void * AllocHook(size_t in_size)
+	for (int i = 0; i < AUDIO_MAX_HANDLES; ++i)
 	{
-		return malloc(in_size);
+		playingSlots[i].handle = AUDIO_INVALID_HANDLE;
+		playingSlots[i].playingID = AK_INVALID_PLAYING_ID;
+		playingSlots[i].liveGenerations = 0;
 	}
-	void FreeHook(void * in_ptr)
+	for (int i = 0; i < (int)AudioCommandType::COUNT; ++i)
 	{
-		free(in_ptr);
+		backendCalls[i] = 0;
+		backendTime[i] = 0;
 	}
-	// Note: VirtualAllocHook() may be used by I/O pools of the default implementation
-	// of the Stream Manager, to allow "true" unbuffered I/O (using FILE_FLAG_NO_BUFFERING
-	// - refer to the Windows SDK documentation for more details). This is NOT mandatory;
-	// you may implement it with a simple malloc().
-	void * VirtualAllocHook(
-		void * in_pMemAddress,
-		size_t in_size,
-		DWORD in_dwAllocationType,
-		DWORD in_dwProtect
-		)
+}
+
+bool AudioEngine::Init(AudioBackend *newBackend)
+{
+	AllocationScope audioAllocations(AllocTag::AUDIO);
+	backend = newBackend;
+	if (backend == NULL)
 	{
-		return VirtualAlloc(in_pMemAddress, in_size, in_dwAllocationType, in_dwProtect);
+#ifdef AUDIO_HAS_WWISE
+		backend = new WwiseAudioBackend();
+#else
+		backend = new NullAudioBackend();
+#endif
 	}
-	void VirtualFreeHook(
-		void * in_pMemAddress,
-		size_t in_size,
-		DWORD in_dwFreeType
-		)
+
+	if (!backend->Init())
 	{
-		VirtualFree(in_pMemAddress, in_size, in_dwFreeType);
+		assert(!"Could not initialize the audio backend.");
+		return false;
 	}
-#endif
+
+	//from here on the game only queues commands, the audio thread does the work
+	StartAudioThread(renderInterval);
+
+	return true;
 }
 
-bool AudioEngine::Init()
+void AudioEngine::StartAudioThread(std::chrono::microseconds interval)
 {
-	//
-	// Create and initialize an instance of the default memory manager. Note
-	// that you can override the default memory manager with your own. Refer
-	// to the SDK documentation for more information.
-	//
+	if (audioThreadRunning) return;
 
-	AkMemSettings memSettings;
-	memSettings.uMaxNumPools = 20;
+	renderInterval = interval;
+	audioThreadRunning = true;
+	audioThread = std::thread(&AudioEngine::AudioThreadLoop, this);
+}
+
+void AudioEngine::StopAudioThread()
+{
+	if (!audioThreadRunning) return;
 
-	if (AK::MemoryMgr::Init(&memSettings) != AK_Success)
+	audioThreadRunning = false;
+	if (audioThread.joinable()) audioThread.join();
+}
+
+void AudioEngine::AudioThreadLoop()
+{
+	//everything this thread allocates is the sound engine's
+	AllocationScope audioAllocations(AllocTag::AUDIO);
+	while (audioThreadRunning)
 	{
-		assert(!"Could not create the memory manager.");
-		return false;
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+		ProcessCommands();
+		// Process bank requests, events, positions, RTPC, etc.
+		backend->RenderAudio();
+
+		std::this_thread::sleep_until(frameStart + renderInterval);
 	}
 
-	//
-	// Create and initialize an instance of the default streaming manager. Note
-	// that you can override the default streaming manager with your own. Refer
-	// to the SDK documentation for more information.
-	//
+	//flush whatever was queued while we were shutting down
+	ProcessCommands();
+	backend->RenderAudio();
+}
 
-	AkStreamMgrSettings stmSettings;
-	AK::StreamMgr::GetDefaultSettings(stmSettings);
+void AudioEngine::ProcessAudio()
+{
+	//the audio thread owns the consumer end of the queue while it runs
+	if (audioThreadRunning) return;
 
-	// Customize the Stream Manager settings here.
+	ProcessCommands();
+	// Process bank requests, events, positions, RTPC, etc.
+	backend->RenderAudio();
+}
+
+void AudioEngine::ProcessCommands()
+{
+	AudioCommand command;
+	while (commandQueue.Pop(command))
+	{
+		ExecuteCommand(command);
+	}
+}
 
-	if (!AK::StreamMgr::Create(stmSettings))
+bool AudioEngine::QueueCommand(const AudioCommand &command)
+{
+	if (!commandQueue.Push(command))
 	{
-		assert(!"Could not create the Streaming Manager");
+		//never block the game thread, just drop the command and count it
+		droppedCommands++;
 		return false;
 	}
+	return true;
+}
 
-	//
-	// Create a streaming device with blocking low-level I/O handshaking.
-	// Note that you can override the default low-level I/O module with your own. Refer
-	// to the SDK documentation for more information.        
-	//
-	AkDeviceSettings deviceSettings;
-	AK::StreamMgr::GetDefaultDeviceSettings(deviceSettings);
+AkPlayingID AudioEngine::ResolveHandle(AudioHandle handle)
+{
+	PlayingSlot &slot = playingSlots[handle & (AUDIO_MAX_HANDLES - 1)];
+	if (slot.handle.load(std::memory_order_acquire) != handle) return AK_INVALID_PLAYING_ID;
+	return slot.playingID.load(std::memory_order_relaxed);
+}
 
-	// Customize the streaming device settings here.
+void AudioEngine::StoreHandle(AudioHandle handle, AkPlayingID playingID)
+{
+	PlayingSlot &slot = playingSlots[handle & (AUDIO_MAX_HANDLES - 1)];
+	AudioHandle previous = slot.handle.load(std::memory_order_relaxed);
+	AkUInt32 generation = handle / AUDIO_MAX_HANDLES;
 
-	// CAkFilePackageLowLevelIOBlocking::Init() creates a streaming device
-	// in the Stream Manager, and registers itself as the File Location Resolver.
-	if (g_lowLevelIO.Init(deviceSettings) != AK_Success)
+	if (previous == AUDIO_INVALID_HANDLE) slot.liveGenerations = 0;
+	else
 	{
-		assert(!"Could not create the streaming device and Low-Level I/O system");
-		return false;
+		//handles between the previous one and this one never reached the slot (merged away
+		//by the governor, or their PLAY was dropped), so they never played
+		AkUInt32 skipped = (handle - previous) / AUDIO_MAX_HANDLES;
+		if (skipped >= AUDIO_HANDLE_GENERATIONS) slot.liveGenerations = 0;
+		for (AkUInt32 i = 1; i < skipped && i < AUDIO_HANDLE_GENERATIONS; ++i)
+		{
+			slot.liveGenerations &= ~(1ull << ((generation - i) % AUDIO_HANDLE_GENERATIONS));
+		}
 	}
 
-	//
-	// Create the Sound Engine
-	// Using default initialization parameters
-	//
+	AkUInt64 bit = 1ull << (generation % AUDIO_HANDLE_GENERATIONS);
+	if (playingID != AK_INVALID_PLAYING_ID) slot.liveGenerations |= bit;
+	else slot.liveGenerations &= ~bit;
 
-	AkInitSettings initSettings;
-	AkPlatformInitSettings platformInitSettings;
-	AK::SoundEngine::GetDefaultInitSettings(initSettings);
-	AK::SoundEngine::GetDefaultPlatformInitSettings(platformInitSettings);
+	slot.playingID.store(playingID, std::memory_order_relaxed);
+	slot.handle.store(handle, std::memory_order_release);
+}
 
-	if (AK::SoundEngine::Init(&initSettings, &platformInitSettings) != AK_Success)
+bool AudioEngine::ResolveAction(AudioHandle handle, AkPlayingID &playingID)
+{
+	//an invalid handle acts on every instance of the event, like an invalid playing ID does
+	playingID = AK_INVALID_PLAYING_ID;
+	if (handle == AUDIO_INVALID_HANDLE) return true;
+
+	PlayingSlot &slot = playingSlots[handle & (AUDIO_MAX_HANDLES - 1)];
+	AudioHandle current = slot.handle.load(std::memory_order_relaxed);
+	if (current == handle)
 	{
-		assert(!"Could not initialize the Sound Engine.");
-		return false;
+		playingID = slot.playingID.load(std::memory_order_relaxed);
+		return playingID != AK_INVALID_PLAYING_ID;
 	}
 
-	//NEXT SECTION ONLY NEEDED IF USING INTERACTIVE MUSIC
+	//newer than what's in the slot, or never stored at all: it never played
+	if (current == AUDIO_INVALID_HANDLE || (AkInt32)(current - handle) < 0) return false;
 
-	//
-	// Initialize the music engine
-	// Using default initialization parameters
-	//
+	//replaced since, its playing ID is gone. If it played and isn't so old it must be over
+	//(music lasts far longer than the handles after it), act on the event on the game object
+	AkUInt32 age = (current - handle) / AUDIO_MAX_HANDLES;
+	if (age >= AUDIO_HANDLE_GENERATIONS) return false;
+	return (slot.liveGenerations >> ((handle / AUDIO_MAX_HANDLES) % AUDIO_HANDLE_GENERATIONS)) & 1;
+}
+
+void AudioEngine::ExecuteCommand(const AudioCommand &command)
+{
+	AkPlayingID playingID = AK_INVALID_PLAYING_ID;
+	if (command.type == AudioCommandType::STOP || command.type == AudioCommandType::PAUSE
+		|| command.type == AudioCommandType::RESUME)
+	{
+		if (!ResolveAction(command.handle, playingID)) return;
+	}
 
-	AkMusicSettings musicInit;
-	AK::MusicEngine::GetDefaultInitSettings(musicInit);
+	//only the call into the backend is timed, so this is the cost of the audio call itself
+	std::chrono::steady_clock::time_point callStart = std::chrono::steady_clock::now();
 
-	if (AK::MusicEngine::Init(&musicInit) != AK_Success)
+	switch (command.type)
 	{
-		assert(!"Could not initialize the Music Engine.");
-		return false;
+	case AudioCommandType::PLAY:
+		playingID = backend->PostEvent(command.id, command.gameObjectID);
+		break;
+
+	case AudioCommandType::SET_RTPC:
+		backend->SetRTPCValue(command.id, command.value, command.gameObjectID);
+		break;
+
+	case AudioCommandType::SET_POSITION:
+		backend->SetPosition(command.gameObjectID, command.value, command.y);
+		break;
+
+	case AudioCommandType::REGISTER:
+		backend->RegisterGameObject(command.gameObjectID);
+		break;
+
+	case AudioCommandType::STOP:
+	case AudioCommandType::PAUSE:
+	case AudioCommandType::RESUME:
+		backend->ExecuteActionOnEvent(command.type, command.id, command.gameObjectID,
+			command.transitionDuration, playingID);
+		break;
+
+	default:
+		return;
 	}
 
-#ifndef AK_OPTIMIZED
-	//
-	// Initialize communications (not in release build!)
-	//
-	AkCommSettings commSettings;
-	AK::Comm::GetDefaultInitSettings(commSettings);
-	if (AK::Comm::Init(commSettings) != AK_Success)
+	backendCalls[(int)command.type]++;
+	backendTime[(int)command.type] += std::chrono::duration<double>(std::chrono::steady_clock::now() - callStart).count();
+
+	if (command.type == AudioCommandType::PLAY) StoreHandle(command.handle, playingID);
+}
+
+void AudioEngine::TermSoundEngine()
+{
+	if (termed) return;
+	termed = true;
+
+	StopAudioThread();
+
+	oLog(Level::Info) << "Audio: " << requestedUpdates << " RTPC/position updates, "
+		<< coalescedUpdates << " coalesced away, " << governedEvents << " governed events, "
+		<< mergedEvents << " merged, " << droppedCommands << " commands dropped";
+	for (int i = 0; i < (int)AudioCommandType::COUNT; ++i)
 	{
-		assert(!"Could not initialize communication.");
-		return false;
+		if (backendCalls[i] == 0) continue;
+		oLog(Level::Info) << "\t" << AudioCommandNames[i] << ": " << backendCalls[i] << " backend calls, "
+			<< GetAverageBackendCost((AudioCommandType)i) * 1000000.0 << " us per call";
 	}
-#endif // AK_OPTIMIZED
 
-	return true;
+	if (backend != NULL)
+	{
+		backend->Term();
+		delete backend;
+		backend = NULL;
+	}
 }
 
-void AudioEngine::ProcessAudio()
+void AudioEngine::SetBasePath(std::string path)
 {
-	// Process bank requests, events, positions, RTPC, etc.
-	AK::SoundEngine::RenderAudio();
+	backend->SetBasePath(path);
 }
 
-void AudioEngine::TermSoundEngine()
+void AudioEngine::SetArchive(const AssetArchive *archive)
+{
+	backend->SetArchive(archive);
+}
+
+bool AudioEngine::LoadBank(std::string bank)
+{
+	return backend->LoadBank(bank);
+}
+
+AudioBankRequest AudioEngine::LoadBankAsync(std::string bank)
+{
+	BankLoad *load = new BankLoad;
+	load->name = bank;
+	load->state = AudioBankState::LOADING;
+	load->requested = std::chrono::steady_clock::now();
+	load->loadTime = 0;
+	bankLoads.push_back(std::unique_ptr<BankLoad>(load));
+
+	if (!backend->LoadBankAsync(bank, OnBankLoaded, load))
+	{
+		oLog(Level::Warning) << "Audio: could not queue bank " << bank;
+		load->state = AudioBankState::FAILED;
+	}
+
+	return (AudioBankRequest)bankLoads.size();
+}
+
+void AudioEngine::OnBankLoaded(bool loaded, void *cookie)
+{
+	//called from the sound engine's bank thread, or from inside LoadBankAsync()
+	BankLoad *load = (BankLoad *)cookie;
+	load->loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - load->requested).count();
+	load->state.store(loaded ? AudioBankState::LOADED : AudioBankState::FAILED, std::memory_order_release);
+}
+
+AudioBankState AudioEngine::GetBankState(AudioBankRequest request)
+{
+	if (request == AUDIO_INVALID_BANK_REQUEST || request > bankLoads.size()) return AudioBankState::FAILED;
+	return bankLoads[request - 1]->state.load(std::memory_order_acquire);
+}
+
+double AudioEngine::GetBankLoadTime(AudioBankRequest request)
+{
+	if (GetBankState(request) == AudioBankState::LOADING) return 0;
+	if (request == AUDIO_INVALID_BANK_REQUEST || request > bankLoads.size()) return 0;
+	return bankLoads[request - 1]->loadTime;
+}
+
+AudioHandle AudioEngine::NextHandle()
 {
-#ifndef AK_OPTIMIZED
-	//
-	// Terminate Communication Services
-	//
-	AK::Comm::Term();
-#endif // AK_OPTIMIZED
+	AudioHandle handle = nextHandle++;
+	if (nextHandle == AUDIO_INVALID_HANDLE) nextHandle++;
+	return handle;
+}
 
-	//
-	// Terminate the music engine
-	//
+bool AudioEngine::PostPlay(AkUniqueID eventID, AkGameObjectID gameObjectID, AudioHandle handle)
+{
+	//the event should hear the RTPCs and position set just before it
+	FlushObjectUpdates(gameObjectID);
+
+	AudioCommand command;
+	command.type = AudioCommandType::PLAY;
+	command.id = eventID;
+	command.gameObjectID = gameObjectID;
+	command.handle = handle;
+	command.transitionDuration = 0;
+	command.value = 0;
+	command.y = 0;
+	return QueueCommand(command);
+}
 
-	AK::MusicEngine::Term();
+AudioHandle AudioEngine::PlayEvent(AkUniqueID eventID, AkGameObjectID gameObj)
+{
+	AudioHandle handle = NextHandle();
+	if (!PostPlay(eventID, gameObj, handle)) return AUDIO_INVALID_HANDLE;
+	return handle;
+}
 
-	//
-	// Terminate the sound engine
-	//
+AudioHandle AudioEngine::PlayEvent(AkUniqueID eventID, AkGameObjectID gameObj, float priority, float x, float y)
+{
+	std::unordered_map<AkUniqueID, EventBudget>::iterator it = eventBudgets.find(eventID);
+	if (it == eventBudgets.end()) return PlayEvent(eventID, gameObj);
 
-	AK::SoundEngine::Term();
+	governedEvents++;
 
-	// Terminate the streaming device and streaming manager
+	GovernedEvent event;
+	event.handle = NextHandle();
+	event.gameObjectID = gameObj;
+	event.priority = priority;
+	event.x = x;
+	event.y = y;
+	event.score = 0;
+	it->second.events.push_back(event);
 
-	// CAkFilePackageLowLevelIOBlocking::Term() destroys its associated streaming device 
-	// that lives in the Stream Manager, and unregisters itself as the File Location Resolver.
-	g_lowLevelIO.Term();
+	return event.handle;
+}
 
-	if (AK::IAkStreamMgr::Get())
-		AK::IAkStreamMgr::Get()->Destroy();
+void AudioEngine::StopEvent(AkUniqueID eventID, AkGameObjectID gameObjectID,
+	AudioHandle handle, AkTimeMs transitionDuration)
+{
+	FlushObjectUpdates(gameObjectID);
+
+	AudioCommand command;
+	command.type = AudioCommandType::STOP;
+	command.id = eventID;
+	command.gameObjectID = gameObjectID;
+	command.handle = handle;
+	command.transitionDuration = transitionDuration;
+	command.value = 0;
+	command.y = 0;
+	QueueCommand(command);
+}
 
-	// Terminate the Memory Manager
-	AK::MemoryMgr::Term();
+void AudioEngine::PauseEvent(AkUniqueID eventID, AkGameObjectID gameObjectID,
+	AudioHandle handle, AkTimeMs transitionDuration)
+{
+	FlushObjectUpdates(gameObjectID);
+
+	AudioCommand command;
+	command.type = AudioCommandType::PAUSE;
+	command.id = eventID;
+	command.gameObjectID = gameObjectID;
+	command.handle = handle;
+	command.transitionDuration = transitionDuration;
+	command.value = 0;
+	command.y = 0;
+	QueueCommand(command);
 }
 
+void AudioEngine::ResumeEvent(AkUniqueID eventID, AkGameObjectID gameObjectID,
+	AudioHandle handle, AkTimeMs transitionDuration)
+{
+	FlushObjectUpdates(gameObjectID);
+
+	AudioCommand command;
+	command.type = AudioCommandType::RESUME;
+	command.id = eventID;
+	command.gameObjectID = gameObjectID;
+	command.handle = handle;
+	command.transitionDuration = transitionDuration;
+	command.value = 0;
+	command.y = 0;
+	QueueCommand(command);
+}
 
-//conversion for strings to wide chars
-inline std::wstring convert(const std::string& as)
+void AudioEngine::SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID)
 {
-	wchar_t* buf = new wchar_t[as.size() * 2 + 2];
-	swprintf(buf, as.size() * 2 + 2, L"%S", as.c_str());
-	std::wstring rval = buf;
-	delete[] buf;
-	return rval;
+	requestedUpdates++;
+
+	//new entries come out zeroed, with nothing pending or sent
+	PendingObjectUpdates &updates = pendingUpdates[gameObjectID];
+	updates.anyPending = true;
+
+	for (PendingRTPC &rtpc : updates.rtpcs)
+	{
+		if (rtpc.rtpcID != rtpcID) continue;
+
+		//an update nobody got to hear yet is replaced
+		if (rtpc.pending) coalescedUpdates++;
+		rtpc.value = value;
+		rtpc.pending = true;
+		return;
+	}
+
+	PendingRTPC rtpc;
+	rtpc.rtpcID = rtpcID;
+	rtpc.value = value;
+	rtpc.lastSent = 0;
+	rtpc.pending = true;
+	rtpc.sent = false;
+	updates.rtpcs.push_back(rtpc);
 }
 
-void AudioEngine::SetBasePath(std::string path)
+void AudioEngine::SetPosition(AkGameObjectID gameObjectID, float x, float y)
 {
-	g_lowLevelIO.SetBasePath(convert(path).c_str());
-	AK::StreamMgr::SetCurrentLanguage(AKTEXT("English(US)"));
+	requestedUpdates++;
+
+	PendingObjectUpdates &updates = pendingUpdates[gameObjectID];
+
+	if (updates.positionPending) coalescedUpdates++;
+	updates.x = x;
+	updates.y = y;
+	updates.positionPending = true;
+	updates.anyPending = true;
 }
 
-bool AudioEngine::LoadBank(std::string bank)
+void AudioEngine::FlushObjectUpdates(AkGameObjectID gameObjectID, PendingObjectUpdates &updates)
 {
-	AkBankID bankID; // Not used. These banks can be unloaded with their file name.
-	AKRESULT eResult = AK::SoundEngine::LoadBank(convert(bank).c_str(), AK_DEFAULT_POOL_ID, bankID);
-	assert(eResult == AK_Success);
-	return(eResult == AK_Success);
+	if (!updates.anyPending) return;
+	updates.anyPending = false;
+
+	AudioCommand command;
+	command.gameObjectID = gameObjectID;
+	command.handle = AUDIO_INVALID_HANDLE;
+	command.transitionDuration = 0;
+
+	for (PendingRTPC &rtpc : updates.rtpcs)
+	{
+		if (!rtpc.pending) continue;
+		rtpc.pending = false;
+
+		if (rtpc.sent && std::fabs(rtpc.value - rtpc.lastSent) <= rtpcThreshold)
+		{
+			coalescedUpdates++;
+			continue;
+		}
+
+		command.type = AudioCommandType::SET_RTPC;
+		command.id = rtpc.rtpcID;
+		command.value = rtpc.value;
+		command.y = 0;
+		//only remember what actually made it into the queue
+		if (QueueCommand(command))
+		{
+			rtpc.lastSent = rtpc.value;
+			rtpc.sent = true;
+		}
+	}
+
+	if (updates.positionPending)
+	{
+		updates.positionPending = false;
+
+		if (updates.positionSent && std::fabs(updates.x - updates.lastSentX) <= positionThreshold
+			&& std::fabs(updates.y - updates.lastSentY) <= positionThreshold)
+		{
+			coalescedUpdates++;
+		}
+		else
+		{
+			command.type = AudioCommandType::SET_POSITION;
+			command.id = AK_INVALID_UNIQUE_ID;
+			command.value = updates.x;
+			command.y = updates.y;
+			if (QueueCommand(command))
+			{
+				updates.lastSentX = updates.x;
+				updates.lastSentY = updates.y;
+				updates.positionSent = true;
+			}
+		}
+	}
 }
 
-AkPlayingID AudioEngine::PlayEvent(std::string eventName, AkGameObjectID gameObj)
+void AudioEngine::FlushObjectUpdates(AkGameObjectID gameObjectID)
 {
-	AkPlayingID playingID = AK::SoundEngine::PostEvent(
-		convert(eventName).c_str(),                   // Name of the event (not case sensitive).
-		gameObj                             // Associated game object ID
-		);
+	std::unordered_map<AkGameObjectID, PendingObjectUpdates>::iterator it = pendingUpdates.find(gameObjectID);
+	if (it != pendingUpdates.end()) FlushObjectUpdates(gameObjectID, it->second);
+}
+
+void AudioEngine::FlushUpdates()
+{
+	for (std::pair<const AkGameObjectID, PendingObjectUpdates> &updates : pendingUpdates)
+	{
+		FlushObjectUpdates(updates.first, updates.second);
+	}
 
-	return playingID;
+	FlushGovernedEvents();
 }
 
-void AudioEngine::StopEvent(std::string eventName, AkGameObjectID gameObjectID,
-	AkPlayingID playingID, AkTimeMs transitionDuration)
+void AudioEngine::PostGovernedEvent(AkUniqueID eventID, EventBudget &budget, const GovernedEvent &event,
+	AkUInt32 eventCount)
 {
-	AK::SoundEngine::ExecuteActionOnEvent(convert(eventName).c_str(),
-		AK::SoundEngine::AkActionOnEventType::AkActionOnEventType_Stop,
-		gameObjectID, transitionDuration, AkCurveInterpolation_Linear,
-		playingID);
+	//goes through the pending updates so the coalescing keeps track of what was sent,
+	//and repeats of the same merge count or X get filtered out
+	if (budget.panRTPC != AK_INVALID_UNIQUE_ID) SetRTPCValue(budget.panRTPC, event.x, event.gameObjectID);
+	if (budget.mergeRTPC != AK_INVALID_UNIQUE_ID)
+	{
+		SetRTPCValue(budget.mergeRTPC, (AkRtpcValue)eventCount, event.gameObjectID);
+	}
+	//the handle was handed out already, if the PLAY is dropped it never reaches its slot
+	//and stopping it does nothing, like a merged-away one
+	PostPlay(eventID, event.gameObjectID, event.handle);
 }
 
-void AudioEngine::PauseEvent(std::string eventName, AkGameObjectID gameObjectID,
-	AkPlayingID playingID, AkTimeMs transitionDuration)
+void AudioEngine::FlushGovernedEvents()
 {
-	AK::SoundEngine::ExecuteActionOnEvent(convert(eventName).c_str(),
-		AK::SoundEngine::AkActionOnEventType::AkActionOnEventType_Pause,
-		gameObjectID, transitionDuration, AkCurveInterpolation_Linear,
-		playingID);
+	for (std::pair<const AkUniqueID, EventBudget> &entry : eventBudgets)
+	{
+		EventBudget &budget = entry.second;
+		std::vector<GovernedEvent> &events = budget.events;
+		if (events.empty()) continue;
+
+		if (events.size() <= budget.maxPerFrame)
+		{
+			for (const GovernedEvent &event : events) PostGovernedEvent(entry.first, budget, event, 1);
+			events.clear();
+			continue;
+		}
+
+		for (GovernedEvent &event : events)
+		{
+			float dx = event.x - listenerX;
+			float dy = event.y - listenerY;
+			event.score = event.priority - proximityWeight * std::sqrt(dx * dx + dy * dy);
+		}
+
+		//best maxPerFrame events first, the order among them doesn't matter
+		std::nth_element(events.begin(), events.begin() + budget.maxPerFrame, events.end(),
+			[](const GovernedEvent &a, const GovernedEvent &b) { return a.score > b.score; });
+
+		for (AkUInt32 i = 0; i < budget.maxPerFrame; ++i) PostGovernedEvent(entry.first, budget, events[i], 1);
+
+		//everything else plays once, from the middle of where it happened, and keeps
+		//the handle of the best of the bunch, which nth_element left right after the kept ones
+		GovernedEvent merged = events[budget.maxPerFrame];
+		float sumX = 0, sumY = 0;
+		for (size_t i = budget.maxPerFrame; i < events.size(); ++i)
+		{
+			sumX += events[i].x;
+			sumY += events[i].y;
+		}
+		AkUInt32 mergedCount = (AkUInt32)(events.size() - budget.maxPerFrame);
+		merged.x = sumX / mergedCount;
+		merged.y = sumY / mergedCount;
+		mergedEvents += mergedCount;
+
+		PostGovernedEvent(entry.first, budget, merged, mergedCount);
+
+		//keeps its capacity, so busy frames don't allocate
+		events.clear();
+	}
 }
 
-void AudioEngine::ResumeEvent(std::string eventName, AkGameObjectID gameObjectID,
-	AkPlayingID playingID, AkTimeMs transitionDuration)
+void AudioEngine::SetEventBudget(AkUniqueID eventID, AkUInt32 maxPerFrame, AkRtpcID panRTPC, AkRtpcID mergeRTPC)
 {
-	AK::SoundEngine::ExecuteActionOnEvent(convert(eventName).c_str(),
-		AK::SoundEngine::AkActionOnEventType::AkActionOnEventType_Resume,
-		gameObjectID, transitionDuration, AkCurveInterpolation_Linear,
-		playingID);
+	assert(maxPerFrame > 0);
+
+	EventBudget &budget = eventBudgets[eventID];
+	budget.maxPerFrame = maxPerFrame;
+	budget.panRTPC = panRTPC;
+	budget.mergeRTPC = mergeRTPC;
+}
+
+void AudioEngine::SetListenerPosition(float x, float y)
+{
+	listenerX = x;
+	listenerY = y;
+}
+
+void AudioEngine::SetProximityWeight(float weight)
+{
+	proximityWeight = weight;
+}
+
+AkUInt32 AudioEngine::GetGovernedEvents()
+{
+	return governedEvents;
+}
+
+AkUInt32 AudioEngine::GetMergedEvents()
+{
+	return mergedEvents;
+}
+
+void AudioEngine::SetRTPCThreshold(float threshold)
+{
+	rtpcThreshold = threshold;
+}
+
+void AudioEngine::SetPositionThreshold(float threshold)
+{
+	positionThreshold = threshold;
+}
+
+AkUInt32 AudioEngine::GetRequestedUpdates()
+{
+	return requestedUpdates;
+}
+
+AkUInt32 AudioEngine::GetCoalescedUpdates()
+{
+	return coalescedUpdates;
+}
+
+AudioHandle AudioEngine::PlayEvent(std::string_view eventName, AkGameObjectID gameObj)
+{
+	return PlayEvent(AudioHash::HashName(eventName), gameObj);
+}
+
+void AudioEngine::StopEvent(std::string_view eventName, AkGameObjectID gameObjectID,
+	AudioHandle handle, AkTimeMs transitionDuration)
+{
+	StopEvent(AudioHash::HashName(eventName), gameObjectID, handle, transitionDuration);
+}
+
+void AudioEngine::PauseEvent(std::string_view eventName, AkGameObjectID gameObjectID,
+	AudioHandle handle, AkTimeMs transitionDuration)
+{
+	PauseEvent(AudioHash::HashName(eventName), gameObjectID, handle, transitionDuration);
+}
+
+void AudioEngine::ResumeEvent(std::string_view eventName, AkGameObjectID gameObjectID,
+	AudioHandle handle, AkTimeMs transitionDuration)
+{
+	ResumeEvent(AudioHash::HashName(eventName), gameObjectID, handle, transitionDuration);
+}
+
+void AudioEngine::SetRTPCValue(std::string_view rtpcName, AkRtpcValue value, AkGameObjectID gameObjectID)
+{
+	SetRTPCValue(AudioHash::HashName(rtpcName), value, gameObjectID);
 }
 
 AudioEngine::~AudioEngine()
@@ -303,7 +670,31 @@ AudioEngine::~AudioEngine()
 
 void AudioEngine::RegisterGameObject(AkGameObjectID gameObjectID)
 {
-	AK::SoundEngine::RegisterGameObj(gameObjectID);
-	AK::SoundEngine::SetDefaultListeners(&gameObjectID, 1);
+	AudioCommand command;
+	command.type = AudioCommandType::REGISTER;
+	command.id = AK_INVALID_UNIQUE_ID;
+	command.gameObjectID = gameObjectID;
+	command.handle = AUDIO_INVALID_HANDLE;
+	command.transitionDuration = 0;
+	command.value = 0;
+	command.y = 0;
+	QueueCommand(command);
+}
+
+double AudioEngine::GetAverageBackendCost(AudioCommandType type)
+{
+	if (backendCalls[(int)type] == 0) return 0;
+	return backendTime[(int)type] / backendCalls[(int)type];
+}
+
+AkPlayingID AudioEngine::GetPlayingID(AudioHandle handle)
+{
+	if (handle == AUDIO_INVALID_HANDLE) return AK_INVALID_PLAYING_ID;
+	return ResolveHandle(handle);
+}
+
+AkUInt32 AudioEngine::GetDroppedCommands()
+{
+	return droppedCommands;
 }
 
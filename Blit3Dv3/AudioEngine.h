@@ -2,74 +2,285 @@
 
 /*
 	Simple Audio Engine class by Darren Reid
-	Wraps Wwise basic functionality.
-
-	version 1.1 for Wwise 2017.2.2.6553
-
-
-	add "C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\include" and
-	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\samples\SoundEngine\Win32"
-	and 
-	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\samples\SoundEngine\Common"
-	to the include directories, and
-	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\Win32_vc140\Release(StaticCRT)\lib"
-	or
-	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\Win32_vc140\Debug(StaticCRT)\lib"
-	to the libs path for 32 bit builds, or the appropriate 64 bit paths for 64 bit builds.
-
-	add the following cpps from the samples to the build:
-	AkDefaultIOHookBlocking.cpp
-	AkDefaultIOHookDeferred.cpp
-	AkDefaultLowLevelIODispatcher.cpp
-	AkFileLocationBase.cpp
-	AkFilePackage.cpp
-	AkFilePackageLUT.cpp
-
-	Make sure "Treat Wchar_t as Built-in Type" is set to Yes (/Zc:wchar_t)
-	*/
+	Wraps basic sound engine functionality.
 
-#ifdef NDEBUG
-#define AK_OPTIMIZED
-#endif
+	The actual sound engine sits behind an AudioBackend: WwiseAudioBackend when the
+	Wwise SDK is available (see WwiseAudioBackend.h for the SDK setup), otherwise
+	NullAudioBackend, which plays nothing but records every call.
+	*/
 
 #include <string>
+#include <string_view>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+#include "SPSCQueue.h"
+#include "AudioTypes.h"
+#include "AudioBackend.h"
+
+
+// Wwise IDs are a 32-bit FNV-1 hash of the lower-cased object name, the same
+// hash AK::SoundEngine::GetIDFromString() computes. Doing it ourselves lets the
+// IDs for known events and RTPCs be worked out at compile time (see AudioIDs.h).
+namespace AudioHash
+{
+	const AkUInt32 FNV_OFFSET_BASIS = 2166136261u;
+	const AkUInt32 FNV_PRIME = 16777619u;
 
-#include <AK/SoundEngine/Common/AkMemoryMgr.h>                  // Memory Manager
-#include <AK/SoundEngine/Common/AkModule.h>                     // Default memory and stream managers
-#include <AK/SoundEngine/Common/IAkStreamMgr.h>                 // Streaming Manager
-#include <AK/Tools/Common/AkPlatformFuncs.h>                    // Thread defines
-#include <AkFilePackageLowLevelIOBlocking.h>                    // Sample low-level I/O implementation
-#include <AK/SoundEngine/Common/AkSoundEngine.h>                // Sound engine
+	constexpr AkUInt32 HashName(const char *name)
+	{
+		AkUInt32 hash = FNV_OFFSET_BASIS;
+		for (; *name != 0; ++name)
+		{
+			char c = *name;
+			if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+			//multiply in 64 bits and truncate, so the compiler doesn't flag constant overflow
+			hash = (AkUInt32)((AkUInt64)hash * FNV_PRIME);
+			hash ^= (AkUInt32)(unsigned char)c;
+		}
+		return hash;
+	}
 
-//only needed if we use interactive music
-#include <AK/MusicEngine/Common/AkMusicEngine.h>                // Music Engine
+	//the same hash of a name that isn't null-terminated
+	constexpr AkUInt32 HashName(std::string_view name)
+	{
+		AkUInt32 hash = FNV_OFFSET_BASIS;
+		for (char c : name)
+		{
+			if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+			hash = (AkUInt32)((AkUInt64)hash * FNV_PRIME);
+			hash ^= (AkUInt32)(unsigned char)c;
+		}
+		return hash;
+	}
+}
 
-// Include for communication between Wwise and the game -- Not needed in the release version
-#ifndef AK_OPTIMIZED
-#include <AK/Comm/AkCommunication.h>
-#endif // AK_OPTIMIZED
+// number of handles whose playing IDs are remembered, must be a power of two
+#define AUDIO_MAX_HANDLES 4096
+// handles that took turns in a slot (AUDIO_MAX_HANDLES apart) whose fate is still known after they were replaced
+#define AUDIO_HANDLE_GENERATIONS 64
+// number of commands that can be waiting for the audio thread, must be a power of two
+#define AUDIO_COMMAND_QUEUE_SIZE 1024
 
+struct AudioCommand
+{
+	AudioCommandType type;
+	AkUniqueID id; //event ID, or RTPC ID for SET_RTPC
+	AkGameObjectID gameObjectID;
+	AudioHandle handle; //handle to fill in for PLAY, handle to act on for STOP/PAUSE/RESUME
+	AkTimeMs transitionDuration;
+	AkRtpcValue value; //RTPC value, or X for SET_POSITION
+	float y; //Y for SET_POSITION
+};
+
+// Where a bank asked for with AudioEngine::LoadBankAsync() is at
+enum class AudioBankState { LOADING = 0, LOADED, FAILED };
+typedef AkUInt32 AudioBankRequest;
+#define AUDIO_INVALID_BANK_REQUEST 0
 
 class AudioEngine
 {
-	// We're using the default Low-Level I/O implementation that's part
-	// of the SDK's sample code, with the file package extension
-	CAkFilePackageLowLevelIOBlocking g_lowLevelIO;
+	// The sound engine we drive, owned by us
+	AudioBackend *backend;
+
+	// Game code is the single producer, the audio thread the single consumer
+	SPSCQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commandQueue;
+	std::atomic<AkUInt32> droppedCommands;
+
+	// Pre-reserved playing ID slots, indexed by handle & (AUDIO_MAX_HANDLES - 1).
+	// Written by the audio thread, the handle stored alongside detects stale lookups.
+	struct PlayingSlot
+	{
+		std::atomic<AudioHandle> handle;
+		std::atomic<AkPlayingID> playingID;
+		// Bit (handle / AUDIO_MAX_HANDLES) % AUDIO_HANDLE_GENERATIONS is set for each of the
+		// slot's recent handles that got a playing ID, so a handle that was replaced while it
+		// may still be playing can be told from one that never played. Audio thread only.
+		AkUInt64 liveGenerations;
+	};
+	PlayingSlot playingSlots[AUDIO_MAX_HANDLES];
+	AudioHandle nextHandle; //only touched by the producer
+
+	std::thread audioThread;
+	std::atomic<bool> audioThreadRunning;
+	std::chrono::microseconds renderInterval;
+	bool termed;
+
+	// RTPC and position updates wait here, per game object, until the frame is flushed
+	// or an event is posted on that object, so only the last value of each gets sent.
+	// Only touched by the game thread.
+	struct PendingRTPC
+	{
+		AkRtpcID rtpcID;
+		AkRtpcValue value;
+		AkRtpcValue lastSent;
+		bool pending;
+		bool sent; //lastSent is valid
+	};
+	struct PendingObjectUpdates
+	{
+		std::vector<PendingRTPC> rtpcs;
+		float x, y;
+		float lastSentX, lastSentY;
+		bool positionPending;
+		bool positionSent;
+		bool anyPending;
+	};
+	std::unordered_map<AkGameObjectID, PendingObjectUpdates> pendingUpdates;
+	float rtpcThreshold;
+	float positionThreshold;
+	AkUInt32 requestedUpdates;
+	AkUInt32 coalescedUpdates;
+
+	// Event governor: events with a budget are collected during the frame and at
+	// FlushUpdates() only the best maxPerFrame of each get posted, the rest are merged
+	// into one extra instance. Only touched by the game thread.
+	struct GovernedEvent
+	{
+		AudioHandle handle;
+		AkGameObjectID gameObjectID;
+		float priority;
+		float x, y;
+		float score; //filled in at flush time
+	};
+	struct EventBudget
+	{
+		AkUInt32 maxPerFrame;
+		AkRtpcID panRTPC; //set to the event's X before it's posted
+		AkRtpcID mergeRTPC; //set to how many events an instance stands for before it's posted
+		std::vector<GovernedEvent> events;
+	};
+	std::unordered_map<AkUniqueID, EventBudget> eventBudgets;
+	float listenerX, listenerY;
+	float proximityWeight;
+	AkUInt32 governedEvents;
+	AkUInt32 mergedEvents;
+
+	// Calls the audio thread made into the backend, and the seconds spent in them, per command type
+	AkUInt64 backendCalls[(int)AudioCommandType::COUNT];
+	double backendTime[(int)AudioCommandType::COUNT];
+
+	// Asynchronous bank loads, request N is bankLoads[N - 1]. Only the game thread adds
+	// to the list, the backend's callback only fills in the load it was given.
+	struct BankLoad
+	{
+		std::string name;
+		std::atomic<AudioBankState> state;
+		std::chrono::steady_clock::time_point requested;
+		double loadTime; //written before state leaves LOADING
+	};
+	std::vector<std::unique_ptr<BankLoad>> bankLoads;
+
+	static void OnBankLoaded(bool loaded, void *cookie);
+	bool QueueCommand(const AudioCommand &command);
+	void ExecuteCommand(const AudioCommand &command);
+	void ProcessCommands();
+	void FlushObjectUpdates(AkGameObjectID gameObjectID, PendingObjectUpdates &updates);
+	void FlushObjectUpdates(AkGameObjectID gameObjectID);
+	AudioHandle NextHandle();
+	bool PostPlay(AkUniqueID eventID, AkGameObjectID gameObjectID, AudioHandle handle);
+	void PostGovernedEvent(AkUniqueID eventID, EventBudget &budget, const GovernedEvent &event, AkUInt32 eventCount);
+	void FlushGovernedEvents();
+	AkPlayingID ResolveHandle(AudioHandle handle);
+	void StoreHandle(AudioHandle handle, AkPlayingID playingID);
+	bool ResolveAction(AudioHandle handle, AkPlayingID &playingID);
+	void AudioThreadLoop();
 public:
-	
+	AudioEngine();
 
-	bool Init();
+	// Pass a backend to use instead of the default one, AudioEngine takes ownership of it.
+	bool Init(AudioBackend *newBackend = NULL);
+	// Starts the thread that drains the command queue and calls RenderAudio().
+	// Init() starts it for you; call StopAudioThread() to drive audio by hand with ProcessAudio().
+	void StartAudioThread(std::chrono::microseconds interval = std::chrono::microseconds(10000));
+	void StopAudioThread();
+	// Drains the command queue and renders on the calling thread.
+	// Does nothing while the audio thread is running.
 	void ProcessAudio();
 	void TermSoundEngine();
 	void SetBasePath(std::string path);
+	// Packed banks are read from here, the archive must stay open until TermSoundEngine()
+	void SetArchive(const AssetArchive *archive);
 	bool LoadBank(std::string bank);
-	AkPlayingID PlayEvent(std::string eventName, AkGameObjectID gameObj);
-	void StopEvent(std::string eventName, AkGameObjectID gameObjectID, 
-		AkPlayingID playingID, AkTimeMs transitionDuration = 0);
-	void PauseEvent(std::string eventName, AkGameObjectID gameObjectID,
-		AkPlayingID playingID, AkTimeMs transitionDuration = 0);
-	void ResumeEvent(std::string eventName, AkGameObjectID gameObjectID,
-		AkPlayingID playingID, AkTimeMs transitionDuration = 0);
+	// Queues the bank and returns straight away, poll GetBankState() to know when it's in.
+	// Banks load one after the other in the order they were asked for.
+	AudioBankRequest LoadBankAsync(std::string bank);
+	AudioBankState GetBankState(AudioBankRequest request);
+	// Seconds from LoadBankAsync() to the bank being loaded or failing, 0 while it's loading
+	double GetBankLoadTime(AudioBankRequest request);
+
+	//ID based calls: no string conversion or hashing, use these on the hot path.
+	//These only queue a command, the audio thread talks to the sound engine.
+	//PlayEvent() returns AUDIO_INVALID_HANDLE if the queue was full and nothing was played.
+	//Stopping, pausing or resuming with AUDIO_INVALID_HANDLE acts on every instance of the
+	//event on the game object, and so does a handle that was replaced in its slot while it
+	//could still be playing. A handle that never played does nothing.
+	AudioHandle PlayEvent(AkUniqueID eventID, AkGameObjectID gameObj);
+	void StopEvent(AkUniqueID eventID, AkGameObjectID gameObjectID,
+		AudioHandle handle, AkTimeMs transitionDuration = 0);
+	void PauseEvent(AkUniqueID eventID, AkGameObjectID gameObjectID,
+		AudioHandle handle, AkTimeMs transitionDuration = 0);
+	void ResumeEvent(AkUniqueID eventID, AkGameObjectID gameObjectID,
+		AudioHandle handle, AkTimeMs transitionDuration = 0);
+	//RTPC and position updates are held back until FlushUpdates(), or until an event
+	//is played/stopped/paused/resumed on the same game object, and only the last one counts
+	void SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID);
+	void SetPosition(AkGameObjectID gameObjectID, float x, float y);
+
+	//Governed play: if the event has a budget (see SetEventBudget()) it is held until
+	//FlushUpdates() and may be merged with others, otherwise it's played straight away.
+	//priority and the position (game units) decide which instances survive a busy frame.
+	//The handle of a merged-away event never resolves, stopping it does nothing.
+	AudioHandle PlayEvent(AkUniqueID eventID, AkGameObjectID gameObj, float priority, float x, float y);
+
+	//by-name wrappers, these just hash the name and forward to the ID versions.
+	//The names are views, so literals and frame arena text are passed without a copy.
+	AudioHandle PlayEvent(std::string_view eventName, AkGameObjectID gameObj);
+	void StopEvent(std::string_view eventName, AkGameObjectID gameObjectID, 
+		AudioHandle handle, AkTimeMs transitionDuration = 0);
+	void PauseEvent(std::string_view eventName, AkGameObjectID gameObjectID,
+		AudioHandle handle, AkTimeMs transitionDuration = 0);
+	void ResumeEvent(std::string_view eventName, AkGameObjectID gameObjectID,
+		AudioHandle handle, AkTimeMs transitionDuration = 0);
+	void SetRTPCValue(std::string_view rtpcName, AkRtpcValue value, AkGameObjectID gameObjectID);
+
 	void RegisterGameObject(AkGameObjectID gameObjectID);
+
+	// Sends the pending RTPC and position updates, call once per frame.
+	void FlushUpdates();
+	// Updates that differ from the last value sent by no more than these are dropped.
+	// The defaults of 0 only drop repeats of the same value.
+	void SetRTPCThreshold(float threshold);
+	void SetPositionThreshold(float threshold);
+	// RTPC and position updates asked for, and how many of those never reached the sound engine
+	AkUInt32 GetRequestedUpdates();
+	AkUInt32 GetCoalescedUpdates();
+
+	// Limits an event to maxPerFrame instances per FlushUpdates(). panRTPC, if given, is set
+	// to each instance's X before it plays; mergeRTPC, if given, is set to the number of
+	// events the instance stands for (1, or how many were merged), map it to volume in
+	// the Wwise project so the merged instance comes out louder.
+	void SetEventBudget(AkUniqueID eventID, AkUInt32 maxPerFrame,
+		AkRtpcID panRTPC = AK_INVALID_UNIQUE_ID, AkRtpcID mergeRTPC = AK_INVALID_UNIQUE_ID);
+	// Where the player is, events closer to it win over farther ones
+	void SetListenerPosition(float x, float y);
+	// Score lost per game unit of distance from the listener, score = priority - weight * distance
+	void SetProximityWeight(float weight);
+	// Governed events asked for, and how many of those were folded into a merged instance
+	AkUInt32 GetGovernedEvents();
+	AkUInt32 GetMergedEvents();
+
+	// The sound engine's playing ID for a handle, or AK_INVALID_PLAYING_ID if the
+	// event hasn't been posted yet, never played or the handle's slot has since been reused.
+	AkPlayingID GetPlayingID(AudioHandle handle);
+	// Commands thrown away because the queue was full
+	AkUInt32 GetDroppedCommands();
+	// Seconds per call into the backend for a command type, timed around the call on the
+	// audio thread. Read it once the audio thread has stopped, TermSoundEngine() logs them all.
+	double GetAverageBackendCost(AudioCommandType type);
 	~AudioEngine();
 };
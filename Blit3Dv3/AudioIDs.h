@@ -0,0 +1,33 @@
+#pragma once
+
+/*
+	Event and game parameter IDs for the banks in Media\Music.
+	Laid out like the Wwise_IDs.h header Wwise generates, but the values are
+	hashed from the names at compile time, so renaming an event in the Wwise
+	project only means changing the string here.
+*/
+
+#include "AudioEngine.h"
+
+namespace AudioIDs
+{
+	namespace EVENTS
+	{
+		constexpr AkUniqueID TITLEMUSIC = AudioHash::HashName("TitleMusic");
+		constexpr AkUniqueID GAMEMUSIC = AudioHash::HashName("GameMusic");
+		constexpr AkUniqueID THRUST = AudioHash::HashName("Thrust");
+		constexpr AkUniqueID PAUSE = AudioHash::HashName("Pause");
+		constexpr AkUniqueID SHOOT = AudioHash::HashName("Shoot");
+		constexpr AkUniqueID SHIELD = AudioHash::HashName("Shield");
+		constexpr AkUniqueID EXPLOSION = AudioHash::HashName("Explosion");
+		constexpr AkUniqueID COLLISION = AudioHash::HashName("Collision");
+		constexpr AkUniqueID BIGASTEROID = AudioHash::HashName("BigAsteroid");
+		constexpr AkUniqueID MEDIUMASTEROID = AudioHash::HashName("MediumAsteroid");
+		constexpr AkUniqueID SMALLASTEROID = AudioHash::HashName("SmallAsteroid");
+	}
+
+	namespace GAME_PARAMETERS
+	{
+		constexpr AkRtpcID PANNINGX = AudioHash::HashName("PanningX");
+	}
+}
@@ -0,0 +1,313 @@
+#include "AudioMemoryPool.h"
+#include "Logger.h"
+
+#include <stdlib.h>
+#include <cassert>
+
+#ifdef _WIN32
+//below needed for VirtualAlloc etc
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+//use the main Blit3D logger
+extern logger oLog;
+
+AudioMemoryPool audioMemory;
+
+#define BLOCK_LIVE 0xA110CA7Eu
+#define BLOCK_FREED 0xF4EEB10Cu
+//start of a slab, ahead of its first block, holds the link to the next slab
+#define SLAB_LINK_SIZE 16
+
+//roughly 1.5x apart, so no more than a third of a block is ever wasted on rounding up
+static const size_t ClassSizes[AUDIO_MEMORY_NUM_CLASSES] = { 16, 32, 48, 64, 96, 128, 192, 256,
+	384, 512, 768, 1024, 1536, 2048, 3072, AUDIO_MEMORY_MAX_POOLED_SIZE };
+
+AudioMemoryPool::AudioMemoryPool() : liveBytes(0), peakLiveBytes(0), reservedBytes(0), peakReservedBytes(0),
+	budget(AUDIO_MEMORY_BUDGET), largeAllocs(0), liveLargeBytes(0), livePageBytes(0), failedAllocs(0)
+{
+	static_assert(sizeof(BlockHeader) == 16, "Blocks must keep malloc()'s alignment");
+
+	for (int i = 0; i < AUDIO_MEMORY_NUM_CLASSES; ++i)
+	{
+		SizeClass &sizeClass = classes[i];
+		sizeClass.blockSize = ClassSizes[i];
+		sizeClass.freeList = NULL;
+		sizeClass.slabs = NULL;
+		sizeClass.stats.blockSize = ClassSizes[i];
+		sizeClass.stats.allocs = 0;
+		sizeClass.stats.frees = 0;
+		sizeClass.stats.liveBlocks = 0;
+		sizeClass.stats.peakLiveBlocks = 0;
+		sizeClass.stats.slabs = 0;
+	}
+
+	//smallest class that fits each multiple of 16 bytes
+	int sizeClass = 0;
+	for (size_t i = 0; i <= AUDIO_MEMORY_MAX_POOLED_SIZE / 16; ++i)
+	{
+		while (ClassSizes[sizeClass] < i * 16) sizeClass++;
+		classLookup[i] = (unsigned char)sizeClass;
+	}
+}
+
+AudioMemoryPool::~AudioMemoryPool()
+{
+	for (int i = 0; i < AUDIO_MEMORY_NUM_CLASSES; ++i)
+	{
+		void *slab = classes[i].slabs;
+		while (slab != NULL)
+		{
+			void *next = *(void **)slab;
+			free(slab);
+			slab = next;
+		}
+		classes[i].slabs = NULL;
+		classes[i].freeList = NULL;
+	}
+}
+
+int AudioMemoryPool::ClassOf(size_t size)
+{
+	if (size > AUDIO_MEMORY_MAX_POOLED_SIZE) return AUDIO_MEMORY_NUM_CLASSES;
+	return classLookup[(size + 15) / 16];
+}
+
+void AudioMemoryPool::RaisePeak(std::atomic<size_t> &peak, size_t value)
+{
+	size_t current = peak.load(std::memory_order_relaxed);
+	while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
+
+bool AudioMemoryPool::Reserve(size_t bytes)
+{
+	size_t limit = budget.load(std::memory_order_relaxed);
+	size_t current = reservedBytes.load(std::memory_order_relaxed);
+	do
+	{
+		if (limit != 0 && current + bytes > limit) return false;
+	} while (!reservedBytes.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+
+	RaisePeak(peakReservedBytes, current + bytes);
+	return true;
+}
+
+void AudioMemoryPool::Unreserve(size_t bytes)
+{
+	reservedBytes -= bytes;
+}
+
+bool AudioMemoryPool::AddSlab(SizeClass &sizeClass)
+{
+	//called with the size class locked
+	if (!Reserve(AUDIO_MEMORY_SLAB_SIZE)) return false;
+
+	char *slab = (char *)malloc(AUDIO_MEMORY_SLAB_SIZE);
+	if (slab == NULL)
+	{
+		Unreserve(AUDIO_MEMORY_SLAB_SIZE);
+		return false;
+	}
+
+	*(void **)slab = sizeClass.slabs;
+	sizeClass.slabs = slab;
+	sizeClass.stats.slabs++;
+
+	//chain the new blocks in address order
+	size_t stride = sizeof(BlockHeader) + sizeClass.blockSize;
+	size_t blockCount = (AUDIO_MEMORY_SLAB_SIZE - SLAB_LINK_SIZE) / stride;
+	BlockHeader *next = sizeClass.freeList;
+	for (size_t i = blockCount; i > 0; --i)
+	{
+		BlockHeader *block = (BlockHeader *)(slab + SLAB_LINK_SIZE + (i - 1) * stride);
+		block->magic = BLOCK_FREED;
+		*(BlockHeader **)(block + 1) = next;
+		next = block;
+	}
+	sizeClass.freeList = next;
+	return true;
+}
+
+void *AudioMemoryPool::Alloc(size_t size)
+{
+	int index = ClassOf(size);
+	BlockHeader *header;
+
+	if (index < AUDIO_MEMORY_NUM_CLASSES)
+	{
+		SizeClass &sizeClass = classes[index];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+
+		if (sizeClass.freeList == NULL && !AddSlab(sizeClass))
+		{
+			failedAllocs++;
+			return NULL;
+		}
+
+		header = sizeClass.freeList;
+		assert(header->magic == BLOCK_FREED && "Audio memory pool free list is corrupt");
+		sizeClass.freeList = *(BlockHeader **)(header + 1);
+
+		sizeClass.stats.allocs++;
+		sizeClass.stats.liveBlocks++;
+		if (sizeClass.stats.liveBlocks > sizeClass.stats.peakLiveBlocks)
+		{
+			sizeClass.stats.peakLiveBlocks = sizeClass.stats.liveBlocks;
+		}
+	}
+	else
+	{
+		if (!Reserve(sizeof(BlockHeader) + size))
+		{
+			failedAllocs++;
+			return NULL;
+		}
+
+		header = (BlockHeader *)malloc(sizeof(BlockHeader) + size);
+		if (header == NULL)
+		{
+			Unreserve(sizeof(BlockHeader) + size);
+			failedAllocs++;
+			return NULL;
+		}
+
+		largeAllocs++;
+		liveLargeBytes += size;
+	}
+
+	header->sizeClass = (AkUInt32)index;
+	header->magic = BLOCK_LIVE;
+	header->size = size;
+	RaisePeak(peakLiveBytes, liveBytes += size);
+	return header + 1;
+}
+
+void AudioMemoryPool::Free(void *ptr)
+{
+	if (ptr == NULL) return;
+
+	BlockHeader *header = (BlockHeader *)ptr - 1;
+	assert(header->magic == BLOCK_LIVE && "Freeing audio memory that isn't allocated");
+	header->magic = BLOCK_FREED;
+	liveBytes -= header->size;
+
+	if (header->sizeClass < AUDIO_MEMORY_NUM_CLASSES)
+	{
+		SizeClass &sizeClass = classes[header->sizeClass];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+
+		*(BlockHeader **)(header + 1) = sizeClass.freeList;
+		sizeClass.freeList = header;
+		sizeClass.stats.frees++;
+		sizeClass.stats.liveBlocks--;
+	}
+	else
+	{
+		liveLargeBytes -= header->size;
+		Unreserve(sizeof(BlockHeader) + header->size);
+		free(header);
+	}
+}
+
+void *AudioMemoryPool::AllocPages(size_t size)
+{
+	if (!Reserve(size))
+	{
+		failedAllocs++;
+		return NULL;
+	}
+
+#ifdef _WIN32
+	void *ptr = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED) ptr = NULL;
+#endif
+	if (ptr == NULL)
+	{
+		Unreserve(size);
+		failedAllocs++;
+		return NULL;
+	}
+
+	std::lock_guard<std::mutex> lock(pagesMutex);
+	pages[ptr] = size;
+	livePageBytes += size;
+	return ptr;
+}
+
+bool AudioMemoryPool::FreePages(void *ptr)
+{
+	size_t size;
+	{
+		std::lock_guard<std::mutex> lock(pagesMutex);
+		std::unordered_map<void *, size_t>::iterator it = pages.find(ptr);
+		if (it == pages.end()) return false;
+		size = it->second;
+		pages.erase(it);
+	}
+
+#ifdef _WIN32
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	munmap(ptr, size);
+#endif
+	livePageBytes -= size;
+	Unreserve(size);
+	return true;
+}
+
+void AudioMemoryPool::SetBudget(size_t bytes)
+{
+	budget = bytes;
+}
+
+AudioMemoryStats AudioMemoryPool::GetStats()
+{
+	AudioMemoryStats stats;
+	stats.liveBytes = liveBytes;
+	stats.peakLiveBytes = peakLiveBytes;
+	stats.reservedBytes = reservedBytes;
+	stats.peakReservedBytes = peakReservedBytes;
+	stats.budget = budget;
+	stats.largeAllocs = largeAllocs;
+	stats.liveLargeBytes = liveLargeBytes;
+	stats.livePageBytes = livePageBytes;
+	stats.failedAllocs = failedAllocs;
+	return stats;
+}
+
+AudioMemoryClassStats AudioMemoryPool::GetClassStats(int sizeClass)
+{
+	assert(sizeClass >= 0 && sizeClass < AUDIO_MEMORY_NUM_CLASSES);
+	std::lock_guard<std::mutex> lock(classes[sizeClass].mutex);
+	return classes[sizeClass].stats;
+}
+
+void AudioMemoryPool::LogReport()
+{
+	AudioMemoryStats stats = GetStats();
+
+	oLog(Level::Info) << "Audio memory: " << stats.liveBytes << " bytes in use, " << stats.peakLiveBytes
+		<< " at most, " << stats.reservedBytes << " bytes reserved, " << stats.peakReservedBytes << " at most";
+	if (stats.budget != 0) oLog(Level::Info) << "\tbudget: " << stats.budget << " bytes";
+	oLog(Level::Info) << "\tlarge blocks: " << stats.largeAllocs << " allocations, " << stats.liveLargeBytes
+		<< " bytes in use; pages: " << stats.livePageBytes << " bytes in use";
+	for (int i = 0; i < AUDIO_MEMORY_NUM_CLASSES; ++i)
+	{
+		AudioMemoryClassStats classStats = GetClassStats(i);
+		if (classStats.allocs == 0) continue;
+		oLog(Level::Info) << "\t" << classStats.blockSize << " byte blocks: " << classStats.allocs << " allocations, "
+			<< classStats.liveBlocks << " live, " << classStats.peakLiveBlocks << " at most, "
+			<< classStats.slabs << " slabs";
+	}
+	if (stats.failedAllocs > 0)
+	{
+		oLog(Level::Warning) << "Audio memory: " << stats.failedAllocs << " allocations failed";
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+/*
+	Size-class pool allocator behind the sound engine's memory hooks.
+
+	Small blocks (up to AUDIO_MEMORY_MAX_POOLED_SIZE bytes) come from per-size-class
+	slabs: AUDIO_MEMORY_SLAB_SIZE chunks taken from the system and cut into blocks of one
+	size, handed out and taken back through a free list. A slab stays with its size class
+	until the pool is destroyed, so the sound engine's churn of small allocations never
+	reaches the general-purpose heap and can't fragment it, however long the game runs.
+	Bigger blocks go to malloc(). Page allocations (what the Stream Manager's I/O pools
+	ask VirtualAlloc() for on Windows) go to VirtualAlloc() or mmap().
+
+	Every block starts with a small header saying where it came from, so Free() needs no
+	size. Each size class has its own lock, so threads allocating different sizes don't
+	wait on each other.
+
+	Everything is counted: allocations, frees and live blocks per size class, bytes in use
+	and reserved from the system, with their peaks. With a budget set, the pool refuses to
+	reserve more than that from the system, and the sound engine gets NULL instead (it
+	copes, by dropping voices or failing the bank load).
+*/
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "AudioTypes.h"
+
+// Size of the chunks size classes get their blocks from
+#define AUDIO_MEMORY_SLAB_SIZE (64 * 1024)
+// Biggest block served from a size class, anything bigger goes to malloc()
+#define AUDIO_MEMORY_MAX_POOLED_SIZE 4096
+#define AUDIO_MEMORY_NUM_CLASSES 16
+
+// Bytes the pool may reserve from the system, 0 for no limit
+#ifndef AUDIO_MEMORY_BUDGET
+#define AUDIO_MEMORY_BUDGET 0
+#endif
+
+struct AudioMemoryClassStats
+{
+	size_t blockSize; //biggest allocation the class serves
+	AkUInt64 allocs;
+	AkUInt64 frees;
+	size_t liveBlocks;
+	size_t peakLiveBlocks;
+	size_t slabs;
+};
+
+struct AudioMemoryStats
+{
+	size_t liveBytes; //asked for and not freed yet, headers and rounding not included
+	size_t peakLiveBytes;
+	size_t reservedBytes; //slabs, big blocks and pages taken from the system
+	size_t peakReservedBytes;
+	size_t budget; //0 for none
+	AkUInt64 largeAllocs; //blocks too big for the size classes
+	size_t liveLargeBytes;
+	size_t livePageBytes;
+	AkUInt64 failedAllocs; //refused because of the budget, or because the system said no
+};
+
+class AudioMemoryPool
+{
+	// In front of every block handed out
+	struct alignas(16) BlockHeader
+	{
+		AkUInt32 sizeClass; //AUDIO_MEMORY_NUM_CLASSES for blocks from malloc()
+		AkUInt32 magic; //tells live blocks from freed ones
+		size_t size; //bytes asked for
+	};
+
+	struct SizeClass
+	{
+		std::mutex mutex;
+		size_t blockSize;
+		BlockHeader *freeList; //chained through the first bytes after the header
+		void *slabs; //chained through their first bytes, to give them back on destruction
+		AudioMemoryClassStats stats;
+	};
+	SizeClass classes[AUDIO_MEMORY_NUM_CLASSES];
+
+	std::atomic<size_t> liveBytes;
+	std::atomic<size_t> peakLiveBytes;
+	std::atomic<size_t> reservedBytes;
+	std::atomic<size_t> peakReservedBytes;
+	std::atomic<size_t> budget;
+	std::atomic<AkUInt64> largeAllocs;
+	std::atomic<size_t> liveLargeBytes;
+	std::atomic<size_t> livePageBytes;
+	std::atomic<AkUInt64> failedAllocs;
+
+	// Page allocations and their sizes, the page free hooks aren't always told the size
+	std::mutex pagesMutex;
+	std::unordered_map<void *, size_t> pages;
+
+	// Size class of each multiple of 16 bytes up to AUDIO_MEMORY_MAX_POOLED_SIZE
+	unsigned char classLookup[AUDIO_MEMORY_MAX_POOLED_SIZE / 16 + 1];
+
+	int ClassOf(size_t size);
+	static void RaisePeak(std::atomic<size_t> &peak, size_t value);
+	// Counts bytes as reserved from the system, false if that would go over the budget
+	bool Reserve(size_t bytes);
+	void Unreserve(size_t bytes);
+	bool AddSlab(SizeClass &sizeClass);
+
+public:
+	AudioMemoryPool();
+	// Gives the slabs back to the system, every block must have been freed by then
+	~AudioMemoryPool();
+
+	void *Alloc(size_t size);
+	void Free(void *ptr);
+	// Whole pages, straight from the system, for the I/O pools
+	void *AllocPages(size_t size);
+	// Returns false, and does nothing, if ptr didn't come from AllocPages()
+	bool FreePages(void *ptr);
+
+	// Bytes the pool may reserve from the system from now on, 0 for no limit.
+	// Memory already reserved stays so.
+	void SetBudget(size_t bytes);
+
+	AudioMemoryStats GetStats();
+	AudioMemoryClassStats GetClassStats(int sizeClass);
+	// Writes the stats and the busy size classes to the Blit3D log
+	void LogReport();
+};
+
+// The pool the sound engine's memory hooks use
+extern AudioMemoryPool audioMemory;
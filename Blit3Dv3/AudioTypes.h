@@ -0,0 +1,48 @@
+#pragma once
+
+/*
+	Basic audio types shared by AudioEngine and its backends.
+
+	When the Wwise SDK is available (Windows builds without AUDIO_NO_WWISE defined,
+	or any build with AUDIO_USE_WWISE defined) these come straight from the SDK. Everywhere else we declare the handful of
+	Ak types the game uses ourselves, with the same sizes Wwise uses, so the game
+	builds and runs against the NullAudioBackend.
+*/
+
+#if (defined(_WIN32) && !defined(AUDIO_NO_WWISE)) || defined(AUDIO_USE_WWISE)
+#define AUDIO_HAS_WWISE
+#endif
+
+#ifdef AUDIO_HAS_WWISE
+
+#ifdef NDEBUG
+#define AK_OPTIMIZED
+#endif
+
+#include <AK/SoundEngine/Common/AkTypes.h>
+
+#else
+
+#include <stdint.h>
+
+typedef uint32_t AkUInt32;
+typedef uint64_t AkUInt64;
+typedef int32_t AkInt32;
+typedef AkUInt32 AkUniqueID;
+typedef AkUInt32 AkPlayingID;
+typedef AkUInt32 AkRtpcID;
+typedef AkUInt64 AkGameObjectID;
+typedef float AkRtpcValue;
+typedef AkInt32 AkTimeMs;
+
+#define AK_INVALID_UNIQUE_ID 0
+#define AK_INVALID_PLAYING_ID 0
+
+#endif
+
+// Handle returned by PlayEvent(). The real AkPlayingID only exists once the audio
+// thread has posted the event, so game code holds on to this instead.
+typedef AkUInt32 AudioHandle;
+#define AUDIO_INVALID_HANDLE 0
+
+enum class AudioCommandType { PLAY = 0, STOP, PAUSE, RESUME, SET_RTPC, SET_POSITION, REGISTER, COUNT };
@@ -0,0 +1,252 @@
+#include "AllocationTracker.h"
+#include "FrameArena.h"
+#include "Logger.h"
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+//operator new is hooked for tracking, and for FrameAllocationCheck's counting
+#define ALLOCATION_HOOK (ALLOCATION_TRACKING || FRAME_ARENA_CHECK_ALLOCATIONS)
+
+namespace
+{
+	//all plain thread_local/static PODs, so using them from operator new needs no allocation
+	//and no initialization that could run too late
+	thread_local AllocTag threadTag = AllocTag::UNTAGGED;
+	thread_local uint64_t threadAllocations = 0;
+
+	struct TagCounters
+	{
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> frees;
+		std::atomic<uint64_t> bytesAllocated;
+		std::atomic<int64_t> liveBytes;
+		std::atomic<int64_t> peakBytes;
+		//taken by EndFrame()
+		std::atomic<uint64_t> frameStartAllocations;
+		std::atomic<uint64_t> frameStartBytes;
+		std::atomic<uint64_t> lastFrameAllocations;
+		std::atomic<uint64_t> lastFrameBytes;
+		std::atomic<uint64_t> peakFrameAllocations;
+	};
+
+	const size_t TOTAL = (size_t)AllocTag::COUNT;
+	//one per tag, and one more for all of them together
+	TagCounters counters[TOTAL + 1];
+	std::atomic<uint64_t> frameCount(0);
+
+#if ALLOCATION_TRACKING
+	//in front of every block, rounded up so the block keeps operator new's alignment
+	struct BlockHeader
+	{
+		size_t size;
+		uint32_t tag;
+		uint32_t magic;
+	};
+	const uint32_t BLOCK_MAGIC = 0xA110CA7E;
+	const size_t HEADER_SIZE = (sizeof(BlockHeader) + alignof(std::max_align_t) - 1)
+		/ alignof(std::max_align_t) * alignof(std::max_align_t);
+
+	void RaisePeak(std::atomic<int64_t> &peak, int64_t live)
+	{
+		int64_t seen = peak.load(std::memory_order_relaxed);
+		while (live > seen && !peak.compare_exchange_weak(seen, live, std::memory_order_relaxed)) {}
+	}
+
+	void Count(TagCounters &tag, size_t size)
+	{
+		tag.allocations.fetch_add(1, std::memory_order_relaxed);
+		tag.bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+		int64_t live = tag.liveBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+		RaisePeak(tag.peakBytes, live);
+	}
+
+	void Uncount(TagCounters &tag, size_t size)
+	{
+		tag.frees.fetch_add(1, std::memory_order_relaxed);
+		tag.liveBytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+	}
+#endif
+}
+
+#if ALLOCATION_HOOK
+//the replaceable global allocation functions: the array and nothrow forms call these
+void *operator new(size_t size)
+{
+	threadAllocations++;
+	if (size == 0) size = 1;
+
+#if ALLOCATION_TRACKING
+	size_t blockSize = size + HEADER_SIZE;
+#else
+	size_t blockSize = size;
+#endif
+
+	void *memory;
+	for (;;)
+	{
+		memory = malloc(blockSize);
+		if (memory != NULL) break;
+
+		std::new_handler handler = std::get_new_handler();
+		if (handler == NULL) throw std::bad_alloc();
+		handler();
+	}
+
+#if ALLOCATION_TRACKING
+	BlockHeader *header = (BlockHeader *)memory;
+	header->size = size;
+	header->tag = (uint32_t)threadTag;
+	header->magic = BLOCK_MAGIC;
+	Count(counters[header->tag], size);
+	Count(counters[TOTAL], size);
+	return (unsigned char *)memory + HEADER_SIZE;
+#else
+	return memory;
+#endif
+}
+
+void operator delete(void *memory) noexcept
+{
+	if (memory == NULL) return;
+
+#if ALLOCATION_TRACKING
+	BlockHeader *header = (BlockHeader *)((unsigned char *)memory - HEADER_SIZE);
+	assert(header->magic == BLOCK_MAGIC && "operator delete on a block that didn't come from operator new");
+	Uncount(counters[header->tag], header->size);
+	Uncount(counters[TOTAL], header->size);
+	header->magic = 0;
+	free(header);
+#else
+	free(memory);
+#endif
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+#endif
+
+bool AllocationTracker::IsEnabled()
+{
+	return ALLOCATION_TRACKING != 0;
+}
+
+const char *AllocationTracker::TagName(AllocTag tag)
+{
+	static const char *names[] = { "untagged", "render", "texture", "font", "audio", "gameplay", "logging" };
+	static_assert(sizeof(names) / sizeof(names[0]) == (size_t)AllocTag::COUNT, "a tag is missing its name");
+
+	if (tag >= AllocTag::COUNT) return "total";
+	return names[(size_t)tag];
+}
+
+AllocTag AllocationTracker::GetThreadTag()
+{
+	return threadTag;
+}
+
+void AllocationTracker::SetThreadTag(AllocTag tag)
+{
+	assert(tag < AllocTag::COUNT && "not an allocation tag");
+	threadTag = tag;
+}
+
+uint64_t AllocationTracker::ThreadAllocationCount()
+{
+#if ALLOCATION_HOOK
+	return threadAllocations;
+#else
+	return 0;
+#endif
+}
+
+void AllocationTracker::EndFrame()
+{
+	for (TagCounters &tag : counters)
+	{
+		uint64_t allocations = tag.allocations.load(std::memory_order_relaxed);
+		uint64_t bytes = tag.bytesAllocated.load(std::memory_order_relaxed);
+		uint64_t frameAllocations = allocations - tag.frameStartAllocations.load(std::memory_order_relaxed);
+
+		tag.lastFrameAllocations.store(frameAllocations, std::memory_order_relaxed);
+		tag.lastFrameBytes.store(bytes - tag.frameStartBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		if (frameAllocations > tag.peakFrameAllocations.load(std::memory_order_relaxed))
+			tag.peakFrameAllocations.store(frameAllocations, std::memory_order_relaxed);
+
+		tag.frameStartAllocations.store(allocations, std::memory_order_relaxed);
+		tag.frameStartBytes.store(bytes, std::memory_order_relaxed);
+	}
+	frameCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t AllocationTracker::GetFrameCount()
+{
+	return frameCount.load(std::memory_order_relaxed);
+}
+
+static AllocationStats StatsOf(const TagCounters &tag)
+{
+	AllocationStats stats;
+	stats.allocations = tag.allocations.load(std::memory_order_relaxed);
+	stats.frees = tag.frees.load(std::memory_order_relaxed);
+	stats.bytesAllocated = tag.bytesAllocated.load(std::memory_order_relaxed);
+	stats.liveBytes = tag.liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = tag.peakBytes.load(std::memory_order_relaxed);
+	stats.lastFrameAllocations = tag.lastFrameAllocations.load(std::memory_order_relaxed);
+	stats.lastFrameBytes = tag.lastFrameBytes.load(std::memory_order_relaxed);
+	stats.peakFrameAllocations = tag.peakFrameAllocations.load(std::memory_order_relaxed);
+	return stats;
+}
+
+AllocationStats AllocationTracker::GetStats(AllocTag tag)
+{
+	assert(tag < AllocTag::COUNT && "not an allocation tag");
+	return StatsOf(counters[(size_t)tag]);
+}
+
+AllocationStats AllocationTracker::GetTotalStats()
+{
+	return StatsOf(counters[TOTAL]);
+}
+
+void AllocationTracker::LogReport()
+{
+	if (!IsEnabled())
+	{
+		oLog(Level::Info) << "Allocation tracking is off, build with ALLOCATION_TRACKING 1 to turn it on";
+		return;
+	}
+
+	//take them all before logging, which allocates
+	AllocationStats stats[TOTAL + 1];
+	for (size_t i = 0; i <= TOTAL; ++i) stats[i] = StatsOf(counters[i]);
+	uint64_t frames = GetFrameCount();
+
+	oLog(Level::Info) << "Heap allocations over " << frames << " frames, by subsystem:";
+	for (size_t i = 0; i <= TOTAL; ++i)
+	{
+		const AllocationStats &tag = stats[i];
+		if (tag.allocations == 0 && i < TOTAL) continue;
+
+		oLog(Level::Info) << "  " << TagName((AllocTag)i) << ": " << tag.allocations << " allocations, "
+			<< tag.frees << " frees, " << tag.bytesAllocated << " bytes allocated, peak "
+			<< tag.peakBytes << " bytes live, "
+			<< (frames > 0 ? (double)tag.allocations / frames : 0.0) << " allocations a frame on average, peak "
+			<< tag.peakFrameAllocations << " in one frame";
+	}
+
+	for (size_t i = 0; i < TOTAL; ++i)
+	{
+		if (stats[i].liveBytes != 0)
+		{
+			oLog(Level::Warning) << "  " << TagName((AllocTag)i) << ": " << stats[i].liveBytes << " bytes in "
+				<< stats[i].allocations - stats[i].frees << " blocks still allocated";
+		}
+	}
+}
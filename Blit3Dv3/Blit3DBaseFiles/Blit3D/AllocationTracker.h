@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+	Heap allocation tracker that works in any build on any platform, for spotting
+	allocation regressions without the MSVC debug heap.
+
+	Turn it on by building with ALLOCATION_TRACKING defined to 1 (release builds too).
+	The global operator new/delete are then replaced by ones that put a small header in
+	front of every block, so each allocation is counted against the subsystem that made it
+	and its bytes are given back to that subsystem when it is freed. For every tag it keeps
+	the count of allocations and frees, the bytes allocated, the live and peak bytes, and
+	how many allocations the last frame made.
+
+	Allocations are tagged by the thread's current tag, set with a scope:
+
+		AllocationScope scope(AllocTag::TEXTURE);
+		...every new on this thread is a texture allocation until scope ends
+
+	Scopes nest and put the tag they replaced back. Blit3D tags Update() as GAMEPLAY and
+	Draw() as RENDER, texture and font loading, the sound engine and the logger tag their
+	own work. Anything else counts as UNTAGGED.
+
+	Blit3D calls EndFrame() after every frame, that's what the per-frame counts are taken
+	over. LogReport() writes everything to the log, call it last thing before exit: the
+	live bytes left then were never freed.
+
+	Only the plain operator new/delete are hooked, the array and nothrow forms go through
+	them. Over-aligned (align_val_t) allocations and malloc() aren't counted.
+
+	version 1.0
+*/
+
+#include <stdint.h>
+#include <cstddef>
+
+// build with ALLOCATION_TRACKING 1 to hook operator new and count allocations by tag
+#ifndef ALLOCATION_TRACKING
+#define ALLOCATION_TRACKING 0
+#endif
+
+enum class AllocTag : uint8_t { UNTAGGED = 0, RENDER, TEXTURE, FONT, AUDIO, GAMEPLAY, LOGGING, COUNT };
+
+struct AllocationStats
+{
+	uint64_t allocations; //made since start-up
+	uint64_t frees;
+	uint64_t bytesAllocated; //made since start-up
+	int64_t liveBytes; //allocated and not freed yet
+	int64_t peakBytes; //most liveBytes has been
+	uint64_t lastFrameAllocations; //made during the last frame
+	uint64_t lastFrameBytes;
+	uint64_t peakFrameAllocations; //most a frame has made
+};
+
+class AllocationTracker
+{
+public:
+	// true if built with ALLOCATION_TRACKING, the stats are all 0 otherwise
+	static bool IsEnabled();
+	static const char *TagName(AllocTag tag);
+
+	// the calling thread's current tag
+	static AllocTag GetThreadTag();
+	static void SetThreadTag(AllocTag tag);
+
+	// heap allocations made so far by the calling thread, counted whenever operator new is
+	// hooked (ALLOCATION_TRACKING, or FRAME_ARENA_CHECK_ALLOCATIONS), always 0 otherwise
+	static uint64_t ThreadAllocationCount();
+
+	// takes the per-frame counts, call it once a frame from one thread, Blit3D does
+	static void EndFrame();
+	static uint64_t GetFrameCount();
+
+	static AllocationStats GetStats(AllocTag tag);
+	// all the tags added up
+	static AllocationStats GetTotalStats();
+	static void LogReport();
+};
+
+// sets the thread's allocation tag while in scope, and puts the previous one back after
+class AllocationScope
+{
+private:
+	AllocTag previousTag;
+
+public:
+	AllocationScope(AllocTag tag) : previousTag(AllocationTracker::GetThreadTag())
+	{
+		AllocationTracker::SetThreadTag(tag);
+	}
+	~AllocationScope()
+	{
+		AllocationTracker::SetThreadTag(previousTag);
+	}
+	AllocationScope(const AllocationScope &) = delete;
+	AllocationScope &operator=(const AllocationScope &) = delete;
+};
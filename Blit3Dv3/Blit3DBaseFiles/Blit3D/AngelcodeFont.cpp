@@ -2,7 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
-#include "ByteSwap.h"
+#include <chrono>
 
 extern logger oLog;
 
@@ -15,209 +15,102 @@ std::string DirectoryOfFilePath(const std::string& filename)
 	else return filename.substr(0, position) + "\\";
 }
 
-AngelcodeFont::AngelcodeFont(std::string fontfile, TextureManager *TexManager, GLSLProgram *shader)
+//reads a file from the archive's mapping if it is packed, from disk otherwise
+static bool LoadFontFile(const std::string &filename, AssetArchive *archive, AssetData &file)
 {
-	texManager = TexManager;
-	angle = 0.f;
-	alpha = 1.f;
-	prog = shader;
-
-	//determine endianness of architecture
-	unsigned char word[4] = { (unsigned char)0x01, (unsigned char)0x23, (unsigned char)0x45, (unsigned char)0x67 };
-
-	unsigned long be = 0x01234567;
-	unsigned long le = 0x67452301;
-	unsigned long me = 0x23016745;
-	unsigned long we;
-
-	memcpy(&we, word, 4);
-	endian = 0;
-	if(we == le) endian = 0;
-	else if(we == be) endian = 1;
-	else if(we == me) endian = 2;
-	
-	//Reading a binary file in
-
-	std::ifstream ifs;
-	ifs.open(fontfile, std::ios::in | std::ios::binary| std::ios::ate);
-		
-	if(!ifs.is_open()) 
-	{
-		oLog(Level::Severe) << "Error while loading font data file: " << fontfile << "for AngelcodeFont";
-		assert(ifs.is_open());
-	}
-
-	std::streampos end = ifs.tellg();
-	ifs.seekg(0, std::ios::beg);
-	std::streampos start = ifs.tellg();
-	uint32_t fsize = (uint32_t) (end - start);
-
-	int16_t *buf = new int16_t[fsize]; //memory to read into
-	char *buffer = (char *)buf;
-
-	//load entire file in one go...much faster than reading 2 chars at a time!
-	ifs.read(buffer, fsize);
-
-	ifs.close();
+	return archive != NULL ? archive->Load(filename, file) : AssetArchive::LoadLooseFile(filename, file);
+}
 
-	//process buffer
-	if(!(	buffer[0] == 'B'
-		&&	buffer[1] == 'M'
-		&&	buffer[2] == 'F'))
+bool AngelcodeFont::LoadLayout(const std::string &fontfile, AssetArchive *archive)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//the compiled font is only copied, nothing to parse
+	std::string compiledFile = CompiledFontPath(fontfile);
+	AssetData compiled;
+	bool useCompiled = LoadFontFile(compiledFile, archive, compiled) && layout.LoadCompiled(compiled.bytes, compiled.size);
+
+	//a compiled font left behind by an edited .bin would lay the text out wrong, so it's
+	//always checked, it only costs hashing the .bin. Without the .bin it is used as is.
+	AssetData file;
+	bool haveSource = false;
+	if (useCompiled)
 	{
-		assert("Not a binary Angelcode font file" && 0);
+		haveSource = LoadFontFile(fontfile, archive, file);
+		if (haveSource && !layout.IsCompiledFrom(file.bytes, file.size))
+		{
+			oLog(Level::Warning) << "Compiled font " << compiledFile << " is out of date, reading " << fontfile << " instead";
+			useCompiled = false;
+		}
 	}
 
-	if(buffer[3] != 3)
+	if (!useCompiled)
 	{
-		assert("Not a version 3 font file" && 0);
-	}
-		
-	uint32_t current = 3;
-	int vertsCounter = 0;
-	while(current < fsize - 1)
-	{
-		current++;
-		switch(buffer[current])
-		{
-		case 1://info block
+		if (!haveSource && !LoadFontFile(fontfile, archive, file))
 		{
-			current++; //advance to size data
-			//move current to end of block
-			int count = ReadInt(current, buffer);
-			current += count + 3;
-		}
-			break;
-		case 2: //common block
-		{
-			current++; //advance to size data
-			//use marker to advance through this block
-			int marker = current + 4; //move it past the block size data
-
-			//move current to end of block
-			int count = ReadInt(current, buffer);
-			current += count + 3;
-			
-			lineHeight = (float)ReadShortAndAdvance(marker, buffer);			
-			base = (float)ReadShortAndAdvance(marker, buffer);
-			scaleW = (float)ReadShortAndAdvance(marker, buffer);
-			scaleH = (float)ReadShortAndAdvance(marker, buffer);
-			
-			if(ReadShortAndAdvance(marker, buffer) != 1)
-			{
-				assert("More than one texture page" && 0);
-			}
+			oLog(Level::Severe) << "Error while loading font data file: " << fontfile << " for AngelcodeFont";
+			return false;
 		}
-			break;
-
-		case 3: //page block
+		if (!layout.Parse(file.bytes, file.size))
 		{
-			current++; //advance to size data
-			//use marker to advance through this block
-			int marker = current + 4; //move it past the block size data
-
-			//move current to end of block
-			int count = ReadInt(current, buffer);
-			current += count + 3;
-
-			//just getting one texture name
-			while(buffer[marker] != 0)
-			{
-				textureName += buffer[marker];
-				marker++;
-			}
+			oLog(Level::Severe) << "Could not read font data file: " << fontfile;
+			return false;
 		}
-			break;
-
-		case 4: //character data
+#if ANGELCODE_FONT_REBUILD_COMPILED
+		if (layout.SaveCompiled(compiledFile))
 		{
-			current++; //advance to size data
-			//use marker to advance through this block
-			int marker = current + 4; //move it past the block size data
-
-			//move current to end of block
-			int count = ReadInt(current, buffer);
-			current += count + 3;
-
-			int numChars = count / 20;
-			for(int i = 0; i < numChars; ++i)
-			{
-				int charNum = ReadIntAndAdvance(marker, buffer);
-
-				AngelcodeCharDescriptor AD;
-				AD.x = ReadShortAndAdvance(marker, buffer);
-				AD.y = ReadShortAndAdvance(marker, buffer);
-				AD.width = ReadShortAndAdvance(marker, buffer);
-				AD.height = ReadShortAndAdvance(marker, buffer);
-				AD.xOffset = ReadShortAndAdvance(marker, buffer);
-				AD.yOffset = -(float)ReadShortAndAdvance(marker, buffer);//negate y offsets for Blit3D coordinate system!
-				AD.xAdvance = ReadShortAndAdvance(marker, buffer); 
-				AD.lookupVerts = vertsCounter;
-				if(Chars.count(charNum) == 0)
-				{
-					vertsCounter++; //only increment if unique key...turns out for some files we need this sanity check
-					//add to map
-					Chars[charNum] = AD;
-				}
-				
-				marker += 2; //skip page & chnl data
-			}
+			oLog(Level::Info) << "Wrote compiled font " << compiledFile;
 		}
-			break;
-
-		case 5: //kerning pairs data
-		{
-			current++; //advance to size data
-			//use marker to advance through this block
-			int marker = current + 4; //move it past the block size data
-
-			//move current to end of block
-			int count = ReadInt(current, buffer);
-			current += count + 3;
-
-			int numKerns = count / 10;
-			
-			std::unordered_map<int32_t, AngelcodeCharDescriptor>::iterator itr;
-
-			for(int i = 0; i < numKerns; ++i)
-			{
-				uint32_t charNum1 = ReadUIntAndAdvance(marker, buffer);
+#endif
+	}
 
-				uint32_t charNum2 = ReadUIntAndAdvance(marker, buffer);
+	oLog(Level::Fine) << "Font " << fontfile << ": " << layout.GetGlyphs().size() << " glyphs, "
+		<< layout.GetKerningPairCount() << " kerning pairs, " << (useCompiled ? "compiled" : "parsed") << " in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms";
+	return true;
+}
 
-				int16_t amount = ReadShortAndAdvance(marker, buffer);
+AngelcodeFont::AngelcodeFont(std::string fontfile, TextureManager *TexManager, GLSLProgram *shader, AssetArchive *archive)
+{
+	texManager = TexManager;
+	prog = shader;
+	distanceField = false;
+	b3d = NULL;
+	Load(fontfile, archive);
+}
 
-				//lookup second character, add first cahracter to it's kerning table
-				itr = Chars.find(charNum2);
-				if(itr != Chars.end())
-				{
-					itr->second.kerningTable[charNum1] = (float)amount;
-				}
+AngelcodeFont::AngelcodeFont(std::string fontfile, Blit3D *blit3D)
+{
+	texManager = blit3D->tManager;
+	prog = blit3D->shaderSDF;
+	distanceField = true;
+	b3d = blit3D;
+	Load(fontfile, &blit3D->assets);
+}
 
-			}
-		}
-			break;
+void AngelcodeFont::Load(const std::string &fontfile, AssetArchive *archive)
+{
+	AllocationScope fontAllocations(AllocTag::FONT);
+	angle = 0.f;
+	alpha = 1.f;
+	scale = 1.f;
+	color = glm::vec4(1.f);
 
-		default:
-		{
-			//skip unknown blocks for now
-			current++; //advance to size data
-			//move current to end of block
-			int count = ReadInt(current, buffer);
-			current += count + 3;
-		}
-			break;
-		}//end switch
-	}
+	bool loaded = LoadLayout(fontfile, archive);
+	assert(loaded && "Could not load the AngelcodeFont");
 
-	delete[] buffer;
+	const std::vector<AngelcodeGlyph> &glyphs = layout.GetGlyphs();
+	size_t glyphCount = glyphs.size();
+	float scaleW = layout.scaleW;
+	float scaleH = layout.scaleH;
 
 	//Make a path string, so we can load textures from w/e the font file was
 	std::string fontPath = DirectoryOfFilePath(fontfile);
-	textureName = fontPath + textureName;
-	texId = texManager->LoadTexture(textureName);
+	textureName = fontPath + layout.textureName;
+	//a distance field has to be filtered, the edge is found between its texels
+	texId = texManager->LoadTexture(textureName, false, GL_TEXTURE0, GL_CLAMP_TO_EDGE, !distanceField);
 
-	verts = new B3D::TVertex[4 * Chars.size()]; //make an array of Textured Vertices
+	verts = new B3D::TVertex[4 * glyphCount]; //make an array of Textured Vertices
 
 	// generate a new VAO and get the associated ID
 	glGenVertexArrays(1, &vaoId); // Create our Vertex Array Object  
@@ -230,21 +123,19 @@ AngelcodeFont::AngelcodeFont(std::string fontfile, TextureManager *TexManager, G
 	glBindBuffer(GL_ARRAY_BUFFER, vboId);
 
 	//set the vertex array points...we need 4 vertices, one for each corner of our sprite,
-	//per letter
+	//per letter, in the order of the glyphs
 	
-	for(auto C : Chars)
+	for(size_t loop = 0; loop < glyphCount; ++loop)
 	{
-		//C.second.lookupVerts = loop; can't update this way
-		int loop = C.second.lookupVerts;
-		assert(loop < Chars.size());
-		float cx = C.second.x;				// X Position Of Current Character
-		float cy = C.second.y;				// Y Position Of Current Character
+		const AngelcodeGlyph &C = glyphs[loop];
+		float cx = C.x;				// X Position Of Current Character
+		float cy = C.y;				// Y Position Of Current Character
 		
-		float charwidth = C.second.width;
-		float charheight = C.second.height;
+		float charwidth = C.width;
+		float charheight = C.height;
 
-		float xoffset = C.second.xOffset;
-		float yoffset = C.second.yOffset - charheight; //invert char height for Blit3D coordinate system
+		float xoffset = C.xOffset;
+		float yoffset = C.yOffset - charheight; //invert char height for Blit3D coordinate system
 
 		verts[loop * 4].x = 0 + xoffset; verts[loop * 4].y = 0 + yoffset;		// Vertex Coord (Bottom Left)
 		verts[loop * 4].u = cx / scaleW;	verts[loop * 4].v = 1 - (cy + charheight) / scaleH;	// Texture Coord (Bottom Left)
@@ -262,7 +153,7 @@ AngelcodeFont::AngelcodeFont(std::string fontfile, TextureManager *TexManager, G
 	}
 
 	// upload data to VBO
-	glBufferData(GL_ARRAY_BUFFER, sizeof(B3D::TVertex) * 4 * Chars.size(), verts, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(B3D::TVertex) * 4 * glyphCount, verts, GL_STATIC_DRAW);
 
 	// Set up our vertex attributes pointers
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(0)); //3 values (x,y,z) per point, start at 0 offset 
@@ -294,11 +185,20 @@ AngelcodeFont::~AngelcodeFont()
 }
 
 //draws the string
-void AngelcodeFont::BlitText(float x, float y, std::string output)
+void AngelcodeFont::BlitText(float x, float y, std::string_view output)
 {
 	dest_x = x;
 	dest_y = y;
 
+	if(distanceField)
+	{
+		//Blit3D only keeps shader2d's matrices up to date
+		prog->use();
+		prog->setUniform("projectionMatrix", b3d->projectionMatrix);
+		prog->setUniform("viewMatrix", b3d->viewMatrix);
+		prog->setUniform("in_Color", color);
+	}
+
 	glBindVertexArray(vaoId); // Bind our Vertex Array Object 
 
 	//bind our texture
@@ -308,6 +208,8 @@ void AngelcodeFont::BlitText(float x, float y, std::string output)
 	modelMatrix = glm::translate(glm::mat4(1.f), glm::vec3(dest_x, dest_y, 0.f));
 	//apply rotation
 	modelMatrix = glm::rotate(modelMatrix, angle, glm::vec3(0.f, 0.f, 1.f));
+	//and scale, the kerning and advances below are in the font's pixels so they scale too
+	modelMatrix = glm::scale(modelMatrix, glm::vec3(scale, scale, 1.f));
 
 	//send our alpha to the shader
 	prog->setUniform("in_Alpha", alpha);
@@ -316,28 +218,26 @@ void AngelcodeFont::BlitText(float x, float y, std::string output)
 	prog->setUniform("modelMatrix", modelMatrix);
 	prog->setUniform("in_Scale_X", 1.f); //default scaling
 	prog->setUniform("in_Scale_Y", 1.f); //default scaling
+	prog->setUniform("in_UVRect", glm::vec4(0.f, 0.f, 1.f, 1.f)); //whole texture, sprites change it
 	
-	std::unordered_map<int32_t, AngelcodeCharDescriptor>::iterator itr;
-	std::unordered_map<int32_t, float>::iterator itrK;
-
 	int prevLetter = -1; //shouldn't find a kerning pair for this letter on first pass
 
 	for(unsigned int i = 0; i < output.size(); ++i)
 	{
-		//lookup this letter in the Chars map and fetch its verts offset
-		itr = Chars.find(output[i]);
-		if(itr != Chars.end())
+		//lookup this letter's glyph, its index is where its verts are
+		const AngelcodeGlyph *glyph = layout.FindGlyph(output[i]);
+		if(glyph != NULL)
 		{ 
-			//kerning: lookup previous letter in cyrrent character's kerning map
-			itrK = itr->second.kerningTable.find(prevLetter);
-			if(itrK != itr->second.kerningTable.end())
+			//kerning: lookup previous letter in current character's kerning pairs
+			float kerning = layout.Kerning(*glyph, prevLetter);
+			if(kerning != 0.f)
 			{
-				modelMatrix = glm::translate(modelMatrix, glm::vec3(itrK->second, 0.f, 0.f));
+				modelMatrix = glm::translate(modelMatrix, glm::vec3(kerning, 0.f, 0.f));
 			}
 			
 			// draw a quad: 1 quad x 4points per quad = 4 verts, the third argument
-			glDrawArrays(GL_QUADS, itr->second.lookupVerts * 4, 4);
-			modelMatrix = glm::translate(modelMatrix, glm::vec3(itr->second.xAdvance, 0.f, 0.f));
+			glDrawArrays(GL_QUADS, (GLint)layout.GlyphIndex(glyph) * 4, 4);
+			modelMatrix = glm::translate(modelMatrix, glm::vec3(glyph->xAdvance, 0.f, 0.f));
 			prog->setUniform("modelMatrix", modelMatrix);
 			prevLetter = output[i]; //store this letter for kerning the next one
 		}
@@ -346,142 +246,30 @@ void AngelcodeFont::BlitText(float x, float y, std::string output)
 	// bind with 0, so, switch back to normal pointer operation
 	glBindVertexArray(0);
 
+	//sprites draw with whatever is bound
+	if(distanceField) b3d->shader2d->use();
+
 	return;
 }
 
 //returns the width of the text string, in pixels
-float AngelcodeFont::WidthText(std::string output)
+float AngelcodeFont::WidthText(std::string_view output)
 {
 	float width_text = 0;
-	std::unordered_map<int32_t, AngelcodeCharDescriptor>::iterator itr;
-	std::unordered_map<int32_t, float>::iterator itrK;
 
 	int prevLetter = -1; //shouldn't find a kerning pair for this letter on first pass
 
 	for(unsigned int i = 0; i < output.size(); ++i)
 	{
-
-		itr = Chars.find(output[i]);
-		if(itr != Chars.end())
+		const AngelcodeGlyph *glyph = layout.FindGlyph(output[i]);
+		if(glyph != NULL)
 		{
-			//kerning: lookup previous letter in current character's kerning map
-			itrK = itr->second.kerningTable.find(prevLetter);
-			if(itrK != itr->second.kerningTable.end())
-			{
-				width_text += (itr->second.xAdvance + itrK->second);
-			}
-			else width_text += itr->second.xAdvance;
+			//kerning: lookup previous letter in current character's kerning pairs
+			width_text += glyph->xAdvance + layout.Kerning(*glyph, prevLetter);
 
 			prevLetter = output[i]; //store this letter for kerning the next one
 		}
 	}
 
-	return width_text;
-}
-
-int16_t AngelcodeFont::ReadShortAndAdvance(int &offset, char buffer[])
-{
-	int16_t *temp = (int16_t *)&buffer[offset];
-	int16_t val = *temp;
-	
-	switch(endian)
-	{
-	case 0://little-endian
-		//
-		break;
-
-	case 1: //big-endian	
-		val = swap_int16(val);
-		break;
-	case 2:
-		break;
-	}	
-	
-	offset += 2;
-	return val;
-}
-
-int32_t AngelcodeFont::ReadIntAndAdvance(int &offset, char buffer[])
-{	
-	int32_t *charNum = (int32_t *)&buffer[offset];
-	int32_t val = *charNum; 	
-	
-	switch(endian)
-	{
-	case 0://little-endian
-		
-		break;
-
-	case 1: //big-endian	
-		val = swap_int32(val);		
-		break;
-	case 2: //middle-endian??
-		break;
-	}
-
-	offset += 4;
-	return val;
-}
-
-uint32_t AngelcodeFont::ReadUIntAndAdvance(int &offset, char buffer[])
-{
-	uint32_t *charNum = (uint32_t *)&buffer[offset];
-	uint32_t val = *charNum;
-
-	switch(endian)
-	{
-	case 0://little-endian
-
-		break;
-
-	case 1: //big-endian	
-		val = swap_uint32(val);
-		break;
-	case 2: //middle-endian??
-		break;
-	}
-
-	offset += 4;
-	return val;
+	return width_text * scale;
 }
-
-int16_t AngelcodeFont::ReadShort(int offset, char buffer[])
-{
-	int16_t *temp = (int16_t *)&buffer[offset];
-	int16_t val = *temp;
-
-	switch(endian)
-	{
-	case 0://little-endian
-		//
-		break;
-
-	case 1: //big-endian	
-		val = swap_int16(val);
-		break;
-	case 2:
-		break;
-	}	
-	return val;
-}
-
-int32_t AngelcodeFont::ReadInt(int offset, char buffer[])
-{
-	int32_t *charNum = (int32_t *)&buffer[offset];
-	int32_t val = *charNum;
-
-	switch(endian)
-	{
-	case 0://little-endian
-
-		break;
-
-	case 1: //big-endian	
-		val = swap_int32(val);
-		break;
-	case 2: //middle-endian??
-		break;
-	}
-	
-	return val;
-}
\ No newline at end of file
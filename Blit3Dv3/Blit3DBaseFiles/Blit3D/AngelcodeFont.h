@@ -2,8 +2,16 @@
 
 /*
 	Angelcode bitmap font class.
-	TODO: text format loading? Support for distance fields. Support for packed & non-32bit fonts?
+	TODO: text format loading? Support for packed & non-32bit fonts?
 
+	version 1.9 - distance field fonts: made with the Blit3D constructor, their texture's alpha is a signed
+				  distance field (see Tools/FontSDF) drawn with Blit3D's shaderSDF in color. Added scale, which
+				  BlitText() and WidthText() apply to any font.
+	version 1.8 - glyphs and kerning pairs are kept in flat sorted arrays (AngelcodeFontLayout) instead of
+				  hash maps, and loaded from a compiled font (.b3df) next to the .bin when there is one and
+				  it is up to date
+	version 1.7 - BlitText() and WidthText() take a std::string_view, so drawing text doesn't copy it
+	version 1.6 - reads the font data file through an AssetArchive, when given one
 	version 1.5 - now loads the texture file from the same directory as the font data file
 	version 1.4 - fixed character yoffset calculations for Blit3D coordinate system
 	version 1.3 - fixed incorrect verts array index if glyph code is stored more than once in the font file
@@ -13,11 +21,22 @@
 */
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdint.h>
 
 #include "Blit3D.h"
-#include <unordered_map>
+#include "AngelcodeFontLayout.h"
+
+// A compiled font is always checked against its .bin, and the .bin is read instead when
+// they differ. Debug builds also write the compiled font again when it is missing or out of date.
+#ifndef ANGELCODE_FONT_REBUILD_COMPILED
+	#ifdef _DEBUG
+		#define ANGELCODE_FONT_REBUILD_COMPILED 1
+	#else
+		#define ANGELCODE_FONT_REBUILD_COMPILED 0
+	#endif
+#endif
 
 class Blit3D;
 
@@ -26,29 +45,10 @@ namespace B3D
 	class TVertex;
 }
 
-class AngelcodeCharDescriptor
-{
-public:
-	float x, y;
-	float width, height;
-	float xOffset, yOffset;
-	float xAdvance;
-	int lookupVerts;
-	std::unordered_map<int32_t, float> kerningTable;
-
-	AngelcodeCharDescriptor() : x(0), y(0), width(0), height(0), xOffset(0), yOffset(0),
-		xAdvance(0), lookupVerts(0)
-	{ }
-};
-
 class AngelcodeFont
 {
 private:
-	char endian;
-	float lineHeight;
-	float base;
-	float scaleW, scaleH;
-	std::unordered_map<int32_t, AngelcodeCharDescriptor> Chars;
+	AngelcodeFontLayout layout; //glyphs and kerning, a glyph's quad is at its index in the VBO
 
 	//TODO: make verts local to the constructer instead of a member var?
 	B3D::TVertex *verts;  // memory for vertice data
@@ -61,24 +61,29 @@ private:
 	glm::mat4 modelMatrix; // Store the model matrix 
 	int modelMatrixLocation; // Store the location of our model matrix in the shader
 	int alphaLocation; //store the location of the alpha variable in the shader
-	GLSLProgram *prog; //our shader for 2d rendering
-	
-	int16_t ReadShort(int offset, char buffer[]);
-	int32_t ReadInt(int offset, char buffer[]);
-	int16_t ReadShortAndAdvance(int &offset, char buffer[]);
-	int32_t ReadIntAndAdvance(int &offset, char buffer[]);
-	uint32_t AngelcodeFont::ReadUIntAndAdvance(int &offset, char buffer[]);
+	GLSLProgram *prog; //our shader for 2d rendering, or shaderSDF for a distance field font
+	bool distanceField; //the texture is a distance field, drawn with prog and then back to shader2d
+	Blit3D *b3d; //for the matrices and shader2d, distance field fonts only
+
+	//loads the layout, the texture and the quads, for both constructors
+	void Load(const std::string &fontfile, AssetArchive *archive);
+	//fills layout from the compiled font, or from the .bin (compiling it again if it should)
+	bool LoadLayout(const std::string &fontfile, AssetArchive *archive);
 
 public:
 	GLfloat dest_x; //window coordinates of the center of the sprite, in pixels
 	GLfloat dest_y;
 	GLfloat angle; //angle of the sprite, in degrees
 	GLfloat alpha;
+	GLfloat scale; //size of the text, 1 draws it as big as it is in the texture
+	glm::vec4 color; //distance field fonts only, bitmap fonts are the colors of their texture
 
-	void BlitText(float x, float y, std::string output); //draws the string
-	float WidthText(std::string output);//returns the width of the text string, in pixels
+	void BlitText(float x, float y, std::string_view output); //draws the string
+	float WidthText(std::string_view output);//returns the width of the text string, in pixels
 	~AngelcodeFont();
-	AngelcodeFont(std::string fontfile, TextureManager *TexManager, GLSLProgram *shader);
+	AngelcodeFont(std::string fontfile, TextureManager *TexManager, GLSLProgram *shader, AssetArchive *archive = NULL);
+	//a distance field font, use Blit3D::MakeAngelcodeSDFFontFromBinary32()
+	AngelcodeFont(std::string fontfile, Blit3D *blit3D);
 
 };
 
@@ -0,0 +1,326 @@
+#include "AngelcodeFontLayout.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+namespace
+{
+	//the .bin is little-endian, whatever machine reads it, and its fields aren't aligned
+	uint16_t ReadU16(const unsigned char *p)
+	{
+		return (uint16_t)(p[0] | (p[1] << 8));
+	}
+
+	int16_t ReadS16(const unsigned char *p)
+	{
+		return (int16_t)ReadU16(p);
+	}
+
+	uint32_t ReadU32(const unsigned char *p)
+	{
+		return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	}
+
+	const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	bool GlyphCodeLess(const AngelcodeGlyph &glyph, int32_t code)
+	{
+		return glyph.code < code;
+	}
+
+	bool KerningPairLess(const AngelcodeKerningPair &a, const AngelcodeKerningPair &b)
+	{
+		if (a.second != b.second) return a.second < b.second;
+		return a.first < b.first;
+	}
+}
+
+AngelcodeFontLayout::AngelcodeFontLayout() : sourceHash(0), sourceSize(0), lineHeight(0), base(0), scaleW(1), scaleH(1)
+{
+	for (int32_t &index : directGlyphs) index = -1;
+}
+
+bool AngelcodeFontLayout::Parse(const unsigned char *data, size_t size)
+{
+	if (size < 4 || data[0] != 'B' || data[1] != 'M' || data[2] != 'F')
+	{
+		oLog(Level::Severe) << "Not a binary Angelcode font file";
+		return false;
+	}
+	if (data[3] != 3)
+	{
+		oLog(Level::Severe) << "Angelcode font is version " << (int)data[3] << ", only version 3 is supported";
+		return false;
+	}
+
+	glyphs.clear();
+	kerningPairs.clear();
+	textureName.clear();
+
+	//block type, block size, then the block
+	size_t offset = 4;
+	while (offset + 5 <= size)
+	{
+		unsigned char type = data[offset];
+		uint32_t blockSize = ReadU32(data + offset + 1);
+		const unsigned char *block = data + offset + 5;
+		if (blockSize > size - offset - 5)
+		{
+			oLog(Level::Severe) << "Angelcode font block " << (int)type << " runs past the end of the file";
+			return false;
+		}
+
+		switch (type)
+		{
+		case 2: //common block
+			if (blockSize < 10) return false;
+			lineHeight = (float)ReadU16(block);
+			base = (float)ReadU16(block + 2);
+			scaleW = (float)ReadU16(block + 4);
+			scaleH = (float)ReadU16(block + 6);
+			if (ReadU16(block + 8) != 1)
+			{
+				oLog(Level::Severe) << "Angelcode font has more than one texture page";
+				return false;
+			}
+			break;
+
+		case 3: //page block, just getting one texture name
+			textureName.assign((const char *)block, strnlen((const char *)block, blockSize));
+			break;
+
+		case 4: //character data
+		{
+			size_t count = blockSize / 20;
+			glyphs.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const unsigned char *c = block + i * 20;
+				AngelcodeGlyph glyph;
+				glyph.code = (int32_t)ReadU32(c);
+				glyph.x = ReadS16(c + 4);
+				glyph.y = ReadS16(c + 6);
+				glyph.width = ReadS16(c + 8);
+				glyph.height = ReadS16(c + 10);
+				glyph.xOffset = ReadS16(c + 12);
+				glyph.yOffset = -(float)ReadS16(c + 14); //negate y offsets for Blit3D coordinate system!
+				glyph.xAdvance = ReadS16(c + 16);
+				glyph.kerningStart = 0;
+				glyph.kerningCount = 0;
+				glyphs.push_back(glyph);
+				//page & chnl data skipped
+			}
+			break;
+		}
+
+		case 5: //kerning pairs data
+		{
+			size_t count = blockSize / 10;
+			kerningPairs.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const unsigned char *k = block + i * 10;
+				AngelcodeKerningPair pair;
+				pair.first = (int32_t)ReadU32(k);
+				pair.second = (int32_t)ReadU32(k + 4);
+				pair.amount = (float)ReadS16(k + 8);
+				kerningPairs.push_back(pair);
+			}
+			break;
+		}
+
+		default: //info block, and anything unknown
+			break;
+		}
+
+		offset += 5 + blockSize;
+	}
+
+	//some files have a glyph code more than once, the first one wins
+	std::stable_sort(glyphs.begin(), glyphs.end(), [](const AngelcodeGlyph &a, const AngelcodeGlyph &b) {
+		return a.code < b.code;
+	});
+	glyphs.erase(std::unique(glyphs.begin(), glyphs.end(), [](const AngelcodeGlyph &a, const AngelcodeGlyph &b) {
+		return a.code == b.code;
+	}), glyphs.end());
+
+	//a pair given twice keeps the last amount, pairs for glyphs the font hasn't got are dropped
+	std::stable_sort(kerningPairs.begin(), kerningPairs.end(), KerningPairLess);
+	size_t kept = 0;
+	for (size_t i = 0; i < kerningPairs.size(); ++i)
+	{
+		const AngelcodeKerningPair &pair = kerningPairs[i];
+		if (i + 1 < kerningPairs.size() && !KerningPairLess(pair, kerningPairs[i + 1])) continue;
+		std::vector<AngelcodeGlyph>::const_iterator glyph = std::lower_bound(glyphs.begin(), glyphs.end(), pair.second, GlyphCodeLess);
+		if (glyph == glyphs.end() || glyph->code != pair.second) continue;
+		kerningPairs[kept++] = pair;
+	}
+	kerningPairs.resize(kept);
+
+	sourceHash = HashSource(data, size);
+	sourceSize = (uint32_t)size;
+	BuildIndex();
+	return true;
+}
+
+bool AngelcodeFontLayout::LoadCompiled(const unsigned char *data, size_t size)
+{
+	AngelcodeCompiledHeader header;
+	if (size < sizeof(header)) return false;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, ANGELCODE_COMPILED_MAGIC, 4) != 0 || header.version != ANGELCODE_COMPILED_VERSION
+		|| header.byteOrder != BYTE_ORDER_MARK)
+	{
+		return false;
+	}
+
+	uint64_t needed = sizeof(header) + (uint64_t)header.glyphCount * sizeof(AngelcodeGlyph)
+		+ (uint64_t)header.kerningCount * sizeof(AngelcodeKerningPair) + header.textureNameSize;
+	if (needed > size) return false;
+
+	const unsigned char *p = data + sizeof(header);
+	glyphs.resize(header.glyphCount);
+	if (header.glyphCount > 0) memcpy(glyphs.data(), p, header.glyphCount * sizeof(AngelcodeGlyph));
+	p += header.glyphCount * sizeof(AngelcodeGlyph);
+	kerningPairs.resize(header.kerningCount);
+	if (header.kerningCount > 0) memcpy(kerningPairs.data(), p, header.kerningCount * sizeof(AngelcodeKerningPair));
+	p += header.kerningCount * sizeof(AngelcodeKerningPair);
+	textureName.assign((const char *)p, header.textureNameSize);
+
+	//the searches rely on the order
+	for (size_t i = 1; i < glyphs.size(); ++i)
+	{
+		if (glyphs[i - 1].code >= glyphs[i].code) return false;
+	}
+	for (size_t i = 1; i < kerningPairs.size(); ++i)
+	{
+		if (!KerningPairLess(kerningPairs[i - 1], kerningPairs[i])) return false;
+	}
+
+	lineHeight = header.lineHeight;
+	base = header.base;
+	scaleW = header.scaleW;
+	scaleH = header.scaleH;
+	sourceHash = header.sourceHash;
+	sourceSize = header.sourceSize;
+	BuildIndex();
+	return true;
+}
+
+bool AngelcodeFontLayout::SaveCompiled(const std::string &filename) const
+{
+	std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		oLog(Level::Warning) << "Could not write compiled font " << filename;
+		return false;
+	}
+
+	AngelcodeCompiledHeader header;
+	memcpy(header.magic, ANGELCODE_COMPILED_MAGIC, 4);
+	header.version = ANGELCODE_COMPILED_VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.glyphCount = (uint32_t)glyphs.size();
+	header.kerningCount = (uint32_t)kerningPairs.size();
+	header.textureNameSize = (uint32_t)textureName.size();
+	header.sourceSize = sourceSize;
+	header.reserved = 0;
+	header.sourceHash = sourceHash;
+	header.lineHeight = lineHeight;
+	header.base = base;
+	header.scaleW = scaleW;
+	header.scaleH = scaleH;
+
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)glyphs.data(), glyphs.size() * sizeof(AngelcodeGlyph));
+	out.write((const char *)kerningPairs.data(), kerningPairs.size() * sizeof(AngelcodeKerningPair));
+	out.write(textureName.data(), textureName.size());
+	if (!out)
+	{
+		oLog(Level::Warning) << "Could not write compiled font " << filename;
+		return false;
+	}
+	return true;
+}
+
+bool AngelcodeFontLayout::IsCompiledFrom(const unsigned char *data, size_t size) const
+{
+	return size == sourceSize && HashSource(data, size) == sourceHash;
+}
+
+void AngelcodeFontLayout::BuildIndex()
+{
+	for (int32_t &index : directGlyphs) index = -1;
+	for (size_t i = 0; i < glyphs.size(); ++i)
+	{
+		AngelcodeGlyph &glyph = glyphs[i];
+		if (glyph.code >= 0 && glyph.code < ANGELCODE_DIRECT_GLYPHS) directGlyphs[glyph.code] = (int32_t)i;
+		glyph.kerningStart = 0;
+		glyph.kerningCount = 0;
+	}
+
+	//both arrays are sorted by the glyph, so one walk finds every glyph's pairs
+	size_t g = 0;
+	for (size_t k = 0; k < kerningPairs.size(); ++k)
+	{
+		int32_t second = kerningPairs[k].second;
+		while (g < glyphs.size() && glyphs[g].code < second) g++;
+		if (g == glyphs.size()) break;
+		if (glyphs[g].code != second) continue;
+		if (glyphs[g].kerningCount == 0) glyphs[g].kerningStart = (uint32_t)k;
+		glyphs[g].kerningCount++;
+	}
+}
+
+const AngelcodeGlyph *AngelcodeFontLayout::SearchGlyph(int32_t code) const
+{
+	std::vector<AngelcodeGlyph>::const_iterator glyph = std::lower_bound(glyphs.begin(), glyphs.end(), code, GlyphCodeLess);
+	if (glyph == glyphs.end() || glyph->code != code) return NULL;
+	return &*glyph;
+}
+
+float AngelcodeFontLayout::SearchKerning(const AngelcodeGlyph &glyph, int32_t previous) const
+{
+	const AngelcodeKerningPair *first = kerningPairs.data() + glyph.kerningStart;
+	const AngelcodeKerningPair *last = first + glyph.kerningCount;
+
+	//most glyphs have a few pairs, a walk over them beats a search
+	if (glyph.kerningCount <= ANGELCODE_KERNING_SCAN)
+	{
+		for (const AngelcodeKerningPair *pair = first; pair != last; ++pair)
+		{
+			if (pair->first >= previous) return pair->first == previous ? pair->amount : 0.f;
+		}
+		return 0.f;
+	}
+
+	const AngelcodeKerningPair *pair = std::lower_bound(first, last, previous,
+		[](const AngelcodeKerningPair &pair, int32_t code) { return pair.first < code; });
+	if (pair == last || pair->first != previous) return 0.f;
+	return pair->amount;
+}
+
+uint64_t AngelcodeFontLayout::HashSource(const unsigned char *data, size_t size)
+{
+	//64-bit FNV-1a, like the asset archive's paths
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+std::string CompiledFontPath(const std::string &fontfile)
+{
+	size_t dot = fontfile.find_last_of('.');
+	size_t separator = fontfile.find_last_of("\\/");
+	if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) return fontfile + ANGELCODE_COMPILED_EXTENSION;
+	return fontfile.substr(0, dot) + ANGELCODE_COMPILED_EXTENSION;
+}
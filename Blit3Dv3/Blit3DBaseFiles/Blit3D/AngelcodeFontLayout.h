@@ -0,0 +1,128 @@
+#pragma once
+
+/*
+	Flat runtime layout of an Angelcode font: the glyphs in one array sorted by code,
+	with a direct index for ASCII, and all the kerning pairs in one array sorted by the
+	glyph they belong to, then by the glyph before it. Each glyph knows where its own
+	pairs start, so kerning is a search of a handful of neighbouring entries.
+
+	Parse() builds it from a binary (version 3) Angelcode .bin. The layout can also be
+	saved as a compiled font (.b3df), which is the header below followed by the two
+	arrays and the texture name exactly as they are in memory. Loading one is a check of
+	the header and two copies, no parsing: pack the .b3df into the asset archive and
+	it is copied straight out of the mapping.
+
+	A compiled font records the size and hash of the .bin it was made from, so a stale
+	one can be told apart. It is written in the byte order of the machine that made it,
+	and refused by one of the other byte order.
+
+	version 1.0
+*/
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#define ANGELCODE_COMPILED_MAGIC "B3DF"
+#define ANGELCODE_COMPILED_VERSION 1
+#define ANGELCODE_COMPILED_EXTENSION ".b3df"
+//glyph codes below this are found through the direct index, without a search
+#define ANGELCODE_DIRECT_GLYPHS 128
+//a glyph with up to this many kerning pairs has them scanned, more are binary searched
+#define ANGELCODE_KERNING_SCAN 8
+
+struct AngelcodeGlyph
+{
+	int32_t code;
+	float x, y; //in the texture, in pixels
+	float width, height;
+	float xOffset, yOffset; //yOffset is negated for the Blit3D coordinate system
+	float xAdvance;
+	uint32_t kerningStart; //its pairs in the kerning array
+	uint32_t kerningCount;
+};
+
+struct AngelcodeKerningPair
+{
+	int32_t second; //the glyph the pair belongs to
+	int32_t first; //the glyph before it
+	float amount;
+};
+
+struct AngelcodeCompiledHeader
+{
+	char magic[4]; //ANGELCODE_COMPILED_MAGIC
+	uint32_t version;
+	uint32_t byteOrder; //0x01020304 as written
+	uint32_t glyphCount;
+	uint32_t kerningCount;
+	uint32_t textureNameSize; //bytes of the texture name after the kerning pairs, no terminator
+	uint32_t sourceSize; //of the .bin it was compiled from
+	uint32_t reserved;
+	uint64_t sourceHash; //AngelcodeFontLayout::HashSource() of that .bin
+	float lineHeight;
+	float base;
+	float scaleW, scaleH;
+};
+
+static_assert(sizeof(AngelcodeGlyph) == 40, "AngelcodeGlyph is part of the compiled font format");
+static_assert(sizeof(AngelcodeKerningPair) == 12, "AngelcodeKerningPair is part of the compiled font format");
+static_assert(sizeof(AngelcodeCompiledHeader) == 56, "AngelcodeCompiledHeader is part of the compiled font format");
+
+class AngelcodeFontLayout
+{
+private:
+	std::vector<AngelcodeGlyph> glyphs; //sorted by code, unique
+	std::vector<AngelcodeKerningPair> kerningPairs; //sorted by second, then first
+	int32_t directGlyphs[ANGELCODE_DIRECT_GLYPHS]; //index into glyphs, -1 if the font hasn't got it
+	uint64_t sourceHash;
+	uint32_t sourceSize;
+
+	void BuildIndex();
+	const AngelcodeGlyph *SearchGlyph(int32_t code) const;
+	float SearchKerning(const AngelcodeGlyph &glyph, int32_t previous) const;
+
+public:
+	float lineHeight;
+	float base;
+	float scaleW, scaleH;
+	std::string textureName; //as named in the font, without the font's directory
+
+	AngelcodeFontLayout();
+
+	//reads a binary Angelcode font, false if it isn't one this can read
+	bool Parse(const unsigned char *data, size_t size);
+	//reads a compiled font, false if it is broken, of another version or byte order
+	bool LoadCompiled(const unsigned char *data, size_t size);
+	//writes the layout as a compiled font
+	bool SaveCompiled(const std::string &filename) const;
+	//true if the layout was compiled from this .bin, as it is now
+	bool IsCompiledFrom(const unsigned char *data, size_t size) const;
+
+	const std::vector<AngelcodeGlyph> &GetGlyphs() const { return glyphs; }
+	size_t GetKerningPairCount() const { return kerningPairs.size(); }
+
+	//the glyph for a character code, NULL if the font hasn't got it
+	const AngelcodeGlyph *FindGlyph(int32_t code) const
+	{
+		if (code >= 0 && code < ANGELCODE_DIRECT_GLYPHS)
+		{
+			int32_t index = directGlyphs[code];
+			return index < 0 ? NULL : &glyphs[index];
+		}
+		return SearchGlyph(code);
+	}
+	//the glyph's index in GetGlyphs(), which is also where its quad is in the font's VBO
+	size_t GlyphIndex(const AngelcodeGlyph *glyph) const { return glyph - glyphs.data(); }
+	//how far glyph moves when it follows previous, 0 if the pair isn't kerned
+	float Kerning(const AngelcodeGlyph &glyph, int32_t previous) const
+	{
+		return glyph.kerningCount == 0 ? 0.f : SearchKerning(glyph, previous);
+	}
+
+	static uint64_t HashSource(const unsigned char *data, size_t size);
+};
+
+//the compiled font's path for a font file: its extension replaced by ANGELCODE_COMPILED_EXTENSION
+std::string CompiledFontPath(const std::string &fontfile);
@@ -0,0 +1,291 @@
+#include "AssetArchive.h"
+#include "Logger.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+//use the main Blit3D logger
+extern logger oLog;
+
+AssetArchive::AssetArchive() : base(NULL), fileSize(0), entries(NULL), entryCount(0), names(NULL), namesSize(0),
+	looseOverride(ASSET_ARCHIVE_LOOSE_OVERRIDE), mappedLoads(0), looseLoads(0)
+{
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+#else
+	fileDescriptor = -1;
+#endif
+}
+
+AssetArchive::~AssetArchive()
+{
+	Close();
+}
+
+bool AssetArchive::Map(const std::string &filename)
+{
+#ifdef _WIN32
+	//the archive is laid out in load order, tell the cache manager to read ahead
+	fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0)
+	{
+		Unmap();
+		return false;
+	}
+	fileSize = (size_t)size.QuadPart;
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+	{
+		Unmap();
+		return false;
+	}
+
+	base = (const unsigned char *)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (base == NULL)
+	{
+		Unmap();
+		return false;
+	}
+#else
+	fileDescriptor = open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) return false;
+
+	struct stat info;
+	if (fstat(fileDescriptor, &info) != 0 || info.st_size == 0)
+	{
+		Unmap();
+		return false;
+	}
+	fileSize = (size_t)info.st_size;
+
+	void *mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		Unmap();
+		return false;
+	}
+	base = (const unsigned char *)mapping;
+
+	//the archive is laid out in load order, start reading all of it in now
+	madvise(mapping, fileSize, MADV_WILLNEED);
+#endif
+	return true;
+}
+
+void AssetArchive::Unmap()
+{
+#ifdef _WIN32
+	if (base != NULL) UnmapViewOfFile(base);
+	if (mappingHandle != NULL) CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	mappingHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (base != NULL) munmap((void *)base, fileSize);
+	if (fileDescriptor >= 0) close(fileDescriptor);
+	fileDescriptor = -1;
+#endif
+	base = NULL;
+	fileSize = 0;
+	entries = NULL;
+	entryCount = 0;
+	names = NULL;
+	namesSize = 0;
+}
+
+bool AssetArchive::Validate()
+{
+	if (fileSize < sizeof(AssetArchiveHeader)) return false;
+
+	const AssetArchiveHeader *header = (const AssetArchiveHeader *)base;
+	if (memcmp(header->magic, ASSET_ARCHIVE_MAGIC, 4) != 0)
+	{
+		oLog(Level::Severe) << "Not an asset archive: " << archiveName;
+		return false;
+	}
+	if (header->version != ASSET_ARCHIVE_VERSION)
+	{
+		oLog(Level::Severe) << "Asset archive " << archiveName << " is version " << header->version
+			<< ", expected " << ASSET_ARCHIVE_VERSION;
+		return false;
+	}
+
+	uint64_t indexSize = sizeof(AssetArchiveHeader) + (uint64_t)header->entryCount * sizeof(AssetArchiveEntry)
+		+ header->namesSize;
+	if (indexSize > fileSize) return false;
+
+	entries = (const AssetArchiveEntry *)(base + sizeof(AssetArchiveHeader));
+	entryCount = header->entryCount;
+	names = (const char *)(entries + entryCount);
+	namesSize = header->namesSize;
+	if (namesSize > 0 && names[namesSize - 1] != 0) return false;
+
+	for (uint32_t i = 0; i < entryCount; ++i)
+	{
+		const AssetArchiveEntry &entry = entries[i];
+		if (i > 0 && entry.hash < entries[i - 1].hash) return false;
+		if (entry.nameOffset >= namesSize) return false;
+		if (entry.offset > fileSize || entry.storedSize > fileSize - entry.offset) return false;
+	}
+	return true;
+}
+
+bool AssetArchive::Open(const std::string &filename)
+{
+	Close();
+	archiveName = filename;
+
+	if (!Map(filename))
+	{
+		oLog(Level::Warning) << "Could not map asset archive " << filename << ", using loose files";
+		return false;
+	}
+
+	if (!Validate())
+	{
+		oLog(Level::Severe) << "Asset archive " << filename << " is damaged, using loose files";
+		Unmap();
+		return false;
+	}
+
+	oLog(Level::Info) << "Mapped asset archive " << filename << ": " << entryCount << " assets, " << fileSize
+		<< " bytes" << (looseOverride ? ", loose files override it" : "");
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	if (base == NULL) return;
+
+	LogStats();
+	Unmap();
+}
+
+bool AssetArchive::IsOpen() const
+{
+	return base != NULL;
+}
+
+void AssetArchive::SetLooseOverride(bool on)
+{
+	looseOverride = on;
+}
+
+bool AssetArchive::GetLooseOverride() const
+{
+	return looseOverride;
+}
+
+const AssetArchiveEntry *AssetArchive::FindEntry(const std::string &path) const
+{
+	if (base == NULL) return NULL;
+
+	std::string normalized = NormalizeAssetPath(path);
+	uint64_t hash = AssetPathHash(normalized);
+
+	const AssetArchiveEntry *end = entries + entryCount;
+	const AssetArchiveEntry *entry = std::lower_bound(entries, end, hash,
+		[](const AssetArchiveEntry &e, uint64_t h) { return e.hash < h; });
+
+	//walk the (very rare) entries sharing the hash to find the right path
+	for (; entry != end && entry->hash == hash; ++entry)
+	{
+		if (normalized == names + entry->nameOffset) return entry;
+	}
+	return NULL;
+}
+
+bool AssetArchive::Find(const std::string &path, AssetData &data) const
+{
+	const AssetArchiveEntry *entry = FindEntry(path);
+	if (entry == NULL) return false;
+
+	if (looseOverride)
+	{
+		FILE *loose = fopen(path.c_str(), "rb");
+		if (loose != NULL)
+		{
+			fclose(loose);
+			return false;
+		}
+	}
+
+	if (entry->codec != (uint32_t)AssetCodec::STORED || entry->size != entry->storedSize)
+	{
+		oLog(Level::Severe) << "Asset " << path << " in " << archiveName << " uses unknown codec " << entry->codec;
+		return false;
+	}
+
+	data.buffer.clear();
+	data.bytes = base + entry->offset;
+	data.size = (size_t)entry->size;
+	data.mapped = true;
+	mappedLoads++;
+	return true;
+}
+
+bool AssetArchive::Load(const std::string &path, AssetData &data) const
+{
+	if (Find(path, data)) return true;
+
+	if (!LoadLooseFile(path, data)) return false;
+	looseLoads++;
+	return true;
+}
+
+bool AssetArchive::LoadLooseFile(const std::string &path, AssetData &data)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file == NULL) return false;
+
+	bool loaded = false;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long size = ftell(file);
+		if (size >= 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			data.buffer.resize((size_t)size);
+			loaded = size == 0 || fread(data.buffer.data(), 1, (size_t)size, file) == (size_t)size;
+		}
+	}
+	fclose(file);
+
+	if (!loaded)
+	{
+		oLog(Level::Severe) << "Error reading file: " << path;
+		data.buffer.clear();
+		return false;
+	}
+
+	data.bytes = data.buffer.data();
+	data.size = data.buffer.size();
+	data.mapped = false;
+	return true;
+}
+
+size_t AssetArchive::GetEntryCount() const
+{
+	return entryCount;
+}
+
+void AssetArchive::LogStats() const
+{
+	oLog(Level::Info) << "Asset archive " << archiveName << ": " << mappedLoads << " assets read from the archive, "
+		<< looseLoads << " from loose files";
+}
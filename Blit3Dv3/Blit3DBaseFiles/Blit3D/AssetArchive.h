@@ -0,0 +1,169 @@
+#pragma once
+
+/*
+	Read-only asset archive, memory-mapped in one go.
+
+	Textures, fonts and sound banks can be packed into one archive file with the
+	AssetPacker tool (see Tools/AssetPacker), in the order the game loads them, so a cold
+	start reads one file front to back instead of opening and reading each asset on its
+	own. The whole file is mapped with mmap()/MapViewOfFile() and assets are handed out
+	as pointers into the mapping, nothing is copied.
+
+	Layout, all integers little-endian:
+	- AssetArchiveHeader
+	- entryCount AssetArchiveEntry, sorted by hash, so a look-up is a binary search
+	- the paths of the entries, null-terminated, so hash collisions can be told apart
+	- the data of each entry, starting on an ASSET_ARCHIVE_ALIGNMENT boundary
+
+	Paths are looked up normalized: lower case, with '/' separators, so "Media\\Background.png"
+	and "media/background.png" are the same asset.
+
+	With the loose file override on (the default in debug builds), a file on disk at the
+	asset's path wins over the archive, so artists can drop in a new file without
+	repacking. Assets not in the archive, or everything if no archive was opened, are read
+	from loose files as before.
+
+	Open() and Close() must only be called while nothing else uses the archive.
+	Find() and Load() may be called from any thread in between.
+
+	version 1.0
+*/
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+#define ASSET_ARCHIVE_MAGIC "B3DA"
+#define ASSET_ARCHIVE_VERSION 1
+//asset data starts on these boundaries, enough for in-memory sound banks
+#define ASSET_ARCHIVE_ALIGNMENT 16
+
+//whether loose files win over the archive, on by default in debug builds
+#ifndef ASSET_ARCHIVE_LOOSE_OVERRIDE
+	#ifdef _DEBUG
+		#define ASSET_ARCHIVE_LOOSE_OVERRIDE true
+	#else
+		#define ASSET_ARCHIVE_LOOSE_OVERRIDE false
+	#endif
+#endif
+
+//how an asset is stored in the archive. PNGs and Vorbis banks are compressed already,
+//so for now everything is stored as is, other codecs are refused when loading.
+enum class AssetCodec : uint32_t { STORED = 0 };
+
+struct AssetArchiveHeader
+{
+	char magic[4]; //ASSET_ARCHIVE_MAGIC
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t namesSize; //bytes of paths after the entries
+};
+
+struct AssetArchiveEntry
+{
+	uint64_t hash; //AssetPathHash() of the normalized path
+	uint64_t offset; //from the start of the archive
+	uint64_t size; //once decoded
+	uint64_t storedSize; //in the archive
+	uint32_t codec; //an AssetCodec
+	uint32_t nameOffset; //from the start of the paths
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 16, "AssetArchiveHeader is part of the file format");
+static_assert(sizeof(AssetArchiveEntry) == 40, "AssetArchiveEntry is part of the file format");
+
+//lower case, '/' separators, no leading "./"
+inline std::string NormalizeAssetPath(const std::string &path)
+{
+	std::string normalized;
+	normalized.reserve(path.size());
+	for (char c : path)
+	{
+		if (c == '\\') c = '/';
+		else if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+		normalized += c;
+	}
+	while (normalized.compare(0, 2, "./") == 0) normalized.erase(0, 2);
+	return normalized;
+}
+
+//64-bit FNV-1a of a normalized path
+inline uint64_t AssetPathHash(const std::string &normalizedPath)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : normalizedPath)
+	{
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+//the bytes of an asset, either straight from the archive's mapping or read from a loose file
+class AssetData
+{
+public:
+	const unsigned char *bytes;
+	size_t size;
+	bool mapped; //true if bytes point into the archive, valid until it is closed
+	std::vector<unsigned char> buffer; //holds the loose file when not mapped
+
+	AssetData() : bytes(NULL), size(0), mapped(false) { }
+	//bytes may point into buffer, so no copies
+	AssetData(const AssetData &) = delete;
+	AssetData &operator=(const AssetData &) = delete;
+};
+
+class AssetArchive
+{
+private:
+	const unsigned char *base; //start of the mapping, NULL when closed
+	size_t fileSize;
+#ifdef _WIN32
+	void *fileHandle;
+	void *mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+	const AssetArchiveEntry *entries;
+	uint32_t entryCount;
+	const char *names;
+	uint32_t namesSize;
+	std::string archiveName;
+	bool looseOverride;
+
+	mutable std::atomic<uint64_t> mappedLoads;
+	mutable std::atomic<uint64_t> looseLoads;
+
+	bool Map(const std::string &filename);
+	void Unmap();
+	//checks the index against the file size, so a broken archive can't send us out of the mapping
+	bool Validate();
+	const AssetArchiveEntry *FindEntry(const std::string &path) const;
+
+public:
+	AssetArchive();
+	~AssetArchive();
+
+	//maps the archive, returns false (and keeps using loose files) if it is missing or broken
+	bool Open(const std::string &filename);
+	void Close();
+	bool IsOpen() const;
+
+	//loose files at an asset's path win over the archive while this is on
+	void SetLooseOverride(bool on);
+	bool GetLooseOverride() const;
+
+	//points data at the asset in the archive, false if it isn't there, is overridden by a
+	//loose file or isn't STORED. Nothing is read until the bytes are touched.
+	bool Find(const std::string &path, AssetData &data) const;
+	//Find(), or else the loose file at path. false if neither exists.
+	bool Load(const std::string &path, AssetData &data) const;
+	//reads a whole file from disk, no archive involved
+	static bool LoadLooseFile(const std::string &path, AssetData &data);
+
+	size_t GetEntryCount() const;
+	void LogStats() const;
+};
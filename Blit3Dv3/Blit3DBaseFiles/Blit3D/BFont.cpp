@@ -132,6 +132,7 @@ void BFont::BlitText(bool whichFont, float x, float y, std::string output)
 	prog->setUniform("modelMatrix", modelMatrix);
 	prog->setUniform("in_Scale_X", 1.f); //default scaling
 	prog->setUniform("in_Scale_Y", 1.f); //default scaling
+	prog->setUniform("in_UVRect", glm::vec4(0.f, 0.f, 1.f, 1.f)); //whole texture, sprites change it
 	int letter;
 
 	float scale = fontSize / 128;
@@ -1,9 +1,10 @@
 #include "Blit3D.h"
 
-logger oLog("Blit3D.log", false);
+logger oLog{"Blit3D.log", false}; //braces, oLog( is the logging macro
 
 void(*Blit3DDoFileDrop)(int, const char**);
 void(*Blit3DDoInput)(int, int, int, int);
+InputQueue *Blit3DInputQueue = NULL; //set when key events are queued instead of handed to DoInput()
 void(*Blit3DCursorPosition)(double, double);
 void(*Blit3DMouseButton)(int, int, int);
 void(*Blit3DScrollwheel)(double, double);
@@ -20,6 +21,8 @@ void SimpleThreadUpdate(void(*Update)(double))
 	double time = glfwGetTime();
 	double prevTime = time;
 	double elapsedTime = 0;
+	//everything this thread allocates is the game's
+	AllocationScope gameplay(AllocTag::GAMEPLAY);
 
 	for(;;)
 	{
@@ -44,6 +47,8 @@ void MultiThreadUpdate(void(*Update)(double))
 	double time = glfwGetTime();
 	double prevTime = time;
 	double elapsedTime = 0;
+	//everything this thread allocates is the game's
+	AllocationScope gameplay(AllocTag::GAMEPLAY);
 
 	for(;;)
 	{
@@ -67,7 +72,8 @@ static void drop_callback(GLFWwindow* window, int count, const char** paths)
 
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-	if(Blit3DDoInput) Blit3DDoInput(key, scancode, action, mods);
+	if(Blit3DInputQueue) Blit3DInputQueue->Push(key, scancode, action, mods);
+	else if(Blit3DDoInput) Blit3DDoInput(key, scancode, action, mods);
 }
 
 static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
@@ -96,6 +102,7 @@ Blit3D::Blit3D(Blit3DWindowModel windowMode, int width, int height)
 	DeInit = NULL;
 	DoInput = NULL;
 	Blit3DDoInput = NULL;
+	Blit3DInputQueue = NULL;
 	Sync = NULL;
 	DoCursor = NULL;
 	Blit3DCursorPosition = NULL;
@@ -114,7 +121,13 @@ Blit3D::Blit3D(Blit3DWindowModel windowMode, int width, int height)
 	farplane = 10000.f;
 
 	shader2d = NULL;
+	shaderSDF = NULL;
 	window = NULL;
+
+	spriteQuadVao = 0;
+	spriteQuadVbo = 0;
+
+	spriteStats = SpriteStats();
 }
 
 Blit3D::Blit3D()
@@ -128,6 +141,7 @@ Blit3D::Blit3D()
 	DeInit = NULL;
 	DoInput = NULL;
 	Blit3DDoInput = NULL;
+	Blit3DInputQueue = NULL;
 	Sync = NULL;
 	DoCursor = NULL;
 	Blit3DCursorPosition = NULL;
@@ -146,12 +160,21 @@ Blit3D::Blit3D()
 	farplane = 10000.f;
 
 	shader2d = NULL;
+	shaderSDF = NULL;
 	window = NULL;
+
+	spriteQuadVao = 0;
+	spriteQuadVbo = 0;
+
+	spriteStats = SpriteStats();
 }
 
 
 Blit3D::~Blit3D()
 {
+	//GLFW's key callback mustn't find a queue that's gone
+	if (Blit3DInputQueue == &inputQueue) Blit3DInputQueue = NULL;
+
 	//free all font memory first
 	for (std::unordered_set<AngelcodeFont *>::iterator itr = fontSet.begin(); itr != fontSet.end(); itr++)
 	{
@@ -166,6 +189,18 @@ Blit3D::~Blit3D()
 	}
 	spriteSet.clear(); // clear the elements 
 
+	//and the cached ones, whether they are still in use or not
+	for (auto &cached : spriteCache)
+	{
+		delete cached.second.sprite;
+	}
+	spriteCache.clear();
+	cachedSpriteKeys.clear();
+
+	//free the quad the sprites drew
+	if (spriteQuadVbo) glDeleteBuffers(1, &spriteQuadVbo);
+	if (spriteQuadVao) glDeleteVertexArrays(1, &spriteQuadVao);
+
 	//free the managers and all of their associated memory
 	if (tManager) delete tManager;
 	if (sManager) delete sManager;
@@ -208,6 +243,11 @@ void Blit3D::SetDoInput(void(*func)(int, int, int, int))
 	Blit3DDoInput = DoInput;
 }
 
+void Blit3D::SetQueueInput(bool queue)
+{
+	Blit3DInputQueue = queue ? &inputQueue : NULL;
+}
+
 void Blit3D::SetSync(void(*func)(void))
 {
 	Sync = func;
@@ -375,6 +415,7 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 
 	sManager = new ShaderManager();
 	tManager = new TextureManager();
+	tManager->SetArchive(&assets);
 
 	projectionMatrix = glm::mat4(1.f);
 	viewMatrix = glm::mat4(1.f);
@@ -401,12 +442,13 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 		"uniform float in_Alpha = 1.f; \n"
 		"uniform float in_Scale_X = 1.f; \n"
 		"uniform float in_Scale_Y = 1.f; \n"
+		"uniform vec4 in_UVRect = vec4(0.0, 0.0, 1.0, 1.0); \n" //part of the texture to map: corner, then size
 		"out vec2 v_texcoord; \n"
 		//"out vec4 gl_Position; \n"
 		"void main(void)\n"
 		"{\n"
 			"gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(in_Position.x * in_Scale_X, in_Position.y * in_Scale_Y, in_Position.z, 1.0); \n"
-			"v_texcoord = in_Texcoord; \n"
+			"v_texcoord = in_UVRect.xy + in_Texcoord * in_UVRect.zw; \n"
 		"}";
 
 	std::string frag2d = "#version 330 \n" 
@@ -425,6 +467,30 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 	shader2d->bindAttribLocation(0, "in_Position");
 	shader2d->bindAttribLocation(1, "in_Texcoord");
 
+	//distance field fonts: the texture's alpha is the distance to the glyph's edge, 0.5 on it,
+	//and fwidth() keeps the edge about a pixel wide whatever the font is scaled to
+	std::string fragSDF = "#version 330 \n"
+		"uniform sampler2D mytexture; \n"
+		"in vec2 v_texcoord; \n"
+		"uniform float in_Alpha; \n"
+		"uniform vec4 in_Color = vec4(1.0, 1.0, 1.0, 1.0); \n"
+		"out vec4 out_Color; \n"
+		"void main(void)"
+		"{ \n"
+		"float distance = texture(mytexture, v_texcoord).a; \n"
+		"float edge = max(fwidth(distance) * 0.5, 0.001); \n"
+		"float coverage = smoothstep(0.5 - edge, 0.5 + edge, distance); \n"
+		"out_Color = vec4(in_Color.rgb, in_Color.a * coverage * in_Alpha); \n"
+		"}";
+
+	shaderSDF = sManager->UseShader("shaderSDF_built_in.vert", "shaderSDF_built_in.frag", vert2d, fragSDF); //load/compile/link
+	shaderSDF->bindAttribLocation(0, "in_Position");
+	shaderSDF->bindAttribLocation(1, "in_Texcoord");
+	shader2d->use();
+
+	//the one quad every sprite draws
+	MakeSpriteQuad();
+
 	//2d orthographic projection
 	SetMode(Blit3DRenderMode::BLIT2D);
 
@@ -467,10 +533,15 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 
 		while(!glfwWindowShouldClose(window))
 		{
+			frameArena.BeginFrame();
 
-			Draw();
+			{
+				AllocationScope render(AllocTag::RENDER);
+				Draw();
+			}
 			// put the stuff we've been drawing onto the display
 			glfwSwapBuffers(window);
+			inputQueue.Presented();
 
 			B3D::loopMutex.lock();
 			if(Sync != NULL) Sync();
@@ -479,6 +550,9 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 			glfwPollEvents();
 			if(DoJoystick) DoJoystick();
 			B3D::loopMutex.unlock();
+
+			frameArena.EndFrame();
+			AllocationTracker::EndFrame();
 		}
 
 		B3D::quitLooping = true;
@@ -492,14 +566,22 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 
 		while(!glfwWindowShouldClose(window))
 		{
+			frameArena.BeginFrame();
 
-			Draw();
+			{
+				AllocationScope render(AllocTag::RENDER);
+				Draw();
+			}
 			// put the stuff we've been drawing onto the display
 			glfwSwapBuffers(window);
+			inputQueue.Presented();
 
 			// update other events like input handling 
 			glfwPollEvents();
 			if(DoJoystick) DoJoystick();
+
+			frameArena.EndFrame();
+			AllocationTracker::EndFrame();
 		}
 
 		B3D::quitLooping = true;
@@ -514,16 +596,28 @@ int Blit3D::Run(Blit3DThreadModel threadType)
 			time = glfwGetTime();
 			elapsedTime = time - prevTime;
 			prevTime = time;
+			frameArena.BeginFrame();
 						
-			Update(elapsedTime);
-
-			Draw();
+			{
+				AllocationScope gameplay(AllocTag::GAMEPLAY);
+				Update(elapsedTime);
+			}
+
+			{
+				AllocationScope render(AllocTag::RENDER);
+				Draw();
+			}
 			// put the stuff we've been drawing onto the display
 			glfwSwapBuffers(window);
+			inputQueue.Presented();
 
 			// update other events like input handling 
 			glfwPollEvents();
 			if(DoJoystick) DoJoystick();
+
+			//everything allocated from the arena this frame goes
+			frameArena.EndFrame();
+			AllocationTracker::EndFrame();
 		}
 		break;
 	}
@@ -538,16 +632,73 @@ error:
 	return 0;
 }
 
+void Blit3D::MakeSpriteQuad()
+{
+	B3D::TVertex verts[4];
+
+	// generate a new VAO and get the associated ID
+	glGenVertexArrays(1, &spriteQuadVao); // Create our Vertex Array Object  
+	glBindVertexArray(spriteQuadVao); // Bind our Vertex Array Object so we can use it  
+
+	// generate a new VBO and get the associated ID
+	glGenBuffers(1, &spriteQuadVbo);
+
+	// bind VBO in order to use
+	glBindBuffer(GL_ARRAY_BUFFER, spriteQuadVbo);
+
+	//one pixel across, centered on the origin: sprites scale it to their size
+	//and pick the part of their texture to show with in_UVRect
+	/*
+
+	0-------2
+	|       |
+	|       |
+	|       |
+	1-------3
+	*/
+
+	//front side, counterclockwise
+	//point 0
+	verts[0].x = -0.5f;		verts[0].y = 0.5f;		verts[0].z = 0.f;
+	verts[0].u = 0.f;	verts[0].v = 1.f;
+	//point 1
+	verts[1].x = -0.5f;		verts[1].y = -0.5f;		verts[1].z = 0.f;
+	verts[1].u = 0.f;	verts[1].v = 0.f;
+	//point 2
+	verts[2].x = 0.5f;		verts[2].y = 0.5f;		verts[2].z = 0.f;
+	verts[2].u = 1.f;	verts[2].v = 1.f;
+	//point 3
+	verts[3].x = 0.5f;		verts[3].y = -0.5f;		verts[3].z = 0.f;
+	verts[3].u = 1.f;	verts[3].v = 0.f;
+
+	// upload data to VBO
+	glBufferData(GL_ARRAY_BUFFER, sizeof(B3D::TVertex) * 4, verts, GL_STATIC_DRAW);
+
+	// Set up our vertex attributes pointers
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(0)); //3 values (x,y,z) per point, start at 0 offset 	
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(sizeof(GLfloat)* 3)); //Start after x,y,z data 
+
+	// activate attribute array
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glDisableVertexAttribArray(2); //don't use channel 2
+	glDisableVertexAttribArray(3); //don't use Color channel, we are textured
+
+	glBindVertexArray(0); // Disable our Vertex Array Object
+	glBindBuffer(GL_ARRAY_BUFFER, 0);// Disable our Vertex Buffer Object
+}
+
 Sprite *Blit3D::MakeSprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height, std::string TextureFileName)
 {
 	//use a lock gaurd to lock until function returns
 	std::lock_guard<std::mutex> lock(spriteMutex);
 
 	//create a new sprite from a bitmap file
-	Sprite *sprite =  new Sprite(startX, startY, width, height, TextureFileName, tManager, shader2d);
+	Sprite *sprite =  new Sprite(startX, startY, width, height, TextureFileName, tManager, shader2d, spriteQuadVao);
 
 	//add sprite pointer to the set tracking all allocated sprites
 	spriteSet.insert(sprite);
+	SpriteMade(sprite);
 
 	return sprite;
 }
@@ -558,9 +709,10 @@ Sprite*Blit3D::MakeSprite(RenderBuffer *rb)
 	std::lock_guard<std::mutex> lock(spriteMutex);
 
 	//create a new sprite from a renderbuffer
-	Sprite *sprite = new Sprite(rb, tManager, shader2d);
+	Sprite *sprite = new Sprite(rb, tManager, shader2d, spriteQuadVao);
 
 	spriteSet.insert(sprite);
+	SpriteMade(sprite);
 
 	return sprite;
 }
@@ -574,15 +726,132 @@ void Blit3D::DeleteSprite(Sprite *sprite)
 	if (it != spriteSet.end())
 	{
 		//delete the sprite and remove from set
+		SpriteFreed(*it);
 		delete *it;
 		spriteSet.erase(it);
 	}
+	else if (ReleaseCachedSprite(sprite))
+	{
+		//others may be using it, so only this use was let go of
+		oLog(Level::Warning) << "DeleteSprite() called on cached Sprite * " << sprite << ", released it instead";
+	}
 	else
 	{
 		oLog(Level::Warning) << "DeleteSprite() called on non-existant Sprite * " << sprite;
 	}
 }
 
+Sprite *Blit3D::AcquireSprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height, std::string TextureFileName)
+{
+	//use a lock gaurd to lock until function returns
+	std::lock_guard<std::mutex> lock(spriteMutex);
+
+	//the same file spelled differently is still the same sprite
+	std::ostringstream key;
+	key << NormalizeAssetPath(TextureFileName) << '|' << startX << '|' << startY << '|' << width << '|' << height;
+
+	std::unordered_map<std::string, CachedSprite>::iterator it = spriteCache.find(key.str());
+	if (it != spriteCache.end())
+	{
+		if (it->second.refCount == 0) spriteStats.cachedSpritesInUse++;
+		it->second.refCount++;
+		spriteStats.cacheHits++;
+		return it->second.sprite;
+	}
+
+	//first time: make it like MakeSprite() does, but keep it in the cache rather than spriteSet
+	Sprite *sprite = new Sprite(startX, startY, width, height, TextureFileName, tManager, shader2d, spriteQuadVao);
+	CachedSprite cached;
+	cached.sprite = sprite;
+	cached.refCount = 1;
+	spriteCache[key.str()] = cached;
+	cachedSpriteKeys[sprite] = key.str();
+
+	SpriteMade(sprite);
+	spriteStats.cachedSprites++;
+	spriteStats.cachedSpritesInUse++;
+	spriteStats.cacheMisses++;
+	return sprite;
+}
+
+bool Blit3D::ReleaseCachedSprite(Sprite *sprite)
+{
+	std::unordered_map<Sprite *, std::string>::iterator key = cachedSpriteKeys.find(sprite);
+	if (key == cachedSpriteKeys.end()) return false;
+
+	CachedSprite &cached = spriteCache[key->second];
+	if (cached.refCount <= 0)
+	{
+		oLog(Level::Warning) << "ReleaseSprite() called more times than AcquireSprite() on Sprite * " << sprite;
+		return true;
+	}
+
+	//unused sprites stay cached, the next AcquireSprite() gets them back for free
+	cached.refCount--;
+	if (cached.refCount == 0) spriteStats.cachedSpritesInUse--;
+	return true;
+}
+
+void Blit3D::ReleaseSprite(Sprite *sprite)
+{
+	//use a lock gaurd to lock until function returns
+	std::lock_guard<std::mutex> lock(spriteMutex);
+
+	if (!ReleaseCachedSprite(sprite))
+	{
+		oLog(Level::Warning) << "ReleaseSprite() called on uncached Sprite * " << sprite;
+	}
+}
+
+void Blit3D::PurgeSpriteCache()
+{
+	//use a lock gaurd to lock until function returns
+	std::lock_guard<std::mutex> lock(spriteMutex);
+
+	for (std::unordered_map<std::string, CachedSprite>::iterator it = spriteCache.begin(); it != spriteCache.end();)
+	{
+		if (it->second.refCount > 0)
+		{
+			++it;
+			continue;
+		}
+
+		SpriteFreed(it->second.sprite);
+		cachedSpriteKeys.erase(it->second.sprite);
+		delete it->second.sprite;
+		it = spriteCache.erase(it);
+		spriteStats.cachedSprites--;
+	}
+}
+
+void Blit3D::SpriteMade(Sprite *sprite)
+{
+	spriteStats.liveSprites++;
+	spriteStats.liveBytes += sprite->GetMemoryUsed();
+	if (spriteStats.liveSprites > spriteStats.peakSprites) spriteStats.peakSprites = spriteStats.liveSprites;
+	if (spriteStats.liveBytes > spriteStats.peakBytes) spriteStats.peakBytes = spriteStats.liveBytes;
+}
+
+void Blit3D::SpriteFreed(Sprite *sprite)
+{
+	spriteStats.liveSprites--;
+	spriteStats.liveBytes -= sprite->GetMemoryUsed();
+}
+
+SpriteStats Blit3D::GetSpriteStats()
+{
+	std::lock_guard<std::mutex> lock(spriteMutex);
+	return spriteStats;
+}
+
+void Blit3D::LogSpriteStats()
+{
+	SpriteStats stats = GetSpriteStats();
+	oLog(Level::Info) << "Sprites: " << stats.liveSprites << " live (" << stats.liveBytes << " bytes), peak "
+		<< stats.peakSprites << " (" << stats.peakBytes << " bytes). Cache: " << stats.cachedSprites << " sprites, "
+		<< stats.cachedSpritesInUse << " in use, " << stats.cacheHits << " hits, " << stats.cacheMisses << " misses";
+}
+
 BFont *Blit3D::MakeBFont(std::string TextureFileName, std::string widths_file, float fontsize)
 {
 	return new BFont(TextureFileName, widths_file, fontsize, tManager, shader2d);
@@ -594,13 +863,26 @@ AngelcodeFont *Blit3D::MakeAngelcodeFontFromBinary32(std::string filename)
 	std::lock_guard<std::mutex> lock(spriteMutex);
 
 	//create new font
-	AngelcodeFont *afont = new AngelcodeFont(filename, tManager, shader2d);
+	AngelcodeFont *afont = new AngelcodeFont(filename, tManager, shader2d, &assets);
 	
 	fontSet.insert(afont);
 	
 	return afont;
 }
 
+AngelcodeFont *Blit3D::MakeAngelcodeSDFFontFromBinary32(std::string filename)
+{
+	//use a lock gaurd to lock until function returns
+	std::lock_guard<std::mutex> lock(fontMutex);
+
+	//create new font
+	AngelcodeFont *afont = new AngelcodeFont(filename, this);
+
+	fontSet.insert(afont);
+
+	return afont;
+}
+
 void Blit3D::DeleteFont(AngelcodeFont *font)
 {
 	//use a lock gaurd to lock until function returns
@@ -647,6 +929,7 @@ void Blit3D::SetMode(Blit3DRenderMode newMode)
 		shader2d->setUniform("in_Alpha", 1.f);
 		shader2d->setUniform("in_Scale_X", 1.f);
 		shader2d->setUniform("in_Scale_Y", 1.f);
+		shader2d->setUniform("in_UVRect", glm::vec4(0.f, 0.f, 1.f, 1.f));
 	}
 	else
 	{
@@ -665,6 +948,7 @@ void Blit3D::SetMode(Blit3DRenderMode newMode)
 		shader2d->setUniform("in_Alpha", 1.f);	
 		shader2d->setUniform("in_Scale_X", 1.f);
 		shader2d->setUniform("in_Scale_Y", 1.f);
+		shader2d->setUniform("in_UVRect", glm::vec4(0.f, 0.f, 1.f, 1.f));
 	}
 
 }
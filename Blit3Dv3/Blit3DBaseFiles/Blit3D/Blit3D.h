@@ -1,4 +1,25 @@
 /* Blit3D cross-platform game graphics library, written by Darren Reid
+version 3.91 - added inputQueue: after SetQueueInput(true) key events are stamped and queued instead of going
+	straight to DoInput(), so a fixed-step Update() can take them tick by tick, see InputQueue.h. The queue
+	measures input to simulation and input to present latency, every loop mode tells it when a frame is presented.
+version 3.9 - added distance field Angelcode fonts: MakeAngelcodeSDFFontFromBinary32() loads a font whose texture
+	is a signed distance field (see Tools/FontSDF), drawn with the new built-in shaderSDF so it stays sharp at any
+	scale. Set the font's scale and color before BlitText().
+version 3.8 - added AllocationTracker: build with ALLOCATION_TRACKING 1 to count heap allocations by subsystem
+	(render, texture, font, audio, gameplay, logging) in any build, see AllocationTracker.h. Update() and
+	Draw() are tagged, and the tracker's per-frame counts are taken after every frame.
+version 3.7 - added frameArena, a per-frame bump arena for formatted text and scratch memory, reset after every
+	frame (see FrameArena.h). Angelcode fonts take std::string_view, so text from the arena or a literal draws
+	without a heap allocation. Needs C++17.
+version 3.6 - added a sprite cache: AcquireSprite() hands out one shared sprite per (file, x, y, width, height),
+	counted with ReleaseSprite(). Released sprites stay cached, so making the same sprites over and over
+	(a new game every time ENTER is pressed) takes no new memory. GetSpriteStats()/LogSpriteStats() report
+	live and peak sprite memory. Cached sprites are shared, so set angle before blitting them.
+version 3.5 - sprites no longer have their own VAO/VBO, they all draw one shared unit quad, sized with
+	in_Scale_X/Y and cropped to their part of the texture with the new in_UVRect uniform of the 2D shader.
+	Making a sprite from a loaded texture takes no GL calls.
+version 3.4 - textures and Angelcode fonts are read through the assets archive when one is open,
+	see AssetArchive.h. Open it before Run(), or in Init() before loading anything.
 version 3.31 - if passing a shader to SetMode, it now gets used() automatically in 3D mode.
 version 3.3 - changed from using deprecated Quads to triangle strips for sprites.
 version 3.21 - added directory path to the stored texture name, so they free properly
@@ -72,6 +93,7 @@ version 0.11
 #include <cassert>
 #include <sstream> 
 #include <unordered_set>
+#include <unordered_map>
 
 #include <atomic>
 #include <mutex>
@@ -79,6 +101,9 @@ version 0.11
 #include "TextureManager.h"
 #include "ShaderManager.h"
 #include "RenderBuffer.h"
+#include "FrameArena.h"
+#include "InputQueue.h"
+#include "AllocationTracker.h"
 #include "Sprite.h"
 #include "BFont.h"
 #include "AngelcodeFont.h"
@@ -115,6 +140,19 @@ enum class Blit3DWindowModel { DECORATEDWINDOW = 1, FULLSCREEN, BORDERLESSFULLSC
 
 enum class Blit3DRenderMode { BLIT2D = 0, BLIT3D };
 
+//what the sprites Blit3D tracks use, from GetSpriteStats()
+struct SpriteStats
+{
+	size_t liveSprites; //made and not deleted, cached ones included
+	size_t peakSprites;
+	size_t liveBytes; //memory the live sprites use
+	size_t peakBytes;
+	size_t cachedSprites; //in the cache, in use or not
+	size_t cachedSpritesInUse; //cached sprites with a refcount above 0
+	uint64_t cacheHits; //AcquireSprite() calls that got a cached sprite
+	uint64_t cacheMisses; //AcquireSprite() calls that had to make one
+};
+
 
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
@@ -128,6 +166,9 @@ class Blit3D
 public:
 	ShaderManager *sManager;
 	TextureManager *tManager;
+	AssetArchive assets; //packed textures and fonts, loose files are used when it isn't open
+	FrameArena frameArena; //memory for this frame only, freed after Draw() returns and input is handled
+	InputQueue inputQueue; //key events for Update() to take, after SetQueueInput(true)
 
 	GLFWwindow* window;
 
@@ -141,6 +182,7 @@ public:
 
 	float nearplane, farplane;
 	GLSLProgram *shader2d;
+	GLSLProgram *shaderSDF; //draws distance field fonts, same vertex shader as shader2d
 
 	//function pointers
 private:
@@ -159,8 +201,29 @@ private:
 	std::mutex spriteMutex;
 	std::unordered_set<Sprite *> spriteSet;
 
+	//sprites shared through AcquireSprite(), by file and source rectangle
+	struct CachedSprite
+	{
+		Sprite *sprite;
+		int refCount; //0 when nothing uses it, it stays cached until PurgeSpriteCache()
+	};
+	std::unordered_map<std::string, CachedSprite> spriteCache;
+	std::unordered_map<Sprite *, std::string> cachedSpriteKeys; //back from a sprite to its cache entry
+	SpriteStats spriteStats;
+
+	//keep spriteStats up to date, called with spriteMutex held
+	void SpriteMade(Sprite *sprite);
+	void SpriteFreed(Sprite *sprite);
+	//lets go of one use of a cached sprite, false if it isn't cached. Called with spriteMutex held.
+	bool ReleaseCachedSprite(Sprite *sprite);
+
 	std::mutex fontMutex;
 	std::unordered_set<AngelcodeFont *> fontSet;
+
+	//unit quad shared by all sprites
+	GLuint spriteQuadVao;
+	GLuint spriteQuadVbo;
+	void MakeSpriteQuad();
 	
 public:	
 
@@ -176,12 +239,26 @@ public:
 
 	Sprite *MakeSprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height, std::string TextureFileName);
 	Sprite *MakeSprite(RenderBuffer *rb);
+	//DeleteSprite() on a sprite from AcquireSprite() releases it instead
 	void DeleteSprite(Sprite *sprite);
+
+	//returns the cached sprite for this file and source rectangle, making it the first time,
+	//and counts a use of it. Hand it back with ReleaseSprite(), never DeleteSprite() it yourself.
+	//Cached sprites are shared: their size and texture never change, but angle and the other
+	//drawing values are everyone's, so set what you need before each Blit().
+	Sprite *AcquireSprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height, std::string TextureFileName);
+	void ReleaseSprite(Sprite *sprite);
+	//frees the cached sprites nothing uses any more (and their textures, if nothing else uses them)
+	void PurgeSpriteCache();
+	SpriteStats GetSpriteStats();
+	void LogSpriteStats();
 	
 	RenderBuffer *MakeRenderBuffer(int width, int height, std::string name);
 	
 	BFont *MakeBFont(std::string TextureFileName, std::string widths_file, float fontsize);
 	AngelcodeFont *MakeAngelcodeFontFromBinary32(std::string filename);
+	//a font whose texture is a signed distance field, it binds shaderSDF to draw and shader2d after
+	AngelcodeFont *MakeAngelcodeSDFFontFromBinary32(std::string filename);
 	void DeleteFont(AngelcodeFont *font);
 	
 	void Reshape(GLSLProgram *shader);
@@ -196,6 +273,8 @@ public:
 	void SetDraw(void(*func)(void));
 	void SetDeInit(void(*func)(void));
 	void SetDoInput(void(*func)(int, int, int, int));
+	//true: key events go to inputQueue instead of DoInput(), the game pops them and calls DoInput() itself
+	void SetQueueInput(bool queue);
 	void SetSync(void(*func)(void));
 	void SetDoCursor(void(*func)(double, double));
 	void SetDoMouseButton(void(*func)(int, int, int));
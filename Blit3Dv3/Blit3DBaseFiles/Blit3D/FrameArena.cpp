@@ -0,0 +1,170 @@
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "Logger.h"
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+uint64_t FrameArena::HeapAllocationCount()
+{
+	return AllocationTracker::ThreadAllocationCount();
+}
+
+FrameArena::FrameArena(size_t initialCapacity) : capacity(initialCapacity), used(0), overflowUsed(0),
+	highWaterMark(0), frameNumber(0), overflowFrames(0), frameStartAllocations(0), frameHeapAllocations(0)
+{
+	if (capacity == 0) capacity = 1;
+	block.reset(new unsigned char[capacity]);
+	//room for a few blocks that don't fit, so overflowing doesn't also grow the list
+	overflow.reserve(16);
+}
+
+void FrameArena::BeginFrame()
+{
+	frameStartAllocations = HeapAllocationCount();
+}
+
+void FrameArena::EndFrame()
+{
+	frameHeapAllocations = HeapAllocationCount() - frameStartAllocations;
+
+	size_t frameUsed = used + overflowUsed;
+	if (frameUsed > highWaterMark) highWaterMark = frameUsed;
+
+	if (!overflow.empty())
+	{
+		//grow to what this frame needed with some room to spare, so the next ones fit
+		overflowFrames++;
+		overflow.clear();
+		capacity = highWaterMark + highWaterMark / 4;
+		block.reset(new unsigned char[capacity]);
+		oLog(Level::Warning) << "Frame arena overflowed, grew it to " << capacity << " bytes. Raise FRAME_ARENA_SIZE.";
+	}
+
+	used = 0;
+	overflowUsed = 0;
+	frameNumber++;
+}
+
+void *FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+
+	uintptr_t base = (uintptr_t)block.get();
+	size_t start = (size_t)(((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+	if (start <= capacity && bytes <= capacity - start)
+	{
+		used = start + bytes;
+		return block.get() + start;
+	}
+
+	return AllocateOverflow(bytes, alignment);
+}
+
+void *FrameArena::AllocateOverflow(size_t bytes, size_t alignment)
+{
+	size_t size = bytes + alignment;
+	overflow.emplace_back(new unsigned char[size]);
+	overflowUsed += size;
+
+	uintptr_t memory = (uintptr_t)overflow.back().get();
+	return (void *)((memory + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+std::string_view FrameArena::Copy(std::string_view text)
+{
+	char *copy = AllocateArray<char>(text.size() + 1);
+	if (!text.empty()) memcpy(copy, text.data(), text.size());
+	copy[text.size()] = 0;
+	return std::string_view(copy, text.size());
+}
+
+std::string_view FrameArena::Format(const char *format, ...)
+{
+	//try what's left of the block first, most text fits
+	uintptr_t base = (uintptr_t)block.get();
+	char *text = (char *)(base + used);
+	size_t room = capacity - used;
+
+	va_list args;
+	va_start(args, format);
+	va_list retry;
+	va_copy(retry, args);
+	int length = vsnprintf(text, room, format, args);
+	va_end(args);
+
+	if (length < 0)
+	{
+		va_end(retry);
+		return std::string_view();
+	}
+
+	if ((size_t)length < room)
+	{
+		used += length + 1;
+	}
+	else
+	{
+		text = AllocateArray<char>(length + 1);
+		vsnprintf(text, length + 1, format, retry);
+	}
+	va_end(retry);
+
+	return std::string_view(text, length);
+}
+
+size_t FrameArena::GetCapacity() const
+{
+	return capacity;
+}
+
+size_t FrameArena::GetUsed() const
+{
+	return used + overflowUsed;
+}
+
+size_t FrameArena::GetHighWaterMark() const
+{
+	return highWaterMark;
+}
+
+uint64_t FrameArena::GetFrameNumber() const
+{
+	return frameNumber;
+}
+
+uint64_t FrameArena::GetFrameHeapAllocations() const
+{
+	return frameHeapAllocations;
+}
+
+void FrameArena::LogStats() const
+{
+	oLog(Level::Info) << "Frame arena: " << frameNumber << " frames, high-water mark " << highWaterMark
+		<< " of " << capacity << " bytes, " << overflowFrames << " frames overflowed";
+}
+
+FrameAllocationCheck::FrameAllocationCheck(const FrameArena &frameArena, const char *name)
+	: arena(frameArena), scopeName(name), startAllocations(FrameArena::HeapAllocationCount())
+{
+}
+
+FrameAllocationCheck::~FrameAllocationCheck()
+{
+#if FRAME_ARENA_CHECK_ALLOCATIONS
+	if (arena.GetFrameNumber() < FRAME_ARENA_WARMUP_FRAMES) return;
+
+	uint64_t allocations = FrameArena::HeapAllocationCount() - startAllocations;
+	if (allocations != 0)
+	{
+		oLog(Level::Severe) << scopeName << " made " << allocations << " heap allocations in frame "
+			<< arena.GetFrameNumber() << ", it should make none";
+		assert(allocations == 0 && "heap allocation where there should be none, see the log");
+	}
+#endif
+}
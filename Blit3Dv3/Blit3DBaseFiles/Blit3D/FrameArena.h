@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+	Per-frame bump arena for the short-lived things a frame needs: formatted text,
+	scratch arrays. Allocate() only moves a pointer along one block of memory, and the
+	whole block is handed back at once when the frame ends, so nothing is freed one by one.
+
+	Blit3D owns one (blit3D->frameArena) and calls BeginFrame()/EndFrame() around every
+	frame, so anything allocated from it is only good until the end of the frame it was
+	made in. Never keep a pointer or string_view into it past that. In the multithreaded
+	loop modes it belongs to the thread running Draw(), don't use it from Update() there.
+
+	If a frame asks for more than the block holds, the extra is taken from the heap and
+	the block grows to the high-water mark when the frame ends, so the next frames fit
+	again. GetHighWaterMark() tells you what to set FRAME_ARENA_SIZE to.
+
+	Allocation checking: with FRAME_ARENA_CHECK_ALLOCATIONS on (the default in debug
+	builds) the global operator new is replaced by one that counts the heap allocations
+	each thread makes (it lives in AllocationTracker.cpp, which also hooks it for
+	ALLOCATION_TRACKING). A FrameAllocationCheck asserts that no heap allocation happened on
+	its thread while it was in scope, once the first FRAME_ARENA_WARMUP_FRAMES frames are
+	over, so put one at the top of code that should be allocation free in steady state,
+	like Draw(). GetFrameHeapAllocations() counts them for the whole last frame.
+
+	version 1.1 - the operator new hook moved to AllocationTracker.cpp, shared with allocation tracking
+	version 1.0
+*/
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <stdint.h>
+
+//bytes in the arena's block to begin with
+#ifndef FRAME_ARENA_SIZE
+#define FRAME_ARENA_SIZE (64 * 1024)
+#endif
+
+//frames to let go by before FrameAllocationCheck asserts, caches fill up on the first ones
+#ifndef FRAME_ARENA_WARMUP_FRAMES
+#define FRAME_ARENA_WARMUP_FRAMES 60
+#endif
+
+//count heap allocations, so FrameAllocationCheck can assert there were none
+#ifndef FRAME_ARENA_CHECK_ALLOCATIONS
+	#ifdef _DEBUG
+		#define FRAME_ARENA_CHECK_ALLOCATIONS 1
+	#else
+		#define FRAME_ARENA_CHECK_ALLOCATIONS 0
+	#endif
+#endif
+
+class FrameArena
+{
+private:
+	std::unique_ptr<unsigned char[]> block;
+	size_t capacity;
+	size_t used;
+	size_t overflowUsed; //bytes handed out from the heap this frame, after the block filled up
+	std::vector<std::unique_ptr<unsigned char[]>> overflow;
+	size_t highWaterMark; //most bytes a frame has used, block and overflow
+	uint64_t frameNumber;
+	uint64_t overflowFrames; //frames that didn't fit in the block
+	uint64_t frameStartAllocations; //HeapAllocationCount() at BeginFrame()
+	uint64_t frameHeapAllocations; //heap allocations the last whole frame made
+
+	void *AllocateOverflow(size_t bytes, size_t alignment);
+
+public:
+	FrameArena(size_t initialCapacity = FRAME_ARENA_SIZE);
+	FrameArena(const FrameArena &) = delete;
+	FrameArena &operator=(const FrameArena &) = delete;
+
+	//Blit3D calls these around each frame. EndFrame() frees everything allocated in it.
+	void BeginFrame();
+	void EndFrame();
+
+	//uninitialized memory, good until the end of the frame. alignment must be a power of two.
+	void *Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+	template<typename T>
+	T *AllocateArray(size_t count)
+	{
+		return static_cast<T *>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	//copies text into the arena, the view is null-terminated past its end
+	std::string_view Copy(std::string_view text);
+	//printf() into the arena, the view is null-terminated past its end
+	std::string_view Format(const char *format, ...);
+
+	size_t GetCapacity() const;
+	size_t GetUsed() const; //this frame so far, block and overflow
+	size_t GetHighWaterMark() const;
+	uint64_t GetFrameNumber() const;
+	//heap allocations made on the frame's thread during the last whole frame, 0 if not counted
+	uint64_t GetFrameHeapAllocations() const;
+	void LogStats() const;
+
+	//heap allocations made so far by the calling thread, always 0 unless
+	//FRAME_ARENA_CHECK_ALLOCATIONS or ALLOCATION_TRACKING is on
+	static uint64_t HeapAllocationCount();
+};
+
+//asserts, in builds with FRAME_ARENA_CHECK_ALLOCATIONS, that the calling thread makes no heap
+//allocations while it is in scope. Does nothing during the arena's warm-up frames.
+class FrameAllocationCheck
+{
+private:
+	const FrameArena &arena;
+	const char *scopeName;
+	uint64_t startAllocations;
+
+public:
+	FrameAllocationCheck(const FrameArena &frameArena, const char *name);
+	~FrameAllocationCheck();
+	FrameAllocationCheck(const FrameAllocationCheck &) = delete;
+	FrameAllocationCheck &operator=(const FrameAllocationCheck &) = delete;
+};
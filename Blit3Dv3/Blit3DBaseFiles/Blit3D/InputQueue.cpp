@@ -0,0 +1,128 @@
+#include "InputQueue.h"
+#include "Logger.h"
+#include <cstring>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+const std::chrono::steady_clock::time_point InputQueue::start = std::chrono::steady_clock::now();
+
+InputLatency::InputLatency() : events(0), total(0.0), longest(0.0)
+{
+	memset(buckets, 0, sizeof(buckets));
+}
+
+void InputLatency::Add(double seconds)
+{
+	if (seconds < 0.0) seconds = 0.0;
+	events++;
+	total += seconds;
+	if (seconds > longest) longest = seconds;
+	size_t bucket = (size_t)(seconds * 1000.0);
+	if (bucket > INPUT_LATENCY_BUCKETS) bucket = INPUT_LATENCY_BUCKETS;
+	buckets[bucket]++;
+}
+
+double InputLatency::Average() const
+{
+	return events > 0 ? total / events : 0.0;
+}
+
+double InputLatency::Percentile(double fraction) const
+{
+	if (events == 0) return 0.0;
+	uint64_t wanted = (uint64_t)(fraction * events + 0.5);
+	if (wanted < 1) wanted = 1;
+	uint64_t seen = 0;
+	for (size_t bucket = 0; bucket < INPUT_LATENCY_BUCKETS; ++bucket)
+	{
+		seen += buckets[bucket];
+		if (seen >= wanted) return (bucket + 1) / 1000.0 < longest ? (bucket + 1) / 1000.0 : longest;
+	}
+	return longest;
+}
+
+InputQueue::InputQueue() : head(0), count(0), droppedEvents(0), awaitingCount(0)
+{
+}
+
+double InputQueue::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool InputQueue::Push(int key, int scancode, int action, int mods)
+{
+	double time = Now();
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (count == INPUT_QUEUE_SIZE)
+	{
+		droppedEvents++;
+		return false;
+	}
+
+	InputEvent &event = events[(head + count) % INPUT_QUEUE_SIZE];
+	event.time = time;
+	event.key = key;
+	event.scancode = scancode;
+	event.action = action;
+	event.mods = mods;
+	count++;
+	return true;
+}
+
+bool InputQueue::Pop(double before, InputEvent &event)
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (count == 0 || events[head].time >= before) return false;
+
+	event = events[head];
+	head = (head + 1) % INPUT_QUEUE_SIZE;
+	count--;
+
+	toSimulation.Add(Now() - event.time);
+	if (awaitingCount < INPUT_QUEUE_SIZE) awaitingPresent[awaitingCount++] = event.time;
+	return true;
+}
+
+void InputQueue::Presented()
+{
+	double time = Now();
+	std::lock_guard<std::mutex> lock(queueMutex);
+	for (size_t i = 0; i < awaitingCount; ++i) toPresent.Add(time - awaitingPresent[i]);
+	awaitingCount = 0;
+}
+
+InputLatency InputQueue::GetSimulationLatency()
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return toSimulation;
+}
+
+InputLatency InputQueue::GetPresentLatency()
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return toPresent;
+}
+
+uint64_t InputQueue::GetDroppedEvents()
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return droppedEvents;
+}
+
+void InputQueue::LogStats()
+{
+	InputLatency simulation = GetSimulationLatency();
+	InputLatency present = GetPresentLatency();
+	uint64_t dropped = GetDroppedEvents();
+
+	oLog(Level::Info) << "Input to simulation: " << simulation.events << " events, " << simulation.Average() * 1000.0
+		<< " ms average, " << simulation.Percentile(0.99) * 1000.0 << " ms 99th percentile, " << simulation.longest * 1000.0 << " ms longest";
+	oLog(Level::Info) << "Input to present: " << present.events << " events, " << present.Average() * 1000.0
+		<< " ms average, " << present.Percentile(0.99) * 1000.0 << " ms 99th percentile, " << present.longest * 1000.0 << " ms longest";
+	if (dropped > 0)
+	{
+		oLog(Level::Warning) << "Input queue was full, " << dropped << " key events were dropped";
+	}
+}
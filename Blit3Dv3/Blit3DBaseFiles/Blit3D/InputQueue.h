@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+	Timestamped key events, for games that run a fixed-step simulation. Instead of GLFW's
+	key callback calling DoInput() whenever glfwPollEvents() runs, Blit3D stamps each
+	event with Now() and puts it in a ring, and the game takes the events out tick by tick:
+	Pop() only hands out events stamped before the time it is given, so each tick gets the
+	events that happened before the end of the stretch of time it simulates.
+
+	Turn it on with blit3D->SetQueueInput(true), then in Update() work out where each tick
+	ends on Now()'s clock and Pop() up to there before running the tick.
+
+	It also measures input latency: from an event's stamp to the Pop() that hands it to
+	the game (input to simulation), and from the stamp to the end of the first
+	glfwSwapBuffers() after that Pop() (input to present). Events are stamped when
+	glfwPollEvents() delivers them, not when the key was pressed, so both leave out the
+	time an event waits for the next poll, up to a frame.
+
+	Safe to push from the thread polling GLFW and pop from the one running Update().
+
+	version 1.0
+*/
+
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+#include <stdint.h>
+
+//events waiting for the game, more than this and new ones are dropped
+#ifndef INPUT_QUEUE_SIZE
+#define INPUT_QUEUE_SIZE 256
+#endif
+
+//the latency histograms have 1 ms buckets up to this, slower events all go in the last one
+#define INPUT_LATENCY_BUCKETS 100
+
+struct InputEvent
+{
+	double time; //InputQueue::Now() when the event was delivered
+	int key;
+	int scancode;
+	int action;
+	int mods;
+};
+
+//one kind of input latency, in seconds
+struct InputLatency
+{
+	uint64_t events;
+	double total;
+	double longest;
+	uint32_t buckets[INPUT_LATENCY_BUCKETS + 1];
+
+	InputLatency();
+	void Add(double seconds);
+	double Average() const;
+	//the latency this fraction of the events were at or under, to the millisecond
+	double Percentile(double fraction) const;
+};
+
+class InputQueue
+{
+private:
+	std::mutex queueMutex;
+	InputEvent events[INPUT_QUEUE_SIZE]; //ring, oldest at head
+	size_t head;
+	size_t count;
+	uint64_t droppedEvents;
+
+	//stamps of the events popped since the last present
+	double awaitingPresent[INPUT_QUEUE_SIZE];
+	size_t awaitingCount;
+
+	InputLatency toSimulation;
+	InputLatency toPresent;
+
+	static const std::chrono::steady_clock::time_point start;
+
+public:
+	InputQueue();
+	InputQueue(const InputQueue &) = delete;
+	InputQueue &operator=(const InputQueue &) = delete;
+
+	//seconds on the queue's clock, which the event stamps are on
+	static double Now();
+
+	//stamps the event and adds it, false if the queue is full and it was dropped
+	bool Push(int key, int scancode, int action, int mods);
+	//takes the oldest event if it was stamped before the time given, false if there isn't one
+	bool Pop(double before, InputEvent &event);
+	//the frame just presented shows the events popped since the last one, Blit3D calls it after glfwSwapBuffers()
+	void Presented();
+
+	InputLatency GetSimulationLatency();
+	InputLatency GetPresentLatency();
+	uint64_t GetDroppedEvents();
+	void LogStats();
+};
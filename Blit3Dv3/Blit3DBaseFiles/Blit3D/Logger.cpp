@@ -1,10 +1,11 @@
 #include "Logger.h"
-#include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <ctime>
-#include <iomanip>
+#include <cstdio>
+#include <cstring>
 
-/* 
+/*
 	std::localtime() is thread unsafe, so I use a wrapper for it from:
 	http://kjellkod.wordpress.com/2013/01/22/exploring-c11-part-2-localtime-and-time-again/
 
@@ -13,63 +14,70 @@
 
 namespace g2
 {
-	typedef std::chrono::time_point<std::chrono::system_clock>  system_time_point;
-
 	tm localtime(const std::time_t& time)
 	{
 		std::tm tm_snapshot;
 #if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
 		localtime_s(&tm_snapshot, &time);
 #else
-		localtime_r(&time, &tm_snapshot); // POSIX  
+		localtime_r(&time, &tm_snapshot); // POSIX
 #endif
 		return tm_snapshot;
 	}
+} // g2-namespace
 
+// The ring a thread logs into, handed back when the thread ends so a new one can have it
+struct LoggerThreadRing
+{
+	logger* owner = NULL;
+	logger::Ring* ring = NULL;
 
-	// To simplify things the return value is just a string. I.e. by design!  
-	std::string put_time(const std::tm* date_time, const char* c_time_format)
+	~LoggerThreadRing()
 	{
-#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
-		std::ostringstream oss;
-
-		// BOGUS hack done for VS2012: C++11 non-conformant since it SHOULD take a "const struct tm*  "
-		// ref. C++11 standard: ISO/IEC 14882:2011,  27.7.1, 
-		oss << std::put_time(const_cast<std::tm*>(date_time), c_time_format);
-		return oss.str();
-
-#else    // LINUX
-		const size_t size = 1024;
-		char buffer[size];
-		auto success = std::strftime(buffer, size, c_time_format, date_time);
-
-		if(0 == success)
-			return c_time_format;
-
-		return buffer;
-#endif
+		if (ring != NULL) ring->owned.store(false, std::memory_order_release);
 	}
+};
+
+static thread_local LoggerThreadRing threadLoggerRing;
 
+static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of two");
 
-	// extracting std::time_t from std:chrono for "now"
-	std::time_t systemtime_now()
+logger::logger(std::string filename, bool append) : m_nRingCount(0), m_nSequence(0), m_nDropped(0),
+	m_nReportedDropped(0), m_nTimestampSecond(0), m_bStopping(false)
+{
+	for (int i = 0; i < LOG_MAX_THREADS; ++i)
 	{
-		system_time_point system_now = std::chrono::system_clock::now();
-		return std::chrono::system_clock::to_time_t(system_now);
+		m_aRings[i].store(NULL, std::memory_order_relaxed);
+		m_aBatchHeads[i] = 0;
 	}
+	m_aTimestamp[0] = 0;
+	m_oBatch.reserve(LOG_RING_RECORDS * 4);
 
-} // g2-namespace
-
-logger::logger(std::string filename, bool append)
-{
 	if(append) m_oFile.open(filename, std::fstream::out | std::fstream::app | std::fstream::ate);
 	else m_oFile.open(filename, std::fstream::out | std::fstream::trunc);
+
+	m_oWriter = std::thread(&logger::writerLoop, this);
 }
 
 logger::~logger()
 {
+	{
+		std::lock_guard<std::mutex> lock(m_oWakeMutex);
+		m_bStopping = true;
+	}
+	m_oWake.notify_one();
+	if (m_oWriter.joinable()) m_oWriter.join();
+
+	//whatever came in while the writer was stopping
+	writeWaiting();
 	m_oFile.flush();
 	m_oFile.close();
+
+	for (int i = 0; i < LOG_MAX_THREADS; ++i)
+	{
+		delete m_aRings[i].load(std::memory_order_relaxed);
+		m_aRings[i].store(NULL, std::memory_order_relaxed);
+	}
 }
 
 logstream logger::operator()()
@@ -82,42 +90,251 @@ logstream logger::operator()(Level nLevel)
 	return logstream(*this, nLevel);
 }
 
-std::string logger::getTimestamp()
-{	
-	std::tm tm = g2::localtime(g2::systemtime_now());
-	std::stringstream buffer;
-	std::stringstream ss;
-	ss << g2::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-	return ss.str();
+logger::Ring* logger::threadRing()
+{
+	LoggerThreadRing& cached = threadLoggerRing;
+	if (cached.owner == this) return cached.ring;
+
+	//first message from this thread: take a ring a finished thread left empty, or make one
+	std::lock_guard<std::mutex> lock(m_oMutex);
+	Ring* ring = NULL;
+	uint32_t count = m_nRingCount.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Ring* candidate = m_aRings[i].load(std::memory_order_relaxed);
+		if (!candidate->owned.load(std::memory_order_acquire) &&
+			candidate->head.load(std::memory_order_relaxed) == candidate->tail.load(std::memory_order_acquire))
+		{
+			ring = candidate;
+			break;
+		}
+	}
+	if (ring == NULL && count < LOG_MAX_THREADS)
+	{
+		ring = new Ring();
+		ring->head.store(0, std::memory_order_relaxed);
+		ring->tail.store(0, std::memory_order_relaxed);
+		m_aRings[count].store(ring, std::memory_order_release);
+		m_nRingCount.store(count + 1, std::memory_order_release);
+	}
+	//too many threads, this one's messages get dropped
+	if (ring == NULL) return NULL;
+
+	ring->owned.store(true, std::memory_order_relaxed);
+	if (cached.ring != NULL) cached.ring->owned.store(false, std::memory_order_release);
+	cached.owner = this;
+	cached.ring = ring;
+	return ring;
 }
 
-void logger::log(Level nLevel, std::string oMessage)
+void logger::log(Level nLevel, std::string_view oMessage)
 {
-	const static char* LevelStr[] = { "Finest", "Finer", "Fine", "Config", "Info", "Warning", "Severe" };
-	
-	m_oMutex.lock();
-	m_oFile << '[' << getTimestamp() << ']' 
-		<< '[' << LevelStr[nLevel] << "]\t"
-		<< oMessage << std::endl;
-	m_oMutex.unlock();
+	Ring* ring = threadRing();
+	if (ring == NULL)
+	{
+		m_nDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	uint32_t head = ring->head.load(std::memory_order_relaxed);
+	uint32_t waiting = head - ring->tail.load(std::memory_order_acquire);
+	if (waiting >= LOG_RING_RECORDS)
+	{
+		m_nDropped.fetch_add(1, std::memory_order_relaxed);
+		m_oWake.notify_one();
+		return;
+	}
+
+	Record& record = ring->records[head & (LOG_RING_RECORDS - 1)];
+	record.sequence = m_nSequence.fetch_add(1, std::memory_order_relaxed);
+	record.time = std::chrono::system_clock::now();
+	record.level = nLevel;
+	record.length = (uint32_t)(oMessage.size() < LOG_MESSAGE_SIZE ? oMessage.size() : LOG_MESSAGE_SIZE);
+	memcpy(record.text, oMessage.data(), record.length);
+	//last, the writer reads the record once it sees this
+	ring->head.store(head + 1, std::memory_order_release);
+
+	//errors go out right away, and a filling ring shouldn't wait for the next interval
+	if (nLevel >= Severe || waiting + 1 >= LOG_RING_RECORDS / 2) m_oWake.notify_one();
+}
+
+void logger::flush()
+{
+	writeWaiting();
+}
+
+uint64_t logger::droppedMessages()
+{
+	return m_nDropped.load(std::memory_order_relaxed);
+}
+
+void logger::writerLoop()
+{
+	//everything this thread allocates is the logger's
+	AllocationScope loggingAllocations(AllocTag::LOGGING);
+
+	std::unique_lock<std::mutex> lock(m_oWakeMutex);
+	while (!m_bStopping)
+	{
+		//woken early for errors and filling rings
+		m_oWake.wait_for(lock, std::chrono::milliseconds(LOG_WRITE_INTERVAL_MS));
+
+		lock.unlock();
+		writeWaiting();
+		lock.lock();
+	}
+}
+
+void logger::writeTimestamp(std::chrono::system_clock::time_point time)
+{
+	//most of a batch is logged within the same second
+	std::time_t second = std::chrono::system_clock::to_time_t(time);
+	if (second != m_nTimestampSecond || m_aTimestamp[0] == 0)
+	{
+		std::tm tm = g2::localtime(second);
+		if (std::strftime(m_aTimestamp, sizeof(m_aTimestamp), "%Y-%m-%d %H:%M:%S", &tm) == 0) m_aTimestamp[0] = 0;
+		m_nTimestampSecond = second;
+	}
+	m_oFile << '[' << m_aTimestamp << ']';
 }
 
-logstream::logstream(logger& oLogger, Level nLevel) : 
-m_oLogger(oLogger), m_nLevel(nLevel)
+void logger::writeWaiting()
 {
+	const static char* LevelStr[] = { "Finest", "Finer", "Fine", "Config", "Info", "Warning", "Severe" };
+
+	std::lock_guard<std::mutex> lock(m_oWriteMutex);
+
+	m_oBatch.clear();
+	uint32_t count = m_nRingCount.load(std::memory_order_acquire);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Ring* ring = m_aRings[i].load(std::memory_order_acquire);
+		uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint32_t head = ring->head.load(std::memory_order_acquire);
+		m_aBatchHeads[i] = head;
+		for (; tail != head; ++tail)
+		{
+			PendingRecord pending = { &ring->records[tail & (LOG_RING_RECORDS - 1)] };
+			m_oBatch.push_back(pending);
+		}
+	}
+
+	//back in the order they were logged in, across threads
+	std::sort(m_oBatch.begin(), m_oBatch.end());
+	for (const PendingRecord& pending : m_oBatch)
+	{
+		const Record& record = *pending.record;
+		writeTimestamp(record.time);
+		m_oFile << '[' << LevelStr[record.level] << "]\t";
+		m_oFile.write(record.text, record.length);
+		m_oFile << '\n';
+	}
+
+	//hand the records back to their threads
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		m_aRings[i].load(std::memory_order_relaxed)->tail.store(m_aBatchHeads[i], std::memory_order_release);
+	}
+
+	uint64_t dropped = m_nDropped.load(std::memory_order_relaxed);
+	if (dropped != m_nReportedDropped)
+	{
+		writeTimestamp(std::chrono::system_clock::now());
+		m_oFile << "[Warning]\t" << dropped - m_nReportedDropped
+			<< " log messages were dropped, their thread's ring was full. Raise LOG_RING_RECORDS.\n";
+		m_nReportedDropped = dropped;
+	}
+
+	if (!m_oBatch.empty()) m_oFile.flush();
 }
 
-logstream::logstream(const logstream& ls) : 
-m_oLogger(ls.m_oLogger), m_nLevel(ls.m_nLevel)
+logstream::logstream(logger& oLogger, Level nLevel) :
+m_oLogger(oLogger), m_nLevel(nLevel), m_oAllocationScope(AllocTag::LOGGING), m_nLength(0), m_bTruncated(false)
 {
-	// As of GCC 8.4.1 basic_stream is still lacking a copy constructor 
-	// (part of C++11 specification)
-	// 
-	// GCC compiler expects the copy constructor even thought because of 
-	// RVO this constructor is never used
 }
 
 logstream::~logstream()
 {
-	m_oLogger.log(m_nLevel, str());
+	if (m_bTruncated && m_nLength >= 3) memcpy(m_aText + m_nLength - 3, "...", 3);
+	m_oLogger.log(m_nLevel, std::string_view(m_aText, m_nLength));
+}
+
+void logstream::append(const char* text, size_t length)
+{
+	size_t room = LOG_MESSAGE_SIZE - m_nLength;
+	if (length > room)
+	{
+		length = room;
+		m_bTruncated = true;
+	}
+	memcpy(m_aText + m_nLength, text, length);
+	m_nLength += length;
+}
+
+template<typename T>
+logstream& logstream::appendFormatted(const char* format, T value)
+{
+	char number[64];
+	int length = snprintf(number, sizeof(number), format, value);
+	if (length > 0) append(number, (size_t)length < sizeof(number) ? (size_t)length : sizeof(number) - 1);
+	return *this;
 }
+
+logstream& logstream::operator<<(std::string_view text)
+{
+	append(text.data(), text.size());
+	return *this;
+}
+
+logstream& logstream::operator<<(const std::string& text)
+{
+	append(text.data(), text.size());
+	return *this;
+}
+
+logstream& logstream::operator<<(const char* text)
+{
+	if (text == NULL) return *this << "(null)";
+	append(text, strlen(text));
+	return *this;
+}
+
+logstream& logstream::operator<<(char* text)
+{
+	return *this << (const char*)text;
+}
+
+logstream& logstream::operator<<(const unsigned char* text)
+{
+	return *this << (const char*)text;
+}
+
+logstream& logstream::operator<<(char c)
+{
+	append(&c, 1);
+	return *this;
+}
+
+logstream& logstream::operator<<(unsigned char c)
+{
+	return *this << (char)c;
+}
+
+logstream& logstream::operator<<(bool b)
+{
+	//the way ostream writes them
+	return *this << (b ? '1' : '0');
+}
+
+logstream& logstream::operator<<(short n) { return appendFormatted("%d", (int)n); }
+logstream& logstream::operator<<(unsigned short n) { return appendFormatted("%u", (unsigned int)n); }
+logstream& logstream::operator<<(int n) { return appendFormatted("%d", n); }
+logstream& logstream::operator<<(unsigned int n) { return appendFormatted("%u", n); }
+logstream& logstream::operator<<(long n) { return appendFormatted("%ld", n); }
+logstream& logstream::operator<<(unsigned long n) { return appendFormatted("%lu", n); }
+logstream& logstream::operator<<(long long n) { return appendFormatted("%lld", n); }
+logstream& logstream::operator<<(unsigned long long n) { return appendFormatted("%llu", n); }
+//%g is ostream's default, 6 significant digits
+logstream& logstream::operator<<(float f) { return appendFormatted("%g", (double)f); }
+logstream& logstream::operator<<(double d) { return appendFormatted("%g", d); }
+logstream& logstream::operator<<(const void* pointer) { return appendFormatted("%p", pointer); }
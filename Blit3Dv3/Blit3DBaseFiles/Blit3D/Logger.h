@@ -1,41 +1,139 @@
 /*
-	Thread-safe simple logger, coded by Vili Petek 
+	Thread-safe simple logger, coded by Vili Petek
 	http://vilipetek.com/2014/04/17/thread-safe-simple-logger-in-c11/
 
 	Edited by Darren Reid to make it even more thread safe.
 
+	Made asynchronous: logging a message only formats it into a fixed-size record and
+	puts it in the calling thread's own ring buffer, with no lock and no heap allocation
+	for the usual types. A writer thread collects the records from every thread in
+	batches, puts them back in the order they were logged, timestamps them and writes
+	them out, flushing the file once a batch. So the game, render, loader and audio
+	threads never wait on the log file.
+
+	Messages below LOG_MIN_LEVEL are compiled out: oLog(level) is a macro, and nothing
+	streamed into a message below the threshold is even evaluated. With a constant level
+	the compiler drops the whole message. If a thread's ring is full the message is dropped and counted, the
+	writer logs how many were.
+
 	Example usage:
 
 		#include "Logger.h"
 
-		logger oLog("test.log");
+		logger oLog{"test.log", false}; //braces, oLog( is the logging macro
 
 		...
 
 		oLog() << "Value of x: "<< x << ", y:  " << y;
+		oLog(Level::Warning) << "Something went wrong";
 */
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <mutex>
 #include <memory>
 #include <fstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <type_traits>
+#include <stdint.h>
+#include "AllocationTracker.h"
 
 // log message levels
 enum Level	{ Finest, Finer, Fine, Config, Info, Warning, Severe };
+
+// messages below this level are compiled out
+#ifndef LOG_MIN_LEVEL
+	#ifdef _DEBUG
+		#define LOG_MIN_LEVEL Finest
+	#else
+		#define LOG_MIN_LEVEL Info
+	#endif
+#endif
+
+// characters a message can hold, longer ones are cut short
+#ifndef LOG_MESSAGE_SIZE
+#define LOG_MESSAGE_SIZE 480
+#endif
+
+// messages each thread can have waiting for the writer, must be a power of two
+#ifndef LOG_RING_RECORDS
+#define LOG_RING_RECORDS 256
+#endif
+
+// threads that can log at once, each gets a ring the first time it logs
+#ifndef LOG_MAX_THREADS
+#define LOG_MAX_THREADS 64
+#endif
+
+// how often the writer thread wakes up to write what's waiting
+#ifndef LOG_WRITE_INTERVAL_MS
+#define LOG_WRITE_INTERVAL_MS 50
+#endif
+
+constexpr bool LogLevelEnabled() { return Info >= LOG_MIN_LEVEL; }
+constexpr bool LogLevelEnabled(Level nLevel) { return nLevel >= LOG_MIN_LEVEL; }
+
 class logger;
 
-class logstream : public std::ostringstream
+class logstream
 {
 public:
 	logstream(logger& oLogger, Level nLevel);
-	logstream(const logstream& ls);
 	~logstream();
+	logstream(const logstream& ls) = delete;
+	logstream& operator=(const logstream& ls) = delete;
+
+	logstream& operator<<(std::string_view text);
+	logstream& operator<<(const std::string& text);
+	logstream& operator<<(const char* text);
+	logstream& operator<<(char* text);
+	logstream& operator<<(const unsigned char* text); //GLubyte strings
+	logstream& operator<<(char c);
+	logstream& operator<<(unsigned char c);
+	logstream& operator<<(bool b);
+	logstream& operator<<(short n);
+	logstream& operator<<(unsigned short n);
+	logstream& operator<<(int n);
+	logstream& operator<<(unsigned int n);
+	logstream& operator<<(long n);
+	logstream& operator<<(unsigned long n);
+	logstream& operator<<(long long n);
+	logstream& operator<<(unsigned long long n);
+	logstream& operator<<(float f);
+	logstream& operator<<(double d);
+	logstream& operator<<(const void* pointer);
+
+	// enums and pointers as numbers, anything else through an ostringstream (which allocates)
+	template<typename T>
+	logstream& operator<<(const T& value)
+	{
+		if constexpr (std::is_enum<T>::value) return *this << (long long)value;
+		else if constexpr (std::is_pointer<T>::value) return *this << (const void*)value;
+		else
+		{
+			std::ostringstream stream;
+			stream << value;
+			return *this << stream.str();
+		}
+	}
 
 private:
 	logger& m_oLogger;
 	Level m_nLevel;
+	AllocationScope m_oAllocationScope; //what the message allocates is the logger's
+	size_t m_nLength;
+	bool m_bTruncated; //ends with ... when written
+	char m_aText[LOG_MESSAGE_SIZE];
+
+	void append(const char* text, size_t length);
+	template<typename T>
+	logstream& appendFormatted(const char* format, T value);
 };
 
 class logger
@@ -44,15 +142,74 @@ public:
 	logger(std::string filename, bool append);
 	virtual ~logger();
 
-	void log(Level nLevel, std::string oMessage);
+	// queues the message for the writer thread, never waits for the file
+	void log(Level nLevel, std::string_view oMessage);
+	// writes everything logged so far on the calling thread, waiting for the file.
+	// For the rare times that matters, like just before giving up on a fatal error.
+	void flush();
+	// messages dropped because their thread's ring was full
+	uint64_t droppedMessages();
 
 	logstream operator()();
 	logstream operator()(Level nLevel);
 
 private:
-	std::string getTimestamp();
+	struct Record
+	{
+		uint64_t sequence; //puts the threads' messages back in order
+		std::chrono::system_clock::time_point time;
+		Level level;
+		uint32_t length;
+		char text[LOG_MESSAGE_SIZE];
+	};
+
+	// Each logging thread is the only one adding to its ring, and whoever holds
+	// m_oWriteMutex the only one taking from it.
+	struct Ring
+	{
+		std::atomic<uint32_t> head; //next record the thread writes
+		std::atomic<uint32_t> tail; //next record the writer reads
+		std::atomic<bool> owned; //a live thread logs into it, free to hand out again once empty if not
+		Record records[LOG_RING_RECORDS];
+	};
+
+	struct PendingRecord
+	{
+		const Record* record;
+		bool operator<(const PendingRecord& other) const { return record->sequence < other.record->sequence; }
+	};
+
+	Ring* threadRing();
+	void writerLoop();
+	// takes everything waiting in the rings and writes it, holding m_oWriteMutex
+	void writeWaiting();
+	void writeTimestamp(std::chrono::system_clock::time_point time);
 
 private:
-	std::mutex m_oMutex;
+	std::mutex m_oMutex; //handing out rings
+	std::atomic<Ring*> m_aRings[LOG_MAX_THREADS];
+	std::atomic<uint32_t> m_nRingCount;
+	std::atomic<uint64_t> m_nSequence;
+	std::atomic<uint64_t> m_nDropped;
+	uint64_t m_nReportedDropped;
+
+	std::mutex m_oWriteMutex; //held while taking records and writing them
 	std::ofstream m_oFile;
+	std::vector<PendingRecord> m_oBatch;
+	uint32_t m_aBatchHeads[LOG_MAX_THREADS];
+	time_t m_nTimestampSecond; //the second m_aTimestamp is for
+	char m_aTimestamp[32];
+
+	std::mutex m_oWakeMutex;
+	std::condition_variable m_oWake;
+	bool m_bStopping;
+	std::thread m_oWriter;
+
+	friend class logstream;
+	friend struct LoggerThreadRing;
 };
+
+// Every oLog(level) << ... goes through here. Below LOG_MIN_LEVEL the loop's condition is a
+// constant false, so the message never runs and the compiler drops it and everything streamed
+// into it. Being a single for statement with no else, it can't steal the else of an unbraced if.
+#define oLog(...) for (bool _oLogOnce = LogLevelEnabled(__VA_ARGS__); _oLogOnce; _oLogOnce = false) oLog(__VA_ARGS__)
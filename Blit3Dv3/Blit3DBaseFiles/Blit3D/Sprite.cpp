@@ -4,7 +4,7 @@ extern logger oLog;
 
 //textured Sprite class --------------------------------------------------------------
 Sprite::Sprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height,
-	std::string TextureFileName, TextureManager *TexManager, GLSLProgram *shader)
+	std::string TextureFileName, TextureManager *TexManager, GLSLProgram *shader, GLuint quadVAO)
 {
 	dest_x = 0.f;
 	dest_y = 0.f;
@@ -12,19 +12,18 @@ Sprite::Sprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height,
 	alpha = 1.f;
 	scale_x = scale_y = 1.f;
 
-	GLfloat halfSizeX, halfSizeY;//x,y half-dimensions of the quad
-
-	halfSizeX = width / 2.f;
-	halfSizeY = height / 2.f;
+	sizeX = width;
+	sizeY = height;
 
 	prog = shader;
+	quadVaoId = quadVAO;
 
 	GLfloat imagewidth, imageheight;
 	textureName = TextureFileName;
 	texManager = TexManager;
 
-	//load the texture via the texture manager
-	texId = texManager->LoadTexture(TextureFileName);
+	//get the texture via the texture manager, no GL calls if it's loaded already
+	texId = texManager->AcquireTexture(TextureFileName);
 	if(texId == 0)
 	{
 		oLog(Level::Severe) << "Image loading error while loading image file: " << TextureFileName << "for Sprite";
@@ -39,70 +38,11 @@ Sprite::Sprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height,
 	GLfloat v1 = 1.f - (startY / imageheight);
 	GLfloat v2 = 1.f - ((startY + height) / imageheight);
 
-
-	verts = new B3D::TVertex[4]; //make an array of Textured Vertices
-
-	// generate a new VAO and get the associated ID
-	glGenVertexArrays(1, &vaoId); // Create our Vertex Array Object  
-	glBindVertexArray(vaoId); // Bind our Vertex Array Object so we can use it  
-
-	// generate a new VBO and get the associated ID
-	glGenBuffers(1, &vboId);
-
-	// bind VBO in order to use
-	glBindBuffer(GL_ARRAY_BUFFER, vboId);
-
-	//set the vertex array points...we need 4 vertices, one for each corner of our sprite, 
-
-	/*
-
-	0-------2
-	|       |
-	|       |
-	|       |
-	1-------3
-	*/
-
-	//front side, counterclockwise
-	//point 0
-	verts[0].x = -halfSizeX;				verts[0].y = halfSizeY;			verts[0].z = 0.f;
-	verts[0].u = u1;	verts[0].v = v1;
-	//point 1
-	verts[1].x = -halfSizeX;				verts[1].y = -halfSizeY;		verts[1].z = 0.f;
-	verts[1].u = u1;	verts[1].v = v2;
-	//point 2
-	verts[2].x = halfSizeX;					verts[2].y = halfSizeY;			verts[2].z = 0.f;
-	verts[2].u = u2;	verts[2].v = v1;
-	//point 3
-	verts[3].x = halfSizeX;					verts[3].y = -halfSizeY;		verts[3].z = 0.f;
-	verts[3].u = u2;	verts[3].v = v2;
-	
-
-	// upload data to VBO
-	glBufferData(GL_ARRAY_BUFFER, sizeof(B3D::TVertex) * 4, verts, GL_STATIC_DRAW);
-
-	// Set up our vertex attributes pointers
-	///we don't really need normals for 2D, except maybe for special effects.
-	//We send them anyway, as we don't have special shaders for 2d mode (YET!)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(0)); //3 values (x,y,z) per point, start at 0 offset 	
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(sizeof(GLfloat)* 3)); //Start after x,y,z data 
-
-
-	// activate attribute array
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glDisableVertexAttribArray(2); //don't use channel 2
-	glDisableVertexAttribArray(3); //don't use Color channel, we are textured
-
-
-	glBindVertexArray(0); // Disable our Vertex Array Object? 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);// Disable our Vertex Buffer Object
-
-	//free the memory once it's been uploaded
-	delete[] verts;
+	//the part of the texture the shared quad gets: bottom-left corner, then size
+	texRect = glm::vec4(u1, v2, u2 - u1, v1 - v2);
 }
 
-Sprite::Sprite(RenderBuffer * rb, TextureManager *TexManager, GLSLProgram *shader)
+Sprite::Sprite(RenderBuffer * rb, TextureManager *TexManager, GLSLProgram *shader, GLuint quadVAO)
 {
 	dest_x = 0.f;
 	dest_y = 0.f;
@@ -110,18 +50,11 @@ Sprite::Sprite(RenderBuffer * rb, TextureManager *TexManager, GLSLProgram *shade
 	alpha = 1.f;
 	scale_x = scale_y = 1.f;
 
-	GLfloat halfSizeX, halfSizeY;//x,y half-dimensions of the quad
-
-	halfSizeX = rb->texwidth / 2.f;
-	halfSizeY = rb->texheight / 2.f;
+	sizeX = (GLfloat)rb->texwidth;
+	sizeY = (GLfloat)rb->texheight;
 
 	prog = shader;
-
-	GLfloat u1 = 0.f;
-	GLfloat u2 = 1.f;
-
-	GLfloat v1 = 1.f;
-	GLfloat v2 = 0.f;
+	quadVaoId = quadVAO;
 
 	textureName = rb->texname;
 	texManager = TexManager;
@@ -132,79 +65,24 @@ Sprite::Sprite(RenderBuffer * rb, TextureManager *TexManager, GLSLProgram *shade
 	//increment our use of this texture
 	texManager->AddLoadedTexture(textureName, texId);
 
-	verts = new B3D::TVertex[4]; //make an array of Textured Vertices
-
-	// generate a new VAO and get the associated ID
-	glGenVertexArrays(1, &vaoId); // Create our Vertex Array Object  
-	glBindVertexArray(vaoId); // Bind our Vertex Array Object so we can use it  
-
-	// generate a new VBO and get the associated ID
-	glGenBuffers(1, &vboId);
-
-	// bind VBO in order to use
-	glBindBuffer(GL_ARRAY_BUFFER, vboId);
-
-	//set the vertex array points...we need 4 vertices, one for each corner of our sprite, 
-
-	/*
-
-	0-------2
-	|       |
-	|       |
-	|       |
-	1-------3
-	*/
-
-	//front side, counterclockwise
-	//point 0
-	verts[0].x = -halfSizeX;				verts[0].y = halfSizeY;			verts[0].z = 0.f;
-	verts[0].u = u1;	verts[0].v = v1;
-	//point 1
-	verts[1].x = -halfSizeX;				verts[1].y = -halfSizeY;		verts[1].z = 0.f;
-	verts[1].u = u1;	verts[1].v = v2;
-	//point 2
-	verts[2].x = halfSizeX;					verts[2].y = halfSizeY;			verts[2].z = 0.f;
-	verts[2].u = u2;	verts[2].v = v1;
-	//point 3
-	verts[3].x = halfSizeX;					verts[3].y = -halfSizeY;		verts[3].z = 0.f;
-	verts[3].u = u2;	verts[3].v = v2;
-
-	// upload data to VBO
-	glBufferData(GL_ARRAY_BUFFER, sizeof(B3D::TVertex) * 4, verts, GL_STATIC_DRAW);
-
-	// Set up our vertex attributes pointers
-	///we don't really need normals for 2D, except maybe for special effects.
-	//We send them anyway, as we don't have special shaders for 2d mode (YET!)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(0)); //3 values (x,y,z) per point, start at 0 offset 	
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(B3D::TVertex), BUFFER_OFFSET(sizeof(GLfloat)* 3)); //Start after x,y,z data 
-
-
-	// activate attribute array
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glDisableVertexAttribArray(2); //don't use channel 2
-	glDisableVertexAttribArray(3); //don't use Color channel, we are textured
-
-	glBindVertexArray(0); // Disable our Vertex Array Object? 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);// Disable our Vertex Buffer Object
-
-	//free the memory once it's been uploaded
-	delete[] verts;
+	//the whole texture
+	texRect = glm::vec4(0.f, 0.f, 1.f, 1.f);
 }
 
 Sprite::~Sprite()
 {
 	// free texture
 	texManager->FreeTexture(textureName);
+}
 
-	// delete VBO when object destroyed
-	glDeleteBuffers(1, &vboId);
-	glDeleteVertexArrays(1, &vaoId);
+size_t Sprite::GetMemoryUsed() const
+{
+	return sizeof(Sprite) + textureName.capacity();
 }
 
 void Sprite::Blit(void)
 {
-	glBindVertexArray(vaoId); // Bind our Vertex Array Object 
+	glBindVertexArray(quadVaoId); // Bind the quad all sprites share
 
 	//bind our texture
 	texManager->BindTexture(texId);
@@ -222,9 +100,11 @@ void Sprite::Blit(void)
 
 	//send our alpha to the shader
 	prog->setUniform("in_Alpha", alpha);
-	//send the scaling
-	prog->setUniform("in_Scale_X", scale_x);
-	prog->setUniform("in_Scale_Y", scale_y);
+	//send the scaling, the quad is one pixel across so this sizes it too
+	prog->setUniform("in_Scale_X", scale_x * sizeX);
+	prog->setUniform("in_Scale_Y", scale_y * sizeY);
+	//and the part of the texture to show on it
+	prog->setUniform("in_UVRect", texRect);
 
 	// draw a triangle strip
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
@@ -13,9 +13,9 @@ namespace B3D
 class Sprite
 {
 private:
-	B3D::TVertex *verts;  // memory for vertice data
-	GLuint vboId;	// ID of VBO
-	GLuint vaoId;	//ID of the VAO 		
+	GLuint quadVaoId;	//ID of the unit quad VAO shared by all sprites
+	GLfloat sizeX, sizeY; //size of the sprite in pixels, before scaling
+	glm::vec4 texRect; //part of the texture shown: u, v of the bottom-left corner, then width and height
 
 	GLuint texId; //ID of texture
 	std::string textureName; //filename of the texture
@@ -39,8 +39,12 @@ public:
 	void Blit(float x, float y, float scale_val_x, float scale_val_y, float alpha_val); //draw the sprite centered at x,y with set scale and alpha
 
 	//we won't call this constructor directly, we'll let the Blit3D object do that
+	//sprites own no GL objects, they all draw Blit3D's unit quad (quadVAO)
 	Sprite(GLfloat startX, GLfloat startY, GLfloat width, GLfloat height,
-		std::string TextureFileName, TextureManager *TexManager, GLSLProgram *shader);
-	Sprite(RenderBuffer * rb, TextureManager *TexManager, GLSLProgram *shader);
+		std::string TextureFileName, TextureManager *TexManager, GLSLProgram *shader, GLuint quadVAO);
+	Sprite(RenderBuffer * rb, TextureManager *TexManager, GLSLProgram *shader, GLuint quadVAO);
 	~Sprite();
+
+	//bytes of memory this sprite uses, not counting its texture
+	size_t GetMemoryUsed() const;
 };
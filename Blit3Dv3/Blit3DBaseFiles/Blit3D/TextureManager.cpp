@@ -1,6 +1,7 @@
 #include "TextureManager.h"
 #include <iostream>
 #include "Logger.h"
+#include "AllocationTracker.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -14,6 +15,7 @@ TextureManager::TextureManager(void)
 	for (int i = 0; i < TEXTURE_MANAGER_MAX_TEXTURES; ++i) currentId[i] = -1;
 
 	texturePath = "";
+	archive = NULL;
 
 	//try for nicest mipmap generation
 	glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST );
@@ -44,109 +46,151 @@ void TextureManager::SetTexturePath(std::string path)
 	oLog(Level::Info) << "Texture Path set to: " << path;
 }
 
-GLuint TextureManager::LoadTexture(std::string filename, bool useMipMaps, GLuint texture_unit, GLuint wrapflag, bool pixelate)
+void TextureManager::SetArchive(AssetArchive *assets)
 {
-	itor = textures.find(filename); //lookup this texture in our std::map
+	archive = assets;
+}
 
-	if(itor == textures.end())
-	{
-		//we didn't find that texture name, so it is a new texture
-		tex *newtex = new tex;
+AssetArchive *TextureManager::GetArchive()
+{
+	return archive;
+}
 
-		newtex->refcount = 1;
-		newtex->unload = true; //currently setting all textures to unload when refcount = 0;
+DecodedImage::DecodedImage() : bits(NULL), width(0), height(0)
+{
+}
 
-		//add the path to the file
-		std::string fullpath;
-		fullpath = texturePath;
-		fullpath.append(filename);
+DecodedImage::~DecodedImage()
+{
+	//Free stb's copy of the data
+	if (bits != NULL) stbi_image_free(bits);
+}
 
-		//pointer to the image data
-		BYTE* bits(0);
-		//image width and height, and #of components (1= gray scale, 4 = rgba)
-		int width(0), height(0), components(0);
-		//OpenGL's image ID to map to
-		GLuint gl_texID;
+bool TextureManager::DecodeImage(const AssetArchive *archive, const std::string &filename, DecodedImage &image)
+{
+	//#of components (1= gray scale, 4 = rgba)
+	int components(0);
 
-		//retrieve the image data, currently force to RGBA (4 components)
-		bits = stbi_load(filename.c_str(), &width, &height, &components, 4);
-		
-		//if somehow one of these failed (they shouldn't), return failure
-		if((bits == 0) || (width == 0) || (height == 0))
-		{
-			if(bits == 0) oLog(Level::Severe) << "bits = 0";
-			if(width == 0) oLog(Level::Severe) << "width = 0";
-			if(height == 0) oLog(Level::Severe) << "height = 0";
-			goto ERROR_HANDLER;
-		}
-		
-		//generate an OpenGL texture ID for this texture
-		glGenTextures(1, &gl_texID);
-		//store the texture ID mapping
-		newtex->texId = gl_texID;
-		
-		glActiveTexture(texture_unit); //needed for programmable shaders?
-		//bind to the new texture ID
-		glBindTexture(GL_TEXTURE_2D, gl_texID);
-
-		//set up some vars for OpenGL texturizing
-		GLenum image_format = GL_RGBA;
-		GLint internal_format = GL_RGBA;
-		GLint level = 0;
-		//store the texture data for OpenGL use
-		glTexImage2D(GL_TEXTURE_2D, level, internal_format, width, height,
-			0, image_format, GL_UNSIGNED_BYTE, bits);
-
-		//swizzle colors - not needed for stb_image
-		//GLint swizzleMask[] = { GL_BLUE, GL_GREEN, GL_RED, GL_ALPHA };
-		//glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
-
-		if (useMipMaps)
+	//retrieve the image data, currently force to RGBA (4 components)
+	if (archive != NULL)
+	{
+		//decode straight from the archive's mapping, or the loose file if it isn't packed
+		AssetData file;
+		if (archive->Load(filename, file))
 		{
-			glGenerateMipmap(GL_TEXTURE_2D);
+			image.bits = stbi_load_from_memory(file.bytes, (int)file.size, &image.width, &image.height, &components, 4);
 		}
+	}
+	else image.bits = stbi_load(filename.c_str(), &image.width, &image.height, &components, 4);
 
-		//Free stb's copy of the data
-		stbi_image_free(bits);
+	//if somehow one of these failed (they shouldn't), return failure
+	if ((image.bits == 0) || (image.width == 0) || (image.height == 0))
+	{
+		if (image.bits == 0) oLog(Level::Severe) << "bits = 0";
+		if (image.width == 0) oLog(Level::Severe) << "width = 0";
+		if (image.height == 0) oLog(Level::Severe) << "height = 0";
+		return false;
+	}
+	return true;
+}
 
-		newtex->width = width;
-		newtex->height = height;
-		
-		//add the new texture to the map
-		textures[filename] = newtex;		
+tex *TextureManager::CreateTexture(const std::string &filename, const DecodedImage &image, bool useMipMaps,
+	GLuint texture_unit, GLuint wrapflag, bool pixelate)
+{
+	tex *newtex = new tex;
 
-		currentId[texture_unit - GL_TEXTURE0] = newtex->texId;
+	newtex->refcount = 0;
+	newtex->unload = true; //currently setting all textures to unload when refcount = 0;
 
-		//setup texture filtering for when we are close/far away
-		if (useMipMaps)
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); //for when we are close
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);//when we are far away
-		}
-		else if(pixelate)
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); //for when we are close
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);//when we are far away
-		}
-		else
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); //for when we are close
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);//when we are far away
-		}
+	//OpenGL's image ID to map to
+	GLuint gl_texID;
 
+	//generate an OpenGL texture ID for this texture
+	glGenTextures(1, &gl_texID);
+	//store the texture ID mapping
+	newtex->texId = gl_texID;
+	
+	glActiveTexture(texture_unit); //needed for programmable shaders?
+	//bind to the new texture ID
+	glBindTexture(GL_TEXTURE_2D, gl_texID);
+
+	//set up some vars for OpenGL texturizing
+	GLenum image_format = GL_RGBA;
+	GLint internal_format = GL_RGBA;
+	GLint level = 0;
+	//store the texture data for OpenGL use
+	glTexImage2D(GL_TEXTURE_2D, level, internal_format, image.width, image.height,
+		0, image_format, GL_UNSIGNED_BYTE, image.bits);
+
+	//swizzle colors - not needed for stb_image
+	//GLint swizzleMask[] = { GL_BLUE, GL_GREEN, GL_RED, GL_ALPHA };
+	//glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+
+	if (useMipMaps)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
 
-		//the following turns on a special, high-quality filtering mode called "ANISOTROPY"
-		if(GL_EXT_texture_filter_anisotropic)
+	newtex->width = image.width;
+	newtex->height = image.height;
+	
+	//add the new texture to the map
+	textures[filename] = newtex;		
+
+	currentId[texture_unit - GL_TEXTURE0] = newtex->texId;
+
+	//setup texture filtering for when we are close/far away
+	if (useMipMaps)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); //for when we are close
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);//when we are far away
+	}
+	else if(pixelate)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); //for when we are close
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);//when we are far away
+	}
+	else
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); //for when we are close
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);//when we are far away
+	}
+
+
+	//the following turns on a special, high-quality filtering mode called "ANISOTROPY"
+	if(GL_EXT_texture_filter_anisotropic)
+	{
+		GLfloat largest_supported_anisotropy;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &largest_supported_anisotropy);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, largest_supported_anisotropy);
+	}
+
+	// the texture stops at the edges with GL_CLAMP_TO_EDGE
+	//...experiment with GL_CLAMP and GL_REPEAT as well
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapflag );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapflag );
+	
+	return newtex;
+}
+
+GLuint TextureManager::LoadTexture(std::string filename, bool useMipMaps, GLuint texture_unit, GLuint wrapflag, bool pixelate)
+{
+	AllocationScope textureAllocations(AllocTag::TEXTURE);
+	itor = textures.find(filename); //lookup this texture in our std::map
+
+	if(itor == textures.end())
+	{
+		//we didn't find that texture name, so it is a new texture
+		DecodedImage image;
+		if (!DecodeImage(archive, filename, image))
 		{
-			GLfloat largest_supported_anisotropy;
-			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &largest_supported_anisotropy);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, largest_supported_anisotropy);
+			oLog(Level::Severe) << "ERROR loading file: " << filename;
+			assert(false && "ERROR loading file");
+			return 0;
 		}
 
-		// the texture stops at the edges with GL_CLAMP_TO_EDGE
-		//...experiment with GL_CLAMP and GL_REPEAT as well
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapflag );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapflag );
+		tex *newtex = CreateTexture(filename, image, useMipMaps, texture_unit, wrapflag, pixelate);
+		newtex->refcount = 1;
 		
 		//return the loaded texture object
 		return newtex->texId;
@@ -157,11 +201,29 @@ GLuint TextureManager::LoadTexture(std::string filename, bool useMipMaps, GLuint
 	//bind it to the texture unit
 	BindTexture((*itor->second).texId, texture_unit);
 	return (*itor->second).texId;//and return the OpenGL texture object ID associated with that texture
+}
+
+GLuint TextureManager::AcquireTexture(std::string filename)
+{
+	itor = textures.find(filename); //lookup this texture in our std::map
+
+	//not loaded yet, load and bind it as usual
+	if (itor == textures.end()) return LoadTexture(filename);
+
+	(*itor->second).refcount++; //update the reference counter
+	return (*itor->second).texId;
+}
+
+GLuint TextureManager::UploadTexture(std::string filename, const DecodedImage &image, bool useMipMaps,
+	GLuint texture_unit, GLuint wrapflag, bool pixelate)
+{
+	AllocationScope textureAllocations(AllocTag::TEXTURE);
+	itor = textures.find(filename); //lookup this texture in our std::map
+
+	//someone beat us to it, keep theirs
+	if (itor != textures.end()) return (*itor->second).texId;
 
-ERROR_HANDLER:
-	oLog(Level::Severe) << "ERROR loading file: " << filename;
-	assert(false && "ERROR loading file");
-	return 0;
+	return CreateTexture(filename, image, useMipMaps, texture_unit, wrapflag, pixelate)->texId;
 }
 
 void TextureManager::FreeTexture(std::string filename)
@@ -6,6 +6,10 @@ texture binding state management.
 
 Now uses the excellent stb_image library as it's image loader.
 
+Version 3.4, added AcquireTexture(), for sprites to share a loaded texture without binding it
+Version 3.3, split decoding from uploading: DecodeImage() can run on any thread, UploadTexture()
+	then creates the texture on the GL thread, so images can be decoded in parallel
+Version 3.2, reads image files through an AssetArchive if one is set, see SetArchive()
 Version 3.1, get stb to flip imges as it loads them so that they are right-side up in OpenGL
 Version 3.0, uses stb_image instead of FreeImage (no more fake memory leaks etc)
 Version 2.3, uses GLEW on all platforms for now
@@ -37,6 +41,7 @@ Version 1.4, added AddLoadedTexture() to let FBO add textures to the TM
 #include <unordered_map>
 #include <algorithm>
 #include "glslprogram.h"
+#include "AssetArchive.h"
 
 struct tex
 {
@@ -47,6 +52,20 @@ public:
 	int width, height;
 };
 
+//an image decoded to RGBA by TextureManager::DecodeImage(), waiting to be uploaded
+class DecodedImage
+{
+public:
+	unsigned char *bits;
+	int width, height;
+
+	DecodedImage();
+	~DecodedImage();
+	//owns stb's copy of the pixels, so no copies
+	DecodedImage(const DecodedImage &) = delete;
+	DecodedImage &operator=(const DecodedImage &) = delete;
+};
+
 //the maximum texture units OpenGL supports
 #define TEXTURE_MANAGER_MAX_TEXTURES 31
 
@@ -57,6 +76,11 @@ private:
 	std::unordered_map<std::string, tex *> textures; //list of textures and associated id's, in a hashmap
 	GLuint currentId[TEXTURE_MANAGER_MAX_TEXTURES]; //currently bound texture
 	std::unordered_map<std::string, tex *>::iterator itor; //might as well save an iterator to use on our map
+	AssetArchive *archive; //where image files are read from, NULL for loose files only
+
+	//makes the GL texture and adds it to the map with a refcount of 0
+	tex *CreateTexture(const std::string &filename, const DecodedImage &image, bool useMipMaps,
+		GLuint texture_unit, GLuint wrapflag, bool pixelate);
 	
 public:
 	std::string texturePath; //relative path to the files
@@ -66,10 +90,20 @@ public:
 	void InitShaderVar(GLSLProgram *the_shader, const char * samplerName, int shaderVar = 0); //initalizes the shader variable for the sampler
 
 	GLuint LoadTexture(std::string filename, bool useMipMaps = false, GLuint texture_unit = GL_TEXTURE0, GLuint wrapflag = GL_CLAMP_TO_EDGE, bool pixelate = true);
+	//like LoadTexture(), but when the texture is loaded already it only adds a reference, no GL calls
+	GLuint AcquireTexture(std::string filename);
+	//reads and decodes an image file, touching neither GL nor the manager, so any thread may call it
+	static bool DecodeImage(const AssetArchive *archive, const std::string &filename, DecodedImage &image);
+	//creates the texture for an image decoded elsewhere, GL thread only. Nothing holds a reference
+	//to it yet, LoadTexture() with the same filename then finds it instead of reading the file.
+	GLuint UploadTexture(std::string filename, const DecodedImage &image, bool useMipMaps = false,
+		GLuint texture_unit = GL_TEXTURE0, GLuint wrapflag = GL_CLAMP_TO_EDGE, bool pixelate = true);
+	AssetArchive *GetArchive();
 	void FreeTexture(std::string filename); 
 	void BindTexture(GLuint bindId, GLuint texture_unit = GL_TEXTURE0);
 	void BindTexture(std::string filename, GLuint texture_unit = GL_TEXTURE0);
 	void SetTexturePath(std::string path);
+	void SetArchive(AssetArchive *assets); //NULL to go back to reading loose files
 	void AddLoadedTexture(std::string name, GLuint bindId);//used by FBO add pre-created textures
 	bool FetchDimensions(std::string name, GLfloat &width, GLfloat &height);
 	TextureManager(void);
@@ -2,6 +2,7 @@
 	by David Wolff.
 	Modified by Darren Reid to suit Blit3D needs.
 
+	Version 1.2 uniform/attribute look-ups by const char * no longer build a std::string
 	Version 1.1 added support for vec2 uniforms
 	Version 1.0	added a map for uniform/attributes, to cache lookup of locations in shader
 */
@@ -21,6 +22,7 @@ using glm::mat4;
 using glm::mat3;
 
 #include <map>
+#include <functional>
 
 namespace GLSLShader {
     enum GLSLShaderType {
@@ -40,8 +42,9 @@ private:
     bool fileExists( const string & fileName );
 
 	//Store uniforms and attributes in a map for easy lookup
-	std::map<std::string, int> UniformMap;
-	std::map<std::string, int>::iterator UMapIter;
+	//std::less<> lets find() compare against the const char * name as is
+	std::map<std::string, int, std::less<>> UniformMap;
+	std::map<std::string, int, std::less<>>::iterator UMapIter;
 
 public:
     GLSLProgram();
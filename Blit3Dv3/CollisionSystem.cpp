@@ -0,0 +1,253 @@
+#include "CollisionSystem.h"
+#include <algorithm>
+#include <cassert>
+
+CollisionSystem::CollisionSystem(unsigned workerThreads) : ship(NULL), shots(NULL), asteroids(NULL),
+	powerUps(NULL), jobCount(1), workerCount(workerThreads), detectNumber(0), jobsLeft(0), stopping(false), trace(NULL)
+{
+	if (workerCount == 0)
+	{
+		//leave a core for the game thread, hardware_concurrency() may not know (0)
+		unsigned cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 1;
+	}
+	jobEvents.resize(workerCount + 1);
+}
+
+CollisionSystem::~CollisionSystem()
+{
+	StopWorkers();
+}
+
+void CollisionSystem::RunJob(unsigned job)
+{
+	std::vector<CollisionEvent> &found = jobEvents[job];
+	found.clear();
+
+	size_t shotCount = shots->size();
+	size_t slotCount = asteroids->SlotCount();
+
+	//the ship's tests are few, the first job takes them
+	if (job == 0 && ship != NULL)
+	{
+		if (!ship->IsDestroyed() && !ship->IsShieldUp())
+		{
+			for (size_t i = 0; i < slotCount; ++i)
+			{
+				Asteroid *asteroid = asteroids->GetSlot(i);
+				if (asteroid == NULL || asteroid->IsDead()) continue;
+				if (ship->CollideWithAsteroid(asteroid))
+				{
+					found.push_back({ CollisionType::SHIP_ASTEROID, 0, (uint32_t)i });
+					break;
+				}
+			}
+		}
+		for (size_t i = 0; i < powerUps->SlotCount(); ++i)
+		{
+			PowerUp *powerUp = powerUps->GetSlot(i);
+			if (powerUp == NULL) continue;
+			if (ship->CollideWithPwerUp(powerUp))
+			{
+				found.push_back({ CollisionType::SHIP_POWER_UP, 0, (uint32_t)i });
+				break;
+			}
+		}
+	}
+
+	for (size_t row = job; row < shotCount + slotCount; row += jobCount)
+	{
+		if (row < shotCount)
+		{
+			Shot &shot = (*shots)[row];
+			if (!shot.IsAlive()) continue;
+			for (size_t i = 0; i < slotCount; ++i)
+			{
+				Asteroid *asteroid = asteroids->GetSlot(i);
+				if (asteroid == NULL || asteroid->IsDead()) continue;
+				if (shot.CollideWithAsteroid(asteroid))
+				{
+					found.push_back({ CollisionType::SHOT_ASTEROID, (uint32_t)row, (uint32_t)i });
+					break;
+				}
+			}
+		}
+		else
+		{
+			size_t i = row - shotCount;
+			Asteroid *first = asteroids->GetSlot(i);
+			if (first == NULL || first->IsDead()) continue;
+			for (size_t j = i + 1; j < slotCount; ++j)
+			{
+				Asteroid *second = asteroids->GetSlot(j);
+				if (second == NULL || second->IsDead()) continue;
+				if (first->CollideAsteroid(second))
+				{
+					found.push_back({ CollisionType::ASTEROID_ASTEROID, (uint32_t)i, (uint32_t)j });
+				}
+			}
+		}
+	}
+}
+
+void CollisionSystem::WorkerLoop(unsigned job)
+{
+	uint64_t lastDetect = 0;
+	std::unique_lock<std::mutex> lock(jobMutex);
+	while (true)
+	{
+		jobsQueued.wait(lock, [this, lastDetect]() { return stopping || detectNumber != lastDetect; });
+		if (stopping) return;
+		lastDetect = detectNumber;
+
+		lock.unlock();
+		RunJob(job);
+		lock.lock();
+
+		if (--jobsLeft == 0) jobsDone.notify_one();
+	}
+}
+
+const std::vector<CollisionEvent> &CollisionSystem::Detect(Spaceship *ship, std::vector<Shot> &shots,
+	SlotMap<Asteroid> &asteroids, SlotMap<PowerUp> &powerUps)
+{
+	size_t shotCount = shots.size();
+	size_t slotCount = asteroids.SlotCount();
+	size_t tests = shotCount * slotCount + slotCount * slotCount / 2;
+
+	if (tests < COLLISION_PARALLEL_MIN_TESTS || workerCount == 0)
+	{
+		this->ship = ship;
+		this->shots = &shots;
+		this->asteroids = &asteroids;
+		this->powerUps = &powerUps;
+		jobCount = 1;
+		RunJob(0);
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			if (workers.empty())
+			{
+				stopping = false;
+				detectNumber = 0;
+				for (unsigned i = 0; i < workerCount; ++i) workers.push_back(std::thread(&CollisionSystem::WorkerLoop, this, i + 1));
+			}
+			this->ship = ship;
+			this->shots = &shots;
+			this->asteroids = &asteroids;
+			this->powerUps = &powerUps;
+			jobCount = workerCount + 1;
+			jobsLeft = workerCount;
+			detectNumber++;
+		}
+		jobsQueued.notify_all();
+
+		RunJob(0);
+
+		std::unique_lock<std::mutex> lock(jobMutex);
+		jobsDone.wait(lock, [this]() { return jobsLeft == 0; });
+	}
+
+	//merge, the sort makes the order independent of which job found what
+	events.clear();
+	for (unsigned job = 0; job < jobCount; ++job)
+	{
+		events.insert(events.end(), jobEvents[job].begin(), jobEvents[job].end());
+	}
+	std::sort(events.begin(), events.end());
+	return events;
+}
+
+int CollisionSystem::Resolve()
+{
+	int score = 0;
+	uint32_t counts[4] = { 0, 0, 0, 0 }; //by CollisionType
+	for (const CollisionEvent &event : events)
+	{
+		counts[(int)event.type]++;
+		switch (event.type)
+		{
+		case CollisionType::SHIP_ASTEROID:
+		{
+			Asteroid *asteroid = asteroids->GetSlot(event.second);
+			int lives = ship->GetLives();
+			size_t spawns = asteroids->PendingSpawnCount();
+			ship->HitAsteroid(asteroid, *asteroids);
+			if (trace != NULL)
+			{
+				trace->Record(TraceEvent::SHIP_HIT, (uint8_t)asteroid->GetType(), event.second, (uint32_t)ship->GetLives());
+				if (ship->GetLives() < lives && !ship->IsDestroyed()) trace->Record(TraceEvent::LIFE_LOST, 0, (uint32_t)ship->GetLives());
+				TraceSplit(event.second, asteroid, spawns);
+			}
+			break;
+		}
+		case CollisionType::SHOT_ASTEROID:
+		{
+			Asteroid *asteroid = asteroids->GetSlot(event.second);
+			size_t spawns = asteroids->PendingSpawnCount();
+			int points = (*shots)[event.first].HitAsteroid(asteroid, *asteroids);
+			score += points;
+			if (trace != NULL)
+			{
+				trace->Record(TraceEvent::SHOT_HIT, (uint8_t)asteroid->GetType(), event.first, event.second, (uint32_t)points);
+				TraceSplit(event.second, asteroid, spawns);
+			}
+			break;
+		}
+		case CollisionType::ASTEROID_ASTEROID:
+		{
+			Asteroid *first = asteroids->GetSlot(event.first);
+			first->Collide(asteroids->GetSlot(event.second));
+			first->playCollisionSound();
+			break;
+		}
+		case CollisionType::SHIP_POWER_UP:
+			powerUps->GetSlot(event.second)->Grabbed();
+			ship->GrabPowerUp();
+			if (trace != NULL) trace->Record(TraceEvent::POWER_UP_GRABBED, 0, event.second, (uint32_t)ship->GetPowerUp());
+			break;
+		default:
+			assert(false && "Unknown collision type");
+			break;
+		}
+	}
+
+	if (trace != NULL && !events.empty())
+	{
+		uint32_t shipCounts = (counts[(int)CollisionType::SHIP_ASTEROID] << 16) | (counts[(int)CollisionType::SHIP_POWER_UP] & 0xFFFF);
+		trace->Record(TraceEvent::COLLISIONS, 0, counts[(int)CollisionType::SHOT_ASTEROID],
+			counts[(int)CollisionType::ASTEROID_ASTEROID], shipCounts);
+	}
+	return score;
+}
+
+void CollisionSystem::TraceSplit(uint32_t slot, Asteroid *asteroid, size_t spawnsBefore)
+{
+	//an asteroid that was already destroyed this tick doesn't split again
+	size_t pieces = asteroids->PendingSpawnCount() - spawnsBefore;
+	if (pieces > 0) trace->Record(TraceEvent::ASTEROID_SPLIT, (uint8_t)asteroid->GetType(), slot, (uint32_t)pieces);
+}
+
+const std::vector<CollisionEvent> &CollisionSystem::GetEvents() const
+{
+	return events;
+}
+
+void CollisionSystem::SetTrace(GameTrace *trace)
+{
+	this->trace = trace;
+}
+
+void CollisionSystem::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+		jobsQueued.notify_all();
+	}
+
+	for (std::thread &worker : workers) worker.join();
+	workers.clear();
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+/*
+	Two-phase collisions for the game's tick.
+
+	Detect() only finds collisions: it tests the ship, shots, asteroids and power ups
+	against each other and writes a CollisionEvent for every hit, without touching any
+	game state. The tests are split into jobs run side by side on a few worker threads,
+	each job writing to its own event buffer, so no locking is needed while testing.
+	The buffers are then merged and sorted, which puts the events in the same order
+	however many threads found them.
+
+	Resolve() then applies the events one by one on the game thread, in that order:
+	damage, asteroid splits, bounces, sounds and score. Games replayed with the same
+	input get the same results whatever machine they run on.
+
+	Events refer to entities by slot (asteroids, power ups) or by index (shots), so
+	nothing may be added to or removed from the lists between Detect() and Resolve().
+	The slot maps only change on Flush(), call it after Resolve().
+*/
+
+#include "Spaceship.h"
+#include "Shot.h"
+#include "Asteroid.h"
+#include "PowerUp.h"
+#include "SlotMap.h"
+#include "GameTrace.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+// Threads doing detection jobs besides the game thread, 0 for one less than the number of cores
+#ifndef COLLISION_THREADS
+#define COLLISION_THREADS 0
+#endif
+
+// Below this many pair tests a tick, detection runs on the game thread alone.
+// Waking the workers costs more than a few hundred tests.
+#ifndef COLLISION_PARALLEL_MIN_TESTS
+#define COLLISION_PARALLEL_MIN_TESTS 512
+#endif
+
+// Also the order events are resolved in
+enum class CollisionType { SHIP_ASTEROID = 0, SHOT_ASTEROID, ASTEROID_ASTEROID, SHIP_POWER_UP };
+
+struct CollisionEvent
+{
+	CollisionType type;
+	uint32_t first; //0 for the ship, the shot's index, or the first asteroid's slot
+	uint32_t second; //the asteroid's or power up's slot
+
+	bool operator<(const CollisionEvent &other) const
+	{
+		if (type != other.type) return type < other.type;
+		if (first != other.first) return first < other.first;
+		return second < other.second;
+	}
+};
+
+class CollisionSystem
+{
+	// What Detect() was given, read by the jobs
+	Spaceship *ship;
+	std::vector<Shot> *shots;
+	SlotMap<Asteroid> *asteroids;
+	SlotMap<PowerUp> *powerUps;
+
+	std::vector<std::vector<CollisionEvent>> jobEvents; //one buffer per job
+	std::vector<CollisionEvent> events; //merged and sorted
+	unsigned jobCount; //jobs this Detect() is split into
+
+	unsigned workerCount;
+	std::vector<std::thread> workers; //started by the first Detect() worth splitting
+	std::mutex jobMutex;
+	std::condition_variable jobsQueued;
+	std::condition_variable jobsDone;
+	uint64_t detectNumber; //bumped to hand the workers a new set of jobs
+	unsigned jobsLeft;
+	bool stopping;
+
+	GameTrace *trace; //Resolve() records what it applies here, when set
+
+	// Runs the tests of one job: every jobCount'th row, starting at row job.
+	// Row i is shot i, the rows after the shots are asteroid slots.
+	void RunJob(unsigned job);
+	void WorkerLoop(unsigned job);
+	// Records the split of the asteroid in slot, if hitting it spawned pieces
+	void TraceSplit(uint32_t slot, Asteroid *asteroid, size_t spawnsBefore);
+public:
+	CollisionSystem(unsigned workerThreads = COLLISION_THREADS);
+	~CollisionSystem();
+
+	// Phase one: finds every collision, changes nothing. ship can be NULL.
+	// Each shot and the ship only report the first asteroid they hit, by slot.
+	const std::vector<CollisionEvent> &Detect(Spaceship *ship, std::vector<Shot> &shots,
+		SlotMap<Asteroid> &asteroids, SlotMap<PowerUp> &powerUps);
+	// Phase two: applies the events Detect() found to the lists it was given, on the
+	// calling thread. Returns the score they earned.
+	int Resolve();
+
+	const std::vector<CollisionEvent> &GetEvents() const;
+	// Resolve() records the hits, splits, power ups grabbed and each tick's collision counts
+	// into trace, NULL to stop
+	void SetTrace(GameTrace *trace);
+	// Waits for the workers and joins them, Detect() starts them again if it needs to
+	void StopWorkers();
+};
@@ -0,0 +1,168 @@
+#include "GameTrace.h"
+#include "Logger.h"
+#include <cassert>
+#include <cstring>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+GameTrace::GameTrace() : chunk(NULL), chunkUsed(0), tick(0), lastRecordTick(0), recordCount(0),
+	droppedRecords(0), stopping(false)
+{
+}
+
+GameTrace::~GameTrace()
+{
+	this->Close();
+}
+
+bool GameTrace::Open(const std::string &filename, float tickSeconds)
+{
+	this->Close();
+
+	this->file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!this->file.is_open())
+	{
+		oLog(Level::Warning) << "Could not open gameplay trace file: " << filename;
+		return false;
+	}
+
+	TraceFileHeader header;
+	memcpy(header.magic, "B3DT", 4);
+	header.version = TRACE_FILE_VERSION;
+	header.recordSize = sizeof(TraceRecord);
+	header.tickSeconds = tickSeconds;
+	header.reserved = 0;
+	this->file.write((const char *)&header, sizeof(header));
+
+	//every chunk up front, so tracing never allocates
+	this->chunkMemory.assign((size_t)TRACE_CHUNKS * TRACE_CHUNK_RECORDS, TraceRecord());
+	this->freeChunks.clear();
+	this->freeChunks.reserve(TRACE_CHUNKS);
+	this->fullChunks.clear();
+	this->fullChunks.reserve(TRACE_CHUNKS);
+	for (size_t i = 1; i < TRACE_CHUNKS; ++i) this->freeChunks.push_back(&this->chunkMemory[i * TRACE_CHUNK_RECORDS]);
+	this->chunk = &this->chunkMemory[0];
+	this->recordCount = 0;
+	this->droppedRecords = 0;
+	this->StartChunk();
+
+	this->stopping = false;
+	this->writer = std::thread(&GameTrace::WriterLoop, this);
+
+	oLog(Level::Info) << "Tracing gameplay to " << filename;
+	return true;
+}
+
+void GameTrace::Close()
+{
+	if (this->chunk == NULL) return;
+
+	{
+		std::lock_guard<std::mutex> lock(this->chunkMutex);
+		this->fullChunks.push_back(std::make_pair(this->chunk, this->chunkUsed));
+		this->stopping = true;
+	}
+	this->chunkReady.notify_one();
+	this->writer.join();
+	this->chunk = NULL;
+	this->file.close();
+
+	oLog(Level::Info) << "Gameplay trace closed, " << this->recordCount - this->droppedRecords << " records written";
+	if (this->droppedRecords > 0)
+	{
+		oLog(Level::Warning) << "Gameplay trace writer fell behind, " << this->droppedRecords << " records were not written";
+	}
+}
+
+void GameTrace::StartChunk()
+{
+	//the reader can pick the ticks up again here, even if chunks before it were dropped
+	this->chunkUsed = 0;
+	TraceRecord &record = this->chunk[this->chunkUsed++];
+	record.event = (uint8_t)TraceEvent::TICK;
+	record.detail = 0;
+	record.tickDelta = 0;
+	record.a = (uint32_t)this->tick;
+	record.b = (uint32_t)(this->tick >> 32);
+	record.c = 0;
+	this->lastRecordTick = this->tick;
+	this->recordCount++;
+}
+
+void GameTrace::SubmitChunk()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->chunkMutex);
+		if (!this->freeChunks.empty())
+		{
+			this->fullChunks.push_back(std::make_pair(this->chunk, this->chunkUsed));
+			this->chunk = this->freeChunks.back();
+			this->freeChunks.pop_back();
+		}
+		else
+		{
+			//the writer is behind, lose this chunk rather than wait for the disk
+			this->droppedRecords += this->chunkUsed;
+		}
+	}
+	this->chunkReady.notify_one();
+	this->StartChunk();
+}
+
+void GameTrace::Write(TraceEvent event, uint8_t detail, uint32_t a, uint32_t b, uint32_t c)
+{
+	assert(event < TraceEvent::COUNT && "not a trace event");
+
+	//room for this record and a TICK record before it if the gap needs one
+	if (this->chunkUsed + 2 > TRACE_CHUNK_RECORDS) this->SubmitChunk();
+
+	uint64_t delta = this->tick - this->lastRecordTick;
+	if (delta > 0xFFFF)
+	{
+		TraceRecord &tickRecord = this->chunk[this->chunkUsed++];
+		tickRecord.event = (uint8_t)TraceEvent::TICK;
+		tickRecord.detail = 0;
+		tickRecord.tickDelta = 0;
+		tickRecord.a = (uint32_t)this->tick;
+		tickRecord.b = (uint32_t)(this->tick >> 32);
+		tickRecord.c = 0;
+		this->recordCount++;
+		delta = 0;
+	}
+
+	TraceRecord &record = this->chunk[this->chunkUsed++];
+	record.event = (uint8_t)event;
+	record.detail = detail;
+	record.tickDelta = (uint16_t)delta;
+	record.a = a;
+	record.b = b;
+	record.c = c;
+	this->lastRecordTick = this->tick;
+	this->recordCount++;
+}
+
+void GameTrace::WriterLoop()
+{
+	std::vector<std::pair<TraceRecord *, size_t>> writing;
+	writing.reserve(TRACE_CHUNKS);
+
+	std::unique_lock<std::mutex> lock(this->chunkMutex);
+	for (;;)
+	{
+		this->chunkReady.wait(lock, [this]() { return this->stopping || !this->fullChunks.empty(); });
+		writing.swap(this->fullChunks);
+		bool done = this->stopping;
+
+		lock.unlock();
+		for (const std::pair<TraceRecord *, size_t> &full : writing)
+		{
+			this->file.write((const char *)full.first, full.second * sizeof(TraceRecord));
+		}
+		lock.lock();
+
+		for (const std::pair<TraceRecord *, size_t> &full : writing) this->freeChunks.push_back(full.first);
+		writing.clear();
+		if (done && this->fullChunks.empty()) break;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+/*
+	Binary trace of gameplay events, for looking at load patterns offline: spawns,
+	splits, shots fired, hits, power ups, lives lost and the collisions and entity
+	counts of every tick.
+
+	Every event is one fixed-size TraceRecord with no strings in it: entities are
+	named by their slot (asteroids, power ups) or index (shots), sizes and kinds by
+	their enum values. Each record holds the ticks since the record before it rather
+	than the tick itself, the absolute tick is in a TICK record at the start of each
+	chunk and wherever the gap is too big for 16 bits.
+
+	Record() only copies the record into the current chunk on the game thread. Full
+	chunks are handed to a writer thread that writes them to the file, so the game
+	never waits on the disk. The chunks are all allocated by Open(). If the writer
+	falls behind and none is free, the chunk being filled is thrown away and counted
+	instead, the chunk after it starts with its absolute tick again.
+
+	Nothing is traced per entity per tick, only per event, so the cost of a tick's
+	capture doesn't grow with the number of asteroids. Record() on a closed trace
+	just returns.
+
+	The file is a TraceFileHeader followed by the records, little-endian.
+	Tools/TraceReader turns it into CSV and histograms.
+*/
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+// records in a chunk, the unit handed to the writer thread
+#ifndef TRACE_CHUNK_RECORDS
+#define TRACE_CHUNK_RECORDS 4096
+#endif
+
+// chunks allocated by Open(), one is being filled and the rest are waiting for or being written
+#ifndef TRACE_CHUNKS
+#define TRACE_CHUNKS 8
+#endif
+
+#define TRACE_FILE_VERSION 1
+
+// What a, b and c hold is given for each event
+enum class TraceEvent : uint8_t
+{
+	TICK = 0,			//a, b: the absolute tick, low and high 32 bits
+	GAME_START,			//a: level
+	LEVEL_START,		//a: level, b: asteroids spawned
+	ASTEROID_SPAWN,		//detail: AsteroidType, a: slot, c: position (TracePosition)
+	ASTEROID_SPLIT,		//detail: the hit asteroid's AsteroidType, a: its slot, b: pieces spawned
+	SHOTS_FIRED,		//a: shots fired, b: shots alive after
+	SHOT_HIT,			//detail: the asteroid's AsteroidType, a: shot index, b: asteroid slot, c: score
+	SHIP_HIT,			//detail: the asteroid's AsteroidType, a: asteroid slot, b: lives left, -1 when destroyed
+	LIFE_LOST,			//a: lives left
+	SHIP_DESTROYED,		//a: score
+	POWER_UP_SPAWN,		//a: slot, c: position (TracePosition)
+	POWER_UP_GRABBED,	//a: slot, b: the ship's power ups after
+	COLLISIONS,			//a: shot-asteroid, b: asteroid-asteroid, c: ship-asteroid (high 16 bits) and ship-power up (low 16)
+	TICK_SUMMARY,		//a: asteroids alive, b: shots (high 16 bits) and power ups (low 16) alive, c: microseconds the tick took
+	GAME_OVER,			//a: score, b: level
+	COUNT
+};
+
+struct TraceFileHeader
+{
+	char magic[4]; //"B3DT"
+	uint16_t version;
+	uint16_t recordSize;
+	float tickSeconds; //length of a tick
+	uint32_t reserved;
+};
+
+struct TraceRecord
+{
+	uint8_t event; //TraceEvent
+	uint8_t detail; //small value that goes with the event
+	uint16_t tickDelta; //ticks since the record before it, 0 in TICK records
+	uint32_t a;
+	uint32_t b;
+	uint32_t c;
+};
+
+static_assert(sizeof(TraceFileHeader) == 16, "the trace header is read and written as is");
+static_assert(sizeof(TraceRecord) == 16, "trace records are read and written as is");
+
+inline const char *TraceEventName(TraceEvent event)
+{
+	static const char *names[] = { "tick", "game_start", "level_start", "asteroid_spawn", "asteroid_split",
+		"shots_fired", "shot_hit", "ship_hit", "life_lost", "ship_destroyed", "power_up_spawn",
+		"power_up_grabbed", "collisions", "tick_summary", "game_over" };
+	static_assert(sizeof(names) / sizeof(names[0]) == (size_t)TraceEvent::COUNT, "a trace event is missing its name");
+
+	if (event >= TraceEvent::COUNT) return "unknown";
+	return names[(size_t)event];
+}
+
+// Packs a position into 32 bits, whole pixels clamped to 0-65535
+inline uint32_t TracePosition(float x, float y)
+{
+	uint32_t px = x <= 0.f ? 0 : x >= 65535.f ? 65535 : (uint32_t)x;
+	uint32_t py = y <= 0.f ? 0 : y >= 65535.f ? 65535 : (uint32_t)y;
+	return (px << 16) | py;
+}
+
+class GameTrace
+{
+private:
+	std::ofstream file;
+	std::vector<TraceRecord> chunkMemory; //all the chunks, TRACE_CHUNKS * TRACE_CHUNK_RECORDS
+	TraceRecord *chunk; //being filled, NULL when closed
+	size_t chunkUsed;
+	uint64_t tick;
+	uint64_t lastRecordTick;
+	uint64_t recordCount;
+	uint64_t droppedRecords;
+
+	// shared with the writer thread
+	std::mutex chunkMutex;
+	std::condition_variable chunkReady;
+	std::vector<TraceRecord *> freeChunks;
+	std::vector<std::pair<TraceRecord *, size_t>> fullChunks;
+	bool stopping;
+	std::thread writer;
+
+	void WriterLoop();
+	// hands the current chunk to the writer and takes a free one
+	void SubmitChunk();
+	void StartChunk();
+	void Write(TraceEvent event, uint8_t detail, uint32_t a, uint32_t b, uint32_t c);
+
+public:
+	GameTrace();
+	~GameTrace();
+
+	// Starts writing a new trace file, tickSeconds is stored in its header
+	bool Open(const std::string &filename, float tickSeconds);
+	// Writes what's left and closes the file
+	void Close();
+	bool IsOpen() const { return chunk != NULL; }
+
+	// Call at the start of every tick
+	void BeginTick() { tick++; }
+	uint64_t GetTick() const { return tick; }
+
+	void Record(TraceEvent event, uint8_t detail = 0, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0)
+	{
+		if (chunk == NULL) return;
+		Write(event, detail, a, b, c);
+	}
+
+	uint64_t GetRecordCount() const { return recordCount; }
+	// records thrown away because the writer fell behind
+	uint64_t GetDroppedRecords() const { return droppedRecords; }
+};
@@ -0,0 +1,389 @@
+#include "LoadScheduler.h"
+#include "Logger.h"
+#include <cassert>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+static const char *LoadTaskStateNames[] = { "waiting", "running", "done", "failed" };
+
+LoadScheduler::LoadScheduler(unsigned workerThreads) : createdTime(std::chrono::steady_clock::now()),
+	unfinishedTasks(0), workerCount(workerThreads), stopping(false)
+{
+	if (workerCount == 0)
+	{
+		//leave a core for the game thread, hardware_concurrency() may not know (0)
+		unsigned cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 1;
+	}
+}
+
+LoadScheduler::~LoadScheduler()
+{
+	StopWorkers();
+}
+
+double LoadScheduler::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - createdTime).count();
+}
+
+LoadTaskID LoadScheduler::Add(const std::string &name, TaskKind kind, std::function<bool()> start,
+	std::function<LoadTaskState()> poll, std::function<bool()> work, const std::vector<LoadTaskID> &dependencies)
+{
+	LoadTaskID id = (LoadTaskID)tasks.size();
+	for (LoadTaskID dependency : dependencies)
+	{
+		//keeps the graph free of cycles, and lets one pass in ID order start a whole chain
+		assert(dependency >= 0 && dependency < id && "Dependencies must be added first");
+	}
+
+	Task task;
+	task.name = name;
+	task.kind = kind;
+	task.dependencies = dependencies;
+	task.start = start;
+	task.poll = poll;
+	task.work = work;
+	task.state = LoadTaskState::WAITING;
+	task.startTime = 0;
+	task.endTime = 0;
+	tasks.push_back(task);
+	unfinishedTasks++;
+	return id;
+}
+
+LoadTaskID LoadScheduler::AddTask(const std::string &name, std::function<bool()> run,
+	const std::vector<LoadTaskID> &dependencies)
+{
+	return Add(name, TaskKind::GAME_THREAD, run, std::function<LoadTaskState()>(), std::function<bool()>(),
+		dependencies);
+}
+
+LoadTaskID LoadScheduler::AddAsyncTask(const std::string &name, std::function<bool()> start,
+	std::function<LoadTaskState()> poll, const std::vector<LoadTaskID> &dependencies)
+{
+	assert(poll);
+	return Add(name, TaskKind::ASYNC, start, poll, std::function<bool()>(), dependencies);
+}
+
+LoadTaskID LoadScheduler::AddWorkerTask(const std::string &name, std::function<bool()> work,
+	std::function<bool()> finish, const std::vector<LoadTaskID> &dependencies)
+{
+	assert(work);
+	return Add(name, TaskKind::WORKER, finish, std::function<LoadTaskState()>(), work, dependencies);
+}
+
+LoadTaskState LoadScheduler::DependencyState(const Task &task)
+{
+	LoadTaskState state = LoadTaskState::DONE;
+	for (LoadTaskID dependency : task.dependencies)
+	{
+		LoadTaskState dependencyState = tasks[dependency].state;
+		if (dependencyState == LoadTaskState::FAILED) return LoadTaskState::FAILED;
+		if (dependencyState != LoadTaskState::DONE) state = LoadTaskState::WAITING;
+	}
+	return state;
+}
+
+void LoadScheduler::Finished(Task &task, LoadTaskState state)
+{
+	task.state = state;
+	task.endTime = Now();
+	unfinishedTasks--;
+
+	//whatever the functions hold on to (decoded images...) can go now
+	task.start = std::function<bool()>();
+	task.poll = std::function<LoadTaskState()>();
+	task.work = std::function<bool()>();
+
+	if (state == LoadTaskState::FAILED) oLog(Level::Warning) << "Loading: " << task.name << " failed";
+}
+
+void LoadScheduler::QueueJob(Task &task)
+{
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->task = (LoadTaskID)(&task - &tasks[0]);
+	job->work = task.work;
+	job->state = JOB_QUEUED;
+	job->queuedTime = Now();
+	job->workStartTime = 0;
+	job->workEndTime = 0;
+	task.work = std::function<bool()>();
+	task.job = job;
+
+	std::lock_guard<std::mutex> lock(jobMutex);
+	if (workers.empty() && !stopping)
+	{
+		for (unsigned i = 0; i < workerCount; ++i) workers.push_back(std::thread(&LoadScheduler::WorkerLoop, this));
+	}
+	if (stopping) job->state = JOB_FAILED;
+	else
+	{
+		jobs.push_back(job);
+		jobQueued.notify_one();
+	}
+}
+
+void LoadScheduler::RunJob(Job &job)
+{
+	job.workStartTime = Now();
+	bool succeeded = job.work();
+	job.work = std::function<bool()>();
+	job.workEndTime = Now();
+	//last, the game thread reads the rest once it sees this
+	job.state = succeeded ? JOB_SUCCEEDED : JOB_FAILED;
+
+	std::lock_guard<std::mutex> lock(jobMutex);
+	jobDone.notify_all();
+}
+
+void LoadScheduler::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(jobMutex);
+	while (true)
+	{
+		jobQueued.wait(lock, [this]() { return stopping || !jobs.empty(); });
+		if (stopping) return;
+
+		std::shared_ptr<Job> job = jobs.front();
+		jobs.pop_front();
+
+		lock.unlock();
+		RunJob(*job);
+		lock.lock();
+	}
+}
+
+bool LoadScheduler::RunQueuedJob(const std::vector<bool> &needed)
+{
+	std::shared_ptr<Job> job;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		for (std::deque<std::shared_ptr<Job>>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+		{
+			if ((*it)->task < (LoadTaskID)needed.size() && needed[(*it)->task])
+			{
+				job = *it;
+				jobs.erase(it);
+				break;
+			}
+		}
+	}
+	if (!job) return false;
+
+	RunJob(*job);
+	return true;
+}
+
+void LoadScheduler::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+		//nobody will run these now
+		for (std::shared_ptr<Job> &job : jobs)
+		{
+			job->work = std::function<bool()>();
+			job->state = JOB_FAILED;
+		}
+		jobs.clear();
+		jobQueued.notify_all();
+	}
+
+	for (std::thread &worker : workers) worker.join();
+	workers.clear();
+}
+
+bool LoadScheduler::HasGameThreadWork(const Task &task)
+{
+	switch (task.kind)
+	{
+	case TaskKind::GAME_THREAD:
+		return task.state == LoadTaskState::WAITING;
+	case TaskKind::WORKER:
+		return task.state == LoadTaskState::RUNNING && task.job->state != JOB_QUEUED;
+	default:
+		return false;
+	}
+}
+
+bool LoadScheduler::Step(Task &task)
+{
+	if (task.state == LoadTaskState::RUNNING)
+	{
+		if (task.kind == TaskKind::WORKER)
+		{
+			int jobState = task.job->state;
+			if (jobState == JOB_QUEUED) return false;
+			if (jobState == JOB_FAILED)
+			{
+				Finished(task, LoadTaskState::FAILED);
+				return false;
+			}
+
+			//hand the result over on the game thread
+			bool finished = !task.start || task.start();
+			Finished(task, finished ? LoadTaskState::DONE : LoadTaskState::FAILED);
+			return true;
+		}
+
+		LoadTaskState state = task.poll();
+		if (state == LoadTaskState::DONE || state == LoadTaskState::FAILED) Finished(task, state);
+		return false;
+	}
+
+	LoadTaskState dependencies = DependencyState(task);
+	if (dependencies == LoadTaskState::WAITING) return false;
+
+	task.startTime = Now();
+	if (dependencies == LoadTaskState::FAILED)
+	{
+		//nothing to run it on
+		Finished(task, LoadTaskState::FAILED);
+		return false;
+	}
+
+	task.state = LoadTaskState::RUNNING;
+	if (task.kind == TaskKind::WORKER)
+	{
+		QueueJob(task);
+		return false;
+	}
+
+	if (!task.start())
+	{
+		bool gameThread = task.kind == TaskKind::GAME_THREAD;
+		Finished(task, LoadTaskState::FAILED);
+		return gameThread;
+	}
+
+	if (task.kind == TaskKind::GAME_THREAD)
+	{
+		Finished(task, LoadTaskState::DONE);
+		return true;
+	}
+
+	//some async jobs are over as soon as they're started
+	Step(task);
+	return false;
+}
+
+void LoadScheduler::QueueReadyJobs()
+{
+	for (Task &task : tasks)
+	{
+		if (task.kind == TaskKind::WORKER && task.state == LoadTaskState::WAITING) Step(task);
+	}
+}
+
+void LoadScheduler::Update(double budget)
+{
+	if (unfinishedTasks == 0) return;
+
+	double deadline = Now() + budget;
+	bool ranWork = false;
+	for (Task &task : tasks)
+	{
+		if (task.state == LoadTaskState::DONE || task.state == LoadTaskState::FAILED) continue;
+		//queuing and polling are cheap, only game-thread work is held back by the budget
+		if (ranWork && HasGameThreadWork(task) && Now() >= deadline) continue;
+		if (Step(task)) ranWork = true;
+	}
+}
+
+bool LoadScheduler::Finish(LoadTaskID task)
+{
+	assert(task >= 0 && task < (LoadTaskID)tasks.size());
+
+	//only what the task needs, directly or not, dependencies always have lower IDs
+	std::vector<bool> needed(task + 1, false);
+	needed[task] = true;
+	for (LoadTaskID id = task; id >= 0; --id)
+	{
+		if (!needed[id]) continue;
+		for (LoadTaskID dependency : tasks[id].dependencies) needed[dependency] = true;
+	}
+
+	while (tasks[task].state != LoadTaskState::DONE && tasks[task].state != LoadTaskState::FAILED)
+	{
+		//keep the workers busy with the rest while we wait
+		QueueReadyJobs();
+
+		bool waiting = true;
+		for (LoadTaskID id = 0; id <= task; ++id)
+		{
+			if (!needed[id]) continue;
+			if (tasks[id].state == LoadTaskState::DONE || tasks[id].state == LoadTaskState::FAILED) continue;
+			if (Step(tasks[id])) waiting = false;
+		}
+		if (!waiting || tasks[task].state == LoadTaskState::DONE || tasks[task].state == LoadTaskState::FAILED) continue;
+
+		//rather than wait for a worker to get to a job we need, do it ourselves
+		if (RunQueuedJob(needed)) continue;
+
+		//only async jobs and jobs already being worked on left, give them time to get on with it
+		std::unique_lock<std::mutex> lock(jobMutex);
+		jobDone.wait_for(lock, std::chrono::milliseconds(1));
+	}
+
+	return tasks[task].state == LoadTaskState::DONE;
+}
+
+LoadTaskState LoadScheduler::GetState(LoadTaskID task)
+{
+	if (task < 0 || task >= (LoadTaskID)tasks.size()) return LoadTaskState::FAILED;
+	return tasks[task].state;
+}
+
+bool LoadScheduler::IsDone(LoadTaskID task)
+{
+	return GetState(task) == LoadTaskState::DONE;
+}
+
+bool LoadScheduler::AllFinished()
+{
+	return unfinishedTasks == 0;
+}
+
+double LoadScheduler::GetElapsedTime()
+{
+	return Now();
+}
+
+void LoadScheduler::LogTimings()
+{
+	double lastEnd = 0;
+	double workTime = 0;
+	for (const Task &task : tasks)
+	{
+		if (task.endTime > lastEnd) lastEnd = task.endTime;
+		if (task.job && task.job->state != JOB_QUEUED) workTime += task.job->workEndTime - task.job->workStartTime;
+	}
+
+	oLog(Level::Info) << "Loading: " << tasks.size() << " tasks, " << unfinishedTasks << " unfinished, last one done at "
+		<< lastEnd * 1000.0 << " ms, " << workTime * 1000.0 << " ms of work on " << workers.size() << " worker threads";
+	for (const Task &task : tasks)
+	{
+		if (task.state == LoadTaskState::DONE || task.state == LoadTaskState::FAILED)
+		{
+			if (task.job && task.job->workEndTime > 0)
+			{
+				const Job &job = *task.job;
+				oLog(Level::Info) << "\t" << task.name << ": " << LoadTaskStateNames[(int)task.state]
+					<< ", started at " << task.startTime * 1000.0 << " ms, took "
+					<< (task.endTime - task.startTime) * 1000.0 << " ms: queued for "
+					<< (job.workStartTime - job.queuedTime) * 1000.0 << " ms, worked for "
+					<< (job.workEndTime - job.workStartTime) * 1000.0 << " ms, finished in "
+					<< (task.endTime - job.workEndTime) * 1000.0 << " ms after that";
+			}
+			else
+			{
+				oLog(Level::Info) << "\t" << task.name << ": " << LoadTaskStateNames[(int)task.state]
+					<< ", started at " << task.startTime * 1000.0 << " ms, took "
+					<< (task.endTime - task.startTime) * 1000.0 << " ms";
+			}
+		}
+		else oLog(Level::Info) << "\t" << task.name << ": " << LoadTaskStateNames[(int)task.state];
+	}
+}
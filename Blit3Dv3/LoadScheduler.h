@@ -0,0 +1,141 @@
+#pragma once
+
+/*
+	Small dependency scheduler for the game's start-up loading.
+
+	Each task lists the tasks it needs, which must have been added before it. A task
+	starts once all of them are done, and fails without running if one of them failed.
+	There are three kinds of task:
+	- game-thread tasks do all their work in one function, called from Update() on the
+	  game thread, so they can use the GL context (sprites, fonts) and game state;
+	- async tasks are started on the game thread and then finish by themselves, like a
+	  bank loading on the sound engine's bank thread; Update() polls them;
+	- worker tasks do their work (file reads, image decoding) on a pool of worker threads,
+	  then hand the result over in a finish function run on the game thread, where the
+	  GL objects get made. Independent worker tasks run side by side, so loading takes
+	  about as long as the slowest of them rather than all of them added up.
+
+	Update() is meant to be called once a frame with a time budget, so loading carries on
+	behind the title screen without stalling it. Finish() gets a task done right away, for
+	when the game can't go on without it.
+
+	Tasks are timed from the scheduler's creation, LogTimings() writes them to the log.
+*/
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Threads doing the work of worker tasks, 0 for one less than the number of cores
+#ifndef LOAD_WORKER_THREADS
+#define LOAD_WORKER_THREADS 0
+#endif
+
+enum class LoadTaskState { WAITING = 0, RUNNING, DONE, FAILED };
+
+typedef int LoadTaskID;
+#define LOAD_INVALID_TASK -1
+
+class LoadScheduler
+{
+	enum class TaskKind { GAME_THREAD = 0, ASYNC, WORKER };
+	enum JobState { JOB_QUEUED = 0, JOB_SUCCEEDED, JOB_FAILED };
+
+	// The part of a worker task the worker threads see, tasks can move as more are added
+	struct Job
+	{
+		LoadTaskID task;
+		std::function<bool()> work; //let go of by the worker once it has run
+		std::atomic<int> state; //a JobState
+		double queuedTime, workStartTime, workEndTime; //written by the worker before state
+	};
+
+	struct Task
+	{
+		std::string name;
+		TaskKind kind;
+		std::vector<LoadTaskID> dependencies;
+		std::function<bool()> start; //game-thread tasks do all their work here, worker tasks finish here
+		std::function<LoadTaskState()> poll; //async tasks only
+		std::shared_ptr<Job> job; //worker tasks only, once queued
+		std::function<bool()> work; //worker tasks only, until queued
+		LoadTaskState state;
+		double startTime, endTime; //seconds since the scheduler was created
+	};
+	std::vector<Task> tasks;
+	std::chrono::steady_clock::time_point createdTime;
+	size_t unfinishedTasks;
+
+	unsigned workerCount;
+	std::vector<std::thread> workers; //started with the first worker task
+	std::mutex jobMutex;
+	std::condition_variable jobQueued;
+	std::condition_variable jobDone;
+	std::deque<std::shared_ptr<Job>> jobs;
+	bool stopping;
+
+	double Now();
+	// WAITING while a dependency is unfinished, then DONE, or FAILED if one failed
+	LoadTaskState DependencyState(const Task &task);
+	void Finished(Task &task, LoadTaskState state);
+	// Starts the task if it can, or polls it if it's running.
+	// Returns true if it ran game-thread work (a game-thread task, or a worker task's finish).
+	bool Step(Task &task);
+	// Whether Step() would run game-thread work, the kind the frame budget holds back
+	bool HasGameThreadWork(const Task &task);
+	LoadTaskID Add(const std::string &name, TaskKind kind, std::function<bool()> start,
+		std::function<LoadTaskState()> poll, std::function<bool()> work,
+		const std::vector<LoadTaskID> &dependencies);
+
+	void QueueJob(Task &task);
+	// Steps every worker task that is ready, so the pool has all it can be given
+	void QueueReadyJobs();
+	// Does a job's work, on a worker or on the game thread
+	void RunJob(Job &job);
+	void WorkerLoop();
+	// Runs a queued job for one of the needed tasks on the calling thread, false if there's none
+	bool RunQueuedJob(const std::vector<bool> &needed);
+public:
+	LoadScheduler(unsigned workerThreads = LOAD_WORKER_THREADS);
+	~LoadScheduler();
+
+	// run does the whole job on the game thread and returns false if it failed
+	LoadTaskID AddTask(const std::string &name, std::function<bool()> run,
+		const std::vector<LoadTaskID> &dependencies = std::vector<LoadTaskID>());
+	// start kicks the job off on the game thread and returns false if it couldn't,
+	// poll is then called by Update() until it returns DONE or FAILED
+	LoadTaskID AddAsyncTask(const std::string &name, std::function<bool()> start,
+		std::function<LoadTaskState()> poll,
+		const std::vector<LoadTaskID> &dependencies = std::vector<LoadTaskID>());
+	// work runs on a worker thread and must leave GL and game state alone, finish then runs
+	// on the game thread to hand the result over. Either returns false if it failed.
+	LoadTaskID AddWorkerTask(const std::string &name, std::function<bool()> work,
+		std::function<bool()> finish,
+		const std::vector<LoadTaskID> &dependencies = std::vector<LoadTaskID>());
+
+	// Starts what's ready and polls what's running. Game-thread work is done until
+	// budget seconds have gone by, but at least one piece per call so loading always moves on.
+	void Update(double budget);
+	// Runs the task and everything it needs now, waiting for async and worker tasks to
+	// finish, and lending a hand with the needed worker jobs still queued.
+	// Returns true if the task is DONE.
+	bool Finish(LoadTaskID task);
+	// Waits for the jobs being worked on and joins the worker threads, queued jobs are
+	// dropped. Call it before anything the jobs read from goes away.
+	void StopWorkers();
+
+	LoadTaskState GetState(LoadTaskID task);
+	bool IsDone(LoadTaskID task);
+	// true once every task is DONE or FAILED
+	bool AllFinished();
+	// Seconds since the scheduler was created, the clock task timings use
+	double GetElapsedTime();
+	void LogTimings();
+};
@@ -0,0 +1,213 @@
+#include "NullAudioBackend.h"
+#include "AudioEngine.h"
+#include "Logger.h"
+
+#include <fstream>
+#include <iomanip>
+
+//use the main Blit3D logger
+extern logger oLog;
+
+static const char *NullAudioCallNames[] = { "Init", "Term", "RenderAudio", "SetBasePath", "LoadBank",
+	"LoadBankAsync", "PostEvent", "ActionOnEvent", "SetRTPCValue", "SetPosition", "RegisterGameObject" };
+
+NullAudioBackend::NullAudioBackend(std::string traceFile, size_t maxEntries)
+{
+	traceFilename = traceFile;
+	maxTraceEntries = maxEntries > 0 ? maxEntries : 1;
+	trace.reserve(maxTraceEntries);
+	traceHead = 0;
+	overwrittenTraceEntries = 0;
+	nextPlayingID = 1;
+	frame = 0;
+	callsThisFrame = 0;
+	maxCallsPerFrame = 0;
+	for (int i = 0; i < (int)NullAudioCall::COUNT; ++i)
+	{
+		callCount[i] = 0;
+	}
+	startTime = std::chrono::steady_clock::now();
+}
+
+void NullAudioBackend::Record(NullAudioCall call, AkUniqueID id, AkGameObjectID gameObjectID, AkPlayingID playingID,
+	AkRtpcValue value)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(traceMutex);
+
+	AudioTraceEntry entry;
+	entry.timestamp = std::chrono::duration<double>(now - startTime).count();
+	entry.frame = frame;
+	entry.call = call;
+	entry.id = id;
+	entry.gameObjectID = gameObjectID;
+	entry.playingID = playingID;
+	entry.value = value;
+
+	if (call == NullAudioCall::RENDER_AUDIO)
+	{
+		//a new audio frame starts after this call
+		if (callsThisFrame > maxCallsPerFrame) maxCallsPerFrame = callsThisFrame;
+		callsThisFrame = 0;
+		frame++;
+	}
+	else callsThisFrame++;
+
+	//never grows past what the constructor reserved
+	if (trace.size() < maxTraceEntries) trace.push_back(entry);
+	else
+	{
+		trace[traceHead] = entry;
+		traceHead = (traceHead + 1) % maxTraceEntries;
+		overwrittenTraceEntries++;
+	}
+	callCount[(int)call]++;
+}
+
+bool NullAudioBackend::Init()
+{
+	startTime = std::chrono::steady_clock::now();
+	Record(NullAudioCall::INIT, AK_INVALID_UNIQUE_ID, 0, AK_INVALID_PLAYING_ID, 0);
+	oLog(Level::Info) << "Audio running on the null backend, no sound will be played";
+	return true;
+}
+
+void NullAudioBackend::Term()
+{
+	Record(NullAudioCall::TERM, AK_INVALID_UNIQUE_ID, 0, AK_INVALID_PLAYING_ID, 0);
+	LogReport();
+	if (!traceFilename.empty()) WriteTrace();
+}
+
+void NullAudioBackend::RenderAudio()
+{
+	Record(NullAudioCall::RENDER_AUDIO, AK_INVALID_UNIQUE_ID, 0, AK_INVALID_PLAYING_ID, 0);
+}
+
+void NullAudioBackend::SetBasePath(const std::string &path)
+{
+	Record(NullAudioCall::SET_BASE_PATH, AudioHash::HashName(path.c_str()), 0, AK_INVALID_PLAYING_ID, 0);
+}
+
+bool NullAudioBackend::LoadBank(const std::string &bank)
+{
+	Record(NullAudioCall::LOAD_BANK, AudioHash::HashName(bank.c_str()), 0, AK_INVALID_PLAYING_ID, 0);
+	return true;
+}
+
+bool NullAudioBackend::LoadBankAsync(const std::string &bank, AudioBankCallback callback, void *cookie)
+{
+	Record(NullAudioCall::LOAD_BANK_ASYNC, AudioHash::HashName(bank.c_str()), 0, AK_INVALID_PLAYING_ID, 0);
+	//there is nothing to load, so it's done already
+	callback(true, cookie);
+	return true;
+}
+
+AkPlayingID NullAudioBackend::PostEvent(AkUniqueID eventID, AkGameObjectID gameObjectID)
+{
+	//hand out unique playing IDs like the real engine would, only the audio thread posts
+	AkPlayingID playingID = nextPlayingID++;
+	if (nextPlayingID == AK_INVALID_PLAYING_ID) nextPlayingID++;
+	Record(NullAudioCall::POST_EVENT, eventID, gameObjectID, playingID, 0);
+	return playingID;
+}
+
+void NullAudioBackend::ExecuteActionOnEvent(AudioCommandType action, AkUniqueID eventID, AkGameObjectID gameObjectID,
+	AkTimeMs /*transitionDuration*/, AkPlayingID playingID)
+{
+	Record(NullAudioCall::ACTION_ON_EVENT, eventID, gameObjectID, playingID, (AkRtpcValue)action);
+}
+
+void NullAudioBackend::SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID)
+{
+	Record(NullAudioCall::SET_RTPC, rtpcID, gameObjectID, AK_INVALID_PLAYING_ID, value);
+}
+
+void NullAudioBackend::SetPosition(AkGameObjectID gameObjectID, float x, float /*y*/)
+{
+	//only X goes in the trace, it's the one the game pans with
+	Record(NullAudioCall::SET_POSITION, AK_INVALID_UNIQUE_ID, gameObjectID, AK_INVALID_PLAYING_ID, x);
+}
+
+void NullAudioBackend::RegisterGameObject(AkGameObjectID gameObjectID)
+{
+	Record(NullAudioCall::REGISTER_GAME_OBJECT, AK_INVALID_UNIQUE_ID, gameObjectID, AK_INVALID_PLAYING_ID, 0);
+}
+
+AkUInt64 NullAudioBackend::GetCallCount(NullAudioCall call)
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	return callCount[(int)call];
+}
+
+double NullAudioBackend::GetAverageCallsPerFrame()
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	if (frame == 0) return 0;
+
+	AkUInt64 calls = 0;
+	for (int i = 0; i < (int)NullAudioCall::COUNT; ++i)
+	{
+		if (i != (int)NullAudioCall::RENDER_AUDIO) calls += callCount[i];
+	}
+	return (double)calls / frame;
+}
+
+AkUInt32 NullAudioBackend::GetMaxCallsPerFrame()
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	return maxCallsPerFrame;
+}
+
+std::vector<AudioTraceEntry> NullAudioBackend::GetTrace()
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	std::vector<AudioTraceEntry> ordered(trace.begin() + traceHead, trace.end());
+	ordered.insert(ordered.end(), trace.begin(), trace.begin() + traceHead);
+	return ordered;
+}
+
+void NullAudioBackend::LogReport()
+{
+	double averageCallsPerFrame = GetAverageCallsPerFrame();
+
+	std::lock_guard<std::mutex> lock(traceMutex);
+
+	oLog(Level::Info) << "Null audio backend: " << frame << " audio frames, "
+		<< averageCallsPerFrame << " calls per frame on average, " << maxCallsPerFrame << " at most";
+	for (int i = 0; i < (int)NullAudioCall::COUNT; ++i)
+	{
+		if (callCount[i] == 0) continue;
+		oLog(Level::Info) << "\t" << NullAudioCallNames[i] << ": " << callCount[i] << " calls";
+	}
+	if (overwrittenTraceEntries > 0)
+	{
+		oLog(Level::Warning) << "Null audio backend trace was full, the oldest " << overwrittenTraceEntries << " calls were overwritten";
+	}
+}
+
+bool NullAudioBackend::WriteTrace()
+{
+	std::ofstream file(traceFilename, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		oLog(Level::Warning) << "Could not open audio trace file: " << traceFilename;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(traceMutex);
+
+	file << "timestamp,frame,call,id,game_object,playing_id,value\n";
+	file << std::setprecision(9);
+	//oldest first, the ring starts at the head
+	for (size_t i = 0; i < trace.size(); ++i)
+	{
+		const AudioTraceEntry &entry = trace[(traceHead + i) % trace.size()];
+		file << entry.timestamp << ',' << entry.frame << ','
+			<< NullAudioCallNames[(int)entry.call] << ',' << entry.id << ',' << entry.gameObjectID << ','
+			<< entry.playingID << ',' << entry.value << '\n';
+	}
+
+	oLog(Level::Info) << "Wrote " << trace.size() << " audio trace entries to " << traceFilename;
+	return true;
+}
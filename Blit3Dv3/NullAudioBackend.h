@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+	AudioBackend that makes no sound at all.
+
+	Every call is accepted and recorded, with a timestamp, into a trace allocated up
+	front and used as a ring, so a long run keeps its latest calls. On Term() a summary
+	(calls per type, calls per audio frame) goes to the Blit3D log and, if a trace file
+	name was given, the trace is written out as CSV.
+
+	Used automatically when the game is built without Wwise, and useful with Wwise
+	too when you want to see the game's audio traffic without the sound engine's own
+	work. AudioEngine times the calls into whichever backend it runs on, see
+	AudioEngine::GetAverageBackendCost().
+*/
+
+#include "AudioBackend.h"
+
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+enum class NullAudioCall { INIT = 0, TERM, RENDER_AUDIO, SET_BASE_PATH, LOAD_BANK,
+	LOAD_BANK_ASYNC, POST_EVENT, ACTION_ON_EVENT, SET_RTPC, SET_POSITION, REGISTER_GAME_OBJECT, COUNT };
+
+struct AudioTraceEntry
+{
+	double timestamp; //seconds since Init()
+	AkUInt32 frame; //number of RenderAudio() calls before this one
+	NullAudioCall call;
+	AkUniqueID id; //event, RTPC or bank ID, depending on the call
+	AkGameObjectID gameObjectID;
+	AkPlayingID playingID;
+	AkRtpcValue value; //RTPC value, X for SET_POSITION, or the AudioCommandType for ACTION_ON_EVENT
+};
+
+class NullAudioBackend : public AudioBackend
+{
+private:
+	std::string traceFilename;
+	size_t maxTraceEntries;
+
+	//the game thread and the audio thread can both be calling in
+	std::mutex traceMutex;
+	std::vector<AudioTraceEntry> trace; //reserved up front, a ring once full
+	size_t traceHead; //oldest entry once the trace is full
+	AkUInt64 overwrittenTraceEntries;
+
+	std::chrono::steady_clock::time_point startTime;
+	AkPlayingID nextPlayingID;
+
+	AkUInt32 frame;
+	AkUInt32 callsThisFrame;
+	AkUInt32 maxCallsPerFrame;
+	AkUInt64 callCount[(int)NullAudioCall::COUNT];
+
+	void Record(NullAudioCall call, AkUniqueID id, AkGameObjectID gameObjectID, AkPlayingID playingID,
+		AkRtpcValue value);
+	void LogReport();
+	bool WriteTrace();
+
+public:
+	// traceFile: CSV file written on Term(), leave empty to skip it.
+	// maxEntries: calls the trace holds, reserved now. Older ones are overwritten, statistics keep counting.
+	NullAudioBackend(std::string traceFile = "", size_t maxEntries = 1 << 16);
+
+	bool Init();
+	void Term();
+	void RenderAudio();
+	void SetBasePath(const std::string &path);
+	bool LoadBank(const std::string &bank);
+	bool LoadBankAsync(const std::string &bank, AudioBankCallback callback, void *cookie);
+
+	AkPlayingID PostEvent(AkUniqueID eventID, AkGameObjectID gameObjectID);
+	void ExecuteActionOnEvent(AudioCommandType action, AkUniqueID eventID, AkGameObjectID gameObjectID,
+		AkTimeMs transitionDuration, AkPlayingID playingID);
+	void SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID);
+	void SetPosition(AkGameObjectID gameObjectID, float x, float y);
+	void RegisterGameObject(AkGameObjectID gameObjectID);
+
+	AkUInt64 GetCallCount(NullAudioCall call);
+	double GetAverageCallsPerFrame();
+	AkUInt32 GetMaxCallsPerFrame();
+	// copy of the trace, oldest call first
+	std::vector<AudioTraceEntry> GetTrace();
+};
@@ -18,6 +18,8 @@ PowerUp::PowerUp(glm::vec2 newPosition, float newRadius, Sprite* newSprite)
 */
 void PowerUp::Draw()
 {
+	//the sprite is shared with the ship's shots, which turn it
+	this->sprite->angle = 0;
 	this->sprite->Blit(this->position.x, this->position.y, this->radiusOrtho, this->radiusOrtho);
 }
 /**
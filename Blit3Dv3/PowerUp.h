@@ -1,6 +1,7 @@
 #pragma once
 
 #include<Blit3D.h>
+#include "SlotMap.h"
 
 /**
 * This class represents a power-up and its behaviour.
@@ -70,4 +71,6 @@ public:
 	* @param glm::vec2 The position to calculate the distance with this power up.
 	*/
 	float Distance(glm::vec2);
-};
\ No newline at end of file
+};
+
+typedef SlotHandle<PowerUp> PowerUpHandle;
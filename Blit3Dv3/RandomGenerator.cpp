@@ -1,20 +1,121 @@
 #include "RandomGenerator.h"
+#include <random>
+
+namespace
+{
+	const uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+}
 
 /**
-* Constructor of the RandomGenerator object.
+* Constructor of the RandomGenerator object, seeded from the system's random device on stream 0.
 */
-RandomGenerator::RandomGenerator() 
+RandomGenerator::RandomGenerator()
 {
 	std::random_device rd;
-	this->SeedRNG(rd());
+	this->Seed(((uint64_t)rd() << 32) | rd(), 0);
+}
+/**
+* Constructor of the RandomGenerator object, with a known seed and stream.
+* @param uint64_t The seed.
+* @param uint64_t The stream.
+*/
+RandomGenerator::RandomGenerator(uint64_t seedVal, uint64_t stream)
+{
+	this->Seed(seedVal, stream);
 }
 /**
-* Seeds the RandomGenerator.
+* Seeds the RandomGenerator on stream 0.
 * @param unsigned int The value to seed the random device.
 */
-void RandomGenerator::SeedRNG(unsigned int seedVal) 
+void RandomGenerator::SeedRNG(unsigned int seedVal)
+{
+	this->Seed(seedVal, 0);
+}
+/**
+* Seeds the RandomGenerator on a given stream.
+* @param uint64_t The seed.
+* @param uint64_t The stream.
+*/
+void RandomGenerator::Seed(uint64_t seedVal, uint64_t stream)
+{
+	// pcg32_srandom_r
+	this->seed = seedVal;
+	this->state = 0;
+	this->increment = (stream << 1) | 1;
+	this->Next();
+	this->state += seedVal;
+	this->Next();
+}
+/**
+* Returns the seed the generator was given.
+* @return The seed.
+*/
+uint64_t RandomGenerator::GetSeed() const
 {
-	rng.seed(seedVal);
+	return this->seed;
+}
+/**
+* Makes a generator with this generator's seed on another stream, as this one was when it was seeded.
+* @param uint64_t The stream, for example the worker's number.
+* @return The new generator.
+*/
+RandomGenerator RandomGenerator::Stream(uint64_t stream) const
+{
+	return RandomGenerator(this->seed, stream);
+}
+/**
+* Skips numbers, as if they had been generated, in a time that grows with the log of the count.
+* @param uint64_t How many numbers to skip.
+*/
+void RandomGenerator::Advance(uint64_t count)
+{
+	// Brown's LCG jump: square the step for every bit of the count
+	uint64_t multiplier = PCG_MULTIPLIER;
+	uint64_t add = this->increment;
+	uint64_t totalMultiplier = 1;
+	uint64_t totalAdd = 0;
+	while (count > 0)
+	{
+		if (count & 1)
+		{
+			totalMultiplier *= multiplier;
+			totalAdd = totalAdd * multiplier + add;
+		}
+		add = (multiplier + 1) * add;
+		multiplier *= multiplier;
+		count >>= 1;
+	}
+	this->state = totalMultiplier * this->state + totalAdd;
+}
+/**
+* Moves the state ahead by one number and returns the number for the old state.
+* @return A random 32 bit number.
+*/
+uint32_t RandomGenerator::Next()
+{
+	uint64_t oldState = this->state;
+	this->state = oldState * PCG_MULTIPLIER + this->increment;
+	return Output(oldState);
+}
+/**
+* Turns a state into its number, the PCG XSH RR output.
+* @param uint64_t The state.
+* @return The state's number.
+*/
+uint32_t RandomGenerator::Output(uint64_t oldState)
+{
+	uint32_t xorShifted = (uint32_t)(((oldState >> 18) ^ oldState) >> 27);
+	uint32_t rotation = (uint32_t)(oldState >> 59);
+	return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+}
+/**
+* Turns a random number into a float in [0, 1), from its top 24 bits.
+* @param uint32_t The random number.
+* @return A float in [0, 1).
+*/
+float RandomGenerator::ToUnitFloat(uint32_t value)
+{
+	return (value >> 8) * (1.f / 16777216.f);
 }
 /**
 * Generates a random float between two numbers and with decimals related to the precision specified.
@@ -26,10 +127,18 @@ void RandomGenerator::SeedRNG(unsigned int seedVal)
 */
 float RandomGenerator::RandomFloat(int min, int max, int precision)
 {
-	int distance = (max - min) * precision;
-	std::uniform_int_distribution<unsigned int> uint_distDice(0, distance);
-	distance = (uint_distDice(rng) / precision) + min;
-	return distance;
+	int steps = this->RandomInt(0, (max - min) * precision);
+	return min + (float)steps / precision;
+}
+/**
+* Generates a random float between two numbers.
+* @param float The minimum value
+* @param float The maximum value, which is never returned
+* @return A random float between min and max.
+*/
+float RandomGenerator::RandomFloat(float min, float max)
+{
+	return min + (max - min) * ToUnitFloat(this->Next());
 }
 /**
 * Generates a random int between two numbers.
@@ -39,6 +148,77 @@ float RandomGenerator::RandomFloat(int min, int max, int precision)
 */
 int RandomGenerator::RandomInt(int min, int max)
 {
-	std::uniform_int_distribution<unsigned int> uint_distDice(min, max);
-	return uint_distDice(rng);
-}
\ No newline at end of file
+	uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+	if (range > 0xFFFFFFFFULL) return (int)this->Next();
+
+	// Lemire's multiply: the high half of number * range, numbers from the uneven part are drawn again
+	uint64_t product = (uint64_t)this->Next() * range;
+	uint32_t low = (uint32_t)product;
+	if (low < range)
+	{
+		uint32_t threshold = (uint32_t)((0x100000000ULL - range) % range);
+		while (low < threshold)
+		{
+			product = (uint64_t)this->Next() * range;
+			low = (uint32_t)product;
+		}
+	}
+	return (int)((int64_t)min + (int64_t)(product >> 32));
+}
+/**
+* Fills an array with random floats between two numbers, the same ones RandomFloat(min, max) would give.
+* @param float* The array.
+* @param size_t How many floats to fill.
+* @param float The minimum value
+* @param float The maximum value, which is never returned
+*/
+void RandomGenerator::FillFloats(float* values, size_t count, float min, float max)
+{
+	// The state lane numbers ahead is laneMultiplier * state + laneAdd, so a block of lanes
+	// only depends on the state at its start
+	uint64_t laneMultiplier[RANDOM_FILL_LANES];
+	uint64_t laneAdd[RANDOM_FILL_LANES];
+	laneMultiplier[0] = 1;
+	laneAdd[0] = 0;
+	for (int lane = 1; lane < RANDOM_FILL_LANES; ++lane)
+	{
+		laneMultiplier[lane] = laneMultiplier[lane - 1] * PCG_MULTIPLIER;
+		laneAdd[lane] = laneAdd[lane - 1] * PCG_MULTIPLIER + this->increment;
+	}
+	uint64_t blockMultiplier = laneMultiplier[RANDOM_FILL_LANES - 1] * PCG_MULTIPLIER;
+	uint64_t blockAdd = laneAdd[RANDOM_FILL_LANES - 1] * PCG_MULTIPLIER + this->increment;
+
+	float span = max - min;
+	size_t i = 0;
+	for (; i + RANDOM_FILL_LANES <= count; i += RANDOM_FILL_LANES)
+	{
+		uint64_t blockState = this->state;
+		for (int lane = 0; lane < RANDOM_FILL_LANES; ++lane)
+		{
+			values[i + lane] = min + span * ToUnitFloat(Output(laneMultiplier[lane] * blockState + laneAdd[lane]));
+		}
+		this->state = blockMultiplier * blockState + blockAdd;
+	}
+	for (; i < count; ++i)
+	{
+		values[i] = min + span * ToUnitFloat(this->Next());
+	}
+}
+/**
+* Fills an array with random vectors inside a rectangle, x then y of each.
+* @param glm::vec2* The array.
+* @param size_t How many vectors to fill.
+* @param glm::vec2 The rectangle's minimum corner
+* @param glm::vec2 The rectangle's maximum corner, which is never reached
+*/
+void RandomGenerator::FillVec2(glm::vec2* values, size_t count, glm::vec2 min, glm::vec2 max)
+{
+	static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "FillVec2 fills the vectors as one array of floats");
+	if (count == 0) return;
+	this->FillFloats(&values[0].x, count * 2, 0.f, 1.f);
+	glm::vec2 span = max - min;
+	for (size_t i = 0; i < count; ++i)
+	{
+		values[i] = min + span * values[i];
+	}
+}
@@ -1,28 +1,98 @@
 #pragma once
 
-#include <random>
+/*
+	PCG32 random numbers (pcg-random.org): 64 bits of state, a multiply and an add per
+	number, and a stream chosen at seeding. Generators with the same seed on different
+	streams give different sequences, so every worker can have its own, made from the game's
+	seed with Stream(), and a game seeded the same way plays out the same whatever the
+	threads do. One generator must only be used by one thread at a time.
+
+	The Fill functions give exactly the numbers the single calls would, but work out several
+	states ahead at once, so long fills aren't held up waiting on the previous number.
+*/
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <stddef.h>
+
+//numbers worked out at once by the Fill functions
+#define RANDOM_FILL_LANES 8
+
 /**
 * This class represents handles random number generation.
 */
 class RandomGenerator
 {
 private:
-	/** 
-	* The randome device used.
+	/**
+	* The generator's state, it moves on with every number.
+	*/
+	uint64_t state;
+	/**
+	* The increment of the generator's stream, always odd.
 	*/
-	std::mt19937 rng;
+	uint64_t increment;
+	/**
+	* The seed the generator was given, Stream() uses it.
+	*/
+	uint64_t seed;
+	/**
+	* Moves the state ahead by one number and returns the number for the old state.
+	* @return A random 32 bit number.
+	*/
+	uint32_t Next();
+	/**
+	* Turns a state into its number, the PCG XSH RR output.
+	* @param uint64_t The state.
+	* @return The state's number.
+	*/
+	static uint32_t Output(uint64_t oldState);
+	/**
+	* Turns a random number into a float in [0, 1), from its top 24 bits.
+	* @param uint32_t The random number.
+	* @return A float in [0, 1).
+	*/
+	static float ToUnitFloat(uint32_t value);
 public:
 	/**
-	* Constructor of the RandomGenerator object.
+	* Constructor of the RandomGenerator object, seeded from the system's random device on stream 0.
 	*/
 	RandomGenerator();
 	/**
-	* Seeds the RandomGenerator.
+	* Constructor of the RandomGenerator object, with a known seed and stream.
+	* @param uint64_t The seed.
+	* @param uint64_t The stream.
+	*/
+	RandomGenerator(uint64_t seedVal, uint64_t stream);
+	/**
+	* Seeds the RandomGenerator on stream 0.
 	* @param unsigned int The value to seed the random device.
 	*/
 	void SeedRNG(unsigned int seedVal);
 	/**
-	* Generates a random floar between two numbers and with decimals related to the precision specified.
+	* Seeds the RandomGenerator on a given stream.
+	* @param uint64_t The seed.
+	* @param uint64_t The stream.
+	*/
+	void Seed(uint64_t seedVal, uint64_t stream);
+	/**
+	* Returns the seed the generator was given.
+	* @return The seed.
+	*/
+	uint64_t GetSeed() const;
+	/**
+	* Makes a generator with this generator's seed on another stream, as this one was when it was seeded.
+	* @param uint64_t The stream, for example the worker's number.
+	* @return The new generator.
+	*/
+	RandomGenerator Stream(uint64_t stream) const;
+	/**
+	* Skips numbers, as if they had been generated, in a time that grows with the log of the count.
+	* @param uint64_t How many numbers to skip.
+	*/
+	void Advance(uint64_t count);
+	/**
+	* Generates a random float between two numbers and with decimals related to the precision specified.
 	* If presicion is 100, the number will have at most two decimal components.
 	* @param int The minimum value
 	* @param int The maximum value
@@ -31,10 +101,33 @@ public:
 	*/
 	float RandomFloat(int min, int max, int precision);
 	/**
+	* Generates a random float between two numbers.
+	* @param float The minimum value
+	* @param float The maximum value, which is never returned
+	* @return A random float between min and max.
+	*/
+	float RandomFloat(float min, float max);
+	/**
 	* Generates a random int between two numbers.
 	* @param int The minimum value
 	* @param int The maximum value
 	* @return A random int between min and max.
 	*/
 	int RandomInt(int min, int max);
-};
\ No newline at end of file
+	/**
+	* Fills an array with random floats between two numbers, the same ones RandomFloat(min, max) would give.
+	* @param float* The array.
+	* @param size_t How many floats to fill.
+	* @param float The minimum value
+	* @param float The maximum value, which is never returned
+	*/
+	void FillFloats(float* values, size_t count, float min, float max);
+	/**
+	* Fills an array with random vectors inside a rectangle, x then y of each.
+	* @param glm::vec2* The array.
+	* @param size_t How many vectors to fill.
+	* @param glm::vec2 The rectangle's minimum corner
+	* @param glm::vec2 The rectangle's maximum corner, which is never reached
+	*/
+	void FillVec2(glm::vec2* values, size_t count, glm::vec2 min, glm::vec2 max);
+};
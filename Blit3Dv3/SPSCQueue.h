@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+	Bounded single-producer/single-consumer queue.
+
+	Exactly one thread may call Push() and exactly one (other) thread may call Pop().
+	Neither side ever takes a lock or allocates: items live in a fixed ring buffer and
+	the two indices only ever grow, so (tail - head) is always the number of queued items.
+*/
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+private:
+	T items[Capacity];
+	//keep the indices on separate cache lines so the two threads don't fight over them
+	alignas(64) std::atomic<size_t> head; //next item to read, written only by the consumer
+	alignas(64) std::atomic<size_t> tail; //next slot to write, written only by the producer
+
+public:
+	SPSCQueue() : head(0), tail(0) { }
+
+	//producer side: returns false if the queue is full
+	bool Push(const T &item)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+
+		items[t & (Capacity - 1)] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	//consumer side: returns false if the queue is empty
+	bool Pop(T &item)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) return false;
+
+		item = items[h & (Capacity - 1)];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	//approximate when called while the other thread is active
+	size_t Size() const
+	{
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+};
@@ -66,32 +66,29 @@ bool Shot::Update(float seconds)
 	return true;
 }
 /**
-* This method checks the collition of the shots with the asteroids
-* @param std::vector<Shot*> The list of shots
-* @param std::vector<Asteroid*> The list of asteroids
-* @return the score if the asteroid hit or 0 otherwise
+* This method returns true if the shot can still hit something.
+* @return True if the shot's time to live hasn't run out
 */
-int Shot::CollideWithAsteroids(std::vector<Asteroid*>& asteroids)
+bool Shot::IsAlive()
 {
-	int collided = 0;
-	if (this->timeToLive > 0)
-	{	
-		// For each asteroid check if the bullet collided with the asteroid
-		for (auto& asteroid : asteroids)
-		{
-			if (this->CollideWithAsteroid(asteroid))
-			{
-				collided = asteroid->GetScore();
-				asteroid->GotHitByBullet(asteroids);
-				this->HitAnAsteroid();
-				break;
-			}
-		}
-	}
-	return collided;
+	return this->timeToLive > 0;
+}
+/**
+* This method applies the shot hitting an asteroid
+* @param Asteroid* The asteroid that was hit
+* @param SlotMap<Asteroid>& The asteroids, the pieces of the hit one are spawned into it
+* @return the score for hitting the asteroid
+*/
+int Shot::HitAsteroid(Asteroid* asteroid, SlotMap<Asteroid>& asteroids)
+{
+	int score = asteroid->GetScore();
+	asteroid->playExplosionSound();
+	asteroid->GotHitByBullet(asteroids);
+	this->HitAnAsteroid();
+	return score;
 }
 /**
-* This method detects the collision of a shot with an asteroid.
+* This method detects the collision of a shot with an asteroid, without changing either.
 * @param Asteroid* The asteroid to detect colission with
 * @return True if the shot collided with the asteroid, false otherwise
 */
@@ -109,7 +106,6 @@ bool Shot::CollideWithAsteroid(Asteroid* asteroid)
 		if (distance < (this->radius + asteroid->GetRadius()))
 		{
 			collision = true;
-			asteroid->playExplosionSound();
 		}
 	}
 	return collision;
@@ -70,18 +70,24 @@ public:
 	*/
 	bool Update(float seconds);
 	/**
-	* This method checks the collition of the shots with the asteroids
-	* @param std::vector<Shot*> The list of shots
-	* @param std::vector<Asteroid*> The list of asteroids
+	* This method returns true if the shot can still hit something.
+	* @return True if the shot's time to live hasn't run out
 	*/
-	int CollideWithAsteroids(std::vector<Asteroid*>&);
+	bool IsAlive();
 	/**
-	* This method detects the collision of a shot with an asteroid.
+	* This method detects the collision of a shot with an asteroid, without changing either.
 	* @param Asteroid* The asteroid to detect colission with
 	* @return True if the shot collided with the asteroid, false otherwise
 	*/
 	bool CollideWithAsteroid(Asteroid*);
 	/**
+	* This method applies the shot hitting an asteroid
+	* @param Asteroid* The asteroid that was hit
+	* @param SlotMap<Asteroid>& The asteroids, the pieces of the hit one are spawned into it
+	* @return the score for hitting the asteroid
+	*/
+	int HitAsteroid(Asteroid*, SlotMap<Asteroid>&);
+	/**
 	* This method handles the show when it has collided with an asteroid
 	*/
 	void HitAnAsteroid();
@@ -0,0 +1,196 @@
+#pragma once
+
+/*
+	Slot map: game entities stored by value in one array of slots, found through
+	generational handles.
+
+	A handle is the entity's slot index plus the generation the slot had when the entity
+	was spawned. Despawning bumps the slot's generation, so old handles to it stop
+	resolving (Get() returns NULL) instead of pointing at whatever reuses the slot next.
+	Freed slots are reused, so the array only grows to the most entities alive at once.
+
+	Spawn() and Despawn() are deferred: they only queue the change, and Flush() applies
+	the queued spawns and then the queued despawns. Call Flush() at a safe point of the
+	tick, where nothing is walking the slots, so entities can be spawned and despawned
+	from inside a loop over them (an asteroid splitting when shot) without moving the
+	array under that loop.
+*/
+
+#include <vector>
+#include <optional>
+#include <utility>
+#include <cstddef>
+#include <stdint.h>
+
+template <typename T>
+class SlotHandle
+{
+public:
+	uint32_t index;
+	uint32_t generation; //0 for a handle to nothing
+
+	SlotHandle() : index(0), generation(0) { }
+	SlotHandle(uint32_t slotIndex, uint32_t slotGeneration) : index(slotIndex), generation(slotGeneration) { }
+
+	bool IsNull() const { return generation == 0; }
+	bool operator==(const SlotHandle &other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const SlotHandle &other) const { return !(*this == other); }
+};
+
+template <typename T>
+class SlotMap
+{
+private:
+	struct Slot
+	{
+		uint32_t generation; //of the entity in it, or of the next one if it's empty
+		std::optional<T> value;
+
+		Slot() : generation(1) { }
+	};
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots; //empty and not handed to a pending spawn
+	uint32_t pendingGrowth; //slots past the end reserved by pending spawns
+	std::vector<std::pair<uint32_t, T>> pendingSpawns;
+	std::vector<SlotHandle<T>> pendingDespawns;
+	size_t liveCount;
+
+public:
+	SlotMap() : pendingGrowth(0), liveCount(0) { }
+
+	//Queues a new entity built from args, the handle resolves once Flush() has run
+	template <typename... Args>
+	SlotHandle<T> Spawn(Args&&... args)
+	{
+		uint32_t index;
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)slots.size() + pendingGrowth;
+			pendingGrowth++;
+		}
+
+		pendingSpawns.emplace_back(index, T(std::forward<Args>(args)...));
+		//new slots start at generation 1, reused ones kept theirs when they were emptied
+		uint32_t generation = index < slots.size() ? slots[index].generation : 1;
+		return SlotHandle<T>(index, generation);
+	}
+
+	//Queues the entity for removal, stale handles and repeats are ignored by Flush()
+	void Despawn(SlotHandle<T> handle)
+	{
+		pendingDespawns.push_back(handle);
+	}
+
+	//Applies the queued spawns, then the queued despawns
+	void Flush()
+	{
+		if (pendingGrowth > 0)
+		{
+			slots.resize(slots.size() + pendingGrowth);
+			pendingGrowth = 0;
+		}
+
+		for (auto &spawn : pendingSpawns)
+		{
+			Slot &slot = slots[spawn.first];
+			slot.value.emplace(std::move(spawn.second));
+			liveCount++;
+		}
+		pendingSpawns.clear();
+
+		for (SlotHandle<T> handle : pendingDespawns)
+		{
+			if (Get(handle) == NULL) continue;
+
+			Slot &slot = slots[handle.index];
+			slot.value.reset();
+			//skip 0, it means no entity
+			if (++slot.generation == 0) slot.generation = 1;
+			freeSlots.push_back(handle.index);
+			liveCount--;
+		}
+		pendingDespawns.clear();
+	}
+
+	//Removes every entity now, along with anything queued. Every handle goes stale,
+	//including those of the dropped spawns.
+	void Clear()
+	{
+		slots.resize(slots.size() + pendingGrowth);
+		pendingGrowth = 0;
+		pendingSpawns.clear();
+		pendingDespawns.clear();
+		freeSlots.clear();
+		for (uint32_t i = (uint32_t)slots.size(); i-- > 0;)
+		{
+			Slot &slot = slots[i];
+			slot.value.reset();
+			if (++slot.generation == 0) slot.generation = 1;
+			freeSlots.push_back(i);
+		}
+		liveCount = 0;
+	}
+
+	//The entity, or NULL if the handle is stale or its spawn hasn't been flushed yet
+	T *Get(SlotHandle<T> handle)
+	{
+		if (handle.index >= slots.size()) return NULL;
+		Slot &slot = slots[handle.index];
+		if (slot.generation != handle.generation || !slot.value.has_value()) return NULL;
+		return &*slot.value;
+	}
+
+	bool IsAlive(SlotHandle<T> handle)
+	{
+		return Get(handle) != NULL;
+	}
+
+	//Entities alive now, not counting pending spawns
+	size_t Size() const
+	{
+		return liveCount;
+	}
+
+	//Spawns queued since the last Flush()
+	size_t PendingSpawnCount() const
+	{
+		return pendingSpawns.size();
+	}
+
+	//Slots to walk with GetSlot(), alive or not
+	size_t SlotCount() const
+	{
+		return slots.size();
+	}
+
+	//The entity in a slot, NULL if it's empty
+	T *GetSlot(size_t index)
+	{
+		Slot &slot = slots[index];
+		return slot.value.has_value() ? &*slot.value : NULL;
+	}
+
+	//The handle to the entity in a slot, a null handle if it's empty
+	SlotHandle<T> GetHandle(size_t index) const
+	{
+		const Slot &slot = slots[index];
+		return slot.value.has_value() ? SlotHandle<T>((uint32_t)index, slot.generation) : SlotHandle<T>();
+	}
+
+	//Calls function(SlotHandle<T>, T &) for every entity, in slot order
+	template <typename Function>
+	void ForEach(Function function)
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			Slot &slot = slots[i];
+			if (slot.value.has_value()) function(SlotHandle<T>((uint32_t)i, slot.generation), *slot.value);
+		}
+	}
+};
@@ -1,6 +1,8 @@
 #include "Spaceship.h"
 #include <cmath>
 
+extern Blit3D* blit3D;
+
 /**
 * Spaceship object constructor method.
 * @param Sprite* The graphical representation of the spaceship.
@@ -24,6 +26,18 @@ Spaceship::Spaceship(glm::vec2 newPosition, Sprite* newShotSprite, float newRadi
 	
 }
 /**
+* Spaceship object destructor method, hands its cached sprites back to Blit3D.
+*/
+Spaceship::~Spaceship()
+{
+	if (this->shotSprite != NULL) blit3D->ReleaseSprite(this->shotSprite);
+	if (this->shieldSprite != NULL) blit3D->ReleaseSprite(this->shieldSprite);
+	for (Sprite* sprite : this->spriteList)
+	{
+		blit3D->ReleaseSprite(sprite);
+	}
+}
+/**
 * Sets the spaceship's velocity to a given 2D vector.
 * @param glm::vec2 The spaceship's new velocity.
 */
@@ -290,8 +304,8 @@ bool Spaceship::Shoot(std::vector<Shot>& shotList)
 		shotList.push_back(this->MakeShot(3, 0.2f));
 		shotList.push_back(this->MakeShot(4, -0.2f));
 	}
-	AKRESULT panningX = AK::SoundEngine::SetRTPCValue(L"PanningX", (AkRtpcValue)(this->position.x), this->soundId);
-	AkPlayingID shootSound = this->audioEngine->PlayEvent("Shoot", this->soundId);
+	this->audioEngine->SetRTPCValue(AudioIDs::GAME_PARAMETERS::PANNINGX, (AkRtpcValue)(this->position.x), this->soundId);
+	AudioHandle shootSound = this->audioEngine->PlayEvent(AudioIDs::EVENTS::SHOOT, this->soundId);
 	return true;
 }
 /**
@@ -369,55 +383,31 @@ bool Spaceship::IsDestroyed()
 	}
 }
 /**
-* This method returns true if the ship collided with an asteroid
+* This method applies the ship hitting an asteroid
+* @param Asteroid* The asteroid the ship hit
+* @param SlotMap<Asteroid>& The asteroids, the pieces of the hit one are spawned into it
 */
-bool Spaceship::CollidedWithAsteroids(std::vector<Asteroid*>& asteroids)
+void Spaceship::HitAsteroid(Asteroid* asteroid, SlotMap<Asteroid>& asteroids)
 {
-	if (this->shieldUp)
-	{
-		return false;
-	}
-	bool collided = false;
-	// For each asteroid check if the ship collided with it
-	for (auto& asteroid : asteroids)
+	asteroid->playExplosionSound();
+	if (this->lives > 0)
 	{
-		if (this->CollideWithAsteroid(asteroid))
-		{
-			if (this->lives > 0)
-			{
-				asteroid->GotHitByBullet(asteroids);
-			}
-			this->GotHit();
-			collided = true;
-			break;
-		}
+		asteroid->GotHitByBullet(asteroids);
 	}
-	return collided;
+	this->GotHit();
 }
 /**
-	* This method returns true if the ship collided with a power up
-	* @return True if the ship collided with at least one powerup
-	*/
-bool Spaceship::CollideWithPowerUps(std::vector<PowerUp*>& powerUps)
+* This method returns true if the ship's shield is up, asteroids can't hit it then
+* @return True if the shield is up
+*/
+bool Spaceship::IsShieldUp()
 {
-	bool collided = false;
-	// for each power up, check if the ship has grabbed it
-	for (auto& powerUp : powerUps)
-	{
-		if (this->CollideWithPwerUp(powerUp))
-		{
-			powerUp->Grabbed();
-			this->GrabPowerUp();
-			collided = true;
-			break;
-		}
-	}
-	return collided;
+	return this->shieldUp;
 }
 /**
-* This method returns true if the ship collided with an specific asteroid
+* This method returns true if the ship collided with an specific asteroid, without changing either
 */
-bool Spaceship::CollideWithAsteroid(Asteroid*& asteroid)
+bool Spaceship::CollideWithAsteroid(Asteroid* asteroid)
 {
 	bool collision = false;
 	// Check if the ship and asteroid could collide
@@ -431,7 +421,6 @@ bool Spaceship::CollideWithAsteroid(Asteroid*& asteroid)
 		if (distance < (this->radius + asteroid->GetRadius()))
 		{
 			collision = true;
-			asteroid->playExplosionSound();
 		}
 	}
 	return collision;
@@ -440,7 +429,7 @@ bool Spaceship::CollideWithAsteroid(Asteroid*& asteroid)
 * This method returns true if the ship collided with an specific powerUp
 * @return True if the ship collided with the power up
 */
-bool Spaceship::CollideWithPwerUp(PowerUp*& powerUp)
+bool Spaceship::CollideWithPwerUp(PowerUp* powerUp)
 {
 	bool collision = false;
 	// Check if the ship and power up could collide
@@ -489,8 +478,8 @@ void Spaceship::ActivateShield()
 	this->shieldTimer = 0;
 	this->shieldAnimationState = true;
 	this->shieldAnimationTime = 1.0f;
-	AKRESULT panningX = AK::SoundEngine::SetRTPCValue(L"PanningX", (AkRtpcValue)(this->position.x), this->soundId);
-	this->shieldSound = this->audioEngine->PlayEvent("Shield", this->soundId);
+	this->audioEngine->SetRTPCValue(AudioIDs::GAME_PARAMETERS::PANNINGX, (AkRtpcValue)(this->position.x), this->soundId);
+	this->shieldSound = this->audioEngine->PlayEvent(AudioIDs::EVENTS::SHIELD, this->soundId);
 
 }
 /**
@@ -523,12 +512,12 @@ void Spaceship::willDelete()
 */
 void Spaceship::Pause()
 {
-	this->audioEngine->PauseEvent("Shield", this->soundId, this->shieldSound);
+	this->audioEngine->PauseEvent(AudioIDs::EVENTS::SHIELD, this->soundId, this->shieldSound);
 }
 /**
 * This method resumes the sound
 */
 void Spaceship::Resume()
 {
-	this->audioEngine->ResumeEvent("Shield", this->soundId, this->shieldSound);
+	this->audioEngine->ResumeEvent(AudioIDs::EVENTS::SHIELD, this->soundId, this->shieldSound);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Blit3D.h"
 #include "AudioEngine.h"
+#include "AudioIDs.h"
 #include "Shot.h"
 #include "Explosion.h"
 #include "PowerUp.h"
@@ -23,12 +24,13 @@ class Spaceship
 private:
 	/**
 	* The sprite that represents the shot graphically.
+	* The ship's sprites come from blit3D->AcquireSprite() and are released when it is deleted.
 	*/
 	Sprite* shotSprite;
 	/**
 	* The hield sprite
 	*/
-	Sprite* shieldSprite;
+	Sprite* shieldSprite = NULL;
 	/**
 	* The sprite array that represents the spaceship graphically.
 	*/
@@ -116,7 +118,7 @@ private:
 	/**
 	* The Game Object sound elements
 	*/
-	AkPlayingID shieldSound;
+	AudioHandle shieldSound;
 	/**
 	* The array that contains the vectors for the spaceship's gun's position
 	*/
@@ -133,6 +135,10 @@ public:
 	*/
 	Spaceship(glm::vec2, Sprite*, float, float, AudioEngine*&);
 	/**
+	* Spaceship object destructor method, hands its cached sprites back to Blit3D.
+	*/
+	~Spaceship();
+	/**
 	* Sets the spaceship's velocity to a given 2D vector.
 	* @param glm::vec2 The spaceship's new velocity.
 	*/
@@ -207,25 +213,26 @@ public:
 	*/
 	void KillShip();
 	/**
-	* This method returns true if the ship collided with an asteroid
-	* @return True if the ship collided with at least one asteroid
-	*/
-	bool CollidedWithAsteroids(std::vector<Asteroid*>&);
-	/**
-	* This method returns true if the ship collided with a power up
-	* @return True if the ship collided with at least one powerup
+	* This method applies the ship hitting an asteroid
+	* @param Asteroid* The asteroid the ship hit
+	* @param SlotMap<Asteroid>& The asteroids, the pieces of the hit one are spawned into it
 	*/
-	bool CollideWithPowerUps(std::vector<PowerUp*>&);
+	void HitAsteroid(Asteroid*, SlotMap<Asteroid>&);
 	/**
-	* This method returns true if the ship collided with an specific asteroid
+	* This method returns true if the ship collided with an specific asteroid, without changing either
 	* @return True if the ship collided with the asteroid
 	*/
-	bool CollideWithAsteroid(Asteroid*&);
+	bool CollideWithAsteroid(Asteroid*);
 	/**
-	* This method returns true if the ship collided with an specific powerUp
+	* This method returns true if the ship collided with an specific powerUp, without changing either
 	* @return True if the ship collided with the power up
 	*/
-	bool CollideWithPwerUp(PowerUp*&);
+	bool CollideWithPwerUp(PowerUp*);
+	/**
+	* This method returns true if the ship's shield is up, asteroids can't hit it then
+	* @return True if the shield is up
+	*/
+	bool IsShieldUp();
 	/**
 	* This method returns true if the ship was hit and had no shields up and false otherwise.
 	* @return True if the ship was destroyed
@@ -0,0 +1,379 @@
+/*
+	AngelcodeFontLayoutTest: checks AngelcodeFontLayout (see
+	Blit3DBaseFiles/Blit3D/AngelcodeFontLayout.h) on a small .bin made here and on the
+	game's fonts: glyph and kerning lookups, what Parse() keeps of repeated glyphs and
+	pairs, broken files being refused, and compiled fonts loading back to the same layout
+	and going stale when their .bin changes.
+
+	Usage:
+
+		AngelcodeFontLayoutTest [fonts directory]
+
+	The fonts directory defaults to Media/fonts. A compiled font is written to the current
+	directory and removed again. Prints the checks that failed and returns 1 if any did,
+	0 otherwise.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++17 -pthread -IBlit3DBaseFiles/Blit3D Tools/AngelcodeFontLayoutTest/AngelcodeFontLayoutTest.cpp
+			Blit3DBaseFiles/Blit3D/AngelcodeFontLayout.cpp Blit3DBaseFiles/Blit3D/Logger.cpp
+			Blit3DBaseFiles/Blit3D/AllocationTracker.cpp Blit3DBaseFiles/Blit3D/FrameArena.cpp -o AngelcodeFontLayoutTest
+
+	or with CMakeLists.txt, which runs it from ctest.
+*/
+
+#include "AngelcodeFontLayout.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//AngelcodeFontLayout logs the files it refuses to the main Blit3D logger
+logger oLog{"AngelcodeFontLayoutTest.log", false};
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while (0)
+
+static const char *COMPILED_FILE = "AngelcodeFontLayoutTest.b3df";
+
+//writes a binary (version 3) Angelcode font, little-endian like BMFont does
+class FontWriter
+{
+private:
+	std::vector<unsigned char> data;
+
+	void U8(unsigned value) { data.push_back((unsigned char)value); }
+	void U16(unsigned value) { U8(value & 0xFF); U8((value >> 8) & 0xFF); }
+	void U32(uint32_t value) { U16(value & 0xFFFF); U16(value >> 16); }
+
+	void Block(unsigned char type, uint32_t size)
+	{
+		U8(type);
+		U32(size);
+	}
+
+public:
+	FontWriter(unsigned version = 3)
+	{
+		data = { 'B', 'M', 'F', (unsigned char)version };
+	}
+
+	void Common(unsigned lineHeight, unsigned base, unsigned scaleW, unsigned scaleH, unsigned pages = 1)
+	{
+		Block(2, 15);
+		U16(lineHeight);
+		U16(base);
+		U16(scaleW);
+		U16(scaleH);
+		U16(pages);
+		U8(0); //bit field
+		U32(0); //channels
+	}
+
+	void Page(const std::string &name)
+	{
+		Block(3, (uint32_t)name.size() + 1);
+		for (char c : name) U8((unsigned char)c);
+		U8(0);
+	}
+
+	struct Char { uint32_t code; int x, y, width, height, xOffset, yOffset, xAdvance; };
+
+	void Chars(const std::vector<Char> &chars)
+	{
+		Block(4, (uint32_t)chars.size() * 20);
+		for (const Char &c : chars)
+		{
+			U32(c.code);
+			U16(c.x);
+			U16(c.y);
+			U16(c.width);
+			U16(c.height);
+			U16((uint16_t)c.xOffset);
+			U16((uint16_t)c.yOffset);
+			U16((uint16_t)c.xAdvance);
+			U8(0); //page
+			U8(15); //channel
+		}
+	}
+
+	struct Kerning { uint32_t first, second; int amount; };
+
+	void Kernings(const std::vector<Kerning> &pairs)
+	{
+		Block(5, (uint32_t)pairs.size() * 10);
+		for (const Kerning &pair : pairs)
+		{
+			U32(pair.first);
+			U32(pair.second);
+			U16((uint16_t)pair.amount);
+		}
+	}
+
+	//a block that says it is longer than what is left
+	void Truncated()
+	{
+		Block(4, 1000);
+		U32(0);
+	}
+
+	const std::vector<unsigned char> &Data() const { return data; }
+};
+
+static std::vector<unsigned char> ReadFile(const std::string &filename)
+{
+	std::ifstream in(filename, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool SameLayout(const AngelcodeFontLayout &a, const AngelcodeFontLayout &b)
+{
+	const std::vector<AngelcodeGlyph> &glyphsA = a.GetGlyphs();
+	const std::vector<AngelcodeGlyph> &glyphsB = b.GetGlyphs();
+	if (glyphsA.size() != glyphsB.size() || a.GetKerningPairCount() != b.GetKerningPairCount()) return false;
+	if (!glyphsA.empty() && memcmp(glyphsA.data(), glyphsB.data(), glyphsA.size() * sizeof(AngelcodeGlyph)) != 0) return false;
+	if (a.lineHeight != b.lineHeight || a.base != b.base || a.scaleW != b.scaleW || a.scaleH != b.scaleH) return false;
+	if (a.textureName != b.textureName) return false;
+
+	//every pair of glyphs kerns the same
+	for (const AngelcodeGlyph &glyph : glyphsA)
+	{
+		for (const AngelcodeGlyph &previous : glyphsA)
+		{
+			if (a.Kerning(glyph, previous.code) != b.Kerning(*b.FindGlyph(glyph.code), previous.code)) return false;
+		}
+	}
+	return true;
+}
+
+//a copy of the layout, through a compiled font on disk
+static bool Recompile(const AngelcodeFontLayout &layout, AngelcodeFontLayout &loaded, std::vector<unsigned char> &compiled)
+{
+	if (!layout.SaveCompiled(COMPILED_FILE)) return false;
+	compiled = ReadFile(COMPILED_FILE);
+	remove(COMPILED_FILE);
+	return loaded.LoadCompiled(compiled.data(), compiled.size());
+}
+
+static std::vector<unsigned char> MakeFont()
+{
+	FontWriter font;
+	font.Common(32, 26, 256, 128);
+	font.Page("test_0.png");
+	font.Chars({
+		{ 'V', 10, 0, 12, 20, 1, 4, 14 },
+		{ 'A', 0, 0, 10, 20, 0, 3, 11 },
+		{ 'B', 30, 0, 10, 20, -1, 5, 12 },
+		{ 0x263A, 50, 0, 20, 20, 0, 2, 22 },
+		{ 'A', 0, 0, 10, 20, 0, 3, 99 }, //repeated, the first one is kept
+	});
+
+	std::vector<FontWriter::Kerning> pairs;
+	//more pairs than ANGELCODE_KERNING_SCAN, so V's are searched
+	for (uint32_t first = 'a'; first < 'a' + ANGELCODE_KERNING_SCAN + 4; ++first)
+	{
+		pairs.push_back({ first, 'V', -(int)(first - 'a') - 1 });
+	}
+	pairs.push_back({ 'A', 'V', -1 });
+	pairs.push_back({ 'A', 'V', -3 }); //repeated, the last one is kept
+	//B's are scanned
+	pairs.push_back({ 'V', 'B', 2 });
+	pairs.push_back({ 'A', 'B', -2 });
+	pairs.push_back({ 0x263A, 'B', 5 });
+	//for a glyph the font hasn't got, dropped
+	pairs.push_back({ 'A', 'Z', -4 });
+	font.Kernings(pairs);
+	return font.Data();
+}
+
+static void TestParse()
+{
+	std::vector<unsigned char> data = MakeFont();
+	AngelcodeFontLayout layout;
+	CHECK(layout.Parse(data.data(), data.size()));
+
+	CHECK(layout.lineHeight == 32 && layout.base == 26 && layout.scaleW == 256 && layout.scaleH == 128);
+	CHECK(layout.textureName == "test_0.png");
+	CHECK(layout.GetGlyphs().size() == 4);
+	CHECK(layout.GetKerningPairCount() == ANGELCODE_KERNING_SCAN + 4 + 1 + 3);
+
+	const AngelcodeGlyph *a = layout.FindGlyph('A');
+	const AngelcodeGlyph *b = layout.FindGlyph('B');
+	const AngelcodeGlyph *v = layout.FindGlyph('V');
+	const AngelcodeGlyph *smiley = layout.FindGlyph(0x263A);
+	CHECK(a != NULL && b != NULL && v != NULL && smiley != NULL);
+	if (a == NULL || b == NULL || v == NULL || smiley == NULL) return;
+
+	CHECK(a->xAdvance == 11);
+	CHECK(b->xOffset == -1 && b->yOffset == -5);
+	CHECK(smiley->width == 20 && smiley->xAdvance == 22);
+	CHECK(layout.FindGlyph('Z') == NULL);
+	CHECK(layout.FindGlyph(0x263B) == NULL);
+	CHECK(layout.FindGlyph(-1) == NULL);
+
+	//sorted by code, and the index is the glyph's place
+	const std::vector<AngelcodeGlyph> &glyphs = layout.GetGlyphs();
+	for (size_t i = 0; i < glyphs.size(); ++i)
+	{
+		CHECK(i == 0 || glyphs[i - 1].code < glyphs[i].code);
+		CHECK(layout.GlyphIndex(layout.FindGlyph(glyphs[i].code)) == i);
+	}
+
+	for (uint32_t first = 'a'; first < 'a' + ANGELCODE_KERNING_SCAN + 4; ++first)
+	{
+		CHECK(layout.Kerning(*v, first) == -(float)(first - 'a') - 1);
+	}
+	CHECK(layout.Kerning(*v, 'A') == -3);
+	CHECK(layout.Kerning(*v, 'B') == 0);
+	CHECK(layout.Kerning(*v, 'z') == 0);
+	CHECK(layout.Kerning(*b, 'V') == 2);
+	CHECK(layout.Kerning(*b, 'A') == -2);
+	CHECK(layout.Kerning(*b, 0x263A) == 5);
+	CHECK(layout.Kerning(*b, 'C') == 0);
+	CHECK(layout.Kerning(*a, 'V') == 0);
+}
+
+static void TestRefused()
+{
+	AngelcodeFontLayout layout;
+
+	const unsigned char text[] = "info face=\"Arial\"";
+	CHECK(!layout.Parse(text, sizeof(text)));
+
+	FontWriter version2(2);
+	version2.Common(32, 26, 256, 128);
+	CHECK(!layout.Parse(version2.Data().data(), version2.Data().size()));
+
+	FontWriter pages;
+	pages.Common(32, 26, 256, 128, 2);
+	CHECK(!layout.Parse(pages.Data().data(), pages.Data().size()));
+
+	FontWriter truncated;
+	truncated.Common(32, 26, 256, 128);
+	truncated.Truncated();
+	CHECK(!layout.Parse(truncated.Data().data(), truncated.Data().size()));
+}
+
+static void TestCompiled()
+{
+	std::vector<unsigned char> data = MakeFont();
+	AngelcodeFontLayout layout;
+	CHECK(layout.Parse(data.data(), data.size()));
+	CHECK(layout.IsCompiledFrom(data.data(), data.size()));
+
+	AngelcodeFontLayout loaded;
+	std::vector<unsigned char> compiled;
+	CHECK(Recompile(layout, loaded, compiled));
+	CHECK(SameLayout(layout, loaded));
+	CHECK(loaded.IsCompiledFrom(data.data(), data.size()));
+
+	//a changed .bin makes it stale, whether or not its size changed
+	std::vector<unsigned char> changed = data;
+	changed.back() ^= 1;
+	CHECK(!loaded.IsCompiledFrom(changed.data(), changed.size()));
+	changed = data;
+	changed.push_back(0);
+	CHECK(!loaded.IsCompiledFrom(changed.data(), changed.size()));
+
+	//broken compiled fonts are refused
+	AngelcodeFontLayout refused;
+	CHECK(!refused.LoadCompiled(compiled.data(), compiled.size() - 1));
+	CHECK(!refused.LoadCompiled(compiled.data(), sizeof(AngelcodeCompiledHeader) - 1));
+
+	AngelcodeCompiledHeader header;
+	memcpy(&header, compiled.data(), sizeof(header));
+
+	std::vector<unsigned char> broken = compiled;
+	broken[0] = 'X';
+	CHECK(!refused.LoadCompiled(broken.data(), broken.size()));
+
+	broken = compiled;
+	header.version = ANGELCODE_COMPILED_VERSION + 1;
+	memcpy(broken.data(), &header, sizeof(header));
+	CHECK(!refused.LoadCompiled(broken.data(), broken.size()));
+
+	broken = compiled;
+	memcpy(&header, compiled.data(), sizeof(header));
+	header.byteOrder = 0x04030201;
+	memcpy(broken.data(), &header, sizeof(header));
+	CHECK(!refused.LoadCompiled(broken.data(), broken.size()));
+
+	//out of order glyphs would break the searches
+	broken = compiled;
+	AngelcodeGlyph first, second;
+	unsigned char *glyphs = broken.data() + sizeof(AngelcodeCompiledHeader);
+	memcpy(&first, glyphs, sizeof(AngelcodeGlyph));
+	memcpy(&second, glyphs + sizeof(AngelcodeGlyph), sizeof(AngelcodeGlyph));
+	memcpy(glyphs, &second, sizeof(AngelcodeGlyph));
+	memcpy(glyphs + sizeof(AngelcodeGlyph), &first, sizeof(AngelcodeGlyph));
+	CHECK(!refused.LoadCompiled(broken.data(), broken.size()));
+}
+
+static void TestGameFonts(const std::string &directory)
+{
+	const char *fonts[] = { "electrolite", "SyneMono" };
+	for (const char *name : fonts)
+	{
+		std::string binFile = directory + "/" + name + ".bin";
+		std::vector<unsigned char> bin = ReadFile(binFile);
+		std::vector<unsigned char> shipped = ReadFile(CompiledFontPath(binFile));
+		CHECK(!bin.empty() && !shipped.empty());
+		if (bin.empty() || shipped.empty())
+		{
+			printf("Could not read %s and its compiled font\n", binFile.c_str());
+			continue;
+		}
+
+		AngelcodeFontLayout parsed;
+		CHECK(parsed.Parse(bin.data(), bin.size()));
+		CHECK(!parsed.GetGlyphs().empty());
+
+		//the compiled font in the repo is up to date and the same as parsing
+		AngelcodeFontLayout loaded;
+		CHECK(loaded.LoadCompiled(shipped.data(), shipped.size()));
+		CHECK(loaded.IsCompiledFrom(bin.data(), bin.size()));
+		CHECK(SameLayout(parsed, loaded));
+
+		AngelcodeFontLayout recompiled;
+		std::vector<unsigned char> compiled;
+		CHECK(Recompile(parsed, recompiled, compiled));
+		CHECK(compiled == shipped);
+
+		//the direct index and the search agree with a walk over the glyphs
+		bool found = true;
+		for (int32_t code = -1; code < 0x3000; ++code)
+		{
+			const AngelcodeGlyph *expected = NULL;
+			for (const AngelcodeGlyph &glyph : parsed.GetGlyphs())
+			{
+				if (glyph.code == code) expected = &glyph;
+			}
+			if (parsed.FindGlyph(code) != expected) found = false;
+		}
+		CHECK(found);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	std::string fontDirectory = argc > 1 ? argv[1] : "Media/fonts";
+
+	TestParse();
+	TestRefused();
+	TestCompiled();
+	TestGameFonts(fontDirectory);
+
+	if (failures > 0)
+	{
+		printf("AngelcodeFontLayoutTest: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("AngelcodeFontLayoutTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,177 @@
+/*
+	AssetPacker: packs the files listed in a manifest into one asset archive for
+	AssetArchive (see Blit3DBaseFiles/Blit3D/AssetArchive.h).
+
+	Usage, from Blit3Dv3/ so the paths match the ones the game loads:
+
+		AssetPacker Media.b3da Media/assets.txt
+
+	The manifest has one path per line, blank lines and lines starting with '#' are
+	skipped. Files are stored in the order they are listed, so list them in the order the
+	game loads them and a cold start reads the archive front to back.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++14 -IBlit3DBaseFiles/Blit3D Tools/AssetPacker/AssetPacker.cpp -o AssetPacker
+*/
+
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+struct PackedFile
+{
+	std::string path; //as listed
+	std::string name; //normalized
+	std::vector<unsigned char> bytes;
+	AssetArchiveEntry entry;
+};
+
+static uint64_t AlignUp(uint64_t value)
+{
+	return (value + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+}
+
+static bool ReadManifest(const char *manifest, std::vector<PackedFile> &files)
+{
+	std::ifstream in(manifest);
+	if (!in.is_open())
+	{
+		fprintf(stderr, "Can't open manifest %s\n", manifest);
+		return false;
+	}
+
+	std::unordered_set<std::string> names;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		//trim, and cope with manifests saved with Windows line endings
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#') continue;
+		size_t last = line.find_last_not_of(" \t\r");
+		line = line.substr(first, last - first + 1);
+
+		PackedFile file;
+		file.path = line;
+		file.name = NormalizeAssetPath(line);
+		if (!names.insert(file.name).second)
+		{
+			fprintf(stderr, "%s is listed twice\n", line.c_str());
+			return false;
+		}
+		files.push_back(file);
+	}
+	return true;
+}
+
+static bool ReadFile(PackedFile &file)
+{
+	//the game loads with Windows separators, the packer may run elsewhere
+	std::string path = file.path;
+#ifndef _WIN32
+	std::replace(path.begin(), path.end(), '\\', '/');
+#endif
+	std::ifstream in(path, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!in.is_open())
+	{
+		fprintf(stderr, "Can't open %s\n", path.c_str());
+		return false;
+	}
+
+	std::streamoff size = in.tellg();
+	in.seekg(0, std::ios::beg);
+	file.bytes.resize((size_t)size);
+	if (size > 0 && !in.read((char *)file.bytes.data(), size))
+	{
+		fprintf(stderr, "Error reading %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <archive> <manifest>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<PackedFile> files;
+	if (!ReadManifest(argv[2], files)) return 1;
+	if (files.empty())
+	{
+		fprintf(stderr, "Nothing to pack in %s\n", argv[2]);
+		return 1;
+	}
+	for (PackedFile &file : files)
+	{
+		if (!ReadFile(file)) return 1;
+	}
+
+	//paths in manifest order, then the data, in the same order
+	std::string names;
+	for (PackedFile &file : files)
+	{
+		file.entry.nameOffset = (uint32_t)names.size();
+		names += file.name;
+		names += '\0';
+	}
+
+	uint64_t offset = AlignUp(sizeof(AssetArchiveHeader) + files.size() * sizeof(AssetArchiveEntry) + names.size());
+	for (PackedFile &file : files)
+	{
+		file.entry.hash = AssetPathHash(file.name);
+		file.entry.offset = offset;
+		file.entry.size = file.bytes.size();
+		file.entry.storedSize = file.bytes.size();
+		file.entry.codec = (uint32_t)AssetCodec::STORED;
+		offset = AlignUp(offset + file.bytes.size());
+	}
+
+	//the index is sorted by hash for the look-ups
+	std::vector<AssetArchiveEntry> entries;
+	for (PackedFile &file : files) entries.push_back(file.entry);
+	std::stable_sort(entries.begin(), entries.end(),
+		[](const AssetArchiveEntry &a, const AssetArchiveEntry &b) { return a.hash < b.hash; });
+
+	AssetArchiveHeader header;
+	memcpy(header.magic, ASSET_ARCHIVE_MAGIC, 4);
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.entryCount = (uint32_t)entries.size();
+	header.namesSize = (uint32_t)names.size();
+
+	std::ofstream out(argv[1], std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		fprintf(stderr, "Can't create %s\n", argv[1]);
+		return 1;
+	}
+
+	static const char padding[ASSET_ARCHIVE_ALIGNMENT] = { 0 };
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)entries.data(), entries.size() * sizeof(AssetArchiveEntry));
+	out.write(names.data(), names.size());
+	uint64_t written = sizeof(header) + entries.size() * sizeof(AssetArchiveEntry) + names.size();
+	for (PackedFile &file : files)
+	{
+		out.write(padding, file.entry.offset - written);
+		out.write((const char *)file.bytes.data(), file.bytes.size());
+		written = file.entry.offset + file.bytes.size();
+		printf("%10llu  %s\n", (unsigned long long)file.bytes.size(), file.name.c_str());
+	}
+
+	out.close();
+	if (out.fail())
+	{
+		fprintf(stderr, "Error writing %s\n", argv[1]);
+		return 1;
+	}
+
+	printf("Packed %u files into %s, %llu bytes\n", header.entryCount, argv[1], (unsigned long long)written);
+	return 0;
+}
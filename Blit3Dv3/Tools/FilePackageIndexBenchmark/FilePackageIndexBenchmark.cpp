@@ -0,0 +1,276 @@
+//////////////////////////////////////////////////////////////////////
+//
+// FilePackageIndexBenchmark.cpp
+//
+// Micro-benchmark of file package look-ups: the walk over all loaded
+// packages with a binary search in each LUT (what Open() used to do)
+// against the hashed index of CAkFilePackageIndex, as the number of
+// packages and the number of files per package grow.
+//
+// Packages are synthesized in memory with the AkFilePackager header
+// layout, so no data files are needed. A tenth of the files of each
+// package are also in the previous one, like a patch package would be.
+// Half of the look-ups are for files that are in no package, which is
+// the worst case of the walk (every LUT gets searched).
+//
+// Not part of the game project. Build it from Blit3Dv3/ as a console
+// app with the Wwise SDK on the include path and
+// WwiseBaseFiles/Common/AkFilePackage.cpp, AkFilePackageLUT.cpp and
+// AkFilePackageIndex.cpp, linked against AkMemoryMgr and AkSoundEngine.
+// For example, with the POSIX samples:
+//
+//   g++ -O2 -std=c++14 -I<sdk>/include -IWwiseBaseFiles/POSIX
+//       -IWwiseBaseFiles/Common Tools/FilePackageIndexBenchmark/*.cpp
+//       WwiseBaseFiles/Common/AkFilePackage*.cpp -L<sdk>/lib
+//       -lAkSoundEngine -lAkMemoryMgr -o FilePackageIndexBenchmark
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkFilePackageIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	// Package with a public constructor; never Destroy()ed, the header memory is ours.
+	class BenchPackage : public CAkFilePackage
+	{
+	public:
+		BenchPackage( AkUInt32 in_uPackageID )
+			: CAkFilePackage( in_uPackageID, 0, AK_INVALID_POOL_ID, NULL, false ) {}
+	};
+
+	// xorshift64*, good enough to scatter file IDs.
+	struct BenchRandom
+	{
+		AkUInt64 uState;
+		explicit BenchRandom( AkUInt64 in_uSeed ) : uState( in_uSeed ) {}
+		AkUInt32 Next()
+		{
+			uState ^= uState >> 12;
+			uState ^= uState << 25;
+			uState ^= uState >> 27;
+			return (AkUInt32)( ( uState * 0x2545F4914F6CDD1DULL ) >> 32 );
+		}
+	};
+
+	struct BenchHeaderFormat
+	{
+		AkUInt32	uFileFormatTag;
+		AkUInt32	uHeaderSize;
+		AkUInt32	uVersion;
+		AkUInt32	uLanguageMapSize;
+		AkUInt32	uSoundBanksLUTSize;
+		AkUInt32	uStmFilesLUTSize;
+		AkUInt32	uExternalsLUTSize;
+	};
+
+	typedef CAkFilePackageLUT::AkFileEntry<AkFileID> BenchEntry;
+
+	// Writes a package header with an empty language map, the given soundbanks
+	// and streamed files (sorted here) and no externals.
+	void BuildHeader(
+		std::vector<BenchEntry> &	io_banks,
+		std::vector<BenchEntry> &	io_stmFiles,
+		std::vector<AkUInt32> &		out_header
+		)
+	{
+		struct ByID
+		{
+			bool operator()( const BenchEntry & a, const BenchEntry & b ) const { return a.fileID < b.fileID; }
+		};
+		std::sort( io_banks.begin(), io_banks.end(), ByID() );
+		std::sort( io_stmFiles.begin(), io_stmFiles.end(), ByID() );
+
+		const AkUInt32 uBanksSize = (AkUInt32)( sizeof( AkUInt32 ) + io_banks.size() * sizeof( BenchEntry ) );
+		const AkUInt32 uStmSize = (AkUInt32)( sizeof( AkUInt32 ) + io_stmFiles.size() * sizeof( BenchEntry ) );
+		const AkUInt32 uTotalSize = (AkUInt32)sizeof( BenchHeaderFormat ) + sizeof( AkUInt32 ) + uBanksSize + uStmSize + sizeof( AkUInt32 );
+
+		out_header.assign( uTotalSize / sizeof( AkUInt32 ), 0 );
+		AkUInt8 * pData = (AkUInt8*)&out_header[0];
+
+		BenchHeaderFormat * pHeader = (BenchHeaderFormat*)pData;
+		pHeader->uFileFormatTag		= AKPK_FILE_FORMAT_TAG;
+		pHeader->uHeaderSize		= uTotalSize - AKPK_HEADER_CHUNK_DEF_SIZE;
+		pHeader->uVersion			= AKPK_CURRENT_VERSION;
+		pHeader->uLanguageMapSize	= sizeof( AkUInt32 );
+		pHeader->uSoundBanksLUTSize	= uBanksSize;
+		pHeader->uStmFilesLUTSize	= uStmSize;
+		pHeader->uExternalsLUTSize	= sizeof( AkUInt32 );
+		pData += sizeof( BenchHeaderFormat );
+
+		*(AkUInt32*)pData = 0;	// No languages.
+		pData += sizeof( AkUInt32 );
+
+		*(AkUInt32*)pData = (AkUInt32)io_banks.size();
+		if ( !io_banks.empty() )
+			memcpy( pData + sizeof( AkUInt32 ), &io_banks[0], io_banks.size() * sizeof( BenchEntry ) );
+		pData += uBanksSize;
+
+		*(AkUInt32*)pData = (AkUInt32)io_stmFiles.size();
+		if ( !io_stmFiles.empty() )
+			memcpy( pData + sizeof( AkUInt32 ), &io_stmFiles[0], io_stmFiles.size() * sizeof( BenchEntry ) );
+		pData += uStmSize;
+
+		*(AkUInt32*)pData = 0;	// No externals.
+	}
+
+	struct BenchResult
+	{
+		double		fLUTNs;			// Average ns per look-up, walk with binary search.
+		double		fIndexNs;		// Average ns per look-up, index.
+		double		fBuildUs;		// Index build time.
+		size_t		uIndexBytes;
+		AkUInt32	uMismatches;
+	};
+
+	BenchResult RunCase( AkUInt32 in_uNumPackages, AkUInt32 in_uFilesPerPackage )
+	{
+		const AkUInt32 uNumLookups = 1 << 20;
+
+		BenchRandom random( 0x5EED0000ULL + in_uNumPackages * 7919 + in_uFilesPerPackage );
+
+		std::vector< std::vector<AkUInt32> > headers( in_uNumPackages );
+		std::vector<BenchPackage*> packages;
+		std::vector<AkFileID> hits;
+		ListFilePackages packageList;
+
+		std::vector<AkFileID> prevIDs;
+		for ( AkUInt32 uPackage = 0; uPackage < in_uNumPackages; ++uPackage )
+		{
+			std::vector<AkFileID> ids;
+			for ( AkUInt32 uFile = 0; uFile < in_uFilesPerPackage; ++uFile )
+			{
+				// Every 10th file overrides one of the previous package.
+				ids.push_back( ( uFile % 10 == 0 && !prevIDs.empty() )
+					? prevIDs[ random.Next() % prevIDs.size() ]
+					: ( random.Next() | 1 ) );	// Odd: misses below are even.
+			}
+
+			// Binary search requires unique (ID, language) pairs.
+			std::sort( ids.begin(), ids.end() );
+			ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+
+			std::vector<BenchEntry> banks, stmFiles;
+			for ( AkUInt32 uFile = 0; uFile < ids.size(); ++uFile )
+			{
+				BenchEntry entry;
+				entry.fileID		= ids[ uFile ];
+				entry.uBlockSize	= 2048;
+				entry.uFileSize		= 4096 + ( random.Next() & 0xFFFF );
+				entry.uStartBlock	= uFile * 64;
+				entry.uLanguageID	= CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID;
+				( uFile % 8 == 0 ? banks : stmFiles ).push_back( entry );
+			}
+			BuildHeader( banks, stmFiles, headers[ uPackage ] );
+
+			BenchPackage * pPackage = new BenchPackage( uPackage );
+			AKRESULT eResult = pPackage->lut.Setup( (AkUInt8*)&headers[ uPackage ][0], (AkUInt32)( headers[ uPackage ].size() * sizeof( AkUInt32 ) ) );
+			AKASSERT( eResult == AK_Success );
+			(void)eResult;
+			pPackage->lut.SetCurLanguage( NULL );
+			packageList.AddFirst( pPackage );
+			packages.push_back( pPackage );
+
+			for ( size_t uStm = 0; uStm < stmFiles.size(); ++uStm )
+				hits.push_back( stmFiles[ uStm ].fileID );
+			prevIDs.swap( ids );
+		}
+
+		// Half hits, half misses, shuffled.
+		std::vector<AkFileID> lookups( uNumLookups );
+		for ( AkUInt32 uLookup = 0; uLookup < uNumLookups; ++uLookup )
+		{
+			lookups[ uLookup ] = ( uLookup & 1 )
+				? hits[ random.Next() % hits.size() ]
+				: ( random.Next() & ~1u );
+		}
+
+		AkFileSystemFlags flags;
+		flags.uCompanyID = AKCOMPANYID_AUDIOKINETIC;
+		flags.uCodecID = 0xFFFFFFFF;	// Streamed audio: not a bank.
+		flags.uCustomParamSize = 0;
+		flags.pCustomParam = NULL;
+		flags.bIsLanguageSpecific = false;
+
+		BenchResult result;
+
+		typedef std::chrono::high_resolution_clock Clock;
+
+		Clock::time_point buildStart = Clock::now();
+		CAkFilePackageIndex index;
+		AKRESULT eResult = index.Build( packageList );
+		result.fBuildUs = std::chrono::duration<double, std::micro>( Clock::now() - buildStart ).count();
+		AKASSERT( eResult == AK_Success );
+		(void)eResult;
+		result.uIndexBytes = index.GetMemorySize();
+
+		// Walk with binary search.
+		AkUInt64 uChecksumLUT = 0;
+		Clock::time_point start = Clock::now();
+		for ( AkUInt32 uLookup = 0; uLookup < uNumLookups; ++uLookup )
+		{
+			ListFilePackages::Iterator it = packageList.Begin();
+			while ( it != packageList.End() )
+			{
+				const BenchEntry * pEntry = (*it)->lut.LookupFile( lookups[ uLookup ], &flags );
+				if ( pEntry )
+				{
+					uChecksumLUT += pEntry->uStartBlock + (*it)->ID();
+					break;
+				}
+				++it;
+			}
+		}
+		result.fLUTNs = std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / uNumLookups;
+
+		// Index.
+		AkUInt64 uChecksumIndex = 0;
+		start = Clock::now();
+		for ( AkUInt32 uLookup = 0; uLookup < uNumLookups; ++uLookup )
+		{
+			const CAkFilePackageIndex::Entry * pEntry = index.Find( lookups[ uLookup ], CAkFilePackageIndex::Table_StmFiles, false );
+			if ( pEntry )
+				uChecksumIndex += pEntry->uStartBlock + pEntry->pPackage->ID();
+		}
+		result.fIndexNs = std::chrono::duration<double, std::nano>( Clock::now() - start ).count() / uNumLookups;
+
+		result.uMismatches = ( uChecksumLUT == uChecksumIndex ) ? 0 : 1;
+
+		packageList.Term();
+		for ( size_t uPackage = 0; uPackage < packages.size(); ++uPackage )
+			delete packages[ uPackage ];
+
+		return result;
+	}
+}
+
+int main()
+{
+	static const AkUInt32 s_packageCounts[] = { 1, 4, 16, 64 };
+	static const AkUInt32 s_fileCounts[] = { 256, 4096, 65536 };
+
+	printf( "packages  files/pkg  LUT walk ns  index ns  speedup  build us  index KB  check\n" );
+	for ( size_t uFiles = 0; uFiles < sizeof( s_fileCounts ) / sizeof( s_fileCounts[0] ); ++uFiles )
+	{
+		for ( size_t uPackages = 0; uPackages < sizeof( s_packageCounts ) / sizeof( s_packageCounts[0] ); ++uPackages )
+		{
+			BenchResult result = RunCase( s_packageCounts[ uPackages ], s_fileCounts[ uFiles ] );
+			printf( "%8u  %9u  %11.1f  %8.1f  %6.1fx  %8.0f  %8u  %s\n",
+				s_packageCounts[ uPackages ],
+				s_fileCounts[ uFiles ],
+				result.fLUTNs,
+				result.fIndexNs,
+				result.fLUTNs / result.fIndexNs,
+				result.fBuildUs,
+				(unsigned int)( result.uIndexBytes / 1024 ),
+				result.uMismatches ? "MISMATCH" : "ok" );
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,336 @@
+/*
+	FontSDF: turns a binary Angelcode font (32-bit, one page) into a distance field font
+	for Blit3D::MakeAngelcodeSDFFontFromBinary32().
+
+	Usage:
+
+		FontSDF <in.bin> <out.bin> [spread] [downscale]
+
+	Export the font from BMFont as usual but big, for example 4 times the size it will
+	mostly be drawn at, with a padding of at least spread * downscale pixels on every side
+	so the field has room around each glyph. FontSDF shrinks it by downscale (default 4)
+	and writes out.bin, with every size in it shrunk to match, and the field as a PNG
+	named like out.bin. The field is in the alpha channel: 0.5 on a glyph's edge, 1 inside
+	at spread (default 4) pixels from it, 0 outside at spread pixels.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++14 -IBlit3DBaseFiles/STB Tools/FontSDF/FontSDF.cpp -o FontSDF
+*/
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// The .bin is little-endian and its fields aren't aligned
+static int ReadS16(const unsigned char *p)
+{
+	return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t ReadU32(const unsigned char *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void WriteS16(unsigned char *p, int value)
+{
+	p[0] = (unsigned char)(value & 0xFF);
+	p[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+static void AppendU32(std::vector<unsigned char> &out, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i) out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static void AppendU32BigEndian(std::vector<unsigned char> &out, uint32_t value)
+{
+	for (int i = 3; i >= 0; --i) out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+// Rounds a size in the big font to the shrunk one
+static int Shrink(int value, int downscale)
+{
+	return (int)std::floor(value / (double)downscale + 0.5);
+}
+
+static uint32_t Crc32(const unsigned char *data, size_t size, uint32_t crc = 0)
+{
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+	}
+	return ~crc;
+}
+
+static void AppendPngChunk(std::vector<unsigned char> &png, const char *type, const std::vector<unsigned char> &data)
+{
+	AppendU32BigEndian(png, (uint32_t)data.size());
+	size_t start = png.size();
+	png.insert(png.end(), type, type + 4);
+	png.insert(png.end(), data.begin(), data.end());
+	AppendU32BigEndian(png, Crc32(png.data() + start, png.size() - start));
+}
+
+// An RGBA PNG with uncompressed deflate blocks: big, but stb_image and any tool
+// that re-saves it read it, and it needs no zlib
+static bool WritePng(const std::string &filename, const std::vector<unsigned char> &rgba, int width, int height)
+{
+	std::vector<unsigned char> raw;
+	raw.reserve((size_t)height * (width * 4 + 1));
+	for (int y = 0; y < height; ++y)
+	{
+		raw.push_back(0); //no filter
+		raw.insert(raw.end(), rgba.begin() + (size_t)y * width * 4, rgba.begin() + (size_t)(y + 1) * width * 4);
+	}
+
+	std::vector<unsigned char> zlib = { 0x78, 0x01 };
+	size_t offset = 0;
+	do
+	{
+		size_t blockSize = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+		zlib.push_back(offset + blockSize == raw.size() ? 1 : 0); //last block, stored
+		zlib.push_back((unsigned char)(blockSize & 0xFF));
+		zlib.push_back((unsigned char)(blockSize >> 8));
+		zlib.push_back((unsigned char)(~blockSize & 0xFF));
+		zlib.push_back((unsigned char)((~blockSize >> 8) & 0xFF));
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < raw.size());
+	uint32_t a = 1, b = 0;
+	for (unsigned char byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	AppendU32BigEndian(zlib, (b << 16) | a);
+
+	std::vector<unsigned char> header;
+	AppendU32BigEndian(header, (uint32_t)width);
+	AppendU32BigEndian(header, (uint32_t)height);
+	header.push_back(8); //bits per channel
+	header.push_back(6); //RGBA
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> png(signature, signature + 8);
+	AppendPngChunk(png, "IHDR", header);
+	AppendPngChunk(png, "IDAT", zlib);
+	AppendPngChunk(png, "IEND", std::vector<unsigned char>());
+
+	std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write((const char *)png.data(), png.size());
+	return (bool)out;
+}
+
+// The field of the shrunk texture: each texel looks for the nearest texel of the big one
+// on the other side of the edge, within spread shrunk texels
+static std::vector<unsigned char> MakeField(const unsigned char *pixels, int channels, int width, int height,
+	int fieldWidth, int fieldHeight, int spread, int downscale)
+{
+	//inside a glyph where the alpha (or the red of an image without it) is over half
+	int channel = channels == 4 ? 3 : 0;
+	std::vector<unsigned char> inside((size_t)width * height);
+	for (size_t i = 0; i < inside.size(); ++i) inside[i] = pixels[i * channels + channel] >= 128;
+
+	int radius = spread * downscale;
+	std::vector<unsigned char> field((size_t)fieldWidth * fieldHeight * 4);
+	for (int fy = 0; fy < fieldHeight; ++fy)
+	{
+		for (int fx = 0; fx < fieldWidth; ++fx)
+		{
+			//the big texel under the centre of this one
+			int cx = fx * downscale + downscale / 2;
+			int cy = fy * downscale + downscale / 2;
+			if (cx >= width) cx = width - 1;
+			if (cy >= height) cy = height - 1;
+			bool in = inside[(size_t)cy * width + cx] != 0;
+
+			int nearest = radius * radius + 1;
+			for (int y = cy - radius; y <= cy + radius; ++y)
+			{
+				if (y < 0 || y >= height) continue;
+				int dy2 = (y - cy) * (y - cy);
+				if (dy2 >= nearest) continue;
+				for (int x = cx - radius; x <= cx + radius; ++x)
+				{
+					if (x < 0 || x >= width) continue;
+					int d2 = dy2 + (x - cx) * (x - cx);
+					if (d2 < nearest && (inside[(size_t)y * width + x] != 0) != in) nearest = d2;
+				}
+			}
+
+			//the edge is half a big texel short of the texel across it
+			double distance = (std::sqrt((double)nearest) - 0.5) / downscale;
+			if (distance > spread) distance = spread;
+			double value = 0.5 + (in ? distance : -distance) / (2.0 * spread);
+			if (value < 0.0) value = 0.0;
+			if (value > 1.0) value = 1.0;
+
+			unsigned char *texel = &field[((size_t)fy * fieldWidth + fx) * 4];
+			texel[0] = texel[1] = texel[2] = 255;
+			texel[3] = (unsigned char)(value * 255.0 + 0.5);
+		}
+	}
+	return field;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: FontSDF <in.bin> <out.bin> [spread] [downscale]\n");
+		return 1;
+	}
+	std::string inFile = argv[1];
+	std::string outFile = argv[2];
+	int spread = argc > 3 ? atoi(argv[3]) : 4;
+	int downscale = argc > 4 ? atoi(argv[4]) : 4;
+	if (spread < 1 || downscale < 1)
+	{
+		fprintf(stderr, "spread and downscale must be at least 1\n");
+		return 1;
+	}
+
+	std::ifstream in(inFile, std::ios::in | std::ios::binary);
+	std::vector<unsigned char> bin((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (bin.size() < 4 || memcmp(bin.data(), "BMF\3", 4) != 0)
+	{
+		fprintf(stderr, "%s is not a version 3 binary Angelcode font\n", inFile.c_str());
+		return 1;
+	}
+
+	//the texture, from the same directory as the font
+	size_t separator = inFile.find_last_of("\\/");
+	std::string inDirectory = separator == std::string::npos ? "" : inFile.substr(0, separator + 1);
+	separator = outFile.find_last_of("\\/");
+	size_t dot = outFile.find_last_of('.');
+	if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) dot = outFile.size();
+	std::string outTexture = outFile.substr(0, dot) + ".png";
+	std::string outTextureName = separator == std::string::npos ? outTexture : outTexture.substr(separator + 1);
+
+	//shrink every size in the font, and point its page at the new texture
+	std::vector<unsigned char> out(bin.begin(), bin.begin() + 4);
+	std::string textureName;
+	int fieldWidth = 0, fieldHeight = 0;
+	size_t offset = 4;
+	while (offset + 5 <= bin.size())
+	{
+		unsigned char type = bin[offset];
+		uint32_t blockSize = ReadU32(&bin[offset + 1]);
+		if (blockSize > bin.size() - offset - 5)
+		{
+			fprintf(stderr, "%s: block %d runs past the end of the file\n", inFile.c_str(), (int)type);
+			return 1;
+		}
+		std::vector<unsigned char> block(bin.begin() + offset + 5, bin.begin() + offset + 5 + blockSize);
+		offset += 5 + blockSize;
+
+		switch (type)
+		{
+		case 1: //info: size, then padding and spacing
+			if (block.size() >= 14)
+			{
+				WriteS16(&block[0], Shrink(ReadS16(&block[0]), downscale));
+				for (int i = 7; i < 13; ++i) block[i] = (unsigned char)Shrink(block[i], downscale);
+			}
+			break;
+
+		case 2: //common
+			if (block.size() < 10) return 1;
+			if (ReadS16(&block[8]) != 1)
+			{
+				fprintf(stderr, "%s has more than one page, Blit3D only draws one\n", inFile.c_str());
+				return 1;
+			}
+			WriteS16(&block[0], Shrink(ReadS16(&block[0]), downscale));
+			WriteS16(&block[2], Shrink(ReadS16(&block[2]), downscale));
+			fieldWidth = (ReadS16(&block[4]) + downscale - 1) / downscale;
+			fieldHeight = (ReadS16(&block[6]) + downscale - 1) / downscale;
+			WriteS16(&block[4], fieldWidth);
+			WriteS16(&block[6], fieldHeight);
+			break;
+
+		case 3: //page
+			textureName.assign((const char *)block.data(), strnlen((const char *)block.data(), block.size()));
+			block.assign(outTextureName.begin(), outTextureName.end());
+			block.push_back(0);
+			break;
+
+		case 4: //characters, the rectangle grows to whole shrunk texels
+			for (size_t c = 0; c + 20 <= block.size(); c += 20)
+			{
+				unsigned char *glyph = &block[c];
+				int x = ReadS16(glyph + 4), y = ReadS16(glyph + 6);
+				int width = ReadS16(glyph + 8), height = ReadS16(glyph + 10);
+				int left = x / downscale, top = y / downscale;
+				int right = (x + width + downscale - 1) / downscale, bottom = (y + height + downscale - 1) / downscale;
+				WriteS16(glyph + 4, left);
+				WriteS16(glyph + 6, top);
+				WriteS16(glyph + 8, right - left);
+				WriteS16(glyph + 10, bottom - top);
+				WriteS16(glyph + 12, Shrink(ReadS16(glyph + 12) - (x - left * downscale), downscale));
+				WriteS16(glyph + 14, Shrink(ReadS16(glyph + 14) - (y - top * downscale), downscale));
+				WriteS16(glyph + 16, Shrink(ReadS16(glyph + 16), downscale));
+			}
+			break;
+
+		case 5: //kerning pairs
+			for (size_t k = 0; k + 10 <= block.size(); k += 10)
+			{
+				WriteS16(&block[k + 8], Shrink(ReadS16(&block[k + 8]), downscale));
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		out.push_back(type);
+		AppendU32(out, (uint32_t)block.size());
+		out.insert(out.end(), block.begin(), block.end());
+	}
+
+	if (textureName.empty() || fieldWidth == 0)
+	{
+		fprintf(stderr, "%s has no page or no common block\n", inFile.c_str());
+		return 1;
+	}
+
+	int width, height, channels;
+	unsigned char *pixels = stbi_load((inDirectory + textureName).c_str(), &width, &height, &channels, 0);
+	if (pixels == NULL)
+	{
+		fprintf(stderr, "Can't load the font's texture %s%s\n", inDirectory.c_str(), textureName.c_str());
+		return 1;
+	}
+	std::vector<unsigned char> field = MakeField(pixels, channels, width, height, fieldWidth, fieldHeight, spread, downscale);
+	stbi_image_free(pixels);
+
+	if (!WritePng(outTexture, field, fieldWidth, fieldHeight))
+	{
+		fprintf(stderr, "Can't write %s\n", outTexture.c_str());
+		return 1;
+	}
+	std::ofstream outBin(outFile, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outBin.write((const char *)out.data(), out.size()))
+	{
+		fprintf(stderr, "Can't write %s\n", outFile.c_str());
+		return 1;
+	}
+
+	printf("%s: %dx%d texture to a %dx%d distance field (spread %d) in %s\n", inFile.c_str(), width, height,
+		fieldWidth, fieldHeight, spread, outTexture.c_str());
+	return 0;
+}
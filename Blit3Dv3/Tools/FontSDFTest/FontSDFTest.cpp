@@ -0,0 +1,157 @@
+/*
+	FontSDFTest: checks a font FontSDF (see Tools/FontSDF) made against the font it was
+	made from. The new .bin must parse, keep every glyph and kerning pair with its sizes
+	shrunk, cover each old glyph rectangle, and point at a field PNG of the shrunk size
+	that stb_image reads. Every field texel must be over half where the old texture is
+	inside a glyph under the texel's centre, and under half where it isn't.
+
+	Usage:
+
+		FontSDFTest <in.bin> <out.bin> <downscale>
+
+	with the arguments FontSDF was run with. Prints the checks that failed and returns 1
+	if any did, 0 otherwise.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++17 -pthread -IBlit3DBaseFiles/Blit3D -IBlit3DBaseFiles/STB Tools/FontSDFTest/FontSDFTest.cpp
+			Blit3DBaseFiles/Blit3D/AngelcodeFontLayout.cpp Blit3DBaseFiles/Blit3D/Logger.cpp
+			Blit3DBaseFiles/Blit3D/AllocationTracker.cpp Blit3DBaseFiles/Blit3D/FrameArena.cpp -o FontSDFTest
+
+	or with CMakeLists.txt, which runs FontSDF on electrolite and then this from ctest.
+*/
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "AngelcodeFontLayout.h"
+#include "Logger.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//AngelcodeFontLayout logs the files it refuses to the main Blit3D logger
+logger oLog{"FontSDFTest.log", false};
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while (0)
+
+static bool LoadFont(const std::string &filename, AngelcodeFontLayout &layout)
+{
+	std::ifstream in(filename, std::ios::binary);
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return layout.Parse(data.data(), data.size());
+}
+
+static std::string Directory(const std::string &filename)
+{
+	size_t separator = filename.find_last_of("\\/");
+	return separator == std::string::npos ? "" : filename.substr(0, separator + 1);
+}
+
+//the size FontSDF gives a size in the big font
+static float Shrink(float value, int downscale)
+{
+	return std::floor(value / downscale + 0.5f);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 4)
+	{
+		fprintf(stderr, "Usage: FontSDFTest <in.bin> <out.bin> <downscale>\n");
+		return 1;
+	}
+	std::string inFile = argv[1];
+	std::string outFile = argv[2];
+	int downscale = atoi(argv[3]);
+
+	AngelcodeFontLayout original, converted;
+	if (!LoadFont(inFile, original) || !LoadFont(outFile, converted))
+	{
+		printf("Could not read %s and %s\n", inFile.c_str(), outFile.c_str());
+		return 1;
+	}
+
+	CHECK(converted.lineHeight == Shrink(original.lineHeight, downscale));
+	CHECK(converted.base == Shrink(original.base, downscale));
+	CHECK(converted.scaleW == std::ceil(original.scaleW / downscale));
+	CHECK(converted.scaleH == std::ceil(original.scaleH / downscale));
+
+	const std::vector<AngelcodeGlyph> &glyphs = original.GetGlyphs();
+	CHECK(converted.GetGlyphs().size() == glyphs.size());
+	CHECK(converted.GetKerningPairCount() == original.GetKerningPairCount());
+
+	bool covered = true, advanced = true, kerned = true;
+	for (const AngelcodeGlyph &glyph : glyphs)
+	{
+		const AngelcodeGlyph *shrunk = converted.FindGlyph(glyph.code);
+		if (shrunk == NULL)
+		{
+			covered = false;
+			continue;
+		}
+		//the shrunk rectangle holds the whole of the old one
+		if (shrunk->x * downscale > glyph.x || shrunk->y * downscale > glyph.y
+			|| (shrunk->x + shrunk->width) * downscale < glyph.x + glyph.width
+			|| (shrunk->y + shrunk->height) * downscale < glyph.y + glyph.height)
+		{
+			covered = false;
+		}
+		if (shrunk->xAdvance != Shrink(glyph.xAdvance, downscale)) advanced = false;
+
+		for (const AngelcodeGlyph &previous : glyphs)
+		{
+			if (converted.Kerning(*shrunk, previous.code) != Shrink(original.Kerning(glyph, previous.code), downscale)) kerned = false;
+		}
+	}
+	CHECK(covered);
+	CHECK(advanced);
+	CHECK(kerned);
+
+	int width, height, channels;
+	unsigned char *source = stbi_load((Directory(inFile) + original.textureName).c_str(), &width, &height, &channels, 4);
+	int fieldWidth, fieldHeight, fieldChannels;
+	unsigned char *field = stbi_load((Directory(outFile) + converted.textureName).c_str(), &fieldWidth, &fieldHeight, &fieldChannels, 0);
+	CHECK(source != NULL);
+	CHECK(field != NULL);
+	if (source != NULL && field != NULL)
+	{
+		CHECK(fieldChannels == 4);
+		CHECK(fieldWidth == (int)converted.scaleW && fieldHeight == (int)converted.scaleH);
+
+		//the edge is where the field crosses half
+		bool sided = fieldChannels == 4;
+		for (int fy = 0; fy < fieldHeight && sided; ++fy)
+		{
+			for (int fx = 0; fx < fieldWidth; ++fx)
+			{
+				int cx = fx * downscale + downscale / 2;
+				int cy = fy * downscale + downscale / 2;
+				if (cx >= width) cx = width - 1;
+				if (cy >= height) cy = height - 1;
+				bool inside = source[((size_t)cy * width + cx) * 4 + 3] >= 128;
+				unsigned char value = field[((size_t)fy * fieldWidth + fx) * 4 + 3];
+				if (inside != (value >= 128)) sided = false;
+			}
+		}
+		CHECK(sided);
+	}
+	stbi_image_free(source);
+	stbi_image_free(field);
+
+	if (failures > 0)
+	{
+		printf("FontSDFTest: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("FontSDFTest: all checks passed\n");
+	return 0;
+}
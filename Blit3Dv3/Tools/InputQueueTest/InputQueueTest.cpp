@@ -0,0 +1,195 @@
+/*
+	InputQueueTest: checks InputQueue (see Blit3DBaseFiles/Blit3D/InputQueue.h): events come
+	out in order and only once they are older than the time asked for, a full queue drops
+	and counts, and the latency histograms bucket and report what they were given. Also
+	pushes from one thread while popping on another and checks nothing is lost or reordered.
+
+	Prints the checks that failed and returns 1 if any did, 0 otherwise.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++17 -pthread -IBlit3DBaseFiles/Blit3D Tools/InputQueueTest/InputQueueTest.cpp
+			Blit3DBaseFiles/Blit3D/InputQueue.cpp Blit3DBaseFiles/Blit3D/Logger.cpp
+			Blit3DBaseFiles/Blit3D/AllocationTracker.cpp Blit3DBaseFiles/Blit3D/FrameArena.cpp -o InputQueueTest
+
+	or with CMakeLists.txt, which runs it from ctest.
+*/
+
+#include "InputQueue.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <thread>
+
+//InputQueue logs its stats to the main Blit3D logger
+logger oLog{"InputQueueTest.log", false};
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while (0)
+
+//far enough ahead that every queued event is older
+static const double LATER = 1e9;
+
+//waits until Now() has moved on, so events pushed either side get different stamps
+static double Tick()
+{
+	double time = InputQueue::Now();
+	while (InputQueue::Now() <= time) { }
+	return InputQueue::Now();
+}
+
+static void TestOrder()
+{
+	InputQueue queue;
+	InputEvent event;
+	CHECK(!queue.Pop(LATER, event));
+
+	queue.Push(1, 10, 1, 0);
+	double between = Tick();
+	Tick();
+	queue.Push(2, 20, 0, 4);
+
+	//only the event stamped before the time given comes out
+	CHECK(queue.Pop(between, event));
+	CHECK(event.key == 1 && event.scancode == 10 && event.action == 1 && event.mods == 0);
+	CHECK(event.time < between);
+	CHECK(!queue.Pop(between, event));
+
+	InputEvent second;
+	CHECK(queue.Pop(LATER, second));
+	CHECK(second.key == 2 && second.scancode == 20 && second.action == 0 && second.mods == 4);
+	CHECK(second.time > event.time);
+	//the stamp itself is not before itself
+	queue.Push(3, 0, 0, 0);
+	InputEvent third;
+	CHECK(queue.Pop(LATER, third));
+	queue.Push(4, 0, 0, 0);
+	CHECK(!queue.Pop(third.time, event));
+	CHECK(queue.Pop(LATER, event) && event.key == 4);
+}
+
+static void TestFull()
+{
+	InputQueue queue;
+	for (int i = 0; i < INPUT_QUEUE_SIZE; ++i) CHECK(queue.Push(i, 0, 0, 0));
+	CHECK(!queue.Push(-1, 0, 0, 0));
+	CHECK(!queue.Push(-2, 0, 0, 0));
+	CHECK(queue.GetDroppedEvents() == 2);
+
+	//the dropped ones never show up, and the ring wraps once there is room again
+	InputEvent event;
+	CHECK(queue.Pop(LATER, event) && event.key == 0);
+	CHECK(queue.Push(INPUT_QUEUE_SIZE, 0, 0, 0));
+	bool inOrder = true;
+	int expected = 1;
+	while (queue.Pop(LATER, event))
+	{
+		if (event.key != expected) inOrder = false;
+		expected++;
+	}
+	CHECK(inOrder);
+	CHECK(expected == INPUT_QUEUE_SIZE + 1);
+}
+
+static void TestPresented()
+{
+	InputQueue queue;
+	InputEvent event;
+	queue.Push(1, 0, 0, 0);
+	queue.Push(2, 0, 0, 0);
+	queue.Push(3, 0, 0, 0);
+	queue.Pop(LATER, event);
+	queue.Pop(LATER, event);
+	CHECK(queue.GetSimulationLatency().events == 2);
+	CHECK(queue.GetPresentLatency().events == 0);
+
+	//a present counts the events popped since the last one, once
+	queue.Presented();
+	CHECK(queue.GetPresentLatency().events == 2);
+	queue.Presented();
+	CHECK(queue.GetPresentLatency().events == 2);
+
+	queue.Pop(LATER, event);
+	queue.Presented();
+	CHECK(queue.GetSimulationLatency().events == 3);
+	CHECK(queue.GetPresentLatency().events == 3);
+	CHECK(queue.GetPresentLatency().longest >= queue.GetSimulationLatency().longest);
+}
+
+static void TestLatency()
+{
+	InputLatency empty;
+	CHECK(empty.Average() == 0.0);
+	CHECK(empty.Percentile(0.99) == 0.0);
+
+	InputLatency latency;
+	latency.Add(0.0005);
+	latency.Add(0.0015);
+	latency.Add(0.5);
+	latency.Add(-1.0); //a stamp from after the pop counts as no wait
+	CHECK(latency.events == 4);
+	CHECK(latency.buckets[0] == 2);
+	CHECK(latency.buckets[1] == 1);
+	CHECK(latency.buckets[INPUT_LATENCY_BUCKETS] == 1);
+	CHECK(latency.longest == 0.5);
+	CHECK(latency.Average() > 0.5019 / 4 && latency.Average() < 0.5021 / 4);
+
+	//reported to the top of the bucket, the overflow bucket reports the longest
+	CHECK(latency.Percentile(0.5) == 0.001);
+	CHECK(latency.Percentile(0.75) == 0.002);
+	CHECK(latency.Percentile(1.0) == 0.5);
+
+	//but never more than the longest
+	InputLatency single;
+	single.Add(0.0003);
+	CHECK(single.Percentile(0.99) == 0.0003);
+}
+
+static void TestThreads()
+{
+	const int eventCount = 20000;
+	InputQueue queue;
+
+	std::thread producer([&queue]() {
+		for (int i = 0; i < eventCount; ++i)
+		{
+			while (!queue.Push(i, 0, 0, 0)) std::this_thread::yield();
+		}
+	});
+
+	InputEvent event;
+	int expected = 0;
+	bool inOrder = true;
+	double lastTime = 0.0;
+	while (expected < eventCount)
+	{
+		if (!queue.Pop(LATER, event)) continue;
+		if (event.key != expected || event.time < lastTime) inOrder = false;
+		lastTime = event.time;
+		expected++;
+	}
+	producer.join();
+
+	CHECK(inOrder);
+	CHECK(!queue.Pop(LATER, event));
+	CHECK(queue.GetSimulationLatency().events == (uint64_t)eventCount);
+}
+
+int main()
+{
+	TestOrder();
+	TestFull();
+	TestPresented();
+	TestLatency();
+	TestThreads();
+
+	if (failures > 0)
+	{
+		printf("InputQueueTest: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("InputQueueTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*
+	RandomGeneratorTest: checks RandomGenerator (see RandomGenerator.h) against the PCG32
+	reference numbers, and that Stream(), Advance() and the Fill functions give the same
+	numbers as making the generator or drawing them one at a time would.
+
+	Prints the checks that failed and returns 1 if any did, 0 otherwise.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++17 -I. -IBlit3DBaseFiles Tools/RandomGeneratorTest/RandomGeneratorTest.cpp RandomGenerator.cpp -o RandomGeneratorTest
+
+	or with CMakeLists.txt, which runs it from ctest.
+*/
+
+#include "RandomGenerator.h"
+
+#include <climits>
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while (0)
+
+//a full range RandomInt is the raw 32 bit number
+static uint32_t Raw(RandomGenerator &rng)
+{
+	return (uint32_t)rng.RandomInt(INT_MIN, INT_MAX);
+}
+
+static void TestReferenceSequence()
+{
+	//pcg32-demo's first numbers for seed 42, stream 54
+	const uint32_t expected[] = { 0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e };
+	RandomGenerator rng(42, 54);
+	for (uint32_t value : expected)
+	{
+		CHECK(Raw(rng) == value);
+	}
+}
+
+static void TestStreams()
+{
+	RandomGenerator game(1234, 0);
+	Raw(game);
+	Raw(game);
+
+	//a stream starts from the seed, not from where the parent has got to
+	RandomGenerator worker = game.Stream(3);
+	RandomGenerator same(1234, 3);
+	CHECK(worker.GetSeed() == 1234);
+	bool allEqual = true;
+	for (int i = 0; i < 100; ++i)
+	{
+		if (Raw(worker) != Raw(same)) allEqual = false;
+	}
+	CHECK(allEqual);
+
+	RandomGenerator first = game.Stream(1);
+	RandomGenerator second = game.Stream(2);
+	int equal = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		if (Raw(first) == Raw(second)) equal++;
+	}
+	CHECK(equal < 5);
+}
+
+static void TestAdvance()
+{
+	const uint64_t counts[] = { 0, 1, 2, 7, 8, 100, 1000, 65537 };
+	for (uint64_t count : counts)
+	{
+		RandomGenerator drawn(99, 7);
+		RandomGenerator skipped(99, 7);
+		for (uint64_t i = 0; i < count; ++i) Raw(drawn);
+		skipped.Advance(count);
+		CHECK(Raw(drawn) == Raw(skipped));
+		CHECK(Raw(drawn) == Raw(skipped));
+	}
+}
+
+static void TestFill()
+{
+	//whole blocks of lanes, a remainder, and fewer than a block
+	const size_t counts[] = { 0, 1, 5, RANDOM_FILL_LANES, RANDOM_FILL_LANES + 3, 4 * RANDOM_FILL_LANES + 7 };
+	for (size_t count : counts)
+	{
+		RandomGenerator single(5, 11);
+		RandomGenerator filled(5, 11);
+		float values[64];
+		filled.FillFloats(values, count, -2.f, 3.f);
+		bool allEqual = true;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (single.RandomFloat(-2.f, 3.f) != values[i]) allEqual = false;
+			if (values[i] < -2.f || values[i] >= 3.f) allEqual = false;
+		}
+		CHECK(allEqual);
+		//and both are left at the same place
+		CHECK(Raw(single) == Raw(filled));
+	}
+
+	RandomGenerator single(8, 2);
+	RandomGenerator filled(8, 2);
+	glm::vec2 vectors[13];
+	filled.FillVec2(vectors, 13, glm::vec2(-1.f, 10.f), glm::vec2(1.f, 20.f));
+	bool allEqual = true;
+	for (int i = 0; i < 13; ++i)
+	{
+		float x = single.RandomFloat(-1.f, 1.f);
+		float y = single.RandomFloat(10.f, 20.f);
+		if (vectors[i].x < -1.f || vectors[i].x >= 1.f || vectors[i].y < 10.f || vectors[i].y >= 20.f) allEqual = false;
+		//FillVec2 scales unit floats afterwards, so allow for the rounding
+		if (vectors[i].x - x > 1e-5f || x - vectors[i].x > 1e-5f) allEqual = false;
+		if (vectors[i].y - y > 1e-4f || y - vectors[i].y > 1e-4f) allEqual = false;
+	}
+	CHECK(allEqual);
+	CHECK(Raw(single) == Raw(filled));
+}
+
+static void TestRanges()
+{
+	RandomGenerator rng(2024, 0);
+	bool seen[7] = { false };
+	bool inRange = true;
+	for (int i = 0; i < 10000; ++i)
+	{
+		int value = rng.RandomInt(-3, 3);
+		if (value < -3 || value > 3) inRange = false;
+		else seen[value + 3] = true;
+	}
+	CHECK(inRange);
+	for (bool wasSeen : seen) CHECK(wasSeen);
+
+	CHECK(rng.RandomInt(5, 5) == 5);
+
+	//negative bounds and the precision's step
+	inRange = true;
+	bool onStep = true;
+	for (int i = 0; i < 10000; ++i)
+	{
+		float value = rng.RandomFloat(-5, -2, 10);
+		if (value < -5.f || value > -2.f) inRange = false;
+		float steps = (value + 5.f) * 10.f;
+		if (steps - (int)(steps + 0.5f) > 1e-3f || (int)(steps + 0.5f) - steps > 1e-3f) onStep = false;
+	}
+	CHECK(inRange);
+	CHECK(onStep);
+}
+
+int main()
+{
+	TestReferenceSequence();
+	TestStreams();
+	TestAdvance();
+	TestFill();
+	TestRanges();
+
+	if (failures > 0)
+	{
+		printf("RandomGeneratorTest: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("RandomGeneratorTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*
+	SlotMapTest: checks SlotMap (see SlotMap.h): deferred spawns and despawns, handles
+	going stale when their slot is emptied or reused, Clear(), and walking the slots.
+
+	Prints the checks that failed and returns 1 if any did, 0 otherwise.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++17 -I. Tools/SlotMapTest/SlotMapTest.cpp -o SlotMapTest
+
+	or with CMakeLists.txt, which runs it from ctest.
+*/
+
+#include "SlotMap.h"
+
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); failures++; } } while (0)
+
+struct Entity
+{
+	int value;
+
+	Entity(int entityValue) : value(entityValue) { }
+};
+
+static void TestDeferredSpawn()
+{
+	SlotMap<Entity> map;
+	SlotHandle<Entity> handle = map.Spawn(7);
+
+	//queued, not there yet
+	CHECK(!handle.IsNull());
+	CHECK(map.Get(handle) == NULL);
+	CHECK(map.Size() == 0);
+	CHECK(map.PendingSpawnCount() == 1);
+
+	map.Flush();
+	CHECK(map.Get(handle) != NULL && map.Get(handle)->value == 7);
+	CHECK(map.Size() == 1);
+	CHECK(map.PendingSpawnCount() == 0);
+	CHECK(map.Get(SlotHandle<Entity>()) == NULL);
+}
+
+static void TestStaleHandles()
+{
+	SlotMap<Entity> map;
+	SlotHandle<Entity> first = map.Spawn(1);
+	map.Flush();
+
+	map.Despawn(first);
+	//still there until the flush
+	CHECK(map.IsAlive(first));
+	map.Flush();
+	CHECK(!map.IsAlive(first));
+	CHECK(map.Size() == 0);
+
+	//the slot is reused with a new generation, the old handle must not see the new entity
+	SlotHandle<Entity> second = map.Spawn(2);
+	CHECK(second.index == first.index);
+	CHECK(second.generation != first.generation);
+	map.Flush();
+	CHECK(map.Get(second) != NULL && map.Get(second)->value == 2);
+	CHECK(map.Get(first) == NULL);
+	CHECK(map.SlotCount() == 1);
+
+	//stale and repeated despawns are ignored
+	map.Despawn(first);
+	map.Despawn(second);
+	map.Despawn(second);
+	map.Flush();
+	CHECK(map.Size() == 0);
+	CHECK(!map.IsAlive(second));
+
+	SlotHandle<Entity> third = map.Spawn(3);
+	map.Flush();
+	CHECK(map.IsAlive(third));
+	CHECK(!map.IsAlive(first) && !map.IsAlive(second));
+	CHECK(map.Size() == 1);
+}
+
+static void TestSpawnAndDespawnInOneTick()
+{
+	SlotMap<Entity> map;
+	SlotHandle<Entity> handle = map.Spawn(1);
+	//spawns are applied before despawns, so this one never shows up
+	map.Despawn(handle);
+	map.Flush();
+	CHECK(!map.IsAlive(handle));
+	CHECK(map.Size() == 0);
+}
+
+static void TestSpawnWhileWalking()
+{
+	SlotMap<Entity> map;
+	for (int i = 0; i < 4; ++i) map.Spawn(i);
+	map.Flush();
+
+	//split every entity while walking them, like a shot asteroid
+	int visited = 0;
+	map.ForEach([&](SlotHandle<Entity> handle, Entity &entity) {
+		visited++;
+		map.Spawn(entity.value + 100);
+		map.Spawn(entity.value + 200);
+		map.Despawn(handle);
+	});
+	CHECK(visited == 4);
+	CHECK(map.Size() == 4);
+
+	map.Flush();
+	CHECK(map.Size() == 8);
+
+	int sum = 0;
+	size_t walked = 0;
+	for (size_t i = 0; i < map.SlotCount(); ++i)
+	{
+		Entity *entity = map.GetSlot(i);
+		if (entity == NULL)
+		{
+			CHECK(map.GetHandle(i).IsNull());
+			continue;
+		}
+		walked++;
+		sum += entity->value;
+		CHECK(map.Get(map.GetHandle(i)) == entity);
+	}
+	CHECK(walked == 8);
+	CHECK(sum == (100 + 101 + 102 + 103) + (200 + 201 + 202 + 203));
+	//the four freed slots were not reused until the flush, so the array grew to twelve
+	CHECK(map.SlotCount() == 12);
+}
+
+static void TestClear()
+{
+	SlotMap<Entity> map;
+	SlotHandle<Entity> live = map.Spawn(1);
+	map.Flush();
+	SlotHandle<Entity> pending = map.Spawn(2);
+
+	map.Clear();
+	CHECK(map.Size() == 0);
+	CHECK(map.PendingSpawnCount() == 0);
+	CHECK(!map.IsAlive(live));
+
+	//the dropped spawn's handle stays stale once its slot is used again
+	map.Flush();
+	CHECK(!map.IsAlive(pending));
+	SlotHandle<Entity> a = map.Spawn(3);
+	SlotHandle<Entity> b = map.Spawn(4);
+	map.Flush();
+	CHECK(map.IsAlive(a) && map.IsAlive(b));
+	CHECK(!map.IsAlive(live) && !map.IsAlive(pending));
+	CHECK(map.SlotCount() == 2);
+}
+
+int main()
+{
+	TestDeferredSpawn();
+	TestStaleHandles();
+	TestSpawnAndDespawnInOneTick();
+	TestSpawnWhileWalking();
+	TestClear();
+
+	if (failures > 0)
+	{
+		printf("SlotMapTest: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("SlotMapTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,245 @@
+/*
+	TraceReader: reads a gameplay trace written by GameTrace (see GameTrace.h), turns it
+	into CSV and prints histograms of the load over the game.
+
+	Usage, on a trace made by starting the game with --trace <file>:
+
+		TraceReader late_game.b3dt [events.csv] [ticks.csv]
+
+	events.csv gets one line per event with its tick, time and fields. ticks.csv gets one
+	line per tick summary: asteroids, shots and power ups alive, the tick's collisions
+	by kind, its events and the microseconds it took. Either can be left out, the
+	summary and histograms printed to the console don't need them.
+
+	Not part of the game project. Build it from Blit3Dv3/ as a console app, for example:
+
+		g++ -O2 -std=c++14 -I. Tools/TraceReader/TraceReader.cpp -o TraceReader
+*/
+
+#include "GameTrace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Counts by power of two buckets: 0, 1, 2-3, 4-7...
+struct Histogram
+{
+	const char *name;
+	uint64_t buckets[33];
+	uint64_t samples;
+	uint64_t total;
+	uint64_t max;
+
+	explicit Histogram(const char *histogramName) : name(histogramName), samples(0), total(0), max(0)
+	{
+		memset(buckets, 0, sizeof(buckets));
+	}
+
+	void Add(uint64_t value)
+	{
+		int bucket = 0;
+		while (bucket < 32 && value >= (1ULL << bucket)) bucket++;
+		buckets[bucket]++;
+		samples++;
+		total += value;
+		if (value > max) max = value;
+	}
+
+	void Print() const
+	{
+		printf("\n%s: %llu samples, %.2f average, %llu max\n", name, (unsigned long long)samples,
+			samples > 0 ? (double)total / samples : 0.0, (unsigned long long)max);
+		if (samples == 0) return;
+
+		uint64_t most = 0;
+		for (uint64_t count : buckets) if (count > most) most = count;
+		for (int bucket = 0; bucket < 33; ++bucket)
+		{
+			if (buckets[bucket] == 0) continue;
+			uint64_t low = bucket == 0 ? 0 : 1ULL << (bucket - 1);
+			uint64_t high = bucket == 0 ? 0 : (1ULL << bucket) - 1;
+			int bar = (int)(buckets[bucket] * 50 / most);
+			printf("  %10llu - %-10llu %10llu |", (unsigned long long)low, (unsigned long long)high,
+				(unsigned long long)buckets[bucket]);
+			for (int i = 0; i < bar; ++i) putchar('#');
+			putchar('\n');
+		}
+	}
+};
+
+// What a tick did, filled from its events and written out at its TICK_SUMMARY
+struct TickCounts
+{
+	uint32_t events;
+	uint32_t shotAsteroid;
+	uint32_t asteroidAsteroid;
+	uint32_t shipAsteroid;
+	uint32_t shipPowerUp;
+	uint32_t splits;
+	uint32_t shotsFired;
+};
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: TraceReader <trace> [events.csv] [ticks.csv]\n");
+		return 1;
+	}
+
+	std::ifstream in(argv[1], std::ios::in | std::ios::binary);
+	if (!in.is_open())
+	{
+		fprintf(stderr, "Can't open trace %s\n", argv[1]);
+		return 1;
+	}
+
+	TraceFileHeader header;
+	if (!in.read((char *)&header, sizeof(header)) || memcmp(header.magic, "B3DT", 4) != 0)
+	{
+		fprintf(stderr, "%s is not a gameplay trace\n", argv[1]);
+		return 1;
+	}
+	if (header.version != TRACE_FILE_VERSION || header.recordSize != sizeof(TraceRecord))
+	{
+		fprintf(stderr, "%s is trace version %u with %u byte records, this reader reads version %u\n", argv[1],
+			(unsigned)header.version, (unsigned)header.recordSize, (unsigned)TRACE_FILE_VERSION);
+		return 1;
+	}
+
+	FILE *events = NULL;
+	if (argc > 2)
+	{
+		events = fopen(argv[2], "w");
+		if (events == NULL)
+		{
+			fprintf(stderr, "Can't write %s\n", argv[2]);
+			return 1;
+		}
+		fprintf(events, "tick,seconds,event,detail,a,b,c\n");
+	}
+	FILE *ticks = NULL;
+	if (argc > 3)
+	{
+		ticks = fopen(argv[3], "w");
+		if (ticks == NULL)
+		{
+			fprintf(stderr, "Can't write %s\n", argv[3]);
+			return 1;
+		}
+		fprintf(ticks, "tick,seconds,asteroids,shots,power_ups,shot_asteroid,asteroid_asteroid,ship_asteroid,"
+			"ship_power_up,splits,shots_fired,events,tick_us\n");
+	}
+
+	uint64_t eventCounts[(size_t)TraceEvent::COUNT] = {};
+	uint64_t unknownEvents = 0;
+	uint64_t records = 0;
+	uint64_t tick = 0;
+	uint64_t firstTick = 0;
+	bool seenTick = false;
+	TickCounts counts = {};
+
+	Histogram asteroidsAlive("Asteroids alive per tick");
+	Histogram shotsAlive("Shots alive per tick");
+	Histogram collisionsPerTick("Collisions per tick (all kinds)");
+	Histogram asteroidCollisionsPerTick("Asteroid-asteroid collisions per tick");
+	Histogram eventsPerTick("Events per tick");
+	Histogram tickTime("Tick time (us)");
+
+	TraceRecord record;
+	while (in.read((char *)&record, sizeof(record)))
+	{
+		records++;
+		if (record.event == (uint8_t)TraceEvent::TICK)
+		{
+			tick = record.a | ((uint64_t)record.b << 32);
+		}
+		else
+		{
+			tick += record.tickDelta;
+		}
+		if (!seenTick)
+		{
+			firstTick = tick;
+			seenTick = true;
+		}
+
+		if (record.event >= (uint8_t)TraceEvent::COUNT)
+		{
+			unknownEvents++;
+			continue;
+		}
+		TraceEvent event = (TraceEvent)record.event;
+		eventCounts[record.event]++;
+		double seconds = tick * (double)header.tickSeconds;
+
+		if (events != NULL && event != TraceEvent::TICK)
+		{
+			fprintf(events, "%llu,%.4f,%s,%u,%u,%u,%u\n", (unsigned long long)tick, seconds, TraceEventName(event),
+				(unsigned)record.detail, record.a, record.b, record.c);
+		}
+
+		if (event != TraceEvent::TICK && event != TraceEvent::TICK_SUMMARY) counts.events++;
+		switch (event)
+		{
+		case TraceEvent::COLLISIONS:
+			counts.shotAsteroid += record.a;
+			counts.asteroidAsteroid += record.b;
+			counts.shipAsteroid += record.c >> 16;
+			counts.shipPowerUp += record.c & 0xFFFF;
+			break;
+		case TraceEvent::ASTEROID_SPLIT:
+			counts.splits++;
+			break;
+		case TraceEvent::SHOTS_FIRED:
+			counts.shotsFired += record.a;
+			break;
+		case TraceEvent::TICK_SUMMARY:
+		{
+			//the tick's last record
+			uint32_t shots = record.b >> 16;
+			uint32_t powerUps = record.b & 0xFFFF;
+			uint32_t collisions = counts.shotAsteroid + counts.asteroidAsteroid + counts.shipAsteroid + counts.shipPowerUp;
+			asteroidsAlive.Add(record.a);
+			shotsAlive.Add(shots);
+			collisionsPerTick.Add(collisions);
+			asteroidCollisionsPerTick.Add(counts.asteroidAsteroid);
+			eventsPerTick.Add(counts.events);
+			tickTime.Add(record.c);
+			if (ticks != NULL)
+			{
+				fprintf(ticks, "%llu,%.4f,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", (unsigned long long)tick, seconds,
+					record.a, shots, powerUps, counts.shotAsteroid, counts.asteroidAsteroid, counts.shipAsteroid,
+					counts.shipPowerUp, counts.splits, counts.shotsFired, counts.events, record.c);
+			}
+			counts = TickCounts();
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	if (events != NULL) fclose(events);
+	if (ticks != NULL) fclose(ticks);
+
+	printf("%s: %llu records, ticks %llu to %llu (%.1f s at %.2f ms a tick)\n", argv[1], (unsigned long long)records,
+		(unsigned long long)firstTick, (unsigned long long)tick, (tick - firstTick) * (double)header.tickSeconds,
+		header.tickSeconds * 1000.0);
+	if (unknownEvents > 0) printf("%llu records with an unknown event were skipped\n", (unsigned long long)unknownEvents);
+	printf("\nEvents:\n");
+	for (size_t i = 1; i < (size_t)TraceEvent::COUNT; ++i)
+	{
+		if (eventCounts[i] == 0) continue;
+		printf("  %-18s %llu\n", TraceEventName((TraceEvent)i), (unsigned long long)eventCounts[i]);
+	}
+
+	asteroidsAlive.Print();
+	shotsAlive.Print();
+	collisionsPerTick.Print();
+	asteroidCollisionsPerTick.Print();
+	eventsPerTick.Print();
+	tickTime.Print();
+	return 0;
+}
@@ -0,0 +1,418 @@
+#include "WwiseAudioBackend.h"
+
+#ifdef AUDIO_HAS_WWISE
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+//below needed for VirtualAlloc etc
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+#include <cassert>
+
+#include "AudioMemoryPool.h"
+#include "AssetArchive.h"
+
+//add the following libraries to the build
+#pragma comment(lib, "AkSoundEngine.lib") //sound engine core
+#pragma comment(lib, "AkMemoryMgr.lib") //memory manager
+#pragma comment(lib, "AkStreamMgr.lib") //io manager
+#pragma comment(lib, "AkMusicEngine.lib") //interactive dynamic music
+#ifndef AK_OPTIMIZED
+#pragma comment(lib, "CommunicationCentral.lib") //debug comms
+#endif
+
+//source plugin libs
+#pragma comment(lib, "AkAudioInputSource.lib")
+#pragma comment(lib, "AkSilenceSource.lib")
+#pragma comment(lib, "AkSineSource.lib")
+#pragma comment(lib, "AkSynthOneSource.lib")
+#pragma comment(lib, "AkToneSource.lib")
+
+//effect plugins
+#pragma comment(lib, "AkCompressorFX.lib")
+#pragma comment(lib, "AkDelayFX.lib")
+#pragma comment(lib, "AkExpanderFX.lib")
+#pragma comment(lib, "AkFlangerFX.lib")
+#pragma comment(lib, "AkGainFX.lib")
+#pragma comment(lib, "AkGuitarDistortionFX.lib")
+#pragma comment(lib, "AkHarmonizerFX.lib")
+#pragma comment(lib, "AkMatrixReverbFX.lib")
+#pragma comment(lib, "AkMeterFX.lib")
+#pragma comment(lib, "AkParametricEQFX.lib")
+#pragma comment(lib, "AkPeakLimiterFX.lib")
+#pragma comment(lib, "AkPitchShifterFX.lib")
+#pragma comment(lib, "AkRoomVerbFX.lib")
+#pragma comment(lib, "AkStereoDelayFX.lib")
+#pragma comment(lib, "AkTimeStretchFX.lib")
+#pragma comment(lib, "AkTremoloFX.lib")
+
+//codec plugins
+#pragma comment(lib, "AkVorbisDecoder.lib")
+
+//motion plugins
+#pragma comment(lib, "AkMotionGeneratorSource.lib")
+//#pragma comment(lib, "AkRumble.lib")
+
+//platform-specific (windows)
+#pragma comment(lib, "dinput8.lib")
+#pragma comment(lib, "dsound.lib")
+#pragma comment(lib, "xinput.lib")
+#pragma comment(lib, "dxguid.lib")
+#ifndef AK_OPTIMIZED
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+
+// Custom alloc/free functions. These are declared as "extern" in AkMemoryMgr.h
+// and MUST be defined by the game developer.
+// Everything goes through our size-class pool, see AudioMemoryPool.h.
+namespace AK
+{
+	void * AllocHook(size_t in_size)
+	{
+		return audioMemory.Alloc(in_size);
+	}
+	void FreeHook(void * in_ptr)
+	{
+		audioMemory.Free(in_ptr);
+	}
+#ifdef WIN32
+	// Note: VirtualAllocHook() may be used by I/O pools of the default implementation
+	// of the Stream Manager, to allow "true" unbuffered I/O (using FILE_FLAG_NO_BUFFERING
+	// - refer to the Windows SDK documentation for more details). This is NOT mandatory;
+	// you may implement it with a simple malloc().
+	void * VirtualAllocHook(
+		void * in_pMemAddress,
+		size_t in_size,
+		DWORD in_dwAllocationType,
+		DWORD in_dwProtect
+		)
+	{
+		//fresh read/write pages are all the I/O pools ask for, the pool counts those
+		if (in_pMemAddress == NULL && (in_dwAllocationType & MEM_COMMIT) && in_dwProtect == PAGE_READWRITE)
+			return audioMemory.AllocPages(in_size);
+		return VirtualAlloc(in_pMemAddress, in_size, in_dwAllocationType, in_dwProtect);
+	}
+	void VirtualFreeHook(
+		void * in_pMemAddress,
+		size_t in_size,
+		DWORD in_dwFreeType
+		)
+	{
+		if (in_dwFreeType == MEM_RELEASE && audioMemory.FreePages(in_pMemAddress)) return;
+		VirtualFree(in_pMemAddress, in_size, in_dwFreeType);
+	}
+#endif
+}
+
+WwiseAudioBackend::WwiseAudioBackend() : archive(NULL)
+{
+}
+
+bool WwiseAudioBackend::Init()
+{
+	//
+	// Create and initialize an instance of the default memory manager. Note
+	// that you can override the default memory manager with your own. Refer
+	// to the SDK documentation for more information.
+	//
+
+	AkMemSettings memSettings;
+	memSettings.uMaxNumPools = 20;
+
+	// The memory hooks allocate from audioMemory, cap what it may take from the system
+	audioMemory.SetBudget(AUDIO_MEMORY_BUDGET);
+
+	if (AK::MemoryMgr::Init(&memSettings) != AK_Success)
+	{
+		assert(!"Could not create the memory manager.");
+		return false;
+	}
+
+	//
+	// Create and initialize an instance of the default streaming manager. Note
+	// that you can override the default streaming manager with your own. Refer
+	// to the SDK documentation for more information.
+	//
+
+	AkStreamMgrSettings stmSettings;
+	AK::StreamMgr::GetDefaultSettings(stmSettings);
+
+	// Customize the Stream Manager settings here.
+
+	if (!AK::StreamMgr::Create(stmSettings))
+	{
+		assert(!"Could not create the Streaming Manager");
+		return false;
+	}
+
+	//
+	// Create a streaming device with blocking low-level I/O handshaking.
+	// Note that you can override the default low-level I/O module with your own. Refer
+	// to the SDK documentation for more information.        
+	//
+	AkDeviceSettings deviceSettings;
+	AK::StreamMgr::GetDefaultDeviceSettings(deviceSettings);
+
+	// Customize the streaming device settings here.
+#if !defined(_WIN32) && defined(AUDIO_WWISE_THREAD_POOL_IO)
+	// The thread pool hook is a deferred one.
+	deviceSettings.uSchedulerTypeFlags = AK_SCHEDULER_DEFERRED_LINED_UP;
+#endif
+
+	// CAkFilePackageLowLevelIOBlocking::Init() creates a streaming device
+	// in the Stream Manager, and registers itself as the File Location Resolver.
+	if (g_lowLevelIO.Init(deviceSettings) != AK_Success)
+	{
+		assert(!"Could not create the streaming device and Low-Level I/O system");
+		return false;
+	}
+
+	//
+	// Create the Sound Engine
+	// Using default initialization parameters
+	//
+
+	AkInitSettings initSettings;
+	AkPlatformInitSettings platformInitSettings;
+	AK::SoundEngine::GetDefaultInitSettings(initSettings);
+	AK::SoundEngine::GetDefaultPlatformInitSettings(platformInitSettings);
+
+	if (AK::SoundEngine::Init(&initSettings, &platformInitSettings) != AK_Success)
+	{
+		assert(!"Could not initialize the Sound Engine.");
+		return false;
+	}
+
+	//NEXT SECTION ONLY NEEDED IF USING INTERACTIVE MUSIC
+
+	//
+	// Initialize the music engine
+	// Using default initialization parameters
+	//
+
+	AkMusicSettings musicInit;
+	AK::MusicEngine::GetDefaultInitSettings(musicInit);
+
+	if (AK::MusicEngine::Init(&musicInit) != AK_Success)
+	{
+		assert(!"Could not initialize the Music Engine.");
+		return false;
+	}
+
+#ifndef AK_OPTIMIZED
+	//
+	// Initialize communications (not in release build!)
+	//
+	AkCommSettings commSettings;
+	AK::Comm::GetDefaultInitSettings(commSettings);
+	if (AK::Comm::Init(commSettings) != AK_Success)
+	{
+		assert(!"Could not initialize communication.");
+		return false;
+	}
+#endif // AK_OPTIMIZED
+
+	return true;
+}
+
+void WwiseAudioBackend::RenderAudio()
+{
+	// Process bank requests, events, positions, RTPC, etc.
+	AK::SoundEngine::RenderAudio();
+}
+
+void WwiseAudioBackend::Term()
+{
+#ifndef AK_OPTIMIZED
+	//
+	// Terminate Communication Services
+	//
+	AK::Comm::Term();
+#endif // AK_OPTIMIZED
+
+	//
+	// Terminate the music engine
+	//
+
+	AK::MusicEngine::Term();
+
+	//
+	// Terminate the sound engine
+	//
+
+	AK::SoundEngine::Term();
+
+	// Terminate the streaming device and streaming manager
+
+	// CAkFilePackageLowLevelIOBlocking::Term() destroys its associated streaming device 
+	// that lives in the Stream Manager, and unregisters itself as the File Location Resolver.
+	g_lowLevelIO.Term();
+
+	if (AK::IAkStreamMgr::Get())
+		AK::IAkStreamMgr::Get()->Destroy();
+
+	// Terminate the Memory Manager
+	AK::MemoryMgr::Term();
+
+	// What the sound engine used, anything still in use here has leaked
+	audioMemory.LogReport();
+}
+
+
+//conversion for strings to the sound engine's AkOSChar, written into the caller's buffer
+//so no temporary string is allocated. Longer names than the buffer holds are cut short.
+static const AkOSChar *convert(const std::string& as, AkOSChar (&buffer)[AK_MAX_PATH])
+{
+#ifdef _WIN32
+	//the game's strings are in the ANSI code page
+	if (MultiByteToWideChar(CP_ACP, 0, as.c_str(), -1, buffer, AK_MAX_PATH) == 0)
+	{
+		//too long: keep what fits
+		MultiByteToWideChar(CP_ACP, 0, as.c_str(), AK_MAX_PATH - 1, buffer, AK_MAX_PATH - 1);
+		buffer[AK_MAX_PATH - 1] = 0;
+	}
+#else
+	//AkOSChar is plain char off Windows, only the game's path separators need fixing
+	size_t length = 0;
+	for (; length < as.size() && length < AK_MAX_PATH - 1; ++length)
+	{
+		buffer[length] = as[length] == '\\' ? '/' : as[length];
+	}
+	buffer[length] = 0;
+#endif
+	return buffer;
+}
+
+void WwiseAudioBackend::SetBasePath(const std::string &path)
+{
+	basePath = path;
+	AkOSChar osPath[AK_MAX_PATH];
+	g_lowLevelIO.SetBasePath(convert(path, osPath));
+	AK::StreamMgr::SetCurrentLanguage(AKTEXT("English(US)"));
+}
+
+void WwiseAudioBackend::SetArchive(const AssetArchive *assets)
+{
+	archive = assets;
+}
+
+bool WwiseAudioBackend::LoadBank(const std::string &bank)
+{
+	AkBankID bankID; // Not used. These banks can be unloaded with their file name.
+	AKRESULT eResult;
+	AssetData packed;
+	if (archive != NULL && archive->Find(basePath + bank, packed))
+	{
+		// The archive keeps banks aligned for the sound engine, which reads them in place
+		eResult = AK::SoundEngine::LoadBank(packed.bytes, (AkUInt32)packed.size, bankID);
+	}
+	else
+	{
+		AkOSChar osBank[AK_MAX_PATH];
+		eResult = AK::SoundEngine::LoadBank(convert(bank, osBank), AK_DEFAULT_POOL_ID, bankID);
+	}
+	assert(eResult == AK_Success);
+	return(eResult == AK_Success);
+}
+
+// What LoadBankAsync() hands the sound engine as its cookie
+struct WwiseBankRequest
+{
+	AudioBankCallback callback;
+	void *cookie;
+};
+
+// Called by the sound engine's bank thread when the bank is in, or failed to load
+static void WwiseBankLoaded(AkUInt32 /*in_bankID*/, const void * /*in_pInMemoryBankPtr*/, AKRESULT in_eLoadResult,
+	AkMemPoolId /*in_memPoolId*/, void *in_pCookie)
+{
+	WwiseBankRequest *request = (WwiseBankRequest *)in_pCookie;
+	request->callback(in_eLoadResult == AK_Success, request->cookie);
+	delete request;
+}
+
+bool WwiseAudioBackend::LoadBankAsync(const std::string &bank, AudioBankCallback callback, void *cookie)
+{
+	WwiseBankRequest *request = new WwiseBankRequest;
+	request->callback = callback;
+	request->cookie = cookie;
+
+	AkBankID bankID; // Not used. These banks can be unloaded with their file name.
+	AKRESULT eResult;
+	AssetData packed;
+	if (archive != NULL && archive->Find(basePath + bank, packed))
+	{
+		eResult = AK::SoundEngine::LoadBank(packed.bytes, (AkUInt32)packed.size, WwiseBankLoaded, request, bankID);
+	}
+	else
+	{
+		AkOSChar osBank[AK_MAX_PATH];
+		eResult = AK::SoundEngine::LoadBank(convert(bank, osBank), WwiseBankLoaded, request,
+			AK_DEFAULT_POOL_ID, bankID);
+	}
+	if (eResult != AK_Success)
+	{
+		//the callback will never come
+		delete request;
+		assert(!"Could not queue the bank load.");
+		return false;
+	}
+	return true;
+}
+
+AkPlayingID WwiseAudioBackend::PostEvent(AkUniqueID eventID, AkGameObjectID gameObjectID)
+{
+	return AK::SoundEngine::PostEvent(
+		eventID,                            // ID of the event
+		gameObjectID                        // Associated game object ID
+		);
+}
+
+void WwiseAudioBackend::ExecuteActionOnEvent(AudioCommandType action, AkUniqueID eventID, AkGameObjectID gameObjectID,
+	AkTimeMs transitionDuration, AkPlayingID playingID)
+{
+	AK::SoundEngine::AkActionOnEventType actionType;
+	switch (action)
+	{
+	case AudioCommandType::STOP:
+		actionType = AK::SoundEngine::AkActionOnEventType::AkActionOnEventType_Stop;
+		break;
+	case AudioCommandType::PAUSE:
+		actionType = AK::SoundEngine::AkActionOnEventType::AkActionOnEventType_Pause;
+		break;
+	case AudioCommandType::RESUME:
+		actionType = AK::SoundEngine::AkActionOnEventType::AkActionOnEventType_Resume;
+		break;
+	default:
+		return;
+	}
+
+	AK::SoundEngine::ExecuteActionOnEvent(eventID, actionType,
+		gameObjectID, transitionDuration, AkCurveInterpolation_Linear,
+		playingID);
+}
+
+void WwiseAudioBackend::SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID)
+{
+	AK::SoundEngine::SetRTPCValue(rtpcID, value, gameObjectID);
+}
+
+void WwiseAudioBackend::SetPosition(AkGameObjectID gameObjectID, float x, float y)
+{
+	AkSoundPosition position;
+	position.SetPosition(x, y, 0.0f);
+	//facing into the screen, with Y up
+	position.SetOrientation(0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f);
+	AK::SoundEngine::SetPosition(gameObjectID, position);
+}
+
+void WwiseAudioBackend::RegisterGameObject(AkGameObjectID gameObjectID)
+{
+	AK::SoundEngine::RegisterGameObj(gameObjectID);
+	AK::SoundEngine::SetDefaultListeners(&gameObjectID, 1);
+}
+
+#endif // AUDIO_HAS_WWISE
@@ -0,0 +1,93 @@
+#pragma once
+
+/*
+	Wwise implementation of AudioBackend, split out of Darren Reid's
+	Simple Audio Engine class.
+
+	version 1.1 for Wwise 2017.2.2.6553
+
+
+	add "C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\include" and
+	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\samples\SoundEngine\Win32"
+	and
+	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\samples\SoundEngine\Common"
+	to the include directories, and
+	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\Win32_vc140\Release(StaticCRT)\lib"
+	or
+	"C:\Audiokinetic\Wwise 2017.2.2.6553\SDK\Win32_vc140\Debug(StaticCRT)\lib"
+	to the libs path for 32 bit builds, or the appropriate 64 bit paths for 64 bit builds.
+
+	add the following cpps from the samples to the build:
+	AkDefaultIOHookBlocking.cpp
+	AkDefaultIOHookDeferred.cpp
+	AkDefaultLowLevelIODispatcher.cpp
+	AkFileLocationBase.cpp
+	AkFilePackage.cpp
+	AkFilePackageLUT.cpp
+
+	Make sure "Treat Wchar_t as Built-in Type" is set to Yes (/Zc:wchar_t)
+
+	On Linux, define AUDIO_USE_WWISE, put WwiseBaseFiles/POSIX and WwiseBaseFiles/Common
+	on the include path, and build AkMappedIOHookBlocking.cpp from WwiseBaseFiles/POSIX
+	instead of the two Win32 hooks. Files and packages are then read through mmap().
+	Define AUDIO_WWISE_THREAD_POOL_IO as well, and build AkThreadPoolIOHookDeferred.cpp
+	instead, to have a deferred device whose reads run on a pool of pread() workers.
+	CMakeLists.txt builds both hooks, with the Common sources they need, as WwiseLowLevelIOPosix.
+	*/
+
+#include "AudioBackend.h"
+
+#ifdef AUDIO_HAS_WWISE
+
+#include <AK/SoundEngine/Common/AkMemoryMgr.h>                  // Memory Manager
+#include <AK/SoundEngine/Common/AkModule.h>                     // Default memory and stream managers
+#include <AK/SoundEngine/Common/IAkStreamMgr.h>                 // Streaming Manager
+#include <AK/Tools/Common/AkPlatformFuncs.h>                    // Thread defines
+#ifdef _WIN32
+#include <AkFilePackageLowLevelIOBlocking.h>                    // Sample low-level I/O implementation
+typedef CAkFilePackageLowLevelIOBlocking WwiseLowLevelIO;
+#elif defined(AUDIO_WWISE_THREAD_POOL_IO)
+#include <AkFilePackageLowLevelIOThreadPool.h>                  // pread() worker pool low-level I/O, see WwiseBaseFiles/POSIX
+typedef CAkFilePackageLowLevelIOThreadPool WwiseLowLevelIO;
+#else
+#include <AkFilePackageLowLevelIOMapped.h>                      // mmap() based low-level I/O, see WwiseBaseFiles/POSIX
+typedef CAkFilePackageLowLevelIOMapped WwiseLowLevelIO;
+#endif
+#include <AK/SoundEngine/Common/AkSoundEngine.h>                // Sound engine
+
+//only needed if we use interactive music
+#include <AK/MusicEngine/Common/AkMusicEngine.h>                // Music Engine
+
+// Include for communication between Wwise and the game -- Not needed in the release version
+#ifndef AK_OPTIMIZED
+#include <AK/Comm/AkCommunication.h>
+#endif // AK_OPTIMIZED
+
+class WwiseAudioBackend : public AudioBackend
+{
+	// We're using the default Low-Level I/O implementation that's part
+	// of the SDK's sample code (the mapped one off Windows), with the file package extension
+	WwiseLowLevelIO g_lowLevelIO;
+	// Banks packed in here are loaded from memory instead of through g_lowLevelIO
+	const AssetArchive *archive;
+	std::string basePath;
+public:
+	WwiseAudioBackend();
+
+	bool Init();
+	void Term();
+	void RenderAudio();
+	void SetBasePath(const std::string &path);
+	void SetArchive(const AssetArchive *assets);
+	bool LoadBank(const std::string &bank);
+	bool LoadBankAsync(const std::string &bank, AudioBankCallback callback, void *cookie);
+
+	AkPlayingID PostEvent(AkUniqueID eventID, AkGameObjectID gameObjectID);
+	void ExecuteActionOnEvent(AudioCommandType action, AkUniqueID eventID, AkGameObjectID gameObjectID,
+		AkTimeMs transitionDuration, AkPlayingID playingID);
+	void SetRTPCValue(AkRtpcID rtpcID, AkRtpcValue value, AkGameObjectID gameObjectID);
+	void SetPosition(AkGameObjectID gameObjectID, float x, float y);
+	void RegisterGameObject(AkGameObjectID gameObjectID);
+};
+
+#endif // AUDIO_HAS_WWISE
@@ -0,0 +1,196 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageIndex.cpp
+//
+// Hashed index over the look-up tables of all loaded file packages.
+// See AkFilePackageIndex.h.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkFilePackageIndex.h"
+
+#include <new>
+
+#define AK_FILE_PACKAGE_INDEX_MIN_CAPACITY	(16)
+
+CAkFilePackageIndex::CAkFilePackageIndex()
+: m_pEntries( NULL )
+, m_uCapacity( 0 )
+, m_uShift( 64 )
+, m_uNumEntries( 0 )
+, m_bHasLanguage( false )
+{
+}
+
+CAkFilePackageIndex::~CAkFilePackageIndex()
+{
+	Term();
+}
+
+void CAkFilePackageIndex::Term()
+{
+	delete [] m_pEntries;
+	m_pEntries = NULL;
+	m_uCapacity = 0;
+	m_uShift = 64;
+	m_uNumEntries = 0;
+	m_bHasLanguage = false;
+}
+
+// Builds the index over all packages of in_packages, which are in search order
+// (newest first).
+AKRESULT CAkFilePackageIndex::Build(
+	ListFilePackages &	in_packages		// Loaded packages.
+	)
+{
+	// Language-specific keys are only needed if they can differ from language-agnostic ones.
+	bool bHasLanguage = false;
+	ListFilePackages::Iterator it = in_packages.Begin();
+	while ( it != in_packages.End() )
+	{
+		if ( (*it)->lut.GetCurLanguageID() != CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID )
+			bHasLanguage = true;
+		++it;
+	}
+	m_bHasLanguage = bHasLanguage;
+
+	// Size the table for the worst case, where no key is shared between packages,
+	// at a load factor of 1/2 at most.
+	AkUInt32 uNumCandidates = AddPackages( in_packages, false );
+
+	AkUInt32 uCapacity = AK_FILE_PACKAGE_INDEX_MIN_CAPACITY;
+	AkUInt32 uShift = 64 - 4;
+	while ( uCapacity < 2 * uNumCandidates )
+	{
+		uCapacity <<= 1;
+		--uShift;
+	}
+
+	// Reuse the table if it has the right size already.
+	if ( uCapacity != m_uCapacity )
+	{
+		Term();
+		m_pEntries = new (std::nothrow) Entry[ uCapacity ];
+		if ( !m_pEntries )
+			return AK_InsufficientMemory;
+		m_bHasLanguage = bHasLanguage;	// Reset by Term().
+		m_uCapacity = uCapacity;
+		m_uShift = uShift;
+	}
+
+	for ( AkUInt32 uSlot = 0; uSlot < m_uCapacity; ++uSlot )
+		m_pEntries[ uSlot ].uKey = 0;
+	m_uNumEntries = 0;
+
+	AddPackages( in_packages, true );
+	return AK_Success;
+}
+
+// Walks all tables of all packages, counting candidate keys or inserting them.
+AkUInt32 CAkFilePackageIndex::AddPackages(
+	ListFilePackages &	in_packages,
+	bool				in_bInsert
+	)
+{
+	AkUInt32 uNumCandidates = 0;
+
+	ListFilePackages::Iterator it = in_packages.Begin();
+	while ( it != in_packages.End() )
+	{
+		CAkFilePackage * pPackage = (*it);
+		const CAkFilePackageLUT & lut = pPackage->lut;
+		AkUInt32 uNumFiles;
+
+		// Soundbanks are looked up in the streamed files LUT when a package has no soundbank LUT.
+		const CAkFilePackageLUT::AkFileEntry<AkFileID> * pBanks = lut.GetSoundBanks( uNumFiles );
+		if ( !pBanks )
+			pBanks = lut.GetStmFiles( uNumFiles );
+		uNumCandidates += AddTable( pPackage, pBanks, uNumFiles, Table_SoundBanks, in_bInsert );
+
+		const CAkFilePackageLUT::AkFileEntry<AkFileID> * pStmFiles = lut.GetStmFiles( uNumFiles );
+		uNumCandidates += AddTable( pPackage, pStmFiles, uNumFiles, Table_StmFiles, in_bInsert );
+
+		const CAkFilePackageLUT::AkFileEntry<AkUInt64> * pExternals = lut.GetExternals( uNumFiles );
+		uNumCandidates += AddTable( pPackage, pExternals, uNumFiles, Table_Externals, in_bInsert );
+
+		++it;
+	}
+
+	return uNumCandidates;
+}
+
+// Adds the entries of one LUT table that are reachable with the package's current language.
+template <class T_FILEID>
+AkUInt32 CAkFilePackageIndex::AddTable(
+	CAkFilePackage *	in_pPackage,	// Package that owns the table.
+	const CAkFilePackageLUT::AkFileEntry<T_FILEID> * in_pEntries,	// Table entries, can be NULL.
+	AkUInt32			in_uNumFiles,	// Number of entries.
+	Table				in_eTable,		// Table the entries are indexed under.
+	bool				in_bInsert		// False: only count candidate keys.
+	)
+{
+	AkUInt16 uCurLangID = in_pPackage->lut.GetCurLanguageID();
+	AkUInt32 uNumCandidates = 0;
+
+	for ( AkUInt32 uFile = 0; uFile < in_uNumFiles; ++uFile )
+	{
+		const CAkFilePackageLUT::AkFileEntry<T_FILEID> & entry = in_pEntries[ uFile ];
+
+		// Language-agnostic look-ups match language ID 0, language-specific look-ups
+		// match the current language (which is also 0 if no language is set).
+		for ( AkUInt32 uSpecific = 0; uSpecific < ( m_bHasLanguage ? 2u : 1u ); ++uSpecific )
+		{
+			AkUInt16 uLangID = uSpecific ? uCurLangID : CAkFilePackageLUT::AK_INVALID_LANGUAGE_ID;
+			if ( entry.uLanguageID != uLangID )
+				continue;
+
+			++uNumCandidates;
+			if ( in_bInsert )
+			{
+				Insert(
+					entry.fileID,
+					MakeKey( in_eTable, uSpecific != 0 ),
+					in_pPackage,
+					entry.uBlockSize,
+					entry.uFileSize,
+					entry.uStartBlock );
+			}
+		}
+	}
+
+	return uNumCandidates;
+}
+
+// Inserts an entry unless its key is already present (first package wins).
+void CAkFilePackageIndex::Insert(
+	AkUInt64			in_fileID,
+	AkUInt32			in_uKey,
+	CAkFilePackage *	in_pPackage,
+	AkUInt32			in_uBlockSize,
+	AkUInt32			in_uFileSize,
+	AkUInt32			in_uStartBlock
+	)
+{
+	AkUInt32 uSlot = Slot( in_fileID, in_uKey );
+	for ( ;; )
+	{
+		Entry & entry = m_pEntries[ uSlot ];
+		if ( entry.uKey == 0 )
+			break;
+		if ( entry.uKey == in_uKey && entry.fileID == in_fileID )
+			return;	// Already provided by a newer package.
+		uSlot = ( uSlot + 1 ) & ( m_uCapacity - 1 );
+	}
+
+	AKASSERT( 2 * ( m_uNumEntries + 1 ) <= m_uCapacity );
+
+	Entry & entry = m_pEntries[ uSlot ];
+	entry.fileID		= in_fileID;
+	entry.pPackage		= in_pPackage;
+	entry.uBlockSize	= in_uBlockSize;
+	entry.uFileSize		= in_uFileSize;
+	entry.uStartBlock	= in_uStartBlock;
+	entry.uKey			= in_uKey;
+	++m_uNumEntries;
+}
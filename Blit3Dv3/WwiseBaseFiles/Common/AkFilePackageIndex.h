@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageIndex.h
+//
+// Hashed index over the look-up tables of all loaded file packages.
+//
+// Without it, CAkFilePackageLowLevelIO::Open() walks the packages from
+// the newest to the oldest and binary searches the LUT of each one, so
+// the cost of an open grows with both the number of packages and the
+// number of files they hold. The index is built once, when packages are
+// loaded or unloaded or when the language changes, and maps a key
+// (file ID, table, language-specific) straight to the entry that the
+// walk would have found: the one of the newest package that has it.
+// Look-ups are then O(1) whatever the number of packages.
+//
+// The table uses open addressing with linear probing. Its capacity is a
+// power of two at least twice the number of keys inserted, so probe
+// sequences stay short and always end on an empty slot.
+//
+// A package contributes, for each table:
+// - its language-agnostic entries (language ID 0), for look-ups that
+//   are not language-specific;
+// - its entries for its current language, for look-ups that are.
+// Entries of other languages are left out, they cannot be reached until
+// the language changes, at which point the index is rebuilt. When no
+// package has a current language (SFX-only packages, or no language
+// set), both kinds of look-ups find the same entries, so only the
+// language-agnostic keys are stored.
+//
+// If the index cannot be allocated it stays invalid, and the owner falls
+// back on the walk with binary search (see AkFilePackageLowLevelIO.inl).
+// When AK_FILE_PACKAGE_INDEX_VERIFY is non-zero (by default in _DEBUG),
+// every indexed look-up is checked against that walk.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_FILE_PACKAGE_INDEX_H_
+#define _AK_FILE_PACKAGE_INDEX_H_
+
+#include "AkFilePackage.h"
+
+#ifndef AK_FILE_PACKAGE_INDEX_VERIFY
+#ifdef _DEBUG
+#define AK_FILE_PACKAGE_INDEX_VERIFY	1
+#else
+#define AK_FILE_PACKAGE_INDEX_VERIFY	0
+#endif
+#endif
+
+//-----------------------------------------------------------------------------
+// Name: class CAkFilePackageIndex.
+// Desc: Maps (file ID, table, language-specific) to the location of a file
+//		 in the newest loaded package that contains it.
+//-----------------------------------------------------------------------------
+class CAkFilePackageIndex
+{
+public:
+
+	// LUT a look-up is answered from, following CAkFilePackageLUT::LookupFile().
+	enum Table
+	{
+		Table_SoundBanks = 0,	// AK soundbanks (the streamed files LUT if a package has no soundbank LUT).
+		Table_StmFiles,			// Other AK files: streamed audio.
+		Table_Externals			// External sources (64-bit IDs).
+	};
+
+	// Location of an indexed file.
+	struct Entry
+	{
+		AkUInt64			fileID;		// File ID (32-bit IDs are zero-extended).
+		CAkFilePackage *	pPackage;	// Package that contains the file.
+		AkUInt32			uBlockSize;	// See CAkFilePackageLUT::AkFileEntry.
+		AkUInt32			uFileSize;
+		AkUInt32			uStartBlock;
+		AkUInt32			uKey;		// Table and language flag, 0 for empty slots.
+	};
+
+	CAkFilePackageIndex();
+	~CAkFilePackageIndex();
+
+	// Builds the index over all packages of in_packages, which are in search order
+	// (newest first). Returns AK_InsufficientMemory if the table could not be
+	// allocated, in which case the index is left invalid.
+	AKRESULT Build(
+		ListFilePackages &	in_packages		// Loaded packages.
+		);
+
+	// Releases the table. The index is invalid until the next Build().
+	void Term();
+
+	// True if the index can answer look-ups. When false, search the packages' LUTs.
+	inline bool IsValid() const { return m_pEntries != NULL; }
+
+	// Finds a file. Returns NULL if no loaded package contains it.
+	// The index must be valid.
+	inline const Entry * Find(
+		AkUInt64			in_fileID,				// File ID.
+		Table				in_eTable,				// LUT to search.
+		bool				in_bIsLanguageSpecific	// True: match the current language.
+		) const
+	{
+		AKASSERT( IsValid() );
+		AkUInt32 uKey = MakeKey( in_eTable, in_bIsLanguageSpecific && m_bHasLanguage );
+		AkUInt32 uSlot = Slot( in_fileID, uKey );
+		for ( ;; )
+		{
+			const Entry & entry = m_pEntries[ uSlot ];
+			if ( entry.uKey == 0 )
+				return NULL;
+			if ( entry.uKey == uKey && entry.fileID == in_fileID )
+				return &entry;
+			uSlot = ( uSlot + 1 ) & ( m_uCapacity - 1 );
+		}
+	}
+
+	// Returns the table to search for a file opened with the given flags.
+	static inline Table GetTable(
+		const AkFileSystemFlags * in_pFlags		// Special flags. Do not pass NULL.
+		)
+	{
+		AKASSERT( in_pFlags );
+		if ( in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC_EXTERNAL )
+			return Table_Externals;
+		return ( in_pFlags->uCodecID == AKCODECID_BANK ) ? Table_SoundBanks : Table_StmFiles;
+	}
+
+	// Statistics.
+	inline AkUInt32 GetNumEntries() const { return m_uNumEntries; }
+	inline AkUInt32 GetCapacity() const { return m_uCapacity; }
+	inline size_t GetMemorySize() const { return m_uCapacity * sizeof( Entry ); }
+
+private:
+
+	static inline AkUInt32 MakeKey( Table in_eTable, bool in_bIsLanguageSpecific )
+	{
+		return 1 + ( ( (AkUInt32)in_eTable << 1 ) | ( in_bIsLanguageSpecific ? 1 : 0 ) );
+	}
+
+	// Fibonacci hashing: the top bits of the product pick the slot.
+	inline AkUInt32 Slot( AkUInt64 in_fileID, AkUInt32 in_uKey ) const
+	{
+		AkUInt64 uHash = ( in_fileID ^ ( (AkUInt64)in_uKey << 59 ) ) * 0x9E3779B97F4A7C15ULL;
+		return (AkUInt32)( uHash >> m_uShift );
+	}
+
+	// Adds the entries of one LUT table that are reachable with the package's current language.
+	// Returns the number of keys that were candidates (whether or not they were inserted).
+	template <class T_FILEID>
+	AkUInt32 AddTable(
+		CAkFilePackage *	in_pPackage,	// Package that owns the table.
+		const CAkFilePackageLUT::AkFileEntry<T_FILEID> * in_pEntries,	// Table entries, can be NULL.
+		AkUInt32			in_uNumFiles,	// Number of entries.
+		Table				in_eTable,		// Table the entries are indexed under.
+		bool				in_bInsert		// False: only count candidate keys.
+		);
+
+	// Inserts an entry unless its key is already present (first package wins).
+	void Insert(
+		AkUInt64			in_fileID,
+		AkUInt32			in_uKey,
+		CAkFilePackage *	in_pPackage,
+		AkUInt32			in_uBlockSize,
+		AkUInt32			in_uFileSize,
+		AkUInt32			in_uStartBlock
+		);
+
+	// Walks all tables of all packages, counting candidate keys or inserting them.
+	AkUInt32 AddPackages(
+		ListFilePackages &	in_packages,
+		bool				in_bInsert
+		);
+
+	Entry *		m_pEntries;
+	AkUInt32	m_uCapacity;	// Power of two.
+	AkUInt32	m_uShift;		// 64 - log2( m_uCapacity ).
+	AkUInt32	m_uNumEntries;
+	bool		m_bHasLanguage;	// True if a package has a current language: language-specific keys are stored.
+};
+
+#endif //_AK_FILE_PACKAGE_INDEX_H_
@@ -99,16 +99,28 @@ public:
 		const AkOSChar*			in_pszLanguage		// Language string.
 		);
 
-	// Find a soundbank ID by its name (by hashing its name)
-	AkFileID GetSoundBankID( 
+	// Find a soundbank ID by its name (by hashing its name).
+	// Does not depend on the package: the ID is the same for all LUTs.
+	static AkFileID GetSoundBankID( 
 		const AkOSChar*			in_pszBankName		// Soundbank name.
 		);
 
-    // Return the id of an external file (by hashing its name in 64 bits)
-	AkUInt64 GetExternalID( 
+    // Return the id of an external file (by hashing its name in 64 bits).
+	// Does not depend on the package: the ID is the same for all LUTs.
+	static AkUInt64 GetExternalID( 
 		const AkOSChar*			in_pszExternalName		// External Source name.
 		);	
 
+	// Raw access to the LUTs, used to build indices that span several packages
+	// (see AkFilePackageIndex.h). Each returns the entries of a table, sorted by 
+	// file ID then by language ID, or NULL (and 0 files) if the table is absent or empty.
+	const AkFileEntry<AkFileID> * GetSoundBanks( AkUInt32 & out_uNumFiles ) const { return GetEntries( m_pSoundBanks, out_uNumFiles ); }
+	const AkFileEntry<AkFileID> * GetStmFiles( AkUInt32 & out_uNumFiles ) const { return GetEntries( m_pStmFiles, out_uNumFiles ); }
+	const AkFileEntry<AkUInt64> * GetExternals( AkUInt32 & out_uNumFiles ) const { return GetEntries( m_pExternals, out_uNumFiles ); }
+
+	// Language ID that language-specific look-ups currently match (set by SetCurLanguage()).
+	inline AkUInt16 GetCurLanguageID() const { return m_curLangID; }
+
 protected:
 	static void RemoveFileExtension( AkOSChar* in_pstring );
 	static void _MakeLower( AkOSChar* in_pString );
@@ -132,6 +144,22 @@ protected:
 		AkUInt32		m_uNumFiles;
 	};
 
+	// Helper: Get the entries of a LUT, NULL if it is absent or empty.
+	template <class T_FILEID>
+	static const AkFileEntry<T_FILEID> * GetEntries(
+		const FileLUT<T_FILEID> *	in_pLut,				// LUT.
+		AkUInt32 &					out_uNumFiles			// Returned number of entries.
+		)
+	{
+		if ( in_pLut && in_pLut->HasFiles() )
+		{
+			out_uNumFiles = in_pLut->NumFiles();
+			return in_pLut->FileEntries();
+		}
+		out_uNumFiles = 0;
+		return NULL;
+	}
+
 	// Helper: Find a file entry by ID.
 	template <class T_FILEID>
 	const AkFileEntry<T_FILEID> * LookupFile(
@@ -35,7 +35,10 @@ written agreement between you and Audiokinetic Inc.
 //
 // LoadFilePackage() returns a package ID that can be used to unload it. Any number
 // of packages can be loaded simultaneously. When Open() is called, the last package 
-// loaded is searched first, then the previous one, and so on.
+// loaded is searched first, then the previous one, and so on. This search is answered
+// by a hashed index over all loaded LUTs (see AkFilePackageIndex.h), rebuilt whenever
+// packages are loaded or unloaded and when the language changes, so that its cost does
+// not depend on the number of packages.
 //
 // The language ID was created dynamically when the package was created. The header 
 // also contains a map of language names (strings) to their ID, so that the proper 
@@ -53,6 +56,7 @@ written agreement between you and Audiokinetic Inc.
 
 #include <AK/SoundEngine/Common/AkStreamMgrModule.h>
 #include "AkFilePackage.h"
+#include "AkFilePackageIndex.h"
 
 //-----------------------------------------------------------------------------
 // Name: AkFilePackageReader 
@@ -398,6 +402,38 @@ protected:
 		AkFileDesc &		out_fileDesc	// Returned file descriptor.
 		);
 
+	// Searches all loaded packages for the file, newest first. Uses the index when it is 
+	// valid, otherwise searches the LUT of each package in turn.
+	// Returns AK_Success if the file is found.
+	template <class T_FILEID>
+	AKRESULT FindFileInPackages( 
+		T_FILEID			in_fileID,		// File ID.
+		AkFileSystemFlags * in_pFlags,		// Special flags. Do not pass NULL.
+		AkFileDesc &		out_fileDesc	// Returned file descriptor.
+		);
+
+	// Searches the LUT of each loaded package in turn, newest first (binary search).
+	// Returns AK_Success if the file is found.
+	template <class T_FILEID>
+	AKRESULT FindFileInLUTs( 
+		T_FILEID			in_fileID,		// File ID.
+		AkFileSystemFlags * in_pFlags,		// Special flags. Do not pass NULL.
+		AkFileDesc &		out_fileDesc	// Returned file descriptor.
+		);
+
+	// Fills a file descriptor for a file that is part of in_pPackage.
+	void FillPackagedFileDesc( 
+		T_PACKAGE *			in_pPackage,	// Package that contains the file.
+		AkUInt32			in_uBlockSize,	// File's block size (see CAkFilePackageLUT::AkFileEntry).
+		AkUInt32			in_uFileSize,	// File's size.
+		AkUInt32			in_uStartBlock,	// File's start block.
+		AkFileDesc &		out_fileDesc	// Returned file descriptor.
+		);
+
+	// Rebuilds the index after the set of packages or their language changed.
+	// If the index cannot be built, look-ups fall back on searching each LUT.
+	void RebuildIndex();
+
 	virtual void InitFileDesc( T_PACKAGE * /*in_pPackage*/, AkFileDesc & /*io_fileDesc*/){};
 	
 	// Returns true if file described by in_fileDesc is in a package.
@@ -411,6 +447,7 @@ protected:
 protected:
 	// List of loaded packages.
 	ListFilePackages	m_packages;
+	CAkFilePackageIndex	m_index;	// Index over the LUTs of m_packages.
 	bool				m_bRegisteredToLangChg;	// True after registering to language change notifications.
 };
 
@@ -69,6 +69,7 @@ void CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::Term()
 {
     UnloadAllFilePackages();
 	m_packages.Term();
+	m_index.Term();
 	if ( m_bRegisteredToLangChg )
 		AK::StreamMgr::RemoveLanguageChangeObserver( this );
 	T_LLIOHOOK_FILELOC::Term();
@@ -92,37 +93,32 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::Open(
 		if( in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC 
 			&& in_pFlags->uCodecID == AKCODECID_BANK )
 		{
-			// Search file in each package.
-			ListFilePackages::Iterator it = m_packages.Begin();
-			while ( it != m_packages.End() )
+			// Search file in all packages.
+			if ( !m_packages.IsEmpty() )
 			{
-				AkFileID fileID = (*it)->lut.GetSoundBankID( in_pszFileName );
+				AkFileID fileID = CAkFilePackageLUT::GetSoundBankID( in_pszFileName );
 
-				if ( FindPackagedFile( (T_PACKAGE*)(*it), fileID, in_pFlags, out_fileDesc ) == AK_Success )
+				if ( FindFileInPackages( fileID, in_pFlags, out_fileDesc ) == AK_Success )
 				{
 					// Found the ID in the lut. 
 					io_bSyncOpen = true;	// File is opened, now.
 					return AK_Success;
 				}
-				++it;
 			}
 		}
 		else if ( in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC_EXTERNAL )
 		{
-			// Search file in each package.
-			ListFilePackages::Iterator it = m_packages.Begin();
-			while ( it != m_packages.End() )
+			// Search file in all packages.
+			if ( !m_packages.IsEmpty() )
 			{
-				AkUInt64 fileID = (*it)->lut.GetExternalID( in_pszFileName );
+				AkUInt64 fileID = CAkFilePackageLUT::GetExternalID( in_pszFileName );
 
-				if ( FindPackagedFile( (T_PACKAGE*)(*it), fileID, in_pFlags, out_fileDesc ) == AK_Success )
+				if ( FindFileInPackages( fileID, in_pFlags, out_fileDesc ) == AK_Success )
 				{
 					// Found the ID in the lut. 
 					io_bSyncOpen = true;	// File is opened, now.
 					return AK_Success;
 				}
-
-				++it;
 			}
 		}
 	}
@@ -152,37 +148,29 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::Open(
 		&& in_pFlags 
 		&& in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC)
 	{
-		// Search file in each package.
-		ListFilePackages::Iterator it = m_packages.Begin();
-		while ( it != m_packages.End() )
+		// Search file in all packages.
+		if ( FindFileInPackages( in_fileID, in_pFlags, out_fileDesc ) == AK_Success )
 		{
-			if ( FindPackagedFile( (T_PACKAGE*)(*it), in_fileID, in_pFlags, out_fileDesc ) == AK_Success )
-			{
-				// File found. Return now.
-				io_bSyncOpen = true;	// File is opened, now.
-				return AK_Success;
-			}
-			++it;
+			// File found. Return now.
+			io_bSyncOpen = true;	// File is opened, now.
+			return AK_Success;
 		}
 	}
 	else if ( in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC_EXTERNAL )
 	{
-		// Search file in each package.
-		ListFilePackages::Iterator it = m_packages.Begin();
-		while ( it != m_packages.End() )
+		// Search file in all packages.
+		if ( !m_packages.IsEmpty() )
 		{	
 			AkOSChar szFileName[20];
 			AK_OSPRINTF(szFileName, 20, AKTEXT("%u.wem"), (unsigned int)in_fileID);
-			AkUInt64 fileID = (*it)->lut.GetExternalID(szFileName);
+			AkUInt64 fileID = CAkFilePackageLUT::GetExternalID(szFileName);
 
-			if ( FindPackagedFile( (T_PACKAGE*)(*it), fileID, in_pFlags, out_fileDesc ) == AK_Success )
+			if ( FindFileInPackages( fileID, in_pFlags, out_fileDesc ) == AK_Success )
 			{
 				// Found the ID in the lut. 
 				io_bSyncOpen = true;	// File is opened, now.
 				return AK_Success;
 			}
-
-			++it;
 		}
 	}
 
@@ -237,6 +225,9 @@ void CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::OnLanguageChange(
 		(*it)->lut.SetCurLanguage( in_pLanguageName );
 		++it;
 	}
+
+	// Language-specific entries of the index are those of the previous language.
+	RebuildIndex();
 }
 
 // Searches the LUT to find the file data associated with the FileID.
@@ -255,24 +246,114 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::FindPackagedFil
 
 	if ( pEntry )
 	{
-		// Fill file descriptor.
-        out_fileDesc.deviceID   = T_LLIOHOOK_FILELOC::m_deviceID;
-        in_pPackage->GetHandleForFileDesc( out_fileDesc.hFile );
-        out_fileDesc.iFileSize	= pEntry->uFileSize;
-        out_fileDesc.uSector	= pEntry->uStartBlock;
-		out_fileDesc.pCustomParam = NULL;
-		// NOTE: We use the uCustomParamSize to store the block size.
-		// We will determine whether this file was opened from a package by comparing 
-		// uCustomParamSize with 0 (see IsInPackage()).
-        out_fileDesc.uCustomParamSize = pEntry->uBlockSize;
-
-		// Deal with custom parameters in derived classes.
-		InitFileDesc(in_pPackage, out_fileDesc);
+		FillPackagedFileDesc( in_pPackage, pEntry->uBlockSize, pEntry->uFileSize, pEntry->uStartBlock, out_fileDesc );
         return AK_Success;
     }
     return AK_FileNotFound;
 }
 
+// Searches all loaded packages for the file, newest first. Uses the index when it is 
+// valid, otherwise searches the LUT of each package in turn.
+// Returns AK_Success if the file is found.
+template <class T_LLIOHOOK_FILELOC, class T_PACKAGE> 
+template <class T_FILEID>
+AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::FindFileInPackages( 
+    T_FILEID			in_fileID,		// File ID.
+    AkFileSystemFlags * in_pFlags,		// Special flags. Do not pass NULL.
+    AkFileDesc &		out_fileDesc	// Returned file descriptor.
+    )
+{
+	AKASSERT( in_pFlags );
+
+	if ( !m_index.IsValid() )
+		return FindFileInLUTs( in_fileID, in_pFlags, out_fileDesc );
+
+	const CAkFilePackageIndex::Entry * pEntry = m_index.Find( 
+		in_fileID, 
+		CAkFilePackageIndex::GetTable( in_pFlags ), 
+		in_pFlags->bIsLanguageSpecific );
+
+#if AK_FILE_PACKAGE_INDEX_VERIFY
+	// The index must agree with the search of each LUT.
+	{
+		AkFileDesc fileDescLUT;
+		AKRESULT eResultLUT = FindFileInLUTs( in_fileID, in_pFlags, fileDescLUT );
+		AKASSERT( ( eResultLUT == AK_Success ) == ( pEntry != NULL ) );
+		if ( pEntry && eResultLUT == AK_Success )
+		{
+			AkFileHandle hPackageFile;
+			((T_PACKAGE*)pEntry->pPackage)->GetHandleForFileDesc( hPackageFile );
+			AKASSERT( ( fileDescLUT.hFile == hPackageFile
+				&& fileDescLUT.uSector == pEntry->uStartBlock
+				&& fileDescLUT.iFileSize == (AkInt64)pEntry->uFileSize
+				&& fileDescLUT.uCustomParamSize == pEntry->uBlockSize )
+				|| !"File package index does not match LUTs" );
+		}
+	}
+#endif
+
+	if ( !pEntry )
+		return AK_FileNotFound;
+
+	FillPackagedFileDesc( (T_PACKAGE*)pEntry->pPackage, pEntry->uBlockSize, pEntry->uFileSize, pEntry->uStartBlock, out_fileDesc );
+	return AK_Success;
+}
+
+// Searches the LUT of each loaded package in turn, newest first (binary search).
+// Returns AK_Success if the file is found.
+template <class T_LLIOHOOK_FILELOC, class T_PACKAGE> 
+template <class T_FILEID>
+AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::FindFileInLUTs( 
+    T_FILEID			in_fileID,		// File ID.
+    AkFileSystemFlags * in_pFlags,		// Special flags. Do not pass NULL.
+    AkFileDesc &		out_fileDesc	// Returned file descriptor.
+    )
+{
+	ListFilePackages::Iterator it = m_packages.Begin();
+	while ( it != m_packages.End() )
+	{
+		if ( FindPackagedFile( (T_PACKAGE*)(*it), in_fileID, in_pFlags, out_fileDesc ) == AK_Success )
+			return AK_Success;
+		++it;
+	}
+	return AK_FileNotFound;
+}
+
+// Fills a file descriptor for a file that is part of in_pPackage.
+template <class T_LLIOHOOK_FILELOC, class T_PACKAGE>
+void CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::FillPackagedFileDesc( 
+	T_PACKAGE *			in_pPackage,	// Package that contains the file.
+	AkUInt32			in_uBlockSize,	// File's block size (see CAkFilePackageLUT::AkFileEntry).
+	AkUInt32			in_uFileSize,	// File's size.
+	AkUInt32			in_uStartBlock,	// File's start block.
+	AkFileDesc &		out_fileDesc	// Returned file descriptor.
+	)
+{
+    out_fileDesc.deviceID   = T_LLIOHOOK_FILELOC::m_deviceID;
+    in_pPackage->GetHandleForFileDesc( out_fileDesc.hFile );
+    out_fileDesc.iFileSize	= in_uFileSize;
+    out_fileDesc.uSector	= in_uStartBlock;
+	out_fileDesc.pCustomParam = NULL;
+	// NOTE: We use the uCustomParamSize to store the block size.
+	// We will determine whether this file was opened from a package by comparing 
+	// uCustomParamSize with 0 (see IsInPackage()).
+    out_fileDesc.uCustomParamSize = in_uBlockSize;
+
+	// Deal with custom parameters in derived classes.
+	InitFileDesc(in_pPackage, out_fileDesc);
+}
+
+// Rebuilds the index after the set of packages or their language changed.
+template <class T_LLIOHOOK_FILELOC, class T_PACKAGE>
+void CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::RebuildIndex()
+{
+	if ( m_index.Build( m_packages ) != AK_Success )
+	{
+		// Not fatal: Open() searches each LUT instead.
+		m_index.Term();
+	}
+}
+
 // File package loading:
 // Opens a package file, parses its header, fills LUT.
 // Overrides of Open() will search files in loaded LUTs first, then use default Low-Level I/O 
@@ -304,6 +385,7 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::LoadFilePackage
 		AKASSERT( pPackage );
 		// Add to packages list.
 		m_packages.AddFirst( pPackage );
+		RebuildIndex();
 		
 		out_uPackageID = pPackage->ID();
 	}
@@ -452,6 +534,7 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::UnloadFilePacka
 
 			// Destroy package.
 			pPackage->Destroy();
+			RebuildIndex();
 
 			return AK_Success;
 		}
@@ -476,6 +559,7 @@ AKRESULT CAkFilePackageLowLevelIO<T_LLIOHOOK_FILELOC,T_PACKAGE>::UnloadAllFilePa
 		// Destroy package.
 		pPackage->Destroy();
 	}
+	RebuildIndex();
 
 	return AK_Success;
 }
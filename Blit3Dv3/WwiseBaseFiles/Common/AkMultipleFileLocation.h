@@ -21,6 +21,21 @@ written agreement between you and Audiokinetic Inc.
 // "Going Further > Overriding Managers > Streaming / Stream Manager > Low-Level I/O"
 // of the SDK documentation. 
 //
+// Opening a file in read mode probes each location in turn, so a file
+// of the oldest location costs a failed open per newer location, every
+// time it is opened. The location each file was found in (or the fact
+// that it was found in none) is therefore remembered in a small cache,
+// keyed by file name and language-specific flag, and the next opens of
+// that file go straight to it. A failed open is only remembered when
+// every location reported the file as not found, not for errors that may
+// pass, like a sharing violation. Files opened by ID are cached under the
+// name they resolve to. The cache is flushed when a base path is added
+// and when the current language changes, as both change what a name
+// resolves to. Files that appear on disk or move after they were looked
+// up are not noticed: call InvalidateCache() after changing the content
+// of the base paths. Opens in other modes may create the file, they are
+// not cached.
+//
 //////////////////////////////////////////////////////////////////////
 
 #ifndef _AK_MULTI_FILE_LOCATION_H_
@@ -31,6 +46,27 @@ struct AkFileSystemFlags;
 #include <AK/SoundEngine/Common/IAkStreamMgr.h>
 #include <AK/SoundEngine/Common/AkStreamMgrModule.h>
 #include <AK/Tools/Common/AkListBareLight.h>
+#include <AK/Tools/Common/AkLock.h>
+
+// Number of entries of the resolved location cache. Must be a power of two.
+#ifndef AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE
+#define AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE		(128)
+#endif
+
+// Longest file name (in characters) that is cached. Longer names are always probed.
+#ifndef AK_MULTIPLE_FILE_LOCATION_CACHE_MAX_NAME
+#define AK_MULTIPLE_FILE_LOCATION_CACHE_MAX_NAME	(47)
+#endif
+
+// Statistics of the resolved location cache, see CAkMultipleFileLocation::GetCacheStats().
+struct AkFileLocationCacheStats
+{
+	AkUInt32	uHits;				// Opens that went straight to the cached location.
+	AkUInt32	uNegativeHits;		// Opens that failed without probing, the file being in no location.
+	AkUInt32	uMisses;			// Opens that probed the locations.
+	AkUInt32	uProbesSaved;		// Failed opens avoided by hits and negative hits.
+	AkUInt32	uInvalidations;
+};
 
 
 // This file location class supports multiple base paths for Wwise file access.
@@ -46,10 +82,32 @@ protected:
 		FilePath *pNextLightItem;
 		AkOSChar szPath[1];	//Variable length
 	};
+
+	// Resolved location of a file name.
+	struct CacheEntry
+	{
+		AkUInt32	uHash;			// Hash of the name and flag, 0 for free entries.
+		FilePath *	pLocation;		// Location the file was found in, NULL if none.
+		AkUInt32	uNumProbes;		// Opens it took to find it, or to find it in none.
+		bool		bIsLanguageSpecific;
+		AkOSChar	szName[AK_MULTIPLE_FILE_LOCATION_CACHE_MAX_NAME + 1];
+	};
 public:
 	CAkMultipleFileLocation();
 	void Term();
 
+	//
+	// Resolved location cache.
+	// ------------------------------------------------------
+
+	// Forgets all resolved locations. Call it if files were added to, moved between or
+	// removed from the base paths.
+	void InvalidateCache();
+
+	void GetCacheStats(
+		AkFileLocationCacheStats & out_stats	// Returned statistics.
+		);
+
 	//
 	// Global path functions.
 	// ------------------------------------------------------
@@ -99,7 +157,52 @@ public:
 
 protected:
 
+	// Probes the locations, newest first. Returns the location the file was opened from
+	// in out_pLocation, or NULL. AK_FileNotFound only if no location has the file,
+	// AK_Fail if any of them failed otherwise.
+	AKRESULT OpenInLocations(
+		const AkOSChar* in_pszFileName,     // File name.
+		AkOpenMode      in_eOpenMode,       // Open mode.
+		AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+		bool			in_bOverlapped,		// Overlapped IO open
+		AkFileDesc &    out_fileDesc,       // Returned file descriptor.
+		FilePath *&		out_pLocation,		// Returned location.
+		AkUInt32 &		out_uNumProbes		// Returned number of locations tried.
+		);
+
+	// Opens the file from one location.
+	AKRESULT OpenInLocation(
+		const AkOSChar* in_pszFileName,     // File name.
+		AkOpenMode      in_eOpenMode,       // Open mode.
+		AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+		bool			in_bOverlapped,		// Overlapped IO open
+		AkFileDesc &    out_fileDesc,       // Returned file descriptor.
+		FilePath *		in_pLocation		// Location.
+		);
+
+	// Cache look-up and insertion. Call with m_cacheLock held.
+	static AkUInt32 HashName( const AkOSChar * in_pszFileName, bool in_bIsLanguageSpecific );
+	CacheEntry * FindInCache( const AkOSChar * in_pszFileName, bool in_bIsLanguageSpecific, AkUInt32 in_uHash );
+	void AddToCache( const AkOSChar * in_pszFileName, bool in_bIsLanguageSpecific, AkUInt32 in_uHash, FilePath * in_pLocation, AkUInt32 in_uNumProbes );
+
+	// Handler for global language change: resolved language-specific paths are stale.
+	static AK_FUNC( void, LanguageChangeHandler )( 
+		const AkOSChar * const in_pLanguageName,// New language name.
+		void * in_pCookie						// Cookie that was passed to AddLanguageChangeObserver().
+		)
+	{
+		((CAkMultipleFileLocation<OPEN_POLICY>*)in_pCookie)->InvalidateCache();
+	}
+
 	AkListBareLight<FilePath> m_Locations;
+
+	// Resolved location cache. Open() is called from the Stream Manager's clients' threads,
+	// InvalidateCache() from the thread that changes the language.
+	CAkLock				m_cacheLock;
+	CacheEntry *		m_pCache;				// AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE entries, allocated with the first base path.
+	AkUInt32			m_uCacheGeneration;		// Incremented by each invalidation.
+	AkFileLocationCacheStats m_cacheStats;
+	bool				m_bRegisteredToLangChg;
 };
 
 #include "AkMultipleFileLocation.inl"
@@ -32,8 +32,10 @@ written agreement between you and Audiokinetic Inc.
 #include <wchar.h>
 #endif //AK_SUPPORT_WCHAR
 #include <stdio.h>
+#include <string.h>
 #include <AK/Tools/Common/AkAssert.h>
 #include <AK/Tools/Common/AkObject.h>
+#include <AK/Tools/Common/AkAutoLock.h>
 
 #include "AkFileHelpers.h"
 
@@ -42,15 +44,37 @@ written agreement between you and Audiokinetic Inc.
 #define ID_TO_STRING_FORMAT_WEM     AKTEXT("%u.wem")
 #define MAX_EXTENSION_SIZE          (4)     // .xxx
 #define MAX_FILETITLE_SIZE          (MAX_NUMBER_STRING_SIZE+MAX_EXTENSION_SIZE+1)   // null-terminated
+#define CACHE_MAX_PROBES            (4)     // Entries tried from the home entry of a name.
 
 template<class OPEN_POLICY>
 CAkMultipleFileLocation<OPEN_POLICY>::CAkMultipleFileLocation()
+: m_pCache( NULL )
+, m_uCacheGeneration( 0 )
+, m_bRegisteredToLangChg( false )
 {
+	AKASSERT( ( AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE & ( AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE - 1 ) ) == 0 );
+	memset( &m_cacheStats, 0, sizeof( m_cacheStats ) );
 }
 
 template<class OPEN_POLICY>
 void CAkMultipleFileLocation<OPEN_POLICY>::Term()
 {
+	if ( m_bRegisteredToLangChg )
+	{
+		AK::StreamMgr::RemoveLanguageChangeObserver( this );
+		m_bRegisteredToLangChg = false;
+	}
+
+	{
+		AkAutoLock<CAkLock> lock( m_cacheLock );
+		if ( m_pCache )
+		{
+			AkFree( AK::StreamMgr::GetPoolID(), m_pCache );
+			m_pCache = NULL;
+		}
+		++m_uCacheGeneration;
+	}
+
 	if (!m_Locations.IsEmpty())
 	{
 		FilePath *p = (*m_Locations.Begin());
@@ -73,23 +97,203 @@ AKRESULT CAkMultipleFileLocation<OPEN_POLICY>::Open(
 										AkFileDesc &    out_fileDesc        // Returned file descriptor.
 										)
 {	
+	FilePath * pLocation;
+	AkUInt32 uNumProbes;
+
+	// Only reads are cached: other modes may create the file in the newest location.
+	if ( in_eOpenMode != AK_OpenModeRead 
+		|| !in_pszFileName
+		|| AKPLATFORM::OsStrLen( in_pszFileName ) > AK_MULTIPLE_FILE_LOCATION_CACHE_MAX_NAME )
+	{
+		return OpenInLocations( in_pszFileName, in_eOpenMode, in_pFlags, in_bOverlapped, out_fileDesc, pLocation, uNumProbes );
+	}
+
+	// The language directory is only part of the path of language-specific files.
+	bool bIsLanguageSpecific = in_pFlags && in_pFlags->bIsLanguageSpecific;
+	AkUInt32 uHash = HashName( in_pszFileName, bIsLanguageSpecific );
+	AkUInt32 uGeneration;
+	{
+		AkAutoLock<CAkLock> lock( m_cacheLock );
+		if ( !m_pCache )
+			return OpenInLocations( in_pszFileName, in_eOpenMode, in_pFlags, in_bOverlapped, out_fileDesc, pLocation, uNumProbes );
+
+		CacheEntry * pEntry = FindInCache( in_pszFileName, bIsLanguageSpecific, uHash );
+		if ( pEntry && !pEntry->pLocation )
+		{
+			++m_cacheStats.uNegativeHits;
+			m_cacheStats.uProbesSaved += pEntry->uNumProbes;
+			return AK_FileNotFound;
+		}
+		pLocation = pEntry ? pEntry->pLocation : NULL;
+		uNumProbes = pEntry ? pEntry->uNumProbes : 0;
+		uGeneration = m_uCacheGeneration;
+	}
+
+	// Open outside the lock, opens of other files need not wait for this one.
+	if ( pLocation )
+	{
+		if ( OpenInLocation( in_pszFileName, in_eOpenMode, in_pFlags, in_bOverlapped, out_fileDesc, pLocation ) == AK_Success )
+		{
+			AkAutoLock<CAkLock> lock( m_cacheLock );
+			++m_cacheStats.uHits;
+			m_cacheStats.uProbesSaved += uNumProbes - 1;
+			return AK_Success;
+		}
+		// The file is gone from where it was found: probe again.
+	}
+
+	AKRESULT eResult = OpenInLocations( in_pszFileName, in_eOpenMode, in_pFlags, in_bOverlapped, out_fileDesc, pLocation, uNumProbes );
+
+	AkAutoLock<CAkLock> lock( m_cacheLock );
+	++m_cacheStats.uMisses;
+	// Do not cache what was resolved with locations or a language that changed meanwhile,
+	// nor failures other than the file being in no location (sharing violation, I/O error):
+	// those may be gone by the next open.
+	if ( m_pCache && uGeneration == m_uCacheGeneration
+		&& ( eResult == AK_Success || eResult == AK_FileNotFound ) )
+		AddToCache( in_pszFileName, bIsLanguageSpecific, uHash, pLocation, uNumProbes );
+	return eResult;
+}
+
+template<class OPEN_POLICY>
+AKRESULT CAkMultipleFileLocation<OPEN_POLICY>::OpenInLocations( 
+										const AkOSChar* in_pszFileName,     // File name.
+										AkOpenMode      in_eOpenMode,       // Open mode.
+										AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+										bool			in_bOverlapped,		// Overlapped IO open
+										AkFileDesc &    out_fileDesc,       // Returned file descriptor.
+										FilePath *&		out_pLocation,		// Returned location.
+										AkUInt32 &		out_uNumProbes		// Returned number of locations tried.
+										)
+{	
+	out_pLocation = NULL;
+	out_uNumProbes = 0;
+	AKRESULT eResult = AK_FileNotFound;
 	for(typename AkListBareLight<FilePath>::Iterator it = m_Locations.Begin(); it != m_Locations.End();++it)
 	{
-		// Get the full file path, using path concatenation logic.
-		AkOSChar szFullFilePath[AK_MAX_PATH];
-		if ( GetFullFilePath( in_pszFileName, in_pFlags, in_eOpenMode, szFullFilePath, (*it) ) == AK_Success )
+		++out_uNumProbes;
+		AKRESULT eOpenResult = OpenInLocation( in_pszFileName, in_eOpenMode, in_pFlags, in_bOverlapped, out_fileDesc, (*it) );
+		if ( eOpenResult == AK_Success )
 		{
-			AKRESULT res = OPEN_POLICY::Open(szFullFilePath, in_eOpenMode, in_bOverlapped, out_fileDesc);		
-			if (res == AK_Success)
-			{
-				//These must be set by the OpenPolicy
-				AKASSERT(out_fileDesc.hFile != NULL );
-				AKASSERT(out_fileDesc.iFileSize != 0 && (in_eOpenMode == AK_OpenModeRead || in_eOpenMode == AK_OpenModeReadWrite) || !(in_eOpenMode == AK_OpenModeRead || in_eOpenMode == AK_OpenModeReadWrite));
-				return AK_Success;
-			}			
+			out_pLocation = (*it);
+			return AK_Success;
 		}
+		if ( eOpenResult != AK_FileNotFound )
+			eResult = AK_Fail;
+	}
+	return eResult;    
+}
+
+template<class OPEN_POLICY>
+AKRESULT CAkMultipleFileLocation<OPEN_POLICY>::OpenInLocation( 
+										const AkOSChar* in_pszFileName,     // File name.
+										AkOpenMode      in_eOpenMode,       // Open mode.
+										AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+										bool			in_bOverlapped,		// Overlapped IO open
+										AkFileDesc &    out_fileDesc,       // Returned file descriptor.
+										FilePath *		in_pLocation		// Location.
+										)
+{	
+	// Get the full file path, using path concatenation logic.
+	AkOSChar szFullFilePath[AK_MAX_PATH];
+	if ( GetFullFilePath( in_pszFileName, in_pFlags, in_eOpenMode, szFullFilePath, in_pLocation ) != AK_Success )
+		return AK_Fail;
+
+	AKRESULT res = OPEN_POLICY::Open(szFullFilePath, in_eOpenMode, in_bOverlapped, out_fileDesc);		
+	if (res == AK_Success)
+	{
+		//These must be set by the OpenPolicy
+		AKASSERT(out_fileDesc.hFile != NULL );
+		AKASSERT((out_fileDesc.iFileSize != 0 && (in_eOpenMode == AK_OpenModeRead || in_eOpenMode == AK_OpenModeReadWrite)) || !(in_eOpenMode == AK_OpenModeRead || in_eOpenMode == AK_OpenModeReadWrite));
 	}
-	return AK_Fail;    
+	return res;
+}
+
+// FNV-1a over the characters of the name, then the flag. Never 0 (free entries).
+template<class OPEN_POLICY>
+AkUInt32 CAkMultipleFileLocation<OPEN_POLICY>::HashName( 
+	const AkOSChar *	in_pszFileName,
+	bool				in_bIsLanguageSpecific
+	)
+{
+	AkUInt32 uHash = 2166136261U;
+	for ( const AkOSChar * pChar = in_pszFileName; *pChar; ++pChar )
+	{
+		uHash ^= (AkUInt32)*pChar;
+		uHash *= 16777619U;
+	}
+	uHash ^= in_bIsLanguageSpecific ? 1 : 0;
+	uHash *= 16777619U;
+	return uHash ? uHash : 1;
+}
+
+template<class OPEN_POLICY>
+typename CAkMultipleFileLocation<OPEN_POLICY>::CacheEntry * CAkMultipleFileLocation<OPEN_POLICY>::FindInCache( 
+	const AkOSChar *	in_pszFileName,
+	bool				in_bIsLanguageSpecific,
+	AkUInt32			in_uHash
+	)
+{
+	// Entries are only freed all at once, so a free entry ends the search.
+	for ( AkUInt32 uProbe = 0; uProbe < CACHE_MAX_PROBES; ++uProbe )
+	{
+		CacheEntry & entry = m_pCache[ ( in_uHash + uProbe ) & ( AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE - 1 ) ];
+		if ( entry.uHash == 0 )
+			return NULL;
+		if ( entry.uHash == in_uHash 
+			&& entry.bIsLanguageSpecific == in_bIsLanguageSpecific
+			&& AKPLATFORM::OsStrCmp( entry.szName, in_pszFileName ) == 0 )
+		{
+			return &entry;
+		}
+	}
+	return NULL;
+}
+
+// Takes the first free entry in reach of the home entry, or replaces the home entry.
+template<class OPEN_POLICY>
+void CAkMultipleFileLocation<OPEN_POLICY>::AddToCache( 
+	const AkOSChar *	in_pszFileName,
+	bool				in_bIsLanguageSpecific,
+	AkUInt32			in_uHash,
+	FilePath *			in_pLocation,
+	AkUInt32			in_uNumProbes
+	)
+{
+	CacheEntry * pEntry = FindInCache( in_pszFileName, in_bIsLanguageSpecific, in_uHash );
+	for ( AkUInt32 uProbe = 0; !pEntry && uProbe < CACHE_MAX_PROBES; ++uProbe )
+	{
+		CacheEntry & entry = m_pCache[ ( in_uHash + uProbe ) & ( AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE - 1 ) ];
+		if ( entry.uHash == 0 )
+			pEntry = &entry;
+	}
+	if ( !pEntry )
+		pEntry = &m_pCache[ in_uHash & ( AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE - 1 ) ];
+
+	pEntry->uHash = in_uHash;
+	pEntry->pLocation = in_pLocation;
+	pEntry->uNumProbes = in_uNumProbes;
+	pEntry->bIsLanguageSpecific = in_bIsLanguageSpecific;
+	AKPLATFORM::SafeStrCpy( pEntry->szName, in_pszFileName, AK_MULTIPLE_FILE_LOCATION_CACHE_MAX_NAME + 1 );
+}
+
+template<class OPEN_POLICY>
+void CAkMultipleFileLocation<OPEN_POLICY>::InvalidateCache()
+{
+	AkAutoLock<CAkLock> lock( m_cacheLock );
+	if ( m_pCache )
+		memset( m_pCache, 0, AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE * sizeof( CacheEntry ) );
+	++m_uCacheGeneration;
+	++m_cacheStats.uInvalidations;
+}
+
+template<class OPEN_POLICY>
+void CAkMultipleFileLocation<OPEN_POLICY>::GetCacheStats(
+	AkFileLocationCacheStats & out_stats	// Returned statistics.
+	)
+{
+	AkAutoLock<CAkLock> lock( m_cacheLock );
+	out_stats = m_cacheStats;
 }
 
 template<class OPEN_POLICY>
@@ -210,8 +414,39 @@ AKRESULT CAkMultipleFileLocation<OPEN_POLICY>::AddBasePath(const AkOSChar* in_ps
 		pPath->szPath[origLen + 1] = 0;
 	}
 	pPath->pNextLightItem = NULL;
+
 	m_Locations.AddFirst(pPath);
 
+	// The new location comes first: names may now resolve to it.
+	InvalidateCache();
+	{
+		AkAutoLock<CAkLock> lock( m_cacheLock );
+		if ( !m_pCache )
+		{
+			// Without a cache, opens simply probe all locations.
+			m_pCache = (CacheEntry*)AkAlloc( AK::StreamMgr::GetPoolID(), AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE * sizeof( CacheEntry ) );
+			if ( m_pCache )
+				memset( m_pCache, 0, AK_MULTIPLE_FILE_LOCATION_CACHE_SIZE * sizeof( CacheEntry ) );
+		}
+	}
+
+	// Language-specific files resolve to another directory when the language changes.
+	if ( !m_bRegisteredToLangChg )
+	{
+		if ( AK::StreamMgr::AddLanguageChangeObserver( LanguageChangeHandler, this ) == AK_Success )
+			m_bRegisteredToLangChg = true;
+		else
+		{
+			// Cached language-specific paths could not be invalidated.
+			AkAutoLock<CAkLock> lock( m_cacheLock );
+			if ( m_pCache )
+			{
+				AkFree( AK::StreamMgr::GetPoolID(), m_pCache );
+				m_pCache = NULL;
+			}
+		}
+	}
+
 	AKRESULT eDirectoryResult = CAkFileHelpers::CheckDirectoryExists( in_pszBasePath );
 	if( eDirectoryResult == AK_Fail ) // AK_NotImplemented could be returned and should be ignored.
 	{
@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkFileHelpers.h
+//
+// Platform-specific helpers for files, POSIX version. Only what the
+// Common/ sources need: the mapped hook does its own open/mmap/close
+// (see AkMappedIOHookBlocking.cpp).
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_FILE_HELPERS_H_
+#define _AK_FILE_HELPERS_H_
+
+#include <AK/Tools/Common/AkAssert.h>
+#include <AK/SoundEngine/Common/IAkStreamMgr.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+class CAkFileHelpers
+{
+public:
+
+	static AKRESULT CheckDirectoryExists( const AkOSChar* in_pszBasePath )
+	{
+		struct stat dirStat;
+		if ( ::stat( in_pszBasePath, &dirStat ) != 0 )
+			return AK_Fail;  //something is wrong with your path!
+
+		if ( S_ISDIR( dirStat.st_mode ) )
+			return AK_Success;   // this is a directory!
+
+		return AK_Fail;
+	}
+};
+
+#endif //_AK_FILE_HELPERS_H_
@@ -0,0 +1,31 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageLowLevelIOMapped.h
+//
+// Extends the CAkMappedIOHookBlocking low level I/O hook with File
+// Package handling functionality. Each package is mapped once when it
+// is loaded, and the files it contains are copied straight out of that
+// mapping.
+//
+// See AkMappedIOHookBlocking.h for details on using the mapped
+// low level I/O hook.
+//
+// See AkFilePackageLowLevelIO.h for details on using file packages.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_FILE_PACKAGE_LOW_LEVEL_IO_MAPPED_H_
+#define _AK_FILE_PACKAGE_LOW_LEVEL_IO_MAPPED_H_
+
+#include "../Common/AkFilePackageLowLevelIO.h"
+#include "AkMappedIOHookBlocking.h"
+
+class CAkFilePackageLowLevelIOMapped
+	: public CAkFilePackageLowLevelIO<CAkMappedIOHookBlocking>
+{
+public:
+	CAkFilePackageLowLevelIOMapped() {}
+	virtual ~CAkFilePackageLowLevelIOMapped() {}
+};
+
+#endif //_AK_FILE_PACKAGE_LOW_LEVEL_IO_MAPPED_H_
@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkFilePackageLowLevelIOThreadPool.h
+//
+// Extends the CAkThreadPoolIOHookDeferred low level I/O hook with File
+// Package handling functionality.
+//
+// See AkThreadPoolIOHookDeferred.h for details on using the thread pool
+// low level I/O hook.
+//
+// See AkFilePackageLowLevelIO.h for details on using file packages.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_FILE_PACKAGE_LOW_LEVEL_IO_THREAD_POOL_H_
+#define _AK_FILE_PACKAGE_LOW_LEVEL_IO_THREAD_POOL_H_
+
+#include "../Common/AkFilePackageLowLevelIO.h"
+#include "AkThreadPoolIOHookDeferred.h"
+
+class CAkFilePackageLowLevelIOThreadPool
+	: public CAkFilePackageLowLevelIO<CAkThreadPoolIOHookDeferred>
+{
+public:
+	CAkFilePackageLowLevelIOThreadPool() {}
+	virtual ~CAkFilePackageLowLevelIOThreadPool() {}
+
+	// Override Cancel: packaged files share the package's handle, so cancelling all
+	// transfers of the handle would cancel those of other files. Cancel this one only.
+	virtual void Cancel(
+		AkFileDesc &			in_fileDesc,		// File descriptor.
+		AkAsyncIOTransferInfo & io_transferInfo,	// Transfer info to cancel.
+		bool & io_bCancelAllTransfersForThisFile	// Flag indicating whether all transfers should be cancelled for this file (see notes in function description).
+		)
+	{
+		if ( IsInPackage( in_fileDesc ) )
+			io_bCancelAllTransfersForThisFile = false;
+
+		CAkThreadPoolIOHookDeferred::Cancel(
+			in_fileDesc,		// File descriptor.
+			io_transferInfo,	// Transfer info to cancel.
+			io_bCancelAllTransfersForThisFile	// Flag indicating whether all transfers should be cancelled for this file (see notes in function description).
+			);
+	}
+};
+
+#endif //_AK_FILE_PACKAGE_LOW_LEVEL_IO_THREAD_POOL_H_
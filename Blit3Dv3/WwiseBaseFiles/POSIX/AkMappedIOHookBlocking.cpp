@@ -0,0 +1,416 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkMappedIOHookBlocking.cpp
+//
+// Blocking low level IO hook (AK::StreamMgr::IAkIOHookBlocking) and
+// file system (AK::StreamMgr::IAkFileLocationResolver) implementation
+// for POSIX systems, built on mmap() instead of read().
+// See AkMappedIOHookBlocking.h for details.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkMappedIOHookBlocking.h"
+#include <AK/Tools/Common/AkPlatformFuncs.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <new>
+
+
+#define POSIX_MAPPED_DEVICE_NAME		(AKTEXT("POSIX Mapped"))	// Default mapped device name.
+
+static inline AkMappedFile * GetMappedFile( const AkFileDesc & in_fileDesc )
+{
+	return reinterpret_cast<AkMappedFile*>( in_fileDesc.hFile );
+}
+
+static inline AkInt64 GetMonotonicNs()
+{
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (AkInt64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+CAkMappedIOHookBlocking::CAkMappedIOHookBlocking()
+: m_deviceID( AK_INVALID_DEVICE_ID )
+, m_bAsyncOpen( false )
+, m_uPrefetchSize( AK_MAPPED_IO_DEFAULT_PREFETCH_SIZE )
+, m_uPageSize( 4096 )
+, m_uBytesServed( 0 )
+, m_iStatsStartNs( 0 )
+{
+}
+
+CAkMappedIOHookBlocking::~CAkMappedIOHookBlocking()
+{
+}
+
+// Initialization/termination. Init() registers this object as the one and
+// only File Location Resolver if none were registered before. Then
+// it creates a streaming device with scheduler type AK_SCHEDULER_BLOCKING.
+AKRESULT CAkMappedIOHookBlocking::Init(
+	const AkDeviceSettings &	in_deviceSettings,		// Device settings.
+	bool						in_bAsyncOpen/*=false*/,	// If true, files are opened asynchronously when possible.
+	AkUInt32					in_uPrefetchSize		// Bytes hinted past each read, 0 disables the hint.
+	)
+{
+	if ( in_deviceSettings.uSchedulerTypeFlags != AK_SCHEDULER_BLOCKING )
+	{
+		AKASSERT( !"CAkMappedIOHookBlocking I/O hook only works with AK_SCHEDULER_BLOCKING devices" );
+		return AK_Fail;
+	}
+
+	m_bAsyncOpen = in_bAsyncOpen;
+	m_uPrefetchSize = in_uPrefetchSize;
+
+	long lPageSize = sysconf( _SC_PAGESIZE );
+	if ( lPageSize > 0 )
+		m_uPageSize = (size_t)lPageSize;
+
+	ResetStats();
+
+	// If the Stream Manager's File Location Resolver was not set yet, set this object as the
+	// File Location Resolver (this I/O hook is also able to resolve file location).
+	if ( !AK::StreamMgr::GetFileLocationResolver() )
+		AK::StreamMgr::SetFileLocationResolver( this );
+
+	// Create a device in the Stream Manager, specifying this as the hook.
+	m_deviceID = AK::StreamMgr::CreateDevice( in_deviceSettings, this );
+	if ( m_deviceID != AK_INVALID_DEVICE_ID )
+		return AK_Success;
+
+	return AK_Fail;
+}
+
+void CAkMappedIOHookBlocking::Term()
+{
+	if ( AK::StreamMgr::GetFileLocationResolver() == this )
+		AK::StreamMgr::SetFileLocationResolver( NULL );
+	AK::StreamMgr::DestroyDevice( m_deviceID );
+}
+
+//
+// IAkFileLocationAware interface.
+//-----------------------------------------------------------------------------
+
+// Returns a file descriptor for a given file name (string).
+AKRESULT CAkMappedIOHookBlocking::Open(
+    const AkOSChar* in_pszFileName,     // File name.
+    AkOpenMode      in_eOpenMode,       // Open mode.
+    AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+	bool &			io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+    AkFileDesc &    out_fileDesc        // Returned file descriptor.
+    )
+{
+	// Mapping a file on a local disk is about as fast as opening it, so like the default
+	// blocking hook we open in the client thread unless asked to defer.
+	if ( io_bSyncOpen || !m_bAsyncOpen )
+	{
+		io_bSyncOpen = true;
+
+		// Get the full file path, using path concatenation logic.
+		AkOSChar szFullFilePath[AK_MAX_PATH];
+		if ( GetFullFilePath( in_pszFileName, in_pFlags, in_eOpenMode, szFullFilePath ) == AK_Success )
+			return OpenMapped( szFullFilePath, in_eOpenMode, in_pFlags, out_fileDesc );
+
+		return AK_Fail;
+	}
+	else
+	{
+		FillDeferredFileDesc( out_fileDesc );
+		return AK_Success;
+	}
+}
+
+// Returns a file descriptor for a given file ID.
+AKRESULT CAkMappedIOHookBlocking::Open(
+    AkFileID        in_fileID,          // File ID.
+    AkOpenMode      in_eOpenMode,       // Open mode.
+    AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+	bool &			io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+    AkFileDesc &    out_fileDesc        // Returned file descriptor.
+    )
+{
+	if ( io_bSyncOpen || !m_bAsyncOpen )
+	{
+		io_bSyncOpen = true;
+
+		// Get the full file path, using path concatenation logic.
+		AkOSChar szFullFilePath[AK_MAX_PATH];
+		if ( GetFullFilePath( in_fileID, in_pFlags, in_eOpenMode, szFullFilePath ) == AK_Success )
+			return OpenMapped( szFullFilePath, in_eOpenMode, in_pFlags, out_fileDesc );
+
+		return AK_Fail;
+	}
+	else
+	{
+		FillDeferredFileDesc( out_fileDesc );
+		return AK_Success;
+	}
+}
+
+// Opens and maps (read modes) the file at in_pszFullFilePath.
+AKRESULT CAkMappedIOHookBlocking::OpenMapped(
+	const AkOSChar *		in_pszFullFilePath,	// Full path.
+	AkOpenMode				in_eOpenMode,		// Open mode.
+	AkFileSystemFlags *		in_pFlags,			// Special flags, used to pick the madvise() hint. Can be NULL.
+	AkFileDesc &			out_fileDesc		// Returned file descriptor.
+	)
+{
+	int iFlags;
+	switch ( in_eOpenMode )
+	{
+		case AK_OpenModeRead:
+			iFlags = O_RDONLY;
+			break;
+		case AK_OpenModeWrite:
+			iFlags = O_WRONLY | O_CREAT;
+			break;
+		case AK_OpenModeWriteOvrwr:
+			iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+			break;
+		case AK_OpenModeReadWrite:
+			iFlags = O_RDWR | O_CREAT;
+			break;
+		default:
+			AKASSERT( !"Invalid open mode" );
+			return AK_InvalidParameter;
+	}
+
+	int fd = ::open( in_pszFullFilePath, iFlags | O_CLOEXEC, 0644 );
+	if ( fd < 0 )
+		return ( errno == ENOENT ) ? AK_FileNotFound : AK_Fail;
+
+	struct stat fileStat;
+	if ( ::fstat( fd, &fileStat ) != 0 )
+	{
+		::close( fd );
+		return AK_Fail;
+	}
+
+	AkMappedFile * pFile = new (std::nothrow) AkMappedFile;
+	if ( !pFile )
+	{
+		::close( fd );
+		return AK_InsufficientMemory;
+	}
+	pFile->fd = fd;
+	pFile->pData = NULL;
+	pFile->iSize = (AkInt64)fileStat.st_size;
+
+	// Only read-only files are mapped; a mapping would not follow a file that we grow.
+	if ( in_eOpenMode == AK_OpenModeRead && pFile->iSize > 0 )
+	{
+		void * pMapping = ::mmap( NULL, (size_t)pFile->iSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( pMapping != MAP_FAILED )
+		{
+			pFile->pData = (AkUInt8*)pMapping;
+
+			int iAdvice = MADV_SEQUENTIAL;
+			if ( in_pFlags && in_pFlags->uCompanyID == AKCOMPANYID_AUDIOKINETIC )
+			{
+				if ( in_pFlags->uCodecID == AKCODECID_FILE_PACKAGE )
+					iAdvice = MADV_RANDOM;
+				else if ( in_pFlags->uCodecID == AKCODECID_BANK )
+					iAdvice = MADV_WILLNEED;
+			}
+			::madvise( pMapping, (size_t)pFile->iSize, iAdvice );
+
+			// The mapping holds its own reference to the file.
+			::close( fd );
+			pFile->fd = -1;
+		}
+		// else: leave it unmapped, Read() falls back on pread().
+	}
+
+	out_fileDesc.hFile				= reinterpret_cast<AkFileHandle>( pFile );
+	out_fileDesc.iFileSize			= pFile->iSize;
+	out_fileDesc.uSector			= 0;
+	out_fileDesc.deviceID			= m_deviceID;
+	out_fileDesc.pCustomParam		= NULL;
+	out_fileDesc.uCustomParamSize	= 0;
+	return AK_Success;
+}
+
+// Fills out_fileDesc for a deferred open.
+void CAkMappedIOHookBlocking::FillDeferredFileDesc(
+	AkFileDesc &			out_fileDesc		// Returned file descriptor.
+	)
+{
+	// The client allows us to perform asynchronous opening.
+	// We only need to specify the deviceID, and leave the boolean to false.
+	out_fileDesc.iFileSize			= 0;
+	out_fileDesc.uSector			= 0;
+	out_fileDesc.deviceID			= m_deviceID;
+	out_fileDesc.pCustomParam		= NULL;
+	out_fileDesc.uCustomParamSize	= 0;
+}
+
+//
+// IAkIOHookBlocking implementation.
+//-----------------------------------------------------------------------------
+
+// Reads data from a file (synchronous).
+AKRESULT CAkMappedIOHookBlocking::Read(
+    AkFileDesc &			in_fileDesc,        // File descriptor.
+	const AkIoHeuristics & /*in_heuristics*/,	// Heuristics for this data transfer (not used in this implementation).
+    void *					out_pBuffer,        // Buffer to be filled with data.
+    AkIOTransferInfo &		io_transferInfo		// Synchronous data transfer info.
+    )
+{
+	AkMappedFile * pFile = GetMappedFile( in_fileDesc );
+    AKASSERT( out_pBuffer && pFile );
+
+	AkUInt64 uPosition = io_transferInfo.uFilePosition;
+	AkUInt32 uSize = io_transferInfo.uRequestedSize;
+
+	if ( pFile->pData )
+	{
+		if ( uPosition + uSize > (AkUInt64)pFile->iSize )
+		{
+			AKASSERT( !"Read past the end of a mapped file" );
+			return AK_Fail;
+		}
+
+		AKPLATFORM::AkMemCpy( out_pBuffer, pFile->pData + uPosition, uSize );
+
+		// Have the kernel start on what the next read will most likely want.
+		AkUInt64 uPrefetchStart = uPosition + uSize;
+		if ( m_uPrefetchSize > 0 && uPrefetchStart < (AkUInt64)pFile->iSize )
+		{
+			AkUInt64 uPageStart = uPrefetchStart - ( uPrefetchStart % m_uPageSize );
+			AkUInt64 uPrefetchEnd = uPrefetchStart + m_uPrefetchSize;
+			if ( uPrefetchEnd > (AkUInt64)pFile->iSize )
+				uPrefetchEnd = (AkUInt64)pFile->iSize;
+			::madvise( pFile->pData + uPageStart, (size_t)( uPrefetchEnd - uPageStart ), MADV_WILLNEED );
+		}
+	}
+	else
+	{
+		// Not mapped (empty, or mmap() failed): plain positioned read.
+		ssize_t iRead = ::pread( pFile->fd, out_pBuffer, uSize, (off_t)uPosition );
+		if ( iRead != (ssize_t)uSize )
+			return AK_Fail;
+	}
+
+	m_uBytesServed.fetch_add( uSize, std::memory_order_relaxed );
+	return AK_Success;
+}
+
+// Writes data to a file (synchronous).
+AKRESULT CAkMappedIOHookBlocking::Write(
+	AkFileDesc &			in_fileDesc,        // File descriptor.
+	const AkIoHeuristics & /*in_heuristics*/,	// Heuristics for this data transfer (not used in this implementation).
+    void *					in_pData,           // Data to be written.
+    AkIOTransferInfo &		io_transferInfo		// Synchronous data transfer info.
+    )
+{
+	AkMappedFile * pFile = GetMappedFile( in_fileDesc );
+    AKASSERT( in_pData && pFile );
+
+	if ( pFile->fd < 0 )
+	{
+		AKASSERT( !"File was opened read-only" );
+		return AK_Fail;
+	}
+
+	ssize_t iWritten = ::pwrite( pFile->fd, in_pData, io_transferInfo.uRequestedSize, (off_t)io_transferInfo.uFilePosition );
+	if ( iWritten == (ssize_t)io_transferInfo.uRequestedSize )
+		return AK_Success;
+	return AK_Fail;
+}
+
+// Cleans up a file.
+AKRESULT CAkMappedIOHookBlocking::Close(
+    AkFileDesc & in_fileDesc      // File descriptor.
+    )
+{
+	AkMappedFile * pFile = GetMappedFile( in_fileDesc );
+	if ( !pFile )
+		return AK_Fail;
+
+	AKRESULT eResult = AK_Success;
+	if ( pFile->pData && ::munmap( pFile->pData, (size_t)pFile->iSize ) != 0 )
+		eResult = AK_Fail;
+	if ( pFile->fd >= 0 && ::close( pFile->fd ) != 0 )
+		eResult = AK_Fail;
+
+	delete pFile;
+	in_fileDesc.hFile = NULL;
+	return eResult;
+}
+
+// Returns the block size for the file or its storage device.
+AkUInt32 CAkMappedIOHookBlocking::GetBlockSize(
+    AkFileDesc &  /*in_fileDesc*/     // File descriptor.
+    )
+{
+	// No constraint on block size (file seeking).
+    return 1;
+}
+
+
+// Returns a description for the streaming device above this low-level hook.
+void CAkMappedIOHookBlocking::GetDeviceDesc(
+    AkDeviceDesc &
+#ifndef AK_OPTIMIZED
+	out_deviceDesc      // Description of associated low-level I/O device.
+#endif
+    )
+{
+#ifndef AK_OPTIMIZED
+	AKASSERT( m_deviceID != AK_INVALID_DEVICE_ID || !"Low-Level device was not initialized" );
+	out_deviceDesc.deviceID       = m_deviceID;
+	out_deviceDesc.bCanRead       = true;
+	out_deviceDesc.bCanWrite      = true;
+	AKPLATFORM::SafeStrCpy( out_deviceDesc.szDeviceName, POSIX_MAPPED_DEVICE_NAME, AK_MONITOR_DEVICENAME_MAXLENGTH );
+	out_deviceDesc.uStringSize   = (AkUInt32)AKPLATFORM::OsStrLen( out_deviceDesc.szDeviceName ) + 1;
+#endif
+}
+
+// Returns custom profiling data: 1 if file opens are asynchronous, 0 otherwise.
+AkUInt32 CAkMappedIOHookBlocking::GetDeviceData()
+{
+	return ( m_bAsyncOpen ) ? 1 : 0;
+}
+
+//
+// Mapped data access and statistics.
+//-----------------------------------------------------------------------------
+
+const void * CAkMappedIOHookBlocking::GetMappedData(
+	const AkFileDesc &		in_fileDesc,		// File descriptor.
+	AkUInt64				in_uPosition,		// Absolute position in the file.
+	AkUInt32				in_uSize			// Number of bytes wanted.
+	)
+{
+	AkMappedFile * pFile = GetMappedFile( in_fileDesc );
+	if ( !pFile || !pFile->pData || in_uPosition + in_uSize > (AkUInt64)pFile->iSize )
+		return NULL;
+	return pFile->pData + in_uPosition;
+}
+
+AkUInt64 CAkMappedIOHookBlocking::GetBytesServed()
+{
+	return m_uBytesServed.load( std::memory_order_relaxed );
+}
+
+double CAkMappedIOHookBlocking::GetBytesPerSecond()
+{
+	AkInt64 iElapsedNs = GetMonotonicNs() - m_iStatsStartNs;
+	if ( iElapsedNs <= 0 )
+		return 0;
+	return (double)GetBytesServed() * 1000000000.0 / (double)iElapsedNs;
+}
+
+void CAkMappedIOHookBlocking::ResetStats()
+{
+	m_uBytesServed.store( 0, std::memory_order_relaxed );
+	m_iStatsStartNs = GetMonotonicNs();
+}
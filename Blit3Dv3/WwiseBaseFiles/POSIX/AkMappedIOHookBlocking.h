@@ -0,0 +1,206 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkMappedIOHookBlocking.h
+//
+// Blocking low level IO hook (AK::StreamMgr::IAkIOHookBlocking) and
+// file system (AK::StreamMgr::IAkFileLocationResolver) implementation
+// for POSIX systems, built on mmap() instead of read().
+//
+// Files opened for reading are mapped in full when they are opened.
+// Read() is then a memcpy() out of the mapping: after the first open,
+// bank loads and streamed music cost no system calls, only page faults
+// that the kernel's read-ahead and our madvise() hints keep ahead of us.
+// Files opened for writing (profiling captures, etc.) are not mapped and
+// go through pwrite().
+//
+// Works as a drop-in for CAkDefaultIOHookBlocking, including as the base
+// of CAkFilePackageLowLevelIO (see AkFilePackageLowLevelIOMapped.h): a
+// file package is mapped once and every file inside it is served from
+// that single mapping, with the offsets from the package's LUT.
+//
+// AkFileDesc::hFile holds a pointer to our AkMappedFile record rather
+// than a FILE* or descriptor. CAkFilePackageLowLevelIO only copies the
+// handle around, so this is transparent to it.
+//
+// madvise() hints:
+// - file packages are opened MADV_RANDOM, since the files inside are
+//   read in any order;
+// - sound banks are opened MADV_WILLNEED, they are always read whole;
+// - anything else (streamed audio) is opened MADV_SEQUENTIAL;
+// - after every read, the next uPrefetchSize bytes are MADV_WILLNEED,
+//   so the next streaming read finds its pages resident.
+//
+// The hook counts the bytes it serves; GetBytesPerSecond() reports the
+// average throughput since Init() or the last ResetStats().
+//
+// Usage is the same as CAkDefaultIOHookBlocking:
+/*
+	AkDeviceSettings deviceSettings;
+	AK::StreamMgr::GetDefaultDeviceSettings( deviceSettings );
+	CAkMappedIOHookBlocking hookIOMapped;
+	AKRESULT eResult = hookIOMapped.Init( deviceSettings );
+	AKASSERT( AK_Success == eResult );
+*/
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_MAPPED_IO_HOOK_BLOCKING_H_
+#define _AK_MAPPED_IO_HOOK_BLOCKING_H_
+
+#include <AK/SoundEngine/Common/AkStreamMgrModule.h>
+#include "../Common/AkFileLocationBase.h"
+
+#include <atomic>
+
+// Default number of bytes hinted with MADV_WILLNEED past the end of each read.
+#define AK_MAPPED_IO_DEFAULT_PREFETCH_SIZE	(256 * 1024)
+
+//-----------------------------------------------------------------------------
+// Name: struct AkMappedFile
+// Desc: What AkFileDesc::hFile points to for files opened by this hook.
+//-----------------------------------------------------------------------------
+struct AkMappedFile
+{
+	int			fd;			// Kept open for writes and for files that could not be mapped.
+	AkUInt8 *	pData;		// Start of the mapping, NULL if the file is not mapped.
+	AkInt64		iSize;		// Size of the file (and of the mapping).
+};
+
+//-----------------------------------------------------------------------------
+// Name: class CAkMappedIOHookBlocking.
+// Desc: Implements IAkIOHookBlocking low-level I/O hook, and
+//		 IAkFileLocationResolver, on top of mmap(). Can be used as a standalone
+//		 Low-Level I/O system, or as part of a system with multiple devices.
+//		 File location is resolved using simple path concatenation logic
+//		 (implemented in CAkFileLocationBase).
+//-----------------------------------------------------------------------------
+class CAkMappedIOHookBlocking : public AK::StreamMgr::IAkFileLocationResolver
+								,public AK::StreamMgr::IAkIOHookBlocking
+								,public CAkFileLocationBase
+{
+public:
+
+	CAkMappedIOHookBlocking();
+	virtual ~CAkMappedIOHookBlocking();
+
+	// Initialization/termination. Init() registers this object as the one and
+	// only File Location Resolver if none were registered before. Then
+	// it creates a streaming device with scheduler type AK_SCHEDULER_BLOCKING.
+	AKRESULT Init(
+		const AkDeviceSettings &	in_deviceSettings,	// Device settings.
+		bool						in_bAsyncOpen=AK_ASYNC_OPEN_DEFAULT,	// If true, files are opened asynchronously when possible.
+		AkUInt32					in_uPrefetchSize=AK_MAPPED_IO_DEFAULT_PREFETCH_SIZE	// Bytes hinted past each read, 0 disables the hint.
+		);
+	void Term();
+
+
+	//
+	// IAkFileLocationAware interface.
+	//-----------------------------------------------------------------------------
+
+	// Returns a file descriptor for a given file name (string).
+    virtual AKRESULT Open(
+        const AkOSChar*			in_pszFileName,		// File name.
+		AkOpenMode				in_eOpenMode,		// Open mode.
+        AkFileSystemFlags *		in_pFlags,			// Special flags. Can pass NULL.
+		bool &					io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+        AkFileDesc &			out_fileDesc        // Returned file descriptor.
+        );
+
+    // Returns a file descriptor for a given file ID.
+    virtual AKRESULT Open(
+        AkFileID				in_fileID,          // File ID.
+        AkOpenMode				in_eOpenMode,       // Open mode.
+        AkFileSystemFlags *		in_pFlags,			// Special flags. Can pass NULL.
+		bool &					io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+        AkFileDesc &			out_fileDesc        // Returned file descriptor.
+        );
+
+
+	//
+	// IAkIOHookBlocking interface.
+	//-----------------------------------------------------------------------------
+
+	// Reads data from a file (synchronous): a copy out of the mapping.
+	virtual AKRESULT Read(
+        AkFileDesc &			in_fileDesc,        // File descriptor.
+		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+        void *					out_pBuffer,        // Buffer to be filled with data.
+        AkIOTransferInfo &		io_transferInfo		// Synchronous data transfer info.
+        );
+
+    // Writes data to a file (synchronous).
+	virtual AKRESULT Write(
+		AkFileDesc &			in_fileDesc,        // File descriptor.
+		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+        void *					in_pData,           // Data to be written.
+        AkIOTransferInfo &		io_transferInfo		// Synchronous data transfer info.
+        );
+
+	// Cleans up a file.
+    virtual AKRESULT Close(
+        AkFileDesc &			in_fileDesc			// File descriptor.
+        );
+
+	// Returns the block size for the file or its storage device.
+	virtual AkUInt32 GetBlockSize(
+        AkFileDesc &  			in_fileDesc			// File descriptor.
+        );
+
+	// Returns a description for the streaming device above this low-level hook.
+    virtual void GetDeviceDesc(
+        AkDeviceDesc &  		out_deviceDesc      // Device description.
+        );
+
+	// Returns custom profiling data: 1 if file opens are asynchronous, 0 otherwise.
+	virtual AkUInt32 GetDeviceData();
+
+
+	//
+	// Mapped data access and statistics.
+	//-----------------------------------------------------------------------------
+
+	// Returns a pointer straight into the mapping for in_uSize bytes at in_uPosition
+	// (an absolute position in the file, like AkIOTransferInfo::uFilePosition), or
+	// NULL if the file is not mapped or the range falls outside of it. The pointer
+	// stays valid until the file (or its package) is closed. The blocking hook
+	// interface always hands us a buffer to fill, so the Stream Manager itself never
+	// uses this; it is for callers that can consume data in place, for instance
+	// AK::SoundEngine::LoadBank() from memory.
+	const void * GetMappedData(
+		const AkFileDesc &		in_fileDesc,		// File descriptor.
+		AkUInt64				in_uPosition,		// Absolute position in the file.
+		AkUInt32				in_uSize			// Number of bytes wanted.
+		);
+
+	// Bytes copied out of mappings by Read().
+	AkUInt64 GetBytesServed();
+	// Average of the above per second since Init() or ResetStats().
+	double GetBytesPerSecond();
+	void ResetStats();
+
+protected:
+
+	// Opens and maps (read modes) the file at in_pszFullFilePath.
+	AKRESULT OpenMapped(
+		const AkOSChar *		in_pszFullFilePath,	// Full path.
+		AkOpenMode				in_eOpenMode,		// Open mode.
+		AkFileSystemFlags *		in_pFlags,			// Special flags, used to pick the madvise() hint. Can be NULL.
+		AkFileDesc &			out_fileDesc		// Returned file descriptor.
+		);
+
+	// Fills out_fileDesc for a deferred open.
+	void FillDeferredFileDesc(
+		AkFileDesc &			out_fileDesc		// Returned file descriptor.
+		);
+
+	AkDeviceID	m_deviceID;
+	bool		m_bAsyncOpen;	// If true, opens files asynchronously when it can.
+	AkUInt32	m_uPrefetchSize;
+	size_t		m_uPageSize;
+
+	std::atomic<AkUInt64>	m_uBytesServed;
+	AkInt64					m_iStatsStartNs;	// CLOCK_MONOTONIC
+};
+
+#endif //_AK_MAPPED_IO_HOOK_BLOCKING_H_
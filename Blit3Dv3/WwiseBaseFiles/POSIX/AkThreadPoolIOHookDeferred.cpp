@@ -0,0 +1,579 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkThreadPoolIOHookDeferred.cpp
+//
+// Deferred low level IO hook (AK::StreamMgr::IAkIOHookDeferred) and
+// file system (AK::StreamMgr::IAkFileLocationResolver) implementation
+// for POSIX systems, on a pool of pread()/pwrite() worker threads.
+// See AkThreadPoolIOHookDeferred.h for details.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "AkThreadPoolIOHookDeferred.h"
+#include <AK/Tools/Common/AkPlatformFuncs.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <new>
+
+
+#define POSIX_THREAD_POOL_DEVICE_NAME	(AKTEXT("POSIX Thread Pool"))	// Default thread pool device name.
+
+static inline AkInt64 GetMonotonicNs()
+{
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (AkInt64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+CAkThreadPoolIOHookDeferred::CAkThreadPoolIOHookDeferred()
+: m_deviceID( AK_INVALID_DEVICE_ID )
+, m_bAsyncOpen( false )
+, m_bStopWorkers( false )
+, m_pRequests( NULL )
+, m_pFreeRequests( NULL )
+, m_pQueue( NULL )
+, m_uQueueDepth( 0 )
+, m_uInFlight( 0 )
+, m_uMaxInFlight( 0 )
+, m_uNumWorkers( 0 )
+{
+	ResetStats();
+}
+
+CAkThreadPoolIOHookDeferred::~CAkThreadPoolIOHookDeferred()
+{
+}
+
+// Initialization/termination. Init() registers this object as the one and
+// only File Location Resolver if none were registered before. Then
+// it creates a streaming device with scheduler type AK_SCHEDULER_DEFERRED_LINED_UP,
+// and starts the worker threads.
+AKRESULT CAkThreadPoolIOHookDeferred::Init(
+	const AkDeviceSettings &	in_deviceSettings,		// Device settings.
+	bool						in_bAsyncOpen/*=false*/,	// If true, files are opened asynchronously when possible.
+	AkUInt32					in_uMaxInFlight,		// Transfers serviced at the same time.
+	AkUInt32					in_uNumWorkers			// Worker threads, 0 for as many as in_uMaxInFlight.
+	)
+{
+	if ( in_deviceSettings.uSchedulerTypeFlags != AK_SCHEDULER_DEFERRED_LINED_UP )
+	{
+		AKASSERT( !"CAkThreadPoolIOHookDeferred I/O hook only works with AK_SCHEDULER_DEFERRED_LINED_UP devices" );
+		return AK_Fail;
+	}
+
+	m_bAsyncOpen = in_bAsyncOpen;
+
+	// One request per transfer the Stream Manager may keep pending on this device.
+	AkUInt32 uNumRequests = in_deviceSettings.uMaxConcurrentIO;
+	if ( uNumRequests == 0 )
+	{
+		AKASSERT( !"uMaxConcurrentIO must be at least 1" );
+		return AK_Fail;
+	}
+	m_pRequests = new (std::nothrow) Request[ uNumRequests ];
+	if ( !m_pRequests )
+		return AK_InsufficientMemory;
+	for ( AkUInt32 uRequest = 0; uRequest < uNumRequests; ++uRequest )
+		m_pRequests[ uRequest ].pNext = ( uRequest + 1 < uNumRequests ) ? &m_pRequests[ uRequest + 1 ] : NULL;
+	m_pFreeRequests = m_pRequests;
+	m_pQueue = NULL;
+	m_uQueueDepth = 0;
+	m_uInFlight = 0;
+
+	// Start the workers before creating the device: it may issue transfers right away.
+	AkUInt32 uNumWorkers = in_uNumWorkers ? in_uNumWorkers : in_uMaxInFlight;
+	if ( uNumWorkers > uNumRequests )
+		uNumWorkers = uNumRequests;
+	if ( uNumWorkers > AK_THREAD_POOL_IO_MAX_WORKERS )
+		uNumWorkers = AK_THREAD_POOL_IO_MAX_WORKERS;
+	if ( uNumWorkers == 0 )
+		uNumWorkers = 1;
+
+	m_uMaxInFlight = in_uMaxInFlight;
+	if ( m_uMaxInFlight > uNumWorkers )
+		m_uMaxInFlight = uNumWorkers;
+	if ( m_uMaxInFlight == 0 )
+		m_uMaxInFlight = 1;
+
+	m_bStopWorkers = false;
+	for ( m_uNumWorkers = 0; m_uNumWorkers < uNumWorkers; ++m_uNumWorkers )
+		m_workers[ m_uNumWorkers ] = std::thread( &CAkThreadPoolIOHookDeferred::WorkerLoop, this );
+
+	ResetStats();
+
+	// If the Stream Manager's File Location Resolver was not set yet, set this object as the
+	// File Location Resolver (this I/O hook is also able to resolve file location).
+	if ( !AK::StreamMgr::GetFileLocationResolver() )
+		AK::StreamMgr::SetFileLocationResolver( this );
+
+	// Create a device in the Stream Manager, specifying this as the hook.
+	m_deviceID = AK::StreamMgr::CreateDevice( in_deviceSettings, this );
+	if ( m_deviceID != AK_INVALID_DEVICE_ID )
+		return AK_Success;
+
+	Term();
+	return AK_Fail;
+}
+
+void CAkThreadPoolIOHookDeferred::Term()
+{
+	if ( AK::StreamMgr::GetFileLocationResolver() == this )
+		AK::StreamMgr::SetFileLocationResolver( NULL );
+
+	// Destroying the device waits for its pending transfers, which need the workers.
+	if ( m_deviceID != AK_INVALID_DEVICE_ID )
+	{
+		AK::StreamMgr::DestroyDevice( m_deviceID );
+		m_deviceID = AK_INVALID_DEVICE_ID;
+	}
+
+	// Workers drain the queue before they exit.
+	{
+		std::lock_guard<std::mutex> lock( m_lock );
+		m_bStopWorkers = true;
+	}
+	m_workAvailable.notify_all();
+	for ( AkUInt32 uWorker = 0; uWorker < m_uNumWorkers; ++uWorker )
+		m_workers[ uWorker ].join();
+	m_uNumWorkers = 0;
+
+	AKASSERT( !m_pQueue && m_uInFlight == 0 );
+	delete [] m_pRequests;
+	m_pRequests = NULL;
+	m_pFreeRequests = NULL;
+}
+
+//
+// IAkFileLocationAware implementation.
+//-----------------------------------------------------------------------------
+
+// Returns a file descriptor for a given file name (string).
+AKRESULT CAkThreadPoolIOHookDeferred::Open(
+    const AkOSChar* in_pszFileName,     // File name.
+    AkOpenMode      in_eOpenMode,       // Open mode.
+    AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+	bool &			io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+    AkFileDesc &    out_fileDesc        // Returned file descriptor.
+    )
+{
+	// We normally consider that calls to ::open() on a hard drive are fast enough to execute in the
+	// client thread. If you want files to be opened asynchronously when it is possible, this device should
+	// be initialized with the flag in_bAsyncOpen set to true.
+	if ( io_bSyncOpen || !m_bAsyncOpen )
+	{
+		io_bSyncOpen = true;
+
+		// Get the full file path, using path concatenation logic.
+		AkOSChar szFullFilePath[AK_MAX_PATH];
+		if ( GetFullFilePath( in_pszFileName, in_pFlags, in_eOpenMode, szFullFilePath ) == AK_Success )
+			return OpenFile( szFullFilePath, in_eOpenMode, out_fileDesc );
+
+		return AK_Fail;
+	}
+	else
+	{
+		FillDeferredFileDesc( out_fileDesc );
+		return AK_Success;
+	}
+}
+
+// Returns a file descriptor for a given file ID.
+AKRESULT CAkThreadPoolIOHookDeferred::Open(
+    AkFileID        in_fileID,          // File ID.
+    AkOpenMode      in_eOpenMode,       // Open mode.
+    AkFileSystemFlags * in_pFlags,      // Special flags. Can pass NULL.
+	bool &			io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+    AkFileDesc &    out_fileDesc        // Returned file descriptor.
+    )
+{
+	if ( io_bSyncOpen || !m_bAsyncOpen )
+	{
+		io_bSyncOpen = true;
+
+		// Get the full file path, using path concatenation logic.
+		AkOSChar szFullFilePath[AK_MAX_PATH];
+		if ( GetFullFilePath( in_fileID, in_pFlags, in_eOpenMode, szFullFilePath ) == AK_Success )
+			return OpenFile( szFullFilePath, in_eOpenMode, out_fileDesc );
+
+		return AK_Fail;
+	}
+	else
+	{
+		FillDeferredFileDesc( out_fileDesc );
+		return AK_Success;
+	}
+}
+
+// Opens the file at in_pszFullFilePath and fills out_fileDesc.
+AKRESULT CAkThreadPoolIOHookDeferred::OpenFile(
+	const AkOSChar *		in_pszFullFilePath,	// Full path.
+	AkOpenMode				in_eOpenMode,		// Open mode.
+	AkFileDesc &			out_fileDesc		// Returned file descriptor.
+	)
+{
+	int iFlags;
+	const char * pszMode;
+	switch ( in_eOpenMode )
+	{
+		case AK_OpenModeRead:
+			iFlags = O_RDONLY;
+			pszMode = "rb";
+			break;
+		case AK_OpenModeWrite:
+			iFlags = O_WRONLY | O_CREAT;
+			pszMode = "wb";
+			break;
+		case AK_OpenModeWriteOvrwr:
+			iFlags = O_WRONLY | O_CREAT | O_TRUNC;
+			pszMode = "wb";
+			break;
+		case AK_OpenModeReadWrite:
+			iFlags = O_RDWR | O_CREAT;
+			pszMode = "r+b";
+			break;
+		default:
+			AKASSERT( !"Invalid open mode" );
+			return AK_InvalidParameter;
+	}
+
+	int fd = ::open( in_pszFullFilePath, iFlags | O_CLOEXEC, 0644 );
+	if ( fd < 0 )
+		return ( errno == ENOENT ) ? AK_FileNotFound : AK_Fail;
+
+	struct stat fileStat;
+	if ( ::fstat( fd, &fileStat ) != 0 )
+	{
+		::close( fd );
+		return AK_Fail;
+	}
+
+	// fdopen() does not truncate or create, the flags above did.
+	FILE * pFile = ::fdopen( fd, pszMode );
+	if ( !pFile )
+	{
+		::close( fd );
+		return AK_Fail;
+	}
+
+	out_fileDesc.hFile				= pFile;
+	out_fileDesc.iFileSize			= (AkInt64)fileStat.st_size;
+	out_fileDesc.uSector			= 0;
+	out_fileDesc.deviceID			= m_deviceID;
+	out_fileDesc.pCustomParam		= NULL;
+	out_fileDesc.uCustomParamSize	= 0;
+	return AK_Success;
+}
+
+// Fills out_fileDesc for a deferred open.
+void CAkThreadPoolIOHookDeferred::FillDeferredFileDesc(
+	AkFileDesc &			out_fileDesc		// Returned file descriptor.
+	)
+{
+	// The client allows us to perform asynchronous opening.
+	// We only need to specify the deviceID, and leave the boolean to false.
+	out_fileDesc.iFileSize			= 0;
+	out_fileDesc.uSector			= 0;
+	out_fileDesc.deviceID			= m_deviceID;
+	out_fileDesc.pCustomParam		= NULL;
+	out_fileDesc.uCustomParamSize	= 0;
+}
+
+//
+// IAkIOHookDeferred implementation.
+//-----------------------------------------------------------------------------
+
+// Reads data from a file (asynchronous).
+AKRESULT CAkThreadPoolIOHookDeferred::Read(
+	AkFileDesc &			in_fileDesc,        // File descriptor.
+	const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+	AkAsyncIOTransferInfo & io_transferInfo		// Asynchronous data transfer info.
+	)
+{
+	AKASSERT( in_fileDesc.hFile
+			&& io_transferInfo.uRequestedSize > 0
+			&& io_transferInfo.uBufferSize >= io_transferInfo.uRequestedSize );
+
+	return QueueTransfer( in_fileDesc, in_heuristics, io_transferInfo, false );
+}
+
+// Writes data to a file (asynchronous).
+AKRESULT CAkThreadPoolIOHookDeferred::Write(
+	AkFileDesc &			in_fileDesc,        // File descriptor.
+	const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+	AkAsyncIOTransferInfo & io_transferInfo		// Platform-specific asynchronous IO operation info.
+	)
+{
+	AKASSERT( in_fileDesc.hFile
+			&& io_transferInfo.uRequestedSize > 0 );
+
+	return QueueTransfer( in_fileDesc, in_heuristics, io_transferInfo, true );
+}
+
+// Takes a request from the pool and queues it. Never blocks.
+AKRESULT CAkThreadPoolIOHookDeferred::QueueTransfer(
+	AkFileDesc &			in_fileDesc,		// File descriptor.
+	const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+	AkAsyncIOTransferInfo & io_transferInfo,	// Asynchronous data transfer info.
+	bool					in_bWrite			// True for Write().
+	)
+{
+	{
+		std::lock_guard<std::mutex> lock( m_lock );
+
+		Request * pRequest = m_pFreeRequests;
+		if ( !pRequest )
+		{
+			// The Stream Manager keeps at most uMaxConcurrentIO transfers pending, so this
+			// means the settings passed to Init() are not those of the device.
+			AKASSERT( !"Too many concurrent transfers in the Low-Level IO" );
+			return AK_Fail;
+		}
+		m_pFreeRequests = pRequest->pNext;
+
+		pRequest->pTransferInfo	= &io_transferInfo;
+		pRequest->fd			= ::fileno( in_fileDesc.hFile );
+		pRequest->priority		= in_heuristics.priority;
+		pRequest->bWrite		= in_bWrite;
+		pRequest->bCancelled	= false;
+		pRequest->iQueuedNs		= GetMonotonicNs();
+
+		// Insert after all requests of the same or higher priority.
+		Request ** ppPrev = &m_pQueue;
+		while ( *ppPrev && (*ppPrev)->priority >= pRequest->priority )
+			ppPrev = &(*ppPrev)->pNext;
+		pRequest->pNext = *ppPrev;
+		*ppPrev = pRequest;
+
+		m_uQueueDepthSum += m_uQueueDepth;
+		++m_uNumQueued;
+		++m_uQueueDepth;
+		if ( m_uQueueDepth > m_uPeakQueueDepth )
+			m_uPeakQueueDepth = m_uQueueDepth;
+	}
+	m_workAvailable.notify_one();
+	return AK_Success;
+}
+
+// Performs a transfer with pread()/pwrite(). Called by the workers, without the lock.
+AKRESULT CAkThreadPoolIOHookDeferred::DoTransfer(
+	const Request &			in_request
+	)
+{
+	AkAsyncIOTransferInfo & transferInfo = *in_request.pTransferInfo;
+	AkUInt8 * pBuffer = (AkUInt8*)transferInfo.pBuffer;
+	AkUInt32 uRemaining = transferInfo.uRequestedSize;
+	off_t iPosition = (off_t)transferInfo.uFilePosition;
+
+	while ( uRemaining > 0 )
+	{
+		ssize_t iDone = in_request.bWrite
+			? ::pwrite( in_request.fd, pBuffer, uRemaining, iPosition )
+			: ::pread( in_request.fd, pBuffer, uRemaining, iPosition );
+		if ( iDone < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			return AK_Fail;
+		}
+		if ( iDone == 0 )
+			return AK_Fail;	// Unexpected end of file.
+
+		pBuffer += iDone;
+		iPosition += iDone;
+		uRemaining -= (AkUInt32)iDone;
+	}
+
+	return AK_Success;
+}
+
+// Worker thread body.
+void CAkThreadPoolIOHookDeferred::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock( m_lock );
+	for ( ;; )
+	{
+		while ( !m_bStopWorkers && ( !m_pQueue || m_uInFlight >= m_uMaxInFlight ) )
+			m_workAvailable.wait( lock );
+		if ( !m_pQueue )
+			break;	// Stopping, and nothing left to do.
+		if ( m_uInFlight >= m_uMaxInFlight )
+		{
+			// Stopping: the queue is still drained no more than the limit at a time.
+			m_workAvailable.wait( lock );
+			continue;
+		}
+
+		Request * pRequest = m_pQueue;
+		m_pQueue = pRequest->pNext;
+		--m_uQueueDepth;
+		++m_uInFlight;
+		bool bCancelled = pRequest->bCancelled;
+		AkInt64 iStartNs = GetMonotonicNs();
+
+		lock.unlock();
+		AKRESULT eResult = bCancelled ? AK_Cancelled : DoTransfer( *pRequest );
+		AkInt64 iEndNs = GetMonotonicNs();
+		lock.lock();
+
+		AkAsyncIOTransferInfo * pTransferInfo = pRequest->pTransferInfo;
+		AkInt64 iLatencyNs = iEndNs - pRequest->iQueuedNs;
+
+		++m_uNumTransfers;
+		if ( eResult == AK_Success )
+			m_uBytesTransferred += pTransferInfo->uRequestedSize;
+		else if ( eResult == AK_Cancelled )
+			++m_uNumCancelled;
+		else
+			++m_uNumFailed;
+		m_iWaitNsSum += iStartNs - pRequest->iQueuedNs;
+		m_iLatencyNsSum += iLatencyNs;
+		if ( iLatencyNs > m_iMaxLatencyNs )
+			m_iMaxLatencyNs = iLatencyNs;
+
+		--m_uInFlight;
+		pRequest->pNext = m_pFreeRequests;
+		m_pFreeRequests = pRequest;
+		// A worker held back by the limit can take the next one.
+		if ( m_pQueue )
+			m_workAvailable.notify_one();
+
+		// Complete outside the lock: the Stream Manager may queue the next transfer from the callback.
+		lock.unlock();
+		pTransferInfo->pCallback( pTransferInfo, eResult );
+		lock.lock();
+	}
+}
+
+// Cancel transfer(s).
+void CAkThreadPoolIOHookDeferred::Cancel(
+	AkFileDesc &			in_fileDesc,		// File descriptor.
+	AkAsyncIOTransferInfo & io_transferInfo,	// Transfer info to cancel.
+	bool & io_bCancelAllTransfersForThisFile	// Flag indicating whether all transfers should be cancelled for this file (see notes in function description).
+	)
+{
+	int fd = ::fileno( in_fileDesc.hFile );
+
+	std::lock_guard<std::mutex> lock( m_lock );
+	for ( Request * pRequest = m_pQueue; pRequest; pRequest = pRequest->pNext )
+	{
+		if ( io_bCancelAllTransfersForThisFile
+			? pRequest->fd == fd
+			: pRequest->pTransferInfo == &io_transferInfo )
+		{
+			// Completed by a worker, with AK_Cancelled and without touching the disk.
+			pRequest->bCancelled = true;
+		}
+	}
+	// Leave io_bCancelAllTransfersForThisFile as it is: if it was set, all queued transfers
+	// of this file were cancelled, so we don't need to be called again.
+}
+
+// Close a file.
+AKRESULT CAkThreadPoolIOHookDeferred::Close(
+    AkFileDesc & in_fileDesc      // File descriptor.
+    )
+{
+	if ( !in_fileDesc.hFile )
+		return AK_Fail;
+
+	AKRESULT eResult = ( ::fclose( in_fileDesc.hFile ) == 0 ) ? AK_Success : AK_Fail;
+	in_fileDesc.hFile = NULL;
+	return eResult;
+}
+
+// Returns the block size for the file or its storage device.
+AkUInt32 CAkThreadPoolIOHookDeferred::GetBlockSize(
+    AkFileDesc &  /*in_fileDesc*/     // File descriptor.
+    )
+{
+	// pread() and pwrite() put no constraint on position or size.
+    return 1;
+}
+
+// Returns a description for the streaming device above this low-level hook.
+void CAkThreadPoolIOHookDeferred::GetDeviceDesc(
+    AkDeviceDesc &
+#ifndef AK_OPTIMIZED
+	out_deviceDesc      // Description of associated low-level I/O device.
+#endif
+    )
+{
+#ifndef AK_OPTIMIZED
+	AKASSERT( m_deviceID != AK_INVALID_DEVICE_ID || !"Low-Level device was not initialized" );
+	out_deviceDesc.deviceID       = m_deviceID;
+	out_deviceDesc.bCanRead       = true;
+	out_deviceDesc.bCanWrite      = true;
+	AKPLATFORM::SafeStrCpy( out_deviceDesc.szDeviceName, POSIX_THREAD_POOL_DEVICE_NAME, AK_MONITOR_DEVICENAME_MAXLENGTH );
+	out_deviceDesc.uStringSize   = (AkUInt32)AKPLATFORM::OsStrLen( out_deviceDesc.szDeviceName ) + 1;
+#endif
+}
+
+// Returns custom profiling data: 1 if file opens are asynchronous, 0 otherwise.
+AkUInt32 CAkThreadPoolIOHookDeferred::GetDeviceData()
+{
+	return ( m_bAsyncOpen ) ? 1 : 0;
+}
+
+//
+// Statistics.
+//-----------------------------------------------------------------------------
+
+void CAkThreadPoolIOHookDeferred::GetStats(
+	AkThreadPoolIOStats &	out_stats			// Returned statistics.
+	)
+{
+	std::lock_guard<std::mutex> lock( m_lock );
+
+	out_stats.uQueueDepth		= m_uQueueDepth;
+	out_stats.uInFlight			= m_uInFlight;
+	out_stats.uMaxInFlight		= m_uMaxInFlight;
+	out_stats.uPeakQueueDepth	= m_uPeakQueueDepth;
+	out_stats.uNumTransfers		= m_uNumTransfers;
+	out_stats.uNumCancelled		= m_uNumCancelled;
+	out_stats.uNumFailed		= m_uNumFailed;
+	out_stats.uBytesTransferred	= m_uBytesTransferred;
+	out_stats.fAvgQueueDepth	= m_uNumQueued ? (double)m_uQueueDepthSum / m_uNumQueued : 0.0;
+	out_stats.fAvgWaitMs		= m_uNumTransfers ? m_iWaitNsSum / 1e6 / m_uNumTransfers : 0.0;
+	out_stats.fAvgLatencyMs		= m_uNumTransfers ? m_iLatencyNsSum / 1e6 / m_uNumTransfers : 0.0;
+	out_stats.fMaxLatencyMs		= m_iMaxLatencyNs / 1e6;
+}
+
+void CAkThreadPoolIOHookDeferred::ResetStats()
+{
+	// Called by the constructor before the workers exist, and by Init() after they were started.
+	std::lock_guard<std::mutex> lock( m_lock );
+
+	m_uPeakQueueDepth	= m_uQueueDepth;
+	m_uNumQueued		= 0;
+	m_uQueueDepthSum	= 0;
+	m_uNumTransfers		= 0;
+	m_uNumCancelled		= 0;
+	m_uNumFailed		= 0;
+	m_uBytesTransferred	= 0;
+	m_iWaitNsSum		= 0;
+	m_iLatencyNsSum		= 0;
+	m_iMaxLatencyNs		= 0;
+}
+
+void CAkThreadPoolIOHookDeferred::SetMaxInFlight(
+	AkUInt32				in_uMaxInFlight		// Transfers serviced at the same time.
+	)
+{
+	{
+		std::lock_guard<std::mutex> lock( m_lock );
+		m_uMaxInFlight = in_uMaxInFlight;
+		if ( m_uMaxInFlight > m_uNumWorkers )
+			m_uMaxInFlight = m_uNumWorkers;
+		if ( m_uMaxInFlight == 0 )
+			m_uMaxInFlight = 1;
+	}
+	// A raised limit lets waiting workers go.
+	m_workAvailable.notify_all();
+}
@@ -0,0 +1,276 @@
+//////////////////////////////////////////////////////////////////////
+//
+// AkThreadPoolIOHookDeferred.h
+//
+// Deferred low level IO hook (AK::StreamMgr::IAkIOHookDeferred) and
+// file system (AK::StreamMgr::IAkFileLocationResolver) implementation
+// for POSIX systems, the counterpart of the Win32 CAkDefaultIOHookDeferred.
+//
+// POSIX has no equivalent of overlapped I/O with completion routines for
+// regular files, so transfers are handed to a small pool of worker
+// threads that perform them with pread()/pwrite(), then complete them
+// back to the Stream Manager through AkAsyncIOTransferInfo::pCallback,
+// from the worker thread. Read() and Write() only queue the transfer and
+// return: neither the Stream Manager's I/O thread nor the thread that
+// calls into the sound engine ever waits on the disk.
+//
+// Transfers are described by request objects taken from a fixed pool
+// allocated by Init(), one per AkDeviceSettings::uMaxConcurrentIO, which
+// is the most transfers the Stream Manager keeps pending on a device. No
+// memory is allocated per transfer.
+//
+// The in-flight limit is how many transfers may hit the disk at the same
+// time, the others wait in the queue, highest AkIoHeuristics::priority
+// first (FIFO among equal priorities), so streamed music is not stuck
+// behind a burst of bank loads. It is set apart from the number of worker
+// threads, and can be lowered and raised while running with
+// SetMaxInFlight(), up to the number of workers.
+//
+// Cancel() only removes transfers that are still queued; they complete
+// with AK_Cancelled from a worker, never from inside Cancel(). Transfers
+// already being serviced run to completion.
+//
+// The hook records the depth of its queue and the latency of transfers,
+// from Read()/Write() to completion, see GetStats().
+//
+// AkFileDesc::hFile is a FILE* (opened with fdopen()), as in the SDK's
+// POSIX samples; transfers use its descriptor directly.
+//
+// Usage:
+/*
+	AkDeviceSettings deviceSettings;
+	AK::StreamMgr::GetDefaultDeviceSettings( deviceSettings );
+	deviceSettings.uSchedulerTypeFlags = AK_SCHEDULER_DEFERRED_LINED_UP;
+	CAkThreadPoolIOHookDeferred hookIOThreadPool;
+	AKRESULT eResult = hookIOThreadPool.Init( deviceSettings );
+	AKASSERT( AK_Success == eResult );
+*/
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _AK_THREAD_POOL_IO_HOOK_DEFERRED_H_
+#define _AK_THREAD_POOL_IO_HOOK_DEFERRED_H_
+
+#include <AK/SoundEngine/Common/AkStreamMgrModule.h>
+#include "../Common/AkFileLocationBase.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Default number of transfers serviced at the same time.
+#define AK_THREAD_POOL_IO_DEFAULT_MAX_IN_FLIGHT	(2)
+// Most worker threads Init() will create.
+#define AK_THREAD_POOL_IO_MAX_WORKERS			(16)
+
+//-----------------------------------------------------------------------------
+// Name: struct AkThreadPoolIOStats
+// Desc: Snapshot of the hook's activity, see CAkThreadPoolIOHookDeferred::GetStats().
+//		 Counters and latencies cover the transfers completed since Init() or
+//		 the last ResetStats().
+//-----------------------------------------------------------------------------
+struct AkThreadPoolIOStats
+{
+	AkUInt32	uQueueDepth;			// Transfers waiting for a worker now.
+	AkUInt32	uInFlight;				// Transfers being serviced now.
+	AkUInt32	uMaxInFlight;			// Current in-flight limit.
+	AkUInt32	uPeakQueueDepth;		// Most transfers that waited at once.
+	AkUInt64	uNumTransfers;			// Completed transfers, including failed and cancelled ones.
+	AkUInt64	uNumCancelled;
+	AkUInt64	uNumFailed;
+	AkUInt64	uBytesTransferred;
+	double		fAvgQueueDepth;			// Queue depth seen by each new transfer, on average.
+	double		fAvgWaitMs;				// Time spent in the queue, on average.
+	double		fAvgLatencyMs;			// Time from Read()/Write() to completion, on average.
+	double		fMaxLatencyMs;
+};
+
+//-----------------------------------------------------------------------------
+// Name: class CAkThreadPoolIOHookDeferred.
+// Desc: Implements IAkIOHookDeferred low-level I/O hook, and
+//		 IAkFileLocationResolver, with a pool of worker threads doing
+//		 positioned reads and writes. Can be used as a standalone Low-Level
+//		 I/O system, or as part of a system with multiple devices.
+//		 File location is resolved using simple path concatenation logic
+//		 (implemented in CAkFileLocationBase).
+//-----------------------------------------------------------------------------
+class CAkThreadPoolIOHookDeferred : public AK::StreamMgr::IAkFileLocationResolver
+								,public AK::StreamMgr::IAkIOHookDeferred
+								,public CAkFileLocationBase
+{
+public:
+
+	CAkThreadPoolIOHookDeferred();
+	virtual ~CAkThreadPoolIOHookDeferred();
+
+	// Initialization/termination. Init() registers this object as the one and
+	// only File Location Resolver if none were registered before. Then
+	// it creates a streaming device with scheduler type AK_SCHEDULER_DEFERRED_LINED_UP,
+	// and starts the worker threads.
+	AKRESULT Init(
+		const AkDeviceSettings &	in_deviceSettings,	// Device settings.
+		bool						in_bAsyncOpen=AK_ASYNC_OPEN_DEFAULT,	// If true, files are opened asynchronously when possible.
+		AkUInt32					in_uMaxInFlight=AK_THREAD_POOL_IO_DEFAULT_MAX_IN_FLIGHT,	// Transfers serviced at the same time. Clamped to [1, worker threads].
+		AkUInt32					in_uNumWorkers=0	// Worker threads, 0 for as many as in_uMaxInFlight. Clamped to [1, min(uMaxConcurrentIO, AK_THREAD_POOL_IO_MAX_WORKERS)].
+		);
+	void Term();
+
+
+	//
+	// IAkFileLocationAware interface.
+	//-----------------------------------------------------------------------------
+
+	// Returns a file descriptor for a given file name (string).
+	virtual AKRESULT Open(
+		const AkOSChar*			in_pszFileName,		// File name.
+		AkOpenMode				in_eOpenMode,		// Open mode.
+		AkFileSystemFlags *		in_pFlags,			// Special flags. Can pass NULL.
+		bool &					io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+		AkFileDesc &			out_fileDesc        // Returned file descriptor.
+		);
+
+	// Returns a file descriptor for a given file ID.
+	virtual AKRESULT Open(
+		AkFileID				in_fileID,          // File ID.
+		AkOpenMode				in_eOpenMode,       // Open mode.
+		AkFileSystemFlags *		in_pFlags,			// Special flags. Can pass NULL.
+		bool &					io_bSyncOpen,		// If true, the file must be opened synchronously. Otherwise it is left at the File Location Resolver's discretion. Return false if Open needs to be deferred.
+		AkFileDesc &			out_fileDesc        // Returned file descriptor.
+		);
+
+
+	//
+	// IAkIOHookDeferred interface.
+	//-----------------------------------------------------------------------------
+
+	// Reads data from a file (asynchronous): queues the transfer for a worker.
+	virtual AKRESULT Read(
+		AkFileDesc &			in_fileDesc,        // File descriptor.
+		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+		AkAsyncIOTransferInfo & io_transferInfo		// Asynchronous data transfer info.
+		);
+
+	// Writes data to a file (asynchronous): queues the transfer for a worker.
+	virtual AKRESULT Write(
+		AkFileDesc &			in_fileDesc,        // File descriptor.
+		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+		AkAsyncIOTransferInfo & io_transferInfo		// Platform-specific asynchronous IO operation info.
+		);
+
+	// Notifies that a transfer request is cancelled. It will be flushed by the streaming device when completed.
+	// Removes io_transferInfo from the queue, or all queued transfers of the file if
+	// io_bCancelAllTransfersForThisFile is true.
+	virtual void Cancel(
+		AkFileDesc &			in_fileDesc,		// File descriptor.
+		AkAsyncIOTransferInfo & io_transferInfo,	// Transfer info to cancel.
+		bool & io_bCancelAllTransfersForThisFile	// Flag indicating whether all transfers should be cancelled for this file (see notes in function description).
+		);
+
+	// Cleans up a file.
+	virtual AKRESULT Close(
+		AkFileDesc &			in_fileDesc			// File descriptor.
+		);
+
+	// Returns the block size for the file or its storage device.
+	virtual AkUInt32 GetBlockSize(
+		AkFileDesc &  			in_fileDesc			// File descriptor.
+		);
+
+	// Returns a description for the streaming device above this low-level hook.
+	virtual void GetDeviceDesc(
+		AkDeviceDesc &  		out_deviceDesc      // Description of associated low-level I/O device.
+		);
+
+	// Returns custom profiling data: 1 if file opens are asynchronous, 0 otherwise.
+	virtual AkUInt32 GetDeviceData();
+
+
+	//
+	// Statistics.
+	//-----------------------------------------------------------------------------
+
+	void GetStats(
+		AkThreadPoolIOStats &	out_stats			// Returned statistics.
+		);
+	void ResetStats();
+
+	// Changes the in-flight limit, clamped to [1, worker threads]. Transfers already
+	// being serviced finish, the limit applies to the next ones taken from the queue.
+	void SetMaxInFlight(
+		AkUInt32				in_uMaxInFlight		// Transfers serviced at the same time.
+		);
+
+protected:
+
+	// A transfer, from Read()/Write() to its completion.
+	struct Request
+	{
+		Request *				pNext;			// Next in the queue or in the free list.
+		AkAsyncIOTransferInfo *	pTransferInfo;	// Transfer to perform and complete.
+		int						fd;				// Descriptor of the file.
+		AkPriority				priority;		// Queue order.
+		bool					bWrite;
+		bool					bCancelled;		// Set by Cancel() while queued.
+		AkInt64					iQueuedNs;		// When Read()/Write() queued it (CLOCK_MONOTONIC).
+	};
+
+	// Opens the file at in_pszFullFilePath and fills out_fileDesc.
+	AKRESULT OpenFile(
+		const AkOSChar *		in_pszFullFilePath,	// Full path.
+		AkOpenMode				in_eOpenMode,		// Open mode.
+		AkFileDesc &			out_fileDesc		// Returned file descriptor.
+		);
+
+	// Fills out_fileDesc for a deferred open.
+	void FillDeferredFileDesc(
+		AkFileDesc &			out_fileDesc		// Returned file descriptor.
+		);
+
+	// Takes a request from the pool and queues it. Never blocks.
+	AKRESULT QueueTransfer(
+		AkFileDesc &			in_fileDesc,		// File descriptor.
+		const AkIoHeuristics &	in_heuristics,		// Heuristics for this data transfer.
+		AkAsyncIOTransferInfo & io_transferInfo,	// Asynchronous data transfer info.
+		bool					in_bWrite			// True for Write().
+		);
+
+	// Performs a transfer with pread()/pwrite(). Called by the workers, without the lock.
+	static AKRESULT DoTransfer(
+		const Request &			in_request
+		);
+
+	// Worker thread body.
+	void WorkerLoop();
+
+	AkDeviceID	m_deviceID;
+	bool		m_bAsyncOpen;	// If true, opens files asynchronously when it can.
+
+	// Protects everything below.
+	std::mutex				m_lock;
+	std::condition_variable	m_workAvailable;
+	bool					m_bStopWorkers;
+
+	Request *				m_pRequests;		// Pool, uMaxConcurrentIO requests.
+	Request *				m_pFreeRequests;
+	Request *				m_pQueue;			// Sorted by priority, then FIFO.
+	AkUInt32				m_uQueueDepth;
+	AkUInt32				m_uInFlight;
+	AkUInt32				m_uMaxInFlight;		// Workers beyond it wait, even with transfers queued.
+
+	std::thread				m_workers[AK_THREAD_POOL_IO_MAX_WORKERS];
+	AkUInt32				m_uNumWorkers;
+
+	// Statistics accumulators.
+	AkUInt32				m_uPeakQueueDepth;
+	AkUInt64				m_uNumQueued;
+	AkUInt64				m_uQueueDepthSum;
+	AkUInt64				m_uNumTransfers;
+	AkUInt64				m_uNumCancelled;
+	AkUInt64				m_uNumFailed;
+	AkUInt64				m_uBytesTransferred;
+	AkInt64					m_iWaitNsSum;
+	AkInt64					m_iLatencyNsSum;
+	AkInt64					m_iMaxLatencyNs;
+};
+
+#endif //_AK_THREAD_POOL_IO_HOOK_DEFERRED_H_
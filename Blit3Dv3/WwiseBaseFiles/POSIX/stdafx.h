@@ -0,0 +1,15 @@
+//////////////////////////////////////////////////////////////////////
+//
+// stdafx.h
+//
+// Precompiled header stand-in for POSIX builds of the low-level I/O
+// samples. The Common/ sources include "stdafx.h", which resolves to
+// this file when WwiseBaseFiles/POSIX is on the include path instead
+// of WwiseBaseFiles/Win32.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
@@ -14,20 +14,35 @@
 #endif  // _DEBUG
 */
 #include <stdlib.h>
+#if defined(_MSC_VER) && defined(_DEBUG)
 #include <crtdbg.h>
+#endif
 
 #include "Blit3D.h"
 #include "AudioEngine.h"
+#include "AudioIDs.h"
 #include "Shot.h"
 #include "PowerUp.h"
 #include "Spaceship.h"
 #include "Asteroid.h"
 #include "Explosion.h"
 #include "RandomGenerator.h"
+#include "LoadScheduler.h"
+#include "CollisionSystem.h"
+#include "GameTrace.h"
+#include <chrono>
+#include <cstring>
+
+//use the main Blit3D logger
+extern logger oLog;
 
 #define backgroundWidth 1920
 #define backgroundHeight 1080
 #define POWER_UP_SIZE 25
+//seconds of loading work done per frame once the title screen is up
+#define LOAD_BUDGET_PER_FRAME 0.004
+//packed media, built from Media\assets.txt by Tools\AssetPacker. Loose files are used without it.
+#define ASSET_ARCHIVE_FILE "Media.b3da"
 
 //GLOBAL DATA
 enum GameState { TITLE_PAGE = 0, GAME = 1, PAUSE = 2 };
@@ -37,11 +52,14 @@ RandomGenerator random;
 // Game Objects
 Spaceship* ship = NULL;
 Explosion* shipExplosion = NULL;
-PowerUp* powerUp;
-// Game Object's lists
+// Game Object's lists, power ups and asteroids are spawned and despawned at the end of each tick
 std::vector<Shot> shotList;
-std::vector<PowerUp*> powerUpList;
-std::vector<Asteroid*> asteroids;
+SlotMap<PowerUp> powerUpList;
+SlotMap<Asteroid> asteroids;
+// Finds the tick's collisions on worker threads, then applies them in a fixed order
+CollisionSystem collisions;
+// Gameplay events, written when the game is started with --trace <file>, read with Tools\TraceReader
+GameTrace trace;
 // Sprites
 Sprite* backgroundSprite = NULL;
 Sprite* shieldIconSprite = NULL;
@@ -75,7 +93,14 @@ bool notPlayedExplosion = true;
 AudioEngine * audioE = NULL;
 AkGameObjectID mainGameID = 1;
 AkGameObjectID asteroidID = 4;
-AkPlayingID titleMusicId, gameMusicId, thrustSound, pauseSound, explosionSound;
+AudioHandle titleMusicId, gameMusicId, thrustSound, pauseSound, explosionSound;
+// Loading
+LoadScheduler loader;
+LoadTaskID gameplaySprites = LOAD_INVALID_TASK;
+LoadTaskID mainSoundBank = LOAD_INVALID_TASK;
+bool firstFrameDrawn = false;
+// F3 shows the heap allocations of each subsystem, in builds with ALLOCATION_TRACKING
+bool showAllocationStats = false;
 
 /**
 * This method creates a random vector inside the screen.
@@ -85,12 +110,89 @@ AkPlayingID titleMusicId, gameMusicId, thrustSound, pauseSound, explosionSound;
 */
 glm::vec2 GetRandomPosition(int width, int height)
 {
-	glm::vec2 newPosition = { random.RandomFloat(0, width, 1000), random.RandomFloat(0, height, 1000) };
+	glm::vec2 newPosition = { random.RandomFloat(0.f, (float)width), random.RandomFloat(0.f, (float)height) };
 	return newPosition;
 }
 
+/**
+* This method spawns the big asteroids a level starts with, one per level.
+* They appear on the asteroids' next Flush().
+*/
+void SpawnLevelAsteroids()
+{
+	// all the level's random numbers at once, into memory that goes with the frame
+	glm::vec2* positions = blit3D->frameArena.AllocateArray<glm::vec2>(level);
+	glm::vec2* velocities = blit3D->frameArena.AllocateArray<glm::vec2>(level);
+	float* spins = blit3D->frameArena.AllocateArray<float>(level);
+	random.FillVec2(positions, level, glm::vec2(0.f, 0.f), glm::vec2(backgroundWidth, backgroundHeight));
+	random.FillVec2(velocities, level, glm::vec2(-50.f, -50.f), glm::vec2(50.f, 50.f));
+	random.FillFloats(spins, level, 1.f, 10.f);
+
+	for (int i = 0; i < level; i++)
+	{
+		glm::vec2 position = positions[i];
+		Asteroid asteroid(BIG_ASTEROID, spriteLists, position, spins[i], audioE);
+		asteroid.SetVelocity(velocities[i]);
+		AsteroidHandle handle = asteroids.Spawn(std::move(asteroid));
+		trace.Record(TraceEvent::ASTEROID_SPAWN, BIG_ASTEROID, handle.index, 0, TracePosition(position.x, position.y));
+	}
+	trace.Record(TraceEvent::LEVEL_START, 0, (uint32_t)level, (uint32_t)level);
+}
+
+/**
+* This method adds a task that loads a sound bank on the sound engine's bank thread.
+* @param std::string The bank's file name.
+* @param std::vector<LoadTaskID> The tasks that must be done before the bank is loaded.
+* @return The task's ID.
+*/
+LoadTaskID AddBankTask(const std::string &bank, const std::vector<LoadTaskID> &dependencies)
+{
+	//filled in when the task starts
+	std::shared_ptr<AudioBankRequest> request = std::make_shared<AudioBankRequest>(AUDIO_INVALID_BANK_REQUEST);
+	return loader.AddAsyncTask(bank,
+		[bank, request]() {
+			*request = audioE->LoadBankAsync(bank);
+			return audioE->GetBankState(*request) != AudioBankState::FAILED;
+		},
+		[request]() {
+			switch (audioE->GetBankState(*request))
+			{
+			case AudioBankState::LOADED:
+				return LoadTaskState::DONE;
+			case AudioBankState::FAILED:
+				return LoadTaskState::FAILED;
+			default:
+				return LoadTaskState::RUNNING;
+			}
+		},
+		dependencies);
+}
+
+/**
+* This method adds a task that decodes an image on one of the loader's worker threads,
+* then makes its texture on the game thread. Sprites and fonts made from that file
+* afterwards find the texture already loaded.
+* @param std::string The image's file name, as the sprites and fonts will ask for it.
+* @return The task's ID.
+*/
+LoadTaskID AddTextureTask(const std::string &filename)
+{
+	std::shared_ptr<DecodedImage> image = std::make_shared<DecodedImage>();
+	const AssetArchive *archive = &blit3D->assets;
+	return loader.AddWorkerTask(filename,
+		[filename, image, archive]() {
+			return TextureManager::DecodeImage(archive, filename, *image);
+		},
+		[filename, image]() {
+			return blit3D->tManager->UploadTexture(filename, *image) != 0;
+		});
+}
+
 /**
 * This method initialices the scene.
+* Every image is decoded at the same time on the loader's workers. Only what the title
+* page needs is waited for here, the sound banks and the gameplay sprites are left to
+* the loader, which carries on with them behind the title page.
 */
 void Init()
 {
@@ -98,36 +200,28 @@ void Init()
 	//turn cursor off
 	blit3D->ShowCursor(false);
 	gameOver = false;
-	//load Sprites for background, shield icon, shot icon and power up
-	backgroundSprite = blit3D->MakeSprite(0, 0, backgroundWidth, backgroundHeight, "Media\\background.png");
-	shieldIconSprite = blit3D->MakeSprite(0, 0, 202, 200, "Media\\shieldIcon.png");
-	shotInterfaceSprite = blit3D->MakeSprite(0, 0, 100, 100, "Media\\shotInterface.png");
-	powerUpSprite = blit3D->MakeSprite(0, 0, 100, 100, "Media\\shot.png");
-	// load all the explosion sprites
-	for (int i = 0; i < 10; i++)
-	{
-		explosionSpriteList.push_back(blit3D->MakeSprite(0 + (i * 1066), 0, 1066, 1091, "Media\\Ship_Exploding.png"));
-	}
-	// Create the asteroids sprites
-	for (int i = 0; i < 8; i++)
-	{
-		bigAsteroidSprites.push_back(blit3D->MakeSprite(i * 804, 0, 804, 798, "Media\\BigAsteroidSet.png"));
-	}
-	spriteLists.push_back(bigAsteroidSprites);
-	for (int i = 0; i < 8; i++)
-	{
-		mediumAsteroidSprites.push_back(blit3D->MakeSprite(i * 405, 0, 405, 372, "Media\\MediumAsteroidSet.png"));
-	}
-	spriteLists.push_back(mediumAsteroidSprites);
-	for (int i = 0; i < 8; i++)
-	{
-		smallAsteroidSprites.push_back(blit3D->MakeSprite(i * 193, 0, 193, 183, "Media\\SmallAsteroidSet.png"));
-	}
-	spriteLists.push_back(smallAsteroidSprites);
 
-	// Font
-	electroliteFont = blit3D->MakeAngelcodeFontFromBinary32("Media\\fonts\\electrolite.bin");
-	syneMonoFont = blit3D->MakeAngelcodeFontFromBinary32("Media\\fonts\\SyneMono.bin");
+	//the images, title page first. The font textures are named in the font files.
+	LoadTaskID backgroundTexture = AddTextureTask("Media\\background.png");
+	LoadTaskID electroliteTexture = AddTextureTask("Media\\fonts\\electrolite.png");
+	LoadTaskID syneMonoTexture = AddTextureTask("Media\\fonts\\SyneMono.png");
+	LoadTaskID shieldIconTexture = AddTextureTask("Media\\shieldIcon.png");
+	LoadTaskID shotInterfaceTexture = AddTextureTask("Media\\shotInterface.png");
+	LoadTaskID shotTexture = AddTextureTask("Media\\shot.png");
+	LoadTaskID explosionTexture = AddTextureTask("Media\\Ship_Exploding.png");
+	LoadTaskID bigAsteroidTexture = AddTextureTask("Media\\BigAsteroidSet.png");
+	LoadTaskID mediumAsteroidTexture = AddTextureTask("Media\\MediumAsteroidSet.png");
+	LoadTaskID smallAsteroidTexture = AddTextureTask("Media\\SmallAsteroidSet.png");
+	LoadTaskID shipTexture = AddTextureTask("Media\\ship.png");
+	LoadTaskID shieldTexture = AddTextureTask("Media\\shield.png");
+
+	//load the background Sprite and the fonts, the title page draws them
+	LoadTaskID titlePage = loader.AddTask("Title page", []() {
+		backgroundSprite = blit3D->MakeSprite(0, 0, backgroundWidth, backgroundHeight, "Media\\background.png");
+		electroliteFont = blit3D->MakeAngelcodeFontFromBinary32("Media\\fonts\\electrolite.bin");
+		syneMonoFont = blit3D->MakeAngelcodeFontFromBinary32("Media\\fonts\\SyneMono.bin");
+		return true;
+	}, { backgroundTexture, electroliteTexture, syneMonoTexture });
 	//set the clear colour
 	glClearColor(1.0f, 0.0f, 1.0f, 0.0f);	//clear colour: r,g,b,a 
 	
@@ -135,18 +229,77 @@ void Init()
 	audioE = new AudioEngine;
 	audioE->Init();
 	audioE->SetBasePath("Media\\Music\\");
-
-	//load banks
-	audioE->LoadBank("Init.bnk");
-	audioE->LoadBank("Main_Sound.bnk");
+	audioE->SetArchive(&blit3D->assets);
 
 	//register our game objects
 	audioE->RegisterGameObject(mainGameID);
 	audioE->RegisterGameObject(asteroidID);
 
-	//start playing the looping drums
-	//We can play events by name:
-	titleMusicId = audioE->PlayEvent("TitleMusic", mainGameID);
+	//cap the asteroid sounds per frame, so a pile-up can't flood the sound engine
+	audioE->SetEventBudget(AudioIDs::EVENTS::COLLISION, 4, AudioIDs::GAME_PARAMETERS::PANNINGX);
+	audioE->SetEventBudget(AudioIDs::EVENTS::BIGASTEROID, 2, AudioIDs::GAME_PARAMETERS::PANNINGX);
+	audioE->SetEventBudget(AudioIDs::EVENTS::MEDIUMASTEROID, 3, AudioIDs::GAME_PARAMETERS::PANNINGX);
+	audioE->SetEventBudget(AudioIDs::EVENTS::SMALLASTEROID, 4, AudioIDs::GAME_PARAMETERS::PANNINGX);
+
+	//load banks, Init.bnk has to be in before any other bank
+	LoadTaskID initBank = AddBankTask("Init.bnk", {});
+	mainSoundBank = AddBankTask("Main_Sound.bnk", { initBank });
+
+	//start playing the title music as soon as its bank is in, unless the game has started already
+	loader.AddTask("TitleMusic", []() {
+		if (gameState == TITLE_PAGE) titleMusicId = audioE->PlayEvent(AudioIDs::EVENTS::TITLEMUSIC, mainGameID);
+		return true;
+	}, { mainSoundBank });
+
+	//load Sprites for shield icon, shot icon and power up
+	LoadTaskID hudSprites = loader.AddTask("HUD sprites", []() {
+		shieldIconSprite = blit3D->MakeSprite(0, 0, 202, 200, "Media\\shieldIcon.png");
+		shotInterfaceSprite = blit3D->MakeSprite(0, 0, 100, 100, "Media\\shotInterface.png");
+		//the same sprite as the ship's shots, so it comes from the sprite cache
+		powerUpSprite = blit3D->AcquireSprite(0, 0, 100, 100, "Media\\shot.png");
+		return true;
+	}, { shieldIconTexture, shotInterfaceTexture, shotTexture });
+	// load all the explosion sprites
+	LoadTaskID explosionSprites = loader.AddTask("Explosion sprites", []() {
+		for (int i = 0; i < 10; i++)
+		{
+			explosionSpriteList.push_back(blit3D->MakeSprite(0 + (i * 1066), 0, 1066, 1091, "Media\\Ship_Exploding.png"));
+		}
+		return true;
+	}, { explosionTexture });
+	// Create the asteroids sprites, one sheet per task
+	LoadTaskID bigAsteroids = loader.AddTask("Big asteroid sprites", []() {
+		for (int i = 0; i < 8; i++)
+		{
+			bigAsteroidSprites.push_back(blit3D->MakeSprite(i * 804, 0, 804, 798, "Media\\BigAsteroidSet.png"));
+		}
+		return true;
+	}, { bigAsteroidTexture });
+	LoadTaskID mediumAsteroids = loader.AddTask("Medium asteroid sprites", []() {
+		for (int i = 0; i < 8; i++)
+		{
+			mediumAsteroidSprites.push_back(blit3D->MakeSprite(i * 405, 0, 405, 372, "Media\\MediumAsteroidSet.png"));
+		}
+		return true;
+	}, { mediumAsteroidTexture });
+	LoadTaskID smallAsteroids = loader.AddTask("Small asteroid sprites", []() {
+		for (int i = 0; i < 8; i++)
+		{
+			smallAsteroidSprites.push_back(blit3D->MakeSprite(i * 193, 0, 193, 183, "Media\\SmallAsteroidSet.png"));
+		}
+		return true;
+	}, { smallAsteroidTexture });
+	//asteroids pick their sprites from these lists, biggest first. The ship and shield
+	//sprites are made when a game starts, their textures only need to be in by then.
+	gameplaySprites = loader.AddTask("Gameplay sprites", []() {
+		spriteLists.push_back(bigAsteroidSprites);
+		spriteLists.push_back(mediumAsteroidSprites);
+		spriteLists.push_back(smallAsteroidSprites);
+		return true;
+	}, { hudSprites, explosionSprites, bigAsteroids, mediumAsteroids, smallAsteroids, shipTexture, shieldTexture });
+
+	//the title page can't be drawn without these, everything else keeps loading meanwhile
+	loader.Finish(titlePage);
 }
 
 /**
@@ -155,21 +308,37 @@ void Init()
 void DeInit(void)
 {
 	
+	//both worker pools are joined here, while what they read is still around and before the
+	//log and allocation reports, not left to the static destructors after main() returns.
+	//The loader's workers read from the asset archive, which goes away with blit3D
+	collisions.StopWorkers();
+	loader.StopWorkers();
+
 	// Eliminate ship, asteroids and power ups
+	trace.Close();
 	//ship->willDelete();
 	if (ship != NULL) delete ship;
-	for (auto asteroid : asteroids)
-	{
-		//asteroid->willDelete();
-		if (asteroid != NULL) delete asteroid;
-	}
-	asteroids.clear();
-	for (auto powerUp : powerUpList)
+	asteroids.Clear();
+	powerUpList.Clear();
+	blit3D->LogSpriteStats();
+	blit3D->frameArena.LogStats();
+	if (audioE != NULL) delete audioE;
+	blit3D->inputQueue.LogStats();
+}
+
+void DoInput(int key, int scancode, int action, int mods);
+
+/**
+* This method hands DoInput() the queued key events that happened before a time.
+* @param double The time, on the input queue's clock.
+*/
+void HandleInput(double before)
+{
+	InputEvent event;
+	while (blit3D->inputQueue.Pop(before, event))
 	{
-		if (powerUp != NULL) delete powerUp;
+		DoInput(event.key, event.scancode, event.action, event.mods);
 	}
-	powerUpList.clear();
-	if (audioE != NULL) delete audioE;
 }
 
 /**
@@ -177,23 +346,29 @@ void DeInit(void)
 */
 void Update(double seconds)
 {
-	//must always update audio in our game loop
-	audioE->ProcessAudio();
+	double now = blit3D->inputQueue.Now();
+	double simulatedTime; //the time the ticks have got to, on the same clock
+
+	//audio is rendered on the AudioEngine's own thread, we only queue commands from here
+
+	//carry on loading behind the title page
+	if (!loader.AllFinished())
+	{
+		loader.Update(LOAD_BUDGET_PER_FRAME);
+		if (loader.AllFinished()) loader.LogTimings();
+	}
 
 	switch (gameState)
 	{
 	case TITLE_PAGE:
+		HandleInput(now);
 		break;
 	case GAME:
 		// Check if you ran out of asteroids and reloas a level if you do
-		if (asteroids.size() <= 0) {
+		if (asteroids.Size() <= 0) {
 			level++;
-			for (int i = 0; i < level; i++)
-			{
-				Asteroid* asteroid = new Asteroid(BIG_ASTEROID, spriteLists, GetRandomPosition(backgroundWidth, backgroundHeight), random.RandomFloat(1, 10, 1), audioE);
-				asteroid->SetVelocity({ random.RandomFloat(-50, 50, 1),random.RandomFloat(-50, 50, 1) });
-				asteroids.push_back(asteroid);
-			}
+			SpawnLevelAsteroids();
+			asteroids.Flush();
 			levelTitleTimer = 0;
 			ship->ActivateShield();
 
@@ -205,27 +380,32 @@ void Update(double seconds)
 			elapsedTime += seconds;
 		else elapsedTime += 0.15;
 
-		//update by a full timeslice when it's time
+		//update by a full timeslice when it's time, each tick takes the input of the timeslice it
+		//simulates: the ticks run behind the clock by what is left in elapsedTime
+		simulatedTime = now - elapsedTime;
 		while (elapsedTime >= timeSlice)
 		{
+			simulatedTime += timeSlice;
+			HandleInput(simulatedTime);
+			if (gameState != GAME) break; //paused, or back to the title page
 			elapsedTime -= timeSlice;
 			levelTitleTimer += timeSlice;
+			trace.BeginTick();
+			std::chrono::steady_clock::time_point tickStart = std::chrono::steady_clock::now();
 
 			
 
 			if (levelTitleTimer > 5) levelTitleTimer = 5;
-			// handle impact
-			if(!ship->IsDestroyed())
-				ship->CollidedWithAsteroids(asteroids);
 			// Update ship
 			ship->Update(timeSlice);
 
 			// Shoot if shooting
 			if (shoot && !ship->IsDestroyed())
 			{
+				size_t shotsBefore = shotList.size();
 				if (ship->Shoot(shotList))
 				{
-					
+					trace.Record(TraceEvent::SHOTS_FIRED, 0, (uint32_t)(shotList.size() - shotsBefore), (uint32_t)shotList.size());
 				}
 			}
 
@@ -239,46 +419,38 @@ void Update(double seconds)
 				{
 					shotList.erase(shotList.begin() + i);
 				}
-				else
-				{
-					// Add on to the score with the collided asteroid
-					score += shotList[i].CollideWithAsteroids(asteroids);
-				}
-
-
 			}
 
 			// update the asteroids
-			for (int i = asteroids.size() - 1; i >= 0; --i)
-			{
+			asteroids.ForEach([](AsteroidHandle handle, Asteroid& asteroid) {
 				// If the asteroids animation has ended, destroy it, the asteroid's explosion can kill you too
-				if (asteroids[i]->IsDead())
+				if (asteroid.IsDead())
 				{
-					delete asteroids[i];
-					asteroids.erase(asteroids.begin() + i);
+					asteroids.Despawn(handle);
 				}
 				else
 				{
 					// Update the asteroid
-					asteroids[i]->Update(timeSlice);
+					asteroid.Update(timeSlice);
 				}
-			}
-			// Check asteroid's collisions with otehr asteroids
-			Asteroid::CollideWithAsteroids(asteroids);
+			});
+			// Find the ship's, shots' and asteroids' collisions, then apply them: impacts, splits,
+			// bounces and the score for the asteroids shot
+			collisions.Detect(ship, shotList, asteroids, powerUpList);
+			score += collisions.Resolve();
 			// Handle the ship destruction
 			if (ship->IsDestroyed())
 			{
-				audioE->StopEvent("Thrust", mainGameID, thrustSound);
+				audioE->StopEvent(AudioIDs::EVENTS::THRUST, mainGameID, thrustSound);
 				// show explosion
 				if (shipExplosion == NULL && !ship->Exploded() && notPlayedExplosion)
 				{
 					notPlayedExplosion = false;
+					trace.Record(TraceEvent::SHIP_DESTROYED, 0, (uint32_t)score);
 					ship->SetExplosion(true);
 					shipExplosion = new Explosion(ship->GetPosition(), explosionSpriteList, ship->GetRadius());
-					AKRESULT panningX = AK::SoundEngine::SetRTPCValue(L"PanningX", (AkRtpcValue)(ship->GetPosition().x), mainGameID);
-					audioE->ProcessAudio();
-					explosionSound = audioE->PlayEvent("Explosion", mainGameID);
-					audioE->ProcessAudio();
+					audioE->SetRTPCValue(AudioIDs::GAME_PARAMETERS::PANNINGX, (AkRtpcValue)(ship->GetPosition().x), mainGameID);
+					explosionSound = audioE->PlayEvent(AudioIDs::EVENTS::EXPLOSION, mainGameID);
 				}
 			}
 			// Chandle the explosion state
@@ -286,6 +458,7 @@ void Update(double seconds)
 			{
 				//Set game over if the epxlosion animation has ended
 				if (shipExplosion->GetFrame() >= 9) {
+					if (!gameOver) trace.Record(TraceEvent::GAME_OVER, 0, (uint32_t)score, (uint32_t)level);
 					gameOver = true;
 				}
 				// Animate the explosion
@@ -300,31 +473,69 @@ void Update(double seconds)
 				}
 			}
 			// Appear power ups if the score has gone over 500 since last power up
-			if (ship->GetPowerUp() + powerUpList.size() < 2 && score - lastPowerUp > 500)
+			if (ship->GetPowerUp() + powerUpList.Size() < 2 && score - lastPowerUp > 500)
 			{
-				powerUp = new PowerUp(GetRandomPosition(backgroundWidth, backgroundHeight), POWER_UP_SIZE, powerUpSprite);
-				powerUpList.push_back(powerUp);
+				glm::vec2 position = GetRandomPosition(backgroundWidth, backgroundHeight);
+				PowerUpHandle handle = powerUpList.Spawn(position, POWER_UP_SIZE, powerUpSprite);
+				trace.Record(TraceEvent::POWER_UP_SPAWN, 0, handle.index, 0, TracePosition(position.x, position.y));
 				lastPowerUp = score;
 			}
-			// Check if the ship grabs a power up
-			ship->CollideWithPowerUps(powerUpList);
 			// Delete power ups that have been grabbed
-			for (int i = powerUpList.size() - 1; i >= 0; --i)
-			{
-				if (!powerUpList[i]->Update(timeSlice))
+			powerUpList.ForEach([](PowerUpHandle handle, PowerUp& powerUp) {
+				if (!powerUp.Update(timeSlice))
 				{
-					if (powerUpList[i] != NULL) delete powerUpList[i];
-					powerUpList.erase(powerUpList.begin() + i);
+					powerUpList.Despawn(handle);
 				}
+			});
+			// the end of the tick is the safe point: nothing is walking the lists, so apply
+			// this tick's spawns (asteroid pieces, power ups) and despawns
+			asteroids.Flush();
+			powerUpList.Flush();
+
+			if (trace.IsOpen())
+			{
+				uint32_t shots = shotList.size() < 0xFFFF ? (uint32_t)shotList.size() : 0xFFFF;
+				uint32_t powerUps = powerUpList.Size() < 0xFFFF ? (uint32_t)powerUpList.Size() : 0xFFFF;
+				uint32_t micros = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tickStart).count();
+				trace.Record(TraceEvent::TICK_SUMMARY, 0, (uint32_t)asteroids.Size(), (shots << 16) | powerUps, micros);
 			}
 		}
 		break;
 	case PAUSE:
+		HandleInput(now);
 		break;
 	default:
 		break;
 	}
-	
+
+	//send this frame's RTPC and position updates, only the last value of each,
+	//and the asteroid sounds that made it through their budgets
+	if (ship != NULL) audioE->SetListenerPosition(ship->GetPosition().x, ship->GetPosition().y);
+	audioE->FlushUpdates();
+}
+
+/**
+* This method draws the allocation tracker's counts, one line per subsystem that has allocated.
+*/
+void DrawAllocationStats()
+{
+	if (syneMonoFont == NULL) return;
+	float y = blit3D->screenHeight - 100.f;
+	if (!AllocationTracker::IsEnabled())
+	{
+		syneMonoFont->BlitText(30.f, y, "Allocation tracking is off (ALLOCATION_TRACKING)");
+		return;
+	}
+	for (int tag = 0; tag <= (int)AllocTag::COUNT; tag++)
+	{
+		AllocationStats stats = tag < (int)AllocTag::COUNT ? AllocationTracker::GetStats((AllocTag)tag) : AllocationTracker::GetTotalStats();
+		if (stats.allocations == 0) continue;
+		std::string_view text = blit3D->frameArena.Format("%s: %llu a frame, %lld KB live, %lld KB peak",
+			AllocationTracker::TagName((AllocTag)tag), (unsigned long long)stats.lastFrameAllocations,
+			(long long)(stats.liveBytes / 1024), (long long)(stats.peakBytes / 1024));
+		syneMonoFont->BlitText(30.f, y, text);
+		y -= 40.f;
+	}
 }
 
 /**
@@ -332,12 +543,19 @@ void Update(double seconds)
 */
 void Draw(void)
 {
-	// Variables for the texts
-	std::string text;
+	//drawing shouldn't touch the heap once the game is going, debug builds assert it doesn't
+	FrameAllocationCheck noAllocations(blit3D->frameArena, "Draw()");
+	// Variables for the texts, numbers are formatted into the frame arena
+	std::string_view text;
 	float textWidth;
 	float textHeight;
 	float vMargin;
 	float hMArgin;
+	if (!firstFrameDrawn)
+	{
+		firstFrameDrawn = true;
+		oLog(Level::Info) << "First frame drawn " << loader.GetElapsedTime() * 1000.0 << " ms after start-up";
+	}
 	switch (gameState)
 	{
 	case TITLE_PAGE:
@@ -394,15 +612,13 @@ void Draw(void)
 		for (auto& shot : shotList)
 			shot.Draw();
 		// Draw the power ups
-		for (auto powerUp : powerUpList)
-		{
-			powerUp->Draw();
-		}
+		powerUpList.ForEach([](PowerUpHandle, PowerUp& powerUp) {
+			powerUp.Draw();
+		});
 		// Draw the asteroids
-		for each (Asteroid * asteroid in asteroids)
-		{
-			asteroid->Draw();
-		}
+		asteroids.ForEach([](AsteroidHandle, Asteroid& asteroid) {
+			asteroid.Draw();
+		});
 		// Draw the ship's explosion
 		if (shipExplosion != NULL)
 		{
@@ -420,7 +636,7 @@ void Draw(void)
 			textWidth = electroliteFont->WidthText(text);
 			textHeight = 120.f;
 			electroliteFont->BlitText(blit3D->screenWidth / 2 - textWidth / 2, blit3D->screenHeight / 2 + textHeight, text);
-			text = "Your score was: " + std::to_string(score);
+			text = blit3D->frameArena.Format("Your score was: %d", score);
 			textWidth = syneMonoFont->WidthText(text);
 			textHeight = 40.f;
 			syneMonoFont->BlitText(blit3D->screenWidth / 2 - textWidth / 2, blit3D->screenHeight / 2 + textHeight, text);
@@ -436,11 +652,11 @@ void Draw(void)
 		{
 			shieldIconSprite->Blit(hMArgin + textWidth + 40.0f + (shieldCounter * 80.0f), 1030.f, 0.3f, 0.3f);
 		}
-		text = "Score: " + std::to_string(score);
+		text = blit3D->frameArena.Format("Score: %d", score);
 		textWidth = syneMonoFont->WidthText(text);
 		syneMonoFont->BlitText(blit3D->screenWidth - textWidth - hMArgin, blit3D->screenHeight - vMargin, text);
 		if (levelTitleTimer < 2) {
-			text = "Level " + std::to_string(level);
+			text = blit3D->frameArena.Format("Level %d", level);
 			textWidth = syneMonoFont->WidthText(text);
 			syneMonoFont->BlitText(blit3D->screenWidth / 2 - textWidth / 2, blit3D->screenHeight / 2 + 38.f, text);
 		}
@@ -464,6 +680,10 @@ void Draw(void)
 		electroliteFont->BlitText(blit3D->screenWidth / 2 - textWidth / 2, blit3D->screenHeight / 2 + textHeight, text);
 
 	}
+	if (showAllocationStats)
+	{
+		DrawAllocationStats();
+	}
 }
 
 /**
@@ -473,59 +693,50 @@ void DoInput(int key, int scancode, int action, int mods)
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		blit3D->Quit(); //start the shutdown sequence
+	if (key == GLFW_KEY_F3 && action == GLFW_RELEASE)
+		showAllocationStats = !showAllocationStats;
 	switch (gameState)
 	{
 	case TITLE_PAGE:
 		// Start a new Game
 		if (key == GLFW_KEY_ENTER && action == GLFW_RELEASE)
 		{
+			//the game can't start without its sprites, or be heard without its bank
+			loader.Finish(gameplaySprites);
+			loader.Finish(mainSoundBank);
 			if (ship != NULL) delete ship;
-			for (auto asteroid : asteroids)
-			{
-				//asteroid->willDelete();
-				if (asteroid != NULL) delete asteroid;
-			}
-			asteroids.clear();
-			for (auto powerUp : powerUpList)
-			{
-				if (powerUp != NULL) delete powerUp;
-			}
-			powerUpList.clear();
+			asteroids.Clear();
+			powerUpList.Clear();
 			score = 0;
 			level = 0;
 			gameOver = false;
-			powerUpList.clear();
-			asteroids.clear();
 			shotList.clear();
 			levelTitleTimer = 0;
 			level = 1;
 			lastPowerUp = 0;
 			notPlayedExplosion = true;
-			//create a ship
-			
-			ship = new Spaceship(glm::vec2(backgroundWidth / 2, backgroundHeight / 2), blit3D->MakeSprite(0, 0, 100, 100, "Media\\shot.png"), 50.0f, 0.0f, audioE);
+			//create a ship, its sprites come from blit3D's sprite cache and go back to it when
+			//the ship is deleted, so starting game after game doesn't make new ones
+			ship = new Spaceship(glm::vec2(backgroundWidth / 2, backgroundHeight / 2), blit3D->AcquireSprite(0, 0, 100, 100, "Media\\shot.png"), 50.0f, 0.0f, audioE);
 			//load a sprite off of a spritesheet
-			ship->AddSprite(blit3D->MakeSprite(0, 0, 1452, 2180, "Media\\ship.png"));
-			ship->AddSprite(blit3D->MakeSprite(1464, 0, 1452, 2180, "Media\\ship.png"));
-			ship->AddSprite(blit3D->MakeSprite(2929, 0, 1452, 2180, "Media\\ship.png"));
-			ship->AddSprite(blit3D->MakeSprite(4393, 0, 1452, 2180, "Media\\ship.png"));
-			ship->SetShieldSprite(blit3D->MakeSprite(0, 0, 1781, 1473, "Media\\shield.png"));
+			ship->AddSprite(blit3D->AcquireSprite(0, 0, 1452, 2180, "Media\\ship.png"));
+			ship->AddSprite(blit3D->AcquireSprite(1464, 0, 1452, 2180, "Media\\ship.png"));
+			ship->AddSprite(blit3D->AcquireSprite(2929, 0, 1452, 2180, "Media\\ship.png"));
+			ship->AddSprite(blit3D->AcquireSprite(4393, 0, 1452, 2180, "Media\\ship.png"));
+			ship->SetShieldSprite(blit3D->AcquireSprite(0, 0, 1781, 1473, "Media\\shield.png"));
 			//load Asteroids
-			for (int i = 0; i < level; i++)
-			{
-				Asteroid* asteroid = new Asteroid(BIG_ASTEROID, spriteLists, GetRandomPosition(backgroundWidth, backgroundHeight), random.RandomFloat(1, 10, 1), audioE);
-				asteroid->SetVelocity({ random.RandomFloat(-50, 50, 1),random.RandomFloat(-50, 50, 1) });
-				asteroids.push_back(asteroid);
-			}
+			trace.Record(TraceEvent::GAME_START, 0, (uint32_t)level);
+			SpawnLevelAsteroids();
+			asteroids.Flush();
 			gameState = GAME;
-			audioE->StopEvent("TitleMusic", mainGameID, titleMusicId);
-			gameMusicId = audioE->PlayEvent("GameMusic", mainGameID);
+			audioE->StopEvent(AudioIDs::EVENTS::TITLEMUSIC, mainGameID, titleMusicId);
+			gameMusicId = audioE->PlayEvent(AudioIDs::EVENTS::GAMEMUSIC, mainGameID);
 		}
 		break;
 	case GAME:
 		if (!gameOver) 
 		{
-			AKRESULT panningX = AK::SoundEngine::SetRTPCValue(L"PanningX", (AkRtpcValue)(ship->GetPosition().x), mainGameID);
+			audioE->SetRTPCValue(AudioIDs::GAME_PARAMETERS::PANNINGX, (AkRtpcValue)(ship->GetPosition().x), mainGameID);
 			// Movement controls
 			if (key == GLFW_KEY_A && action == GLFW_PRESS)
 				ship->SetTurnLeft(true);
@@ -540,13 +751,13 @@ void DoInput(int key, int scancode, int action, int mods)
 				ship->SetTurnRight(false);
 
 			if (key == GLFW_KEY_W && action == GLFW_PRESS && !ship->IsDestroyed()) {
-				thrustSound = audioE->PlayEvent("Thrust", mainGameID);
+				thrustSound = audioE->PlayEvent(AudioIDs::EVENTS::THRUST, mainGameID);
 				ship->SetThrusting(true);
 			}
 				
 
 			if (key == GLFW_KEY_W && action == GLFW_RELEASE) {
-				audioE->StopEvent("Thrust", mainGameID, thrustSound);
+				audioE->StopEvent(AudioIDs::EVENTS::THRUST, mainGameID, thrustSound);
 				ship->SetThrusting(false);
 			}
 				
@@ -560,10 +771,10 @@ void DoInput(int key, int scancode, int action, int mods)
 			// Pause action
 			if (key == GLFW_KEY_P && action == GLFW_RELEASE)
 			{
-				pauseSound = audioE->PlayEvent("Pause", mainGameID);
+				pauseSound = audioE->PlayEvent(AudioIDs::EVENTS::PAUSE, mainGameID);
 				gameState = PAUSE;
-				audioE->PauseEvent("GameMusic", mainGameID, gameMusicId);
-				audioE->PauseEvent("Thrust", mainGameID, thrustSound);
+				audioE->PauseEvent(AudioIDs::EVENTS::GAMEMUSIC, mainGameID, gameMusicId);
+				audioE->PauseEvent(AudioIDs::EVENTS::THRUST, mainGameID, thrustSound);
 				ship->Pause();
 
 			}
@@ -575,8 +786,8 @@ void DoInput(int key, int scancode, int action, int mods)
 			{
 				score = 0;
 				gameState = TITLE_PAGE;
-				audioE->StopEvent("GameMusic", mainGameID, gameMusicId); 
-				titleMusicId = audioE->PlayEvent("TitleMusic", mainGameID);
+				audioE->StopEvent(AudioIDs::EVENTS::GAMEMUSIC, mainGameID, gameMusicId); 
+				titleMusicId = audioE->PlayEvent(AudioIDs::EVENTS::TITLEMUSIC, mainGameID);
 			}
 		}
 		break;
@@ -584,13 +795,13 @@ void DoInput(int key, int scancode, int action, int mods)
 		// Unpause action
 		if (key == GLFW_KEY_P && action == GLFW_RELEASE)
 		{
-			pauseSound = audioE->PlayEvent("Pause", mainGameID);
+			pauseSound = audioE->PlayEvent(AudioIDs::EVENTS::PAUSE, mainGameID);
 			gameState = GAME;
-			audioE->ResumeEvent("GameMusic", mainGameID, gameMusicId);
-			audioE->ResumeEvent("Thrust", mainGameID, thrustSound);
+			audioE->ResumeEvent(AudioIDs::EVENTS::GAMEMUSIC, mainGameID, gameMusicId);
+			audioE->ResumeEvent(AudioIDs::EVENTS::THRUST, mainGameID, thrustSound);
 			ship->Resume();
 			if (thrustPressed) {
-				thrustSound = audioE->PlayEvent("Thrust", mainGameID);
+				thrustSound = audioE->PlayEvent(AudioIDs::EVENTS::THRUST, mainGameID);
 				ship->SetThrusting(true);
 			}
 		}
@@ -599,7 +810,7 @@ void DoInput(int key, int scancode, int action, int mods)
 		}
 
 		if (key == GLFW_KEY_W && action == GLFW_RELEASE) {
-			audioE->StopEvent("Thrust", mainGameID, thrustSound);
+			audioE->StopEvent(AudioIDs::EVENTS::THRUST, mainGameID, thrustSound);
 			ship->SetThrusting(false);
 			thrustPressed = false;
 		}
@@ -614,8 +825,11 @@ void DoInput(int key, int scancode, int action, int mods)
 */
 int main(int argc, char *argv[])
 {
-	//memory leak detection
+	//memory leak detection, MSVC debug builds only. Build with ALLOCATION_TRACKING 1 for the
+	//report by subsystem logged at exit, on any platform
+#if defined(_MSC_VER) && defined(_DEBUG)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
 	//_crtBreakAlloc = 77263;
 	blit3D = new Blit3D(Blit3DWindowModel::BORDERLESSFULLSCREEN_1080P, 1920, 1080);
 
@@ -625,8 +839,30 @@ int main(int argc, char *argv[])
 	blit3D->SetUpdate(Update);
 	blit3D->SetDraw(Draw);
 	blit3D->SetDoInput(DoInput);
+	//key events wait for the tick they happened in, Update() hands them to DoInput()
+	blit3D->SetQueueInput(true);
+
+	//map the packed media before anything gets loaded
+	blit3D->assets.Open(ASSET_ARCHIVE_FILE);
+
+	//--trace <file> records the gameplay events for Tools\TraceReader,
+	//--seed <number> gives the asteroids and power ups the random numbers of an earlier game
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--trace") == 0 && trace.Open(argv[i + 1], timeSlice))
+		{
+			collisions.SetTrace(&trace);
+		}
+		if (strcmp(argv[i], "--seed") == 0)
+		{
+			random.Seed(strtoull(argv[i + 1], NULL, 10), 0);
+		}
+	}
+	oLog(Level::Info) << "Random seed " << random.GetSeed() << " (--seed to use it again)";
 	
 	//Run() blocks until the window is closed
 	blit3D->Run(Blit3DThreadModel::SINGLETHREADED);
 	if (blit3D) delete blit3D;
+	//whatever is still live now was never freed
+	AllocationTracker::LogReport();
 }
\ No newline at end of file